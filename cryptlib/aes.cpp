@@ -0,0 +1,857 @@
+#include "aes.hpp"
+#include "aes_ni.hpp"
+#include "cpu_features.hpp"
+#include <cstring>
+#include <stdexcept>
+
+// Rotate a 64-bit word right
+static inline uint64_t rtr64(uint64_t x, unsigned c)
+{
+    return (x >> c) | (x << (64U - c));
+}
+
+// Apply the AES S-box to the bitsliced state (Boyar-Peralta circuit)
+// Plane q[b] holds bit b of every state byte.
+static void sub_bytes(uint64_t *q)
+{
+    // Top linear transformation
+    uint64_t x0 = q[7];
+    uint64_t x1 = q[6];
+    uint64_t x2 = q[5];
+    uint64_t x3 = q[4];
+    uint64_t x4 = q[3];
+    uint64_t x5 = q[2];
+    uint64_t x6 = q[1];
+    uint64_t x7 = q[0];
+
+    uint64_t y14 = x3 ^ x5;
+    uint64_t y13 = x0 ^ x6;
+    uint64_t y9 = x0 ^ x3;
+    uint64_t y8 = x0 ^ x5;
+    uint64_t t0 = x1 ^ x2;
+    uint64_t y1 = t0 ^ x7;
+    uint64_t y4 = y1 ^ x3;
+    uint64_t y12 = y13 ^ y14;
+    uint64_t y2 = y1 ^ x0;
+    uint64_t y5 = y1 ^ x6;
+    uint64_t y3 = y5 ^ y8;
+    uint64_t t1 = x4 ^ y12;
+    uint64_t y15 = t1 ^ x5;
+    uint64_t y20 = t1 ^ x1;
+    uint64_t y6 = y15 ^ x7;
+    uint64_t y10 = y15 ^ t0;
+    uint64_t y11 = y20 ^ y9;
+    uint64_t y7 = x7 ^ y11;
+    uint64_t y17 = y10 ^ y11;
+    uint64_t y19 = y10 ^ y8;
+    uint64_t y16 = t0 ^ y11;
+    uint64_t y21 = y13 ^ y16;
+    uint64_t y18 = x0 ^ y16;
+
+    // Non-linear section (GF(2^8) inversion)
+    uint64_t t2 = y12 & y15;
+    uint64_t t3 = y3 & y6;
+    uint64_t t4 = t3 ^ t2;
+    uint64_t t5 = y4 & x7;
+    uint64_t t6 = t5 ^ t2;
+    uint64_t t7 = y13 & y16;
+    uint64_t t8 = y5 & y1;
+    uint64_t t9 = t8 ^ t7;
+    uint64_t t10 = y2 & y7;
+    uint64_t t11 = t10 ^ t7;
+    uint64_t t12 = y9 & y11;
+    uint64_t t13 = y14 & y17;
+    uint64_t t14 = t13 ^ t12;
+    uint64_t t15 = y8 & y10;
+    uint64_t t16 = t15 ^ t12;
+    uint64_t t17 = t4 ^ t14;
+    uint64_t t18 = t6 ^ t16;
+    uint64_t t19 = t9 ^ t14;
+    uint64_t t20 = t11 ^ t16;
+    uint64_t t21 = t17 ^ y20;
+    uint64_t t22 = t18 ^ y19;
+    uint64_t t23 = t19 ^ y21;
+    uint64_t t24 = t20 ^ y18;
+    uint64_t t25 = t21 ^ t22;
+    uint64_t t26 = t21 & t23;
+    uint64_t t27 = t24 ^ t26;
+    uint64_t t28 = t25 & t27;
+    uint64_t t29 = t28 ^ t22;
+    uint64_t t30 = t23 ^ t24;
+    uint64_t t31 = t22 ^ t26;
+    uint64_t t32 = t31 & t30;
+    uint64_t t33 = t32 ^ t24;
+    uint64_t t34 = t23 ^ t33;
+    uint64_t t35 = t27 ^ t33;
+    uint64_t t36 = t24 & t35;
+    uint64_t t37 = t36 ^ t34;
+    uint64_t t38 = t27 ^ t36;
+    uint64_t t39 = t29 & t38;
+    uint64_t t40 = t25 ^ t39;
+    uint64_t t41 = t40 ^ t37;
+    uint64_t t42 = t29 ^ t33;
+    uint64_t t43 = t29 ^ t40;
+    uint64_t t44 = t33 ^ t37;
+    uint64_t t45 = t42 ^ t41;
+    uint64_t z0 = t44 & y15;
+    uint64_t z1 = t37 & y6;
+    uint64_t z2 = t33 & x7;
+    uint64_t z3 = t43 & y16;
+    uint64_t z4 = t40 & y1;
+    uint64_t z5 = t29 & y7;
+    uint64_t z6 = t42 & y11;
+    uint64_t z7 = t45 & y17;
+    uint64_t z8 = t41 & y10;
+    uint64_t z9 = t44 & y12;
+    uint64_t z10 = t37 & y3;
+    uint64_t z11 = t33 & y4;
+    uint64_t z12 = t43 & y13;
+    uint64_t z13 = t40 & y5;
+    uint64_t z14 = t29 & y2;
+    uint64_t z15 = t42 & y9;
+    uint64_t z16 = t45 & y14;
+    uint64_t z17 = t41 & y8;
+
+    // Bottom linear transformation
+    uint64_t t46 = z15 ^ z16;
+    uint64_t t47 = z10 ^ z11;
+    uint64_t t48 = z5 ^ z13;
+    uint64_t t49 = z9 ^ z10;
+    uint64_t t50 = z2 ^ z12;
+    uint64_t t51 = z2 ^ z5;
+    uint64_t t52 = z7 ^ z8;
+    uint64_t t53 = z0 ^ z3;
+    uint64_t t54 = z6 ^ z7;
+    uint64_t t55 = z16 ^ z17;
+    uint64_t t56 = z12 ^ t48;
+    uint64_t t57 = t50 ^ t53;
+    uint64_t t58 = z4 ^ t46;
+    uint64_t t59 = z3 ^ t54;
+    uint64_t t60 = t46 ^ t57;
+    uint64_t t61 = z14 ^ t57;
+    uint64_t t62 = t52 ^ t58;
+    uint64_t t63 = t49 ^ t58;
+    uint64_t t64 = z4 ^ t59;
+    uint64_t t65 = t61 ^ t62;
+    uint64_t t66 = z1 ^ t63;
+    uint64_t s0 = t59 ^ t63;
+    uint64_t s6 = t56 ^ ~t62;
+    uint64_t s7 = t48 ^ ~t60;
+    uint64_t t67 = t64 ^ t65;
+    uint64_t s3 = t53 ^ t66;
+    uint64_t s4 = t51 ^ t66;
+    uint64_t s5 = t47 ^ t65;
+    uint64_t s1 = t64 ^ ~s3;
+    uint64_t s2 = t55 ^ ~t67;
+
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+
+// Apply the inverse of the S-box affine transformation to the bitsliced state
+static void inv_affine(uint64_t *q)
+{
+    uint64_t t[8];
+    for (unsigned b = 0U; b < 8U; ++b)
+    {
+        t[b] = q[(b + 2U) & 7U] ^ q[(b + 5U) & 7U] ^ q[(b + 7U) & 7U];
+    }
+
+    // Add the constant 0x05
+    q[0] = ~t[0];
+    q[1] = t[1];
+    q[2] = ~t[2];
+    for (unsigned b = 3U; b < 8U; ++b)
+    {
+        q[b] = t[b];
+    }
+}
+
+// Apply the inverse S-box to the bitsliced state
+// S = A(inv(x)) for the affine map A, so inv_S = A^-1 o S o A^-1.
+static void inv_sub_bytes(uint64_t *q)
+{
+    inv_affine(q);
+    sub_bytes(q);
+    inv_affine(q);
+}
+
+// Rotate each row of the bitsliced state left by its row index
+// Bit 16 * row + 4 * column + block of each plane holds one state byte.
+static void shift_rows(uint64_t *q)
+{
+    for (unsigned b = 0U; b < 8U; ++b)
+    {
+        uint64_t x = q[b];
+        q[b] = (x & 0x000000000000FFFFULL)
+            | ((x & 0x00000000FFF00000ULL) >> 4) | ((x & 0x00000000000F0000ULL) << 12)
+            | ((x & 0x0000FF0000000000ULL) >> 8) | ((x & 0x000000FF00000000ULL) << 8)
+            | ((x & 0xF000000000000000ULL) >> 12) | ((x & 0x0FFF000000000000ULL) << 4);
+    }
+}
+
+// Rotate each row of the bitsliced state right by its row index
+static void inv_shift_rows(uint64_t *q)
+{
+    for (unsigned b = 0U; b < 8U; ++b)
+    {
+        uint64_t x = q[b];
+        q[b] = (x & 0x000000000000FFFFULL)
+            | ((x & 0x000000000FFF0000ULL) << 4) | ((x & 0x00000000F0000000ULL) >> 12)
+            | ((x & 0x0000FF0000000000ULL) >> 8) | ((x & 0x000000FF00000000ULL) << 8)
+            | ((x & 0x000F000000000000ULL) << 12) | ((x & 0xFFF0000000000000ULL) >> 4);
+    }
+}
+
+// Multiply every bitsliced byte by x in GF(2^8)
+static void xtime(uint64_t *q)
+{
+    uint64_t hi = q[7];
+    q[7] = q[6];
+    q[6] = q[5];
+    q[5] = q[4];
+    q[4] = q[3] ^ hi;
+    q[3] = q[2] ^ hi;
+    q[2] = q[1];
+    q[1] = q[0] ^ hi;
+    q[0] = hi;
+}
+
+// Mix the columns of the bitsliced state
+// Rotating a plane right by 16 bits moves row r + 1 onto row r.
+static void mix_columns(uint64_t *q)
+{
+    uint64_t t[8];
+    uint64_t r[8];
+    for (unsigned b = 0U; b < 8U; ++b)
+    {
+        r[b] = rtr64(q[b], 16U);
+        t[b] = q[b] ^ r[b];
+    }
+
+    // out = 2 * (a0 ^ a1) ^ a1 ^ a2 ^ a3
+    xtime(t);
+    for (unsigned b = 0U; b < 8U; ++b)
+    {
+        q[b] = t[b] ^ r[b] ^ rtr64(q[b], 32U) ^ rtr64(q[b], 48U);
+    }
+}
+
+// Inverse mix the columns of the bitsliced state
+// InvMixColumns(a) = MixColumns(a ^ 4 * (a ^ (a rotated by two rows))).
+static void inv_mix_columns(uint64_t *q)
+{
+    uint64_t t[8];
+    for (unsigned b = 0U; b < 8U; ++b)
+    {
+        t[b] = q[b] ^ rtr64(q[b], 32U);
+    }
+
+    xtime(t);
+    xtime(t);
+    for (unsigned b = 0U; b < 8U; ++b)
+    {
+        q[b] ^= t[b];
+    }
+
+    mix_columns(q);
+}
+
+// Add a bitsliced round key
+static void add_round_key(uint64_t *q, const uint64_t *key)
+{
+    for (unsigned b = 0U; b < 8U; ++b)
+    {
+        q[b] ^= key[b];
+    }
+}
+
+// Transpose an 8x8 bit matrix (bit 8 * i + j to bit 8 * j + i)
+static uint64_t transpose8(uint64_t x)
+{
+    uint64_t t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+    x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+    x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+    x ^= t ^ (t << 28);
+    return x;
+}
+
+// Convert up to four blocks into bitsliced form
+// Byte k of each plane covers row k / 2, columns 2 * (k % 2) and the next,
+// for all four blocks; one bit transpose splits those 8 bytes into planes.
+static void load_sliced(uint64_t *q, const uint8_t *blocks, size_t count)
+{
+    for (unsigned b = 0U; b < 8U; ++b)
+    {
+        q[b] = 0U;
+    }
+
+    for (unsigned k = 0U; k < 8U; ++k)
+    {
+        unsigned row = k / 2U;
+        unsigned col = (k % 2U) * 2U;
+
+        uint64_t x = 0U;
+        for (unsigned i = 0U; i < 8U; ++i)
+        {
+            unsigned block = i % 4U;
+            if (block < count)
+            {
+                x |= static_cast<uint64_t>(blocks[block * 16U + (col + i / 4U) * 4U + row]) << (i * 8U);
+            }
+        }
+
+        x = transpose8(x);
+        for (unsigned b = 0U; b < 8U; ++b)
+        {
+            q[b] |= ((x >> (b * 8U)) & 0xFFU) << (k * 8U);
+        }
+    }
+}
+
+// Convert up to four blocks out of bitsliced form
+static void store_sliced(const uint64_t *q, uint8_t *blocks, size_t count)
+{
+    for (unsigned k = 0U; k < 8U; ++k)
+    {
+        unsigned row = k / 2U;
+        unsigned col = (k % 2U) * 2U;
+
+        uint64_t x = 0U;
+        for (unsigned b = 0U; b < 8U; ++b)
+        {
+            x |= ((q[b] >> (k * 8U)) & 0xFFU) << (b * 8U);
+        }
+
+        x = transpose8(x);
+        for (unsigned i = 0U; i < 8U; ++i)
+        {
+            unsigned block = i % 4U;
+            if (block < count)
+            {
+                blocks[block * 16U + (col + i / 4U) * 4U + row] = static_cast<uint8_t>(x >> (i * 8U));
+            }
+        }
+    }
+}
+
+// Apply the S-box to the four bytes of a key schedule word
+static void sub_word(uint8_t *word)
+{
+    uint64_t q[8] = {};
+    for (unsigned j = 0U; j < 4U; ++j)
+    {
+        for (unsigned b = 0U; b < 8U; ++b)
+        {
+            q[b] |= static_cast<uint64_t>((word[j] >> b) & 1U) << j;
+        }
+    }
+
+    sub_bytes(q);
+    for (unsigned j = 0U; j < 4U; ++j)
+    {
+        uint8_t value = 0U;
+        for (unsigned b = 0U; b < 8U; ++b)
+        {
+            value |= static_cast<uint8_t>(((q[b] >> j) & 1U) << b);
+        }
+
+        word[j] = value;
+    }
+}
+
+// Expand the key into the encryption round keys
+static void expand_key(AesSchedule &schedule, const uint8_t *key, size_t size)
+{
+    size_t nk = size / 4U;
+    size_t words = 4U * (nk + 7U);
+    uint8_t *w = &schedule.enc[0][0];
+    schedule.rounds = nk + 6U;
+
+    std::memcpy(w, key, size);
+
+    uint8_t rcon = 0x01U;
+    for (size_t i = nk; i < words; ++i)
+    {
+        uint8_t t[4] = { w[i * 4U - 4U], w[i * 4U - 3U], w[i * 4U - 2U], w[i * 4U - 1U] };
+        if (i % nk == 0U)
+        {
+            // RotWord, SubWord and the round constant
+            uint8_t first = t[0];
+            t[0] = t[1];
+            t[1] = t[2];
+            t[2] = t[3];
+            t[3] = first;
+            sub_word(t);
+            t[0] ^= rcon;
+            rcon = static_cast<uint8_t>((rcon << 1) ^ ((rcon & 0x80U) ? 0x1BU : 0x00U));
+        }
+        else if (nk > 6U && i % nk == 4U)
+        {
+            sub_word(t);
+        }
+
+        for (size_t j = 0U; j < 4U; ++j)
+        {
+            w[i * 4U + j] = w[(i - nk) * 4U + j] ^ t[j];
+        }
+    }
+}
+
+// Increment a 128-bit big-endian counter block
+static void increment(uint8_t *counter)
+{
+    for (size_t i = 16U; i > 0U && ++counter[i - 1U] == 0U; --i)
+    {
+    }
+}
+
+// XOR blocks of data
+static void xor_bytes(uint8_t *output, const uint8_t *a, const uint8_t *b, size_t size)
+{
+    for (size_t i = 0U; i < size; ++i)
+    {
+        output[i] = a[i] ^ b[i];
+    }
+}
+
+// Prepare the bitsliced round keys, replicated across the four block slots
+static void prepare_sliced(AesSchedule &schedule)
+{
+    for (size_t r = 0U; r <= schedule.rounds; ++r)
+    {
+        uint8_t keys[64];
+        for (size_t i = 0U; i < 4U; ++i)
+        {
+            std::memcpy(keys + i * 16U, schedule.enc[r], 16U);
+        }
+
+        load_sliced(schedule.sliced[r], keys, 4U);
+    }
+}
+
+// Encrypt up to four blocks with the bitsliced cipher
+static void encrypt_sliced(const AesSchedule &schedule, const uint8_t *input, uint8_t *output, size_t count)
+{
+    uint64_t q[8];
+    load_sliced(q, input, count);
+
+    add_round_key(q, schedule.sliced[0]);
+    for (size_t r = 1U; r < schedule.rounds; ++r)
+    {
+        sub_bytes(q);
+        shift_rows(q);
+        mix_columns(q);
+        add_round_key(q, schedule.sliced[r]);
+    }
+
+    sub_bytes(q);
+    shift_rows(q);
+    add_round_key(q, schedule.sliced[schedule.rounds]);
+
+    store_sliced(q, output, count);
+}
+
+// Decrypt up to four blocks with the bitsliced cipher
+static void decrypt_sliced(const AesSchedule &schedule, const uint8_t *input, uint8_t *output, size_t count)
+{
+    uint64_t q[8];
+    load_sliced(q, input, count);
+
+    add_round_key(q, schedule.sliced[schedule.rounds]);
+    for (size_t r = schedule.rounds - 1U; r > 0U; --r)
+    {
+        inv_shift_rows(q);
+        inv_sub_bytes(q);
+        add_round_key(q, schedule.sliced[r]);
+        inv_mix_columns(q);
+    }
+
+    inv_shift_rows(q);
+    inv_sub_bytes(q);
+    add_round_key(q, schedule.sliced[0]);
+
+    store_sliced(q, output, count);
+}
+
+// Encrypt blocks in ECB mode with the bitsliced cipher
+static void ecb_encrypt_sliced(const AesSchedule &schedule, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+    for (; blocks; input += 64U, output += 64U)
+    {
+        size_t count = (blocks < 4U) ? blocks : 4U;
+        encrypt_sliced(schedule, input, output, count);
+        blocks -= count;
+    }
+}
+
+// Decrypt blocks in ECB mode with the bitsliced cipher
+static void ecb_decrypt_sliced(const AesSchedule &schedule, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+    for (; blocks; input += 64U, output += 64U)
+    {
+        size_t count = (blocks < 4U) ? blocks : 4U;
+        decrypt_sliced(schedule, input, output, count);
+        blocks -= count;
+    }
+}
+
+// Encrypt blocks in CBC mode with the bitsliced cipher
+static void cbc_encrypt_sliced(const AesSchedule &schedule, uint8_t *iv, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+    // Each block depends on the previous one, so only one slot is used
+    for (; blocks; --blocks, input += 16U, output += 16U)
+    {
+        xor_bytes(iv, iv, input, 16U);
+        encrypt_sliced(schedule, iv, iv, 1U);
+        std::memcpy(output, iv, 16U);
+    }
+}
+
+// Decrypt blocks in CBC mode with the bitsliced cipher
+static void cbc_decrypt_sliced(const AesSchedule &schedule, uint8_t *iv, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+    for (; blocks; input += 64U, output += 64U)
+    {
+        size_t count = (blocks < 4U) ? blocks : 4U;
+
+        // Keep the ciphertext in case the output overwrites it
+        uint8_t cipher[64];
+        uint8_t plain[64];
+        std::memcpy(cipher, input, count * 16U);
+        decrypt_sliced(schedule, cipher, plain, count);
+
+        xor_bytes(output, plain, iv, 16U);
+        xor_bytes(output + 16U, plain + 16U, cipher, (count - 1U) * 16U);
+        std::memcpy(iv, cipher + (count - 1U) * 16U, 16U);
+        blocks -= count;
+    }
+}
+
+// Process blocks in CTR mode with the bitsliced cipher
+static void ctr_sliced(const AesSchedule &schedule, uint8_t *counter, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+    for (; blocks; input += 64U, output += 64U)
+    {
+        size_t count = (blocks < 4U) ? blocks : 4U;
+
+        uint8_t stream[64];
+        for (size_t i = 0U; i < count; ++i)
+        {
+            std::memcpy(stream + i * 16U, counter, 16U);
+            increment(counter);
+        }
+
+        encrypt_sliced(schedule, stream, stream, count);
+        xor_bytes(output, input, stream, count * 16U);
+        blocks -= count;
+    }
+}
+
+#if defined(CRYPTLIB_X86)
+// Prepare the decryption round keys for the equivalent inverse cipher
+CRYPTLIB_TARGET("aes,ssse3")
+static void prepare_aesni(AesSchedule &schedule)
+{
+    size_t rounds = schedule.rounds;
+    std::memcpy(schedule.dec[0], schedule.enc[rounds], 16U);
+    for (size_t r = 1U; r < rounds; ++r)
+    {
+        __m128i key = _mm_loadu_si128(reinterpret_cast<const __m128i*>(schedule.enc[rounds - r]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(schedule.dec[r]), _mm_aesimc_si128(key));
+    }
+
+    std::memcpy(schedule.dec[rounds], schedule.enc[0], 16U);
+}
+
+// Encrypt blocks in ECB mode with AES-NI
+CRYPTLIB_TARGET("aes,ssse3")
+static void ecb_encrypt_aesni(const AesSchedule &schedule, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+    __m128i keys[15];
+    load_keys(keys, schedule.enc, schedule.rounds);
+
+    const __m128i *in = reinterpret_cast<const __m128i*>(input);
+    __m128i *out = reinterpret_cast<__m128i*>(output);
+    for (; blocks >= 8U; blocks -= 8U, in += 8, out += 8)
+    {
+        Aes8 x = load8(in);
+        encrypt8_aesni(keys, schedule.rounds, x);
+        store8(out, x);
+    }
+
+    for (; blocks; --blocks, ++in, ++out)
+    {
+        _mm_storeu_si128(out, encrypt_aesni(keys, schedule.rounds, _mm_loadu_si128(in)));
+    }
+}
+
+// Decrypt blocks in ECB mode with AES-NI
+CRYPTLIB_TARGET("aes,ssse3")
+static void ecb_decrypt_aesni(const AesSchedule &schedule, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+    __m128i keys[15];
+    load_keys(keys, schedule.dec, schedule.rounds);
+
+    const __m128i *in = reinterpret_cast<const __m128i*>(input);
+    __m128i *out = reinterpret_cast<__m128i*>(output);
+    for (; blocks >= 8U; blocks -= 8U, in += 8, out += 8)
+    {
+        Aes8 x = load8(in);
+        decrypt8_aesni(keys, schedule.rounds, x);
+        store8(out, x);
+    }
+
+    for (; blocks; --blocks, ++in, ++out)
+    {
+        _mm_storeu_si128(out, decrypt_aesni(keys, schedule.rounds, _mm_loadu_si128(in)));
+    }
+}
+
+// Encrypt blocks in CBC mode with AES-NI
+CRYPTLIB_TARGET("aes,ssse3")
+static void cbc_encrypt_aesni(const AesSchedule &schedule, uint8_t *iv, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+    __m128i keys[15];
+    load_keys(keys, schedule.enc, schedule.rounds);
+
+    // Each block depends on the previous one, so there is nothing to interleave
+    const __m128i *in = reinterpret_cast<const __m128i*>(input);
+    __m128i *out = reinterpret_cast<__m128i*>(output);
+    __m128i chain = _mm_loadu_si128(reinterpret_cast<const __m128i*>(iv));
+    for (; blocks; --blocks, ++in, ++out)
+    {
+        chain = encrypt_aesni(keys, schedule.rounds, _mm_xor_si128(chain, _mm_loadu_si128(in)));
+        _mm_storeu_si128(out, chain);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(iv), chain);
+}
+
+// Decrypt blocks in CBC mode with AES-NI
+CRYPTLIB_TARGET("aes,ssse3")
+static void cbc_decrypt_aesni(const AesSchedule &schedule, uint8_t *iv, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+    __m128i keys[15];
+    load_keys(keys, schedule.dec, schedule.rounds);
+
+    const __m128i *in = reinterpret_cast<const __m128i*>(input);
+    __m128i *out = reinterpret_cast<__m128i*>(output);
+    __m128i chain = _mm_loadu_si128(reinterpret_cast<const __m128i*>(iv));
+    for (; blocks >= 8U; blocks -= 8U, in += 8, out += 8)
+    {
+        // Load the ciphertext first in case the output overwrites it
+        Aes8 c = load8(in);
+        Aes8 x = c;
+        decrypt8_aesni(keys, schedule.rounds, x);
+        store8(out, xor8(x, Aes8{ chain, c.b0, c.b1, c.b2, c.b3, c.b4, c.b5, c.b6 }));
+        chain = c.b7;
+    }
+
+    for (; blocks; --blocks, ++in, ++out)
+    {
+        __m128i c = _mm_loadu_si128(in);
+        _mm_storeu_si128(out, _mm_xor_si128(decrypt_aesni(keys, schedule.rounds, c), chain));
+        chain = c;
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(iv), chain);
+}
+
+// Process blocks in CTR mode with AES-NI
+CRYPTLIB_TARGET("aes,ssse3")
+static void ctr_aesni(const AesSchedule &schedule, uint8_t *counter, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+    __m128i keys[15];
+    load_keys(keys, schedule.enc, schedule.rounds);
+
+    // Keep the counter byte-reversed so the low 64 bits can be added natively
+    const __m128i swap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i one = _mm_set_epi64x(0, 1);
+    __m128i value = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(counter)), swap);
+    uint64_t lo = static_cast<uint64_t>(_mm_cvtsi128_si64(value));
+
+    const __m128i *in = reinterpret_cast<const __m128i*>(input);
+    __m128i *out = reinterpret_cast<__m128i*>(output);
+    for (; blocks >= 8U; blocks -= 8U, in += 8, out += 8, lo += 8U)
+    {
+        Aes8 x;
+        if (lo <= UINT64_MAX - 8U)
+        {
+            // Common case: no carry into the high half within these blocks
+            x.b0 = value;
+            x.b1 = _mm_add_epi64(x.b0, one);
+            x.b2 = _mm_add_epi64(x.b1, one);
+            x.b3 = _mm_add_epi64(x.b2, one);
+            x.b4 = _mm_add_epi64(x.b3, one);
+            x.b5 = _mm_add_epi64(x.b4, one);
+            x.b6 = _mm_add_epi64(x.b5, one);
+            x.b7 = _mm_add_epi64(x.b6, one);
+            value = _mm_add_epi64(x.b7, one);
+        }
+        else
+        {
+            // Carry one block at a time across the 64-bit boundary
+            __m128i b[8];
+            for (size_t i = 0U; i < 8U; ++i)
+            {
+                b[i] = value;
+                value = _mm_add_epi64(value, one);
+                if (_mm_cvtsi128_si64(value) == 0)
+                {
+                    value = _mm_add_epi64(value, _mm_slli_si128(one, 8));
+                }
+            }
+
+            x = Aes8{ b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7] };
+        }
+
+        x.b0 = _mm_shuffle_epi8(x.b0, swap);
+        x.b1 = _mm_shuffle_epi8(x.b1, swap);
+        x.b2 = _mm_shuffle_epi8(x.b2, swap);
+        x.b3 = _mm_shuffle_epi8(x.b3, swap);
+        x.b4 = _mm_shuffle_epi8(x.b4, swap);
+        x.b5 = _mm_shuffle_epi8(x.b5, swap);
+        x.b6 = _mm_shuffle_epi8(x.b6, swap);
+        x.b7 = _mm_shuffle_epi8(x.b7, swap);
+
+        encrypt8_aesni(keys, schedule.rounds, x);
+        store8(out, xor8(x, load8(in)));
+    }
+
+    for (; blocks; --blocks, ++in, ++out)
+    {
+        __m128i stream = encrypt_aesni(keys, schedule.rounds, _mm_shuffle_epi8(value, swap));
+        _mm_storeu_si128(out, _mm_xor_si128(stream, _mm_loadu_si128(in)));
+        value = _mm_add_epi64(value, one);
+        if (_mm_cvtsi128_si64(value) == 0)
+        {
+            value = _mm_add_epi64(value, _mm_slli_si128(one, 8));
+        }
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(counter), _mm_shuffle_epi8(value, swap));
+}
+#endif
+
+/// AES backend.
+struct AesBackend
+{
+    /// Backend name.
+    const char *name;
+
+    /// Prepare the backend-specific key schedule.
+    void (*prepare)(AesSchedule &schedule);
+
+    /// ECB encryption.
+    void (*ecb_encrypt)(const AesSchedule &schedule, const uint8_t *input, uint8_t *output, size_t blocks);
+
+    /// ECB decryption.
+    void (*ecb_decrypt)(const AesSchedule &schedule, const uint8_t *input, uint8_t *output, size_t blocks);
+
+    /// CBC encryption.
+    void (*cbc_encrypt)(const AesSchedule &schedule, uint8_t *iv, const uint8_t *input, uint8_t *output, size_t blocks);
+
+    /// CBC decryption.
+    void (*cbc_decrypt)(const AesSchedule &schedule, uint8_t *iv, const uint8_t *input, uint8_t *output, size_t blocks);
+
+    /// CTR mode over whole blocks.
+    void (*ctr)(const AesSchedule &schedule, uint8_t *counter, const uint8_t *input, uint8_t *output, size_t blocks);
+};
+
+// Select the fastest backend supported by the processor
+static const AesBackend &select_backend()
+{
+    static const AesBackend backend =
+#if defined(CRYPTLIB_X86)
+        (CpuFeatures::aes() && CpuFeatures::ssse3()) ?
+            AesBackend{ "aes-ni", prepare_aesni, ecb_encrypt_aesni, ecb_decrypt_aesni, cbc_encrypt_aesni, cbc_decrypt_aesni, ctr_aesni } :
+#endif
+        AesBackend{ "bitsliced", prepare_sliced, ecb_encrypt_sliced, ecb_decrypt_sliced, cbc_encrypt_sliced, cbc_decrypt_sliced, ctr_sliced };
+    return backend;
+}
+
+Aes::Aes(const void *key, size_t size) : schedule()
+{
+    set_key(key, size);
+}
+
+Aes::~Aes()
+{
+    volatile uint8_t *wipe = reinterpret_cast<volatile uint8_t*>(&schedule);
+    for (size_t i = 0U; i < sizeof(schedule); ++i)
+    {
+        wipe[i] = 0U;
+    }
+}
+
+void Aes::set_key(const void *key, size_t size)
+{
+    if (size != 16U && size != 24U && size != 32U)
+    {
+        throw std::invalid_argument("AES key must be 16, 24 or 32 bytes");
+    }
+
+    expand_key(schedule, static_cast<const uint8_t*>(key), size);
+    select_backend().prepare(schedule);
+}
+
+size_t Aes::block_size() const
+{
+    return 16U;
+}
+
+void Aes::encrypt(const uint8_t *input, uint8_t *output, size_t blocks)
+{
+    select_backend().ecb_encrypt(schedule, input, output, blocks);
+}
+
+void Aes::decrypt(const uint8_t *input, uint8_t *output, size_t blocks)
+{
+    select_backend().ecb_decrypt(schedule, input, output, blocks);
+}
+
+void Aes::cbc_encrypt(uint8_t *iv, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+    select_backend().cbc_encrypt(schedule, iv, input, output, blocks);
+}
+
+void Aes::cbc_decrypt(uint8_t *iv, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+    select_backend().cbc_decrypt(schedule, iv, input, output, blocks);
+}
+
+void Aes::ctr(uint8_t *counter, const uint8_t *input, uint8_t *output, size_t size)
+{
+    const AesBackend &backend = select_backend();
+    size_t blocks = size / 16U;
+    backend.ctr(schedule, counter, input, output, blocks);
+
+    // Encrypt a final partial block with one more counter value
+    size_t tail = size % 16U;
+    if (tail)
+    {
+        uint8_t stream[16];
+        backend.ecb_encrypt(schedule, counter, stream, 1U);
+        increment(counter);
+        xor_bytes(output + blocks * 16U, input + blocks * 16U, stream, tail);
+    }
+}
+
+const AesSchedule &Aes::key_schedule() const
+{
+    return schedule;
+}
+
+const char *Aes::backend()
+{
+    return select_backend().name;
+}
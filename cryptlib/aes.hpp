@@ -0,0 +1,97 @@
+#pragma once
+
+#include "cipher.hpp"
+
+/// AES key schedule.
+struct AesSchedule
+{
+    /// Number of rounds (10, 12 or 14)
+    size_t rounds;
+
+    /// Encryption round keys
+    uint8_t enc[15][16];
+
+    /// Decryption round keys for the equivalent inverse cipher (AES-NI)
+    uint8_t dec[15][16];
+
+    /// Encryption round keys in bitsliced form (portable backend)
+    uint64_t sliced[15][8];
+};
+
+/// AES block cipher class (FIPS 197).
+/// Supports 128, 192 and 256-bit keys. The AES-NI backend pipelines eight
+/// independent blocks to hide the aesenc/aesdec latency in ECB, CTR and
+/// CBC decryption. The portable backend is bitsliced, processing four
+/// blocks at a time without secret-dependent table lookups or branches.
+class Aes : public BlockCipher
+{
+private:
+    /// Key schedule.
+    AesSchedule schedule;
+
+public:
+    /// Constructor.
+    /// @param key                      Pointer to the key
+    /// @param size                     Key size in bytes (16, 24 or 32)
+    Aes(const void *key, size_t size);
+
+    /// Destructor, wiping the key schedule.
+    virtual ~Aes();
+
+    /// Delete copy constructor.
+    Aes(const Aes &) = delete;
+
+    /// Delete assignment operator.
+    Aes &operator=(const Aes &) = delete;
+
+    /// Set a new key.
+    /// @param key                      Pointer to the key
+    /// @param size                     Key size in bytes (16, 24 or 32)
+    void set_key(const void *key, size_t size);
+
+    /// Get the block size.
+    /// @return                         Block size in bytes (16)
+    virtual size_t block_size() const;
+
+    /// Encrypt whole blocks independently (ECB).
+    /// @param input                    Plaintext blocks
+    /// @param output                   Ciphertext blocks (may equal input)
+    /// @param blocks                   Number of blocks
+    virtual void encrypt(const uint8_t *input, uint8_t *output, size_t blocks);
+
+    /// Decrypt whole blocks independently (ECB).
+    /// @param input                    Ciphertext blocks
+    /// @param output                   Plaintext blocks (may equal input)
+    /// @param blocks                   Number of blocks
+    virtual void decrypt(const uint8_t *input, uint8_t *output, size_t blocks);
+
+    /// Encrypt whole blocks in CBC mode.
+    /// @param iv                       Initialization vector, updated for the next call
+    /// @param input                    Plaintext blocks
+    /// @param output                   Ciphertext blocks (may equal input)
+    /// @param blocks                   Number of blocks
+    void cbc_encrypt(uint8_t *iv, const uint8_t *input, uint8_t *output, size_t blocks);
+
+    /// Decrypt whole blocks in CBC mode.
+    /// @param iv                       Initialization vector, updated for the next call
+    /// @param input                    Ciphertext blocks
+    /// @param output                   Plaintext blocks (may equal input)
+    /// @param blocks                   Number of blocks
+    void cbc_decrypt(uint8_t *iv, const uint8_t *input, uint8_t *output, size_t blocks);
+
+    /// Encrypt or decrypt data in CTR mode with a 128-bit big-endian counter.
+    /// A partial final block consumes a whole counter value.
+    /// @param counter                  Counter block, updated for the next call
+    /// @param input                    Input data
+    /// @param output                   Output data (may equal input)
+    /// @param size                     Size of the data in bytes
+    void ctr(uint8_t *counter, const uint8_t *input, uint8_t *output, size_t size);
+
+    /// Get the expanded key schedule, for modes that run the rounds themselves.
+    /// @return                         Key schedule
+    const AesSchedule &key_schedule() const;
+
+    /// Get the name of the backend selected for this processor.
+    /// @return                         Backend name ("aes-ni" or "bitsliced")
+    static const char *backend();
+};
@@ -0,0 +1,787 @@
+#include "aes_gcm.hpp"
+#include "aes_ni.hpp"
+#include "cpu_features.hpp"
+#include <cstring>
+#include <stdexcept>
+
+// Largest text of one message: 2^32 - 2 counter blocks, so the 32-bit
+// counter never wraps back to J0
+static const uint64_t max_text_size = 16ULL * 0xfffffffeULL;
+
+// Load a big-endian 64-bit word
+static inline uint64_t load_be64(const uint8_t *p)
+{
+    return (static_cast<uint64_t>(p[0]) << 56) | (static_cast<uint64_t>(p[1]) << 48) |
+        (static_cast<uint64_t>(p[2]) << 40) | (static_cast<uint64_t>(p[3]) << 32) |
+        (static_cast<uint64_t>(p[4]) << 24) | (static_cast<uint64_t>(p[5]) << 16) |
+        (static_cast<uint64_t>(p[6]) << 8) | static_cast<uint64_t>(p[7]);
+}
+
+// Store a big-endian 64-bit word
+static inline void store_be64(uint8_t *p, uint64_t x)
+{
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        p[i] = static_cast<uint8_t>(x >> (56U - 8U * i));
+    }
+}
+
+// Increment the low 32 bits of a counter block (inc32)
+static inline void increment32(uint8_t *counter)
+{
+    for (size_t i = 15U; i >= 12U && ++counter[i] == 0U; --i)
+    {
+    }
+}
+
+// Wipe memory in a way the compiler cannot elide
+static void wipe(void *data, size_t size)
+{
+    volatile uint8_t *p = static_cast<volatile uint8_t*>(data);
+    for (size_t i = 0U; i < size; ++i)
+    {
+        p[i] = 0U;
+    }
+}
+
+// Carry-less multiply of two 64-bit words, constant time.
+// The operands are split into four interleaved bit groups so that the
+// carries of the integer multiplications land in holes that are masked off.
+static inline uint64_t bmul64(uint64_t x, uint64_t y)
+{
+    const uint64_t m0 = 0x1111111111111111U;
+    const uint64_t m1 = 0x2222222222222222U;
+    const uint64_t m2 = 0x4444444444444444U;
+    const uint64_t m3 = 0x8888888888888888U;
+
+    uint64_t x0 = x & m0;
+    uint64_t x1 = x & m1;
+    uint64_t x2 = x & m2;
+    uint64_t x3 = x & m3;
+    uint64_t y0 = y & m0;
+    uint64_t y1 = y & m1;
+    uint64_t y2 = y & m2;
+    uint64_t y3 = y & m3;
+
+    uint64_t z0 = (x0 * y0) ^ (x1 * y3) ^ (x2 * y2) ^ (x3 * y1);
+    uint64_t z1 = (x0 * y1) ^ (x1 * y0) ^ (x2 * y3) ^ (x3 * y2);
+    uint64_t z2 = (x0 * y2) ^ (x1 * y1) ^ (x2 * y0) ^ (x3 * y3);
+    uint64_t z3 = (x0 * y3) ^ (x1 * y2) ^ (x2 * y1) ^ (x3 * y0);
+    return (z0 & m0) | (z1 & m1) | (z2 & m2) | (z3 & m3);
+}
+
+// Reverse the bits of a 64-bit word
+static inline uint64_t rev64(uint64_t x)
+{
+    x = ((x & 0x5555555555555555U) << 1) | ((x >> 1) & 0x5555555555555555U);
+    x = ((x & 0x3333333333333333U) << 2) | ((x >> 2) & 0x3333333333333333U);
+    x = ((x & 0x0F0F0F0F0F0F0F0FU) << 4) | ((x >> 4) & 0x0F0F0F0F0F0F0F0FU);
+    x = ((x & 0x00FF00FF00FF00FFU) << 8) | ((x >> 8) & 0x00FF00FF00FF00FFU);
+    x = ((x & 0x0000FFFF0000FFFFU) << 16) | ((x >> 16) & 0x0000FFFF0000FFFFU);
+    return (x << 32) | (x >> 32);
+}
+
+// Prepare the hash key for the portable backend, which only needs H itself
+static void prepare_portable(const uint8_t *h, uint8_t (*powers)[16])
+{
+    std::memcpy(powers[0], h, 16U);
+}
+
+// GHASH whole blocks with the portable constant-time multiply
+static void ghash_portable(const uint8_t (*powers)[16], uint8_t *x, const uint8_t *data, size_t blocks)
+{
+    uint64_t h1 = load_be64(powers[0]);
+    uint64_t h0 = load_be64(powers[0] + 8U);
+    uint64_t h0r = rev64(h0);
+    uint64_t h1r = rev64(h1);
+    uint64_t h2 = h0 ^ h1;
+    uint64_t h2r = h0r ^ h1r;
+
+    uint64_t y1 = load_be64(x);
+    uint64_t y0 = load_be64(x + 8U);
+    for (; blocks; --blocks, data += 16U)
+    {
+        y1 ^= load_be64(data);
+        y0 ^= load_be64(data + 8U);
+
+        // Karatsuba over the 64-bit halves; the bit-reversed products give
+        // the high halves of each 128-bit product
+        uint64_t y0r = rev64(y0);
+        uint64_t y1r = rev64(y1);
+        uint64_t y2 = y0 ^ y1;
+        uint64_t y2r = y0r ^ y1r;
+
+        uint64_t z0 = bmul64(y0, h0);
+        uint64_t z1 = bmul64(y1, h1);
+        uint64_t z2 = bmul64(y2, h2);
+        uint64_t z0h = bmul64(y0r, h0r);
+        uint64_t z1h = bmul64(y1r, h1r);
+        uint64_t z2h = bmul64(y2r, h2r);
+        z2 ^= z0 ^ z1;
+        z2h ^= z0h ^ z1h;
+        z0h = rev64(z0h) >> 1;
+        z1h = rev64(z1h) >> 1;
+        z2h = rev64(z2h) >> 1;
+
+        // Assemble the 256-bit product, shift it for the reflected bit order
+        // and reduce modulo x^128 + x^7 + x^2 + x + 1
+        uint64_t v0 = z0;
+        uint64_t v1 = z0h ^ z2;
+        uint64_t v2 = z1 ^ z2h;
+        uint64_t v3 = z1h;
+        v3 = (v3 << 1) | (v2 >> 63);
+        v2 = (v2 << 1) | (v1 >> 63);
+        v1 = (v1 << 1) | (v0 >> 63);
+        v0 = (v0 << 1);
+
+        v2 ^= v0 ^ (v0 >> 1) ^ (v0 >> 2) ^ (v0 >> 7);
+        v1 ^= (v0 << 63) ^ (v0 << 62) ^ (v0 << 57);
+        v3 ^= v1 ^ (v1 >> 1) ^ (v1 >> 2) ^ (v1 >> 7);
+        v2 ^= (v1 << 63) ^ (v1 << 62) ^ (v1 << 57);
+        y0 = v2;
+        y1 = v3;
+    }
+
+    store_be64(x, y1);
+    store_be64(x + 8U, y0);
+}
+
+// Generate keystream for up to eight blocks with the block cipher
+static void keystream_portable(Aes &aes, uint8_t *counter, uint8_t *stream, size_t count)
+{
+    for (size_t i = 0U; i < count; ++i)
+    {
+        std::memcpy(stream + i * 16U, counter, 16U);
+        increment32(counter);
+    }
+
+    aes.encrypt(stream, stream, count);
+}
+
+// Encrypt whole blocks with the portable backend
+static void encrypt_portable(Aes &aes, const uint8_t (*powers)[16], uint8_t *counter, uint8_t *x, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+    uint8_t stream[128];
+    while (blocks)
+    {
+        size_t count = (blocks < 8U) ? blocks : 8U;
+        keystream_portable(aes, counter, stream, count);
+        for (size_t i = 0U; i < count * 16U; ++i)
+        {
+            output[i] = input[i] ^ stream[i];
+        }
+
+        ghash_portable(powers, x, output, count);
+        input += count * 16U;
+        output += count * 16U;
+        blocks -= count;
+    }
+
+    wipe(stream, sizeof(stream));
+}
+
+// Decrypt whole blocks with the portable backend
+static void decrypt_portable(Aes &aes, const uint8_t (*powers)[16], uint8_t *counter, uint8_t *x, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+    uint8_t stream[128];
+    while (blocks)
+    {
+        // Hash the ciphertext before the output overwrites it
+        size_t count = (blocks < 8U) ? blocks : 8U;
+        ghash_portable(powers, x, input, count);
+        keystream_portable(aes, counter, stream, count);
+        for (size_t i = 0U; i < count * 16U; ++i)
+        {
+            output[i] = input[i] ^ stream[i];
+        }
+
+        input += count * 16U;
+        output += count * 16U;
+        blocks -= count;
+    }
+
+    wipe(stream, sizeof(stream));
+}
+
+#if defined(CRYPTLIB_X86)
+/// Unreduced 256-bit carry-less product. The middle terms are kept apart
+/// so several products can be summed before folding and reducing once.
+struct Clmul
+{
+    __m128i lo, mid, hi;
+};
+
+// Reverse the bytes of a block, giving the operand order PCLMULQDQ expects
+CRYPTLIB_TARGET("pclmul,aes,ssse3")
+static inline __m128i swap_bytes(__m128i x)
+{
+    return _mm_shuffle_epi8(x, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+// Multiply two 128-bit polynomials without reduction
+CRYPTLIB_TARGET("pclmul,aes,ssse3")
+static inline Clmul clmul(__m128i a, __m128i b)
+{
+    return Clmul{
+        _mm_clmulepi64_si128(a, b, 0x00),
+        _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10), _mm_clmulepi64_si128(a, b, 0x01)),
+        _mm_clmulepi64_si128(a, b, 0x11) };
+}
+
+// Multiply two 128-bit polynomials and add to an unreduced sum
+CRYPTLIB_TARGET("pclmul,aes,ssse3")
+static inline void clmul_add(Clmul &sum, __m128i a, __m128i b)
+{
+    sum.lo = _mm_xor_si128(sum.lo, _mm_clmulepi64_si128(a, b, 0x00));
+    sum.mid = _mm_xor_si128(sum.mid, _mm_clmulepi64_si128(a, b, 0x10));
+    sum.mid = _mm_xor_si128(sum.mid, _mm_clmulepi64_si128(a, b, 0x01));
+    sum.hi = _mm_xor_si128(sum.hi, _mm_clmulepi64_si128(a, b, 0x11));
+}
+
+// Reduce a 256-bit product modulo x^128 + x^7 + x^2 + x + 1
+CRYPTLIB_TARGET("pclmul,aes,ssse3")
+static inline __m128i reduce(const Clmul &p)
+{
+    __m128i lo = _mm_xor_si128(p.lo, _mm_slli_si128(p.mid, 8));
+    __m128i hi = _mm_xor_si128(p.hi, _mm_srli_si128(p.mid, 8));
+
+    // Shift left by one bit to account for the reflected bit order
+    __m128i a = _mm_srli_epi32(lo, 31);
+    __m128i b = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+    __m128i c = _mm_srli_si128(a, 12);
+    b = _mm_slli_si128(b, 4);
+    a = _mm_slli_si128(a, 4);
+    lo = _mm_or_si128(lo, a);
+    hi = _mm_or_si128(_mm_or_si128(hi, b), c);
+
+    // First phase of the reduction
+    a = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31), _mm_slli_epi32(lo, 30)), _mm_slli_epi32(lo, 25));
+    b = _mm_srli_si128(a, 4);
+    lo = _mm_xor_si128(lo, _mm_slli_si128(a, 12));
+
+    // Second phase of the reduction
+    a = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1), _mm_srli_epi32(lo, 2)), _mm_srli_epi32(lo, 7));
+    lo = _mm_xor_si128(lo, _mm_xor_si128(a, b));
+    return _mm_xor_si128(hi, lo);
+}
+
+// Hash up to eight blocks into the accumulator with one reduction:
+// X = (X + C0) H^n + C1 H^(n-1) + ... + C(n-1) H
+CRYPTLIB_TARGET("pclmul,aes,ssse3")
+static inline __m128i ghash_n(const __m128i *h, __m128i x, const __m128i *c, size_t n)
+{
+    Clmul sum = clmul(_mm_xor_si128(x, swap_bytes(_mm_loadu_si128(c))), h[n - 1U]);
+    for (size_t i = 1U; i < n; ++i)
+    {
+        clmul_add(sum, swap_bytes(_mm_loadu_si128(c + i)), h[n - 1U - i]);
+    }
+
+    return reduce(sum);
+}
+
+// Make eight counter blocks and advance the counter. The counter is kept
+// byte-swapped so the 32-bit add on the low lane is exactly inc32
+CRYPTLIB_TARGET("pclmul,aes,ssse3")
+static inline Aes8 counters8(__m128i &value)
+{
+    const __m128i one = _mm_set_epi32(0, 0, 0, 1);
+    Aes8 x;
+    x.b0 = value;
+    x.b1 = _mm_add_epi32(x.b0, one);
+    x.b2 = _mm_add_epi32(x.b1, one);
+    x.b3 = _mm_add_epi32(x.b2, one);
+    x.b4 = _mm_add_epi32(x.b3, one);
+    x.b5 = _mm_add_epi32(x.b4, one);
+    x.b6 = _mm_add_epi32(x.b5, one);
+    x.b7 = _mm_add_epi32(x.b6, one);
+    value = _mm_add_epi32(x.b7, one);
+    return Aes8{
+        swap_bytes(x.b0), swap_bytes(x.b1), swap_bytes(x.b2), swap_bytes(x.b3),
+        swap_bytes(x.b4), swap_bytes(x.b5), swap_bytes(x.b6), swap_bytes(x.b7) };
+}
+
+// Encrypt eight counter blocks while hashing eight ciphertext blocks.
+// Each aesenc round is paired with one carry-less multiply so the AES and
+// PCLMULQDQ units work in parallel, and the shared reduction overlaps the
+// remaining rounds. The ciphertext is read from memory as it is needed,
+// leaving the registers to the keystream.
+CRYPTLIB_TARGET("pclmul,aes,ssse3")
+static CRYPTLIB_INLINE void stitch8(const __m128i *keys, size_t rounds, const __m128i *h, Aes8 &s, const __m128i *c, __m128i &x)
+{
+    xor_key8(s, keys[0]);
+    aesenc8(s, keys[1]);
+    Clmul sum = clmul(_mm_xor_si128(x, swap_bytes(_mm_loadu_si128(c))), h[7]);
+    aesenc8(s, keys[2]);
+    clmul_add(sum, swap_bytes(_mm_loadu_si128(c + 1)), h[6]);
+    aesenc8(s, keys[3]);
+    clmul_add(sum, swap_bytes(_mm_loadu_si128(c + 2)), h[5]);
+    aesenc8(s, keys[4]);
+    clmul_add(sum, swap_bytes(_mm_loadu_si128(c + 3)), h[4]);
+    aesenc8(s, keys[5]);
+    clmul_add(sum, swap_bytes(_mm_loadu_si128(c + 4)), h[3]);
+    aesenc8(s, keys[6]);
+    clmul_add(sum, swap_bytes(_mm_loadu_si128(c + 5)), h[2]);
+    aesenc8(s, keys[7]);
+    clmul_add(sum, swap_bytes(_mm_loadu_si128(c + 6)), h[1]);
+    aesenc8(s, keys[8]);
+    clmul_add(sum, swap_bytes(_mm_loadu_si128(c + 7)), h[0]);
+    aesenc8(s, keys[9]);
+    x = reduce(sum);
+
+    for (size_t r = 10U; r < rounds; ++r)
+    {
+        aesenc8(s, keys[r]);
+    }
+
+    aesenclast8(s, keys[rounds]);
+}
+
+// Compute H^1 to H^8 in the byte-swapped representation
+CRYPTLIB_TARGET("pclmul,aes,ssse3")
+static void prepare_pclmul(const uint8_t *h, uint8_t (*powers)[16])
+{
+    __m128i key = swap_bytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h)));
+    __m128i power = key;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(powers[0]), power);
+    for (size_t i = 1U; i < 8U; ++i)
+    {
+        power = reduce(clmul(power, key));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(powers[i]), power);
+    }
+}
+
+// Load the powers of H
+CRYPTLIB_TARGET("pclmul,aes,ssse3")
+static inline void load_powers(__m128i *h, const uint8_t (*powers)[16])
+{
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        h[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(powers[i]));
+    }
+}
+
+// GHASH whole blocks with PCLMULQDQ, eight blocks per reduction
+CRYPTLIB_TARGET("pclmul,aes,ssse3")
+static void ghash_pclmul(const uint8_t (*powers)[16], uint8_t *x, const uint8_t *data, size_t blocks)
+{
+    __m128i h[8];
+    load_powers(h, powers);
+
+    __m128i y = swap_bytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x)));
+    const __m128i *in = reinterpret_cast<const __m128i*>(data);
+    for (; blocks >= 8U; blocks -= 8U, in += 8)
+    {
+        y = ghash_n(h, y, in, 8U);
+    }
+
+    if (blocks)
+    {
+        y = ghash_n(h, y, in, blocks);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(x), swap_bytes(y));
+}
+
+// Process the last one to seven blocks in parallel, discarding the
+// keystream of the unused lanes
+CRYPTLIB_TARGET("pclmul,aes,ssse3")
+static inline void tail_pclmul(const __m128i *keys, size_t rounds, __m128i &value, const __m128i *in, __m128i *out, size_t blocks)
+{
+    __m128i next = _mm_add_epi32(value, _mm_set_epi32(0, 0, 0, static_cast<int>(blocks)));
+    Aes8 s = counters8(value);
+    value = next;
+    encrypt8_aesni(keys, rounds, s);
+
+    __m128i stream[8];
+    store8(stream, s);
+    for (size_t i = 0U; i < blocks; ++i)
+    {
+        _mm_storeu_si128(out + i, _mm_xor_si128(stream[i], _mm_loadu_si128(in + i)));
+    }
+}
+
+// Encrypt whole blocks with AES-NI, stitching the GHASH of each batch of
+// ciphertext into the encryption of the next
+CRYPTLIB_TARGET("pclmul,aes,ssse3")
+static void encrypt_pclmul(Aes &aes, const uint8_t (*powers)[16], uint8_t *counter, uint8_t *x, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+    const AesSchedule &schedule = aes.key_schedule();
+    __m128i keys[15];
+    load_keys(keys, schedule.enc, schedule.rounds);
+    __m128i h[8];
+    load_powers(h, powers);
+
+    __m128i value = swap_bytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(counter)));
+    __m128i y = swap_bytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x)));
+    const __m128i *in = reinterpret_cast<const __m128i*>(input);
+    __m128i *out = reinterpret_cast<__m128i*>(output);
+
+    if (blocks >= 8U)
+    {
+        // The first batch has no earlier ciphertext to hash alongside it
+        Aes8 s = counters8(value);
+        encrypt8_aesni(keys, schedule.rounds, s);
+        store8(out, xor8(s, load8(in)));
+        blocks -= 8U;
+        in += 8;
+        out += 8;
+
+        for (; blocks >= 8U; blocks -= 8U, in += 8, out += 8)
+        {
+            s = counters8(value);
+            stitch8(keys, schedule.rounds, h, s, out - 8, y);
+            store8(out, xor8(s, load8(in)));
+        }
+
+        y = ghash_n(h, y, out - 8, 8U);
+    }
+
+    if (blocks)
+    {
+        tail_pclmul(keys, schedule.rounds, value, in, out, blocks);
+        y = ghash_n(h, y, out, blocks);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(counter), swap_bytes(value));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(x), swap_bytes(y));
+}
+
+// Decrypt whole blocks with AES-NI, stitching the GHASH of each batch of
+// ciphertext into its own decryption
+CRYPTLIB_TARGET("pclmul,aes,ssse3")
+static void decrypt_pclmul(Aes &aes, const uint8_t (*powers)[16], uint8_t *counter, uint8_t *x, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+    const AesSchedule &schedule = aes.key_schedule();
+    __m128i keys[15];
+    load_keys(keys, schedule.enc, schedule.rounds);
+    __m128i h[8];
+    load_powers(h, powers);
+
+    __m128i value = swap_bytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(counter)));
+    __m128i y = swap_bytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x)));
+    const __m128i *in = reinterpret_cast<const __m128i*>(input);
+    __m128i *out = reinterpret_cast<__m128i*>(output);
+
+    for (; blocks >= 8U; blocks -= 8U, in += 8, out += 8)
+    {
+        Aes8 s = counters8(value);
+        stitch8(keys, schedule.rounds, h, s, in, y);
+        store8(out, xor8(s, load8(in)));
+    }
+
+    // Hash the ciphertext before the output overwrites it
+    if (blocks)
+    {
+        y = ghash_n(h, y, in, blocks);
+        tail_pclmul(keys, schedule.rounds, value, in, out, blocks);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(counter), swap_bytes(value));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(x), swap_bytes(y));
+}
+#endif
+
+/// AES-GCM backend.
+struct GcmBackend
+{
+    /// Backend name.
+    const char *name;
+
+    /// Prepare the powers of the hash key H.
+    void (*prepare)(const uint8_t *h, uint8_t (*powers)[16]);
+
+    /// GHASH whole blocks.
+    void (*ghash)(const uint8_t (*powers)[16], uint8_t *x, const uint8_t *data, size_t blocks);
+
+    /// Encrypt whole blocks and GHASH the ciphertext.
+    void (*encrypt)(Aes &aes, const uint8_t (*powers)[16], uint8_t *counter, uint8_t *x, const uint8_t *input, uint8_t *output, size_t blocks);
+
+    /// GHASH whole blocks of ciphertext and decrypt them.
+    void (*decrypt)(Aes &aes, const uint8_t (*powers)[16], uint8_t *counter, uint8_t *x, const uint8_t *input, uint8_t *output, size_t blocks);
+};
+
+// Select the fastest backend supported by the processor
+static const GcmBackend &select_backend()
+{
+    static const GcmBackend backend =
+#if defined(CRYPTLIB_X86)
+        (CpuFeatures::aes() && CpuFeatures::pclmul() && CpuFeatures::ssse3()) ?
+            GcmBackend{ "aes-ni+pclmul", prepare_pclmul, ghash_pclmul, encrypt_pclmul, decrypt_pclmul } :
+#endif
+        GcmBackend{ "portable", prepare_portable, ghash_portable, encrypt_portable, decrypt_portable };
+    return backend;
+}
+
+// Derive the hash key H = E(0) and its powers
+static void hash_key(Aes &aes, uint8_t (*powers)[16])
+{
+    uint8_t h[16] = {};
+    aes.encrypt(h, h, 1U);
+    select_backend().prepare(h, powers);
+    wipe(h, sizeof(h));
+}
+
+AesGcm::AesGcm(const void *key, size_t size) :
+    aes(key, size), powers(), j0(), counter(), x(), stream(), block(), buflen(0U), aadlen(0U), textlen(0U), text(false)
+{
+    hash_key(aes, powers);
+}
+
+AesGcm::~AesGcm()
+{
+    wipe(powers, sizeof(powers));
+    wipe(j0, sizeof(j0));
+    wipe(counter, sizeof(counter));
+    wipe(x, sizeof(x));
+    wipe(stream, sizeof(stream));
+    wipe(block, sizeof(block));
+}
+
+void AesGcm::set_key(const void *key, size_t size)
+{
+    aes.set_key(key, size);
+    hash_key(aes, powers);
+}
+
+void AesGcm::start(const void *iv, size_t size)
+{
+    const uint8_t *p = static_cast<const uint8_t*>(iv);
+    const GcmBackend &backend = select_backend();
+    std::memset(x, 0, sizeof(x));
+
+    if (size == 12U)
+    {
+        // J0 = IV || 0^31 || 1
+        std::memcpy(j0, p, 12U);
+        j0[12] = j0[13] = j0[14] = 0U;
+        j0[15] = 1U;
+    }
+    else
+    {
+        // J0 = GHASH(IV || 0^s || 0^64 || [len(IV)]64)
+        backend.ghash(powers, x, p, size / 16U);
+        if (size % 16U)
+        {
+            uint8_t last[16] = {};
+            std::memcpy(last, p + size - size % 16U, size % 16U);
+            backend.ghash(powers, x, last, 1U);
+        }
+
+        uint8_t lengths[16] = {};
+        store_be64(lengths + 8U, static_cast<uint64_t>(size) * 8U);
+        backend.ghash(powers, x, lengths, 1U);
+        std::memcpy(j0, x, 16U);
+        std::memset(x, 0, sizeof(x));
+    }
+
+    std::memcpy(counter, j0, 16U);
+    increment32(counter);
+    buflen = 0U;
+    aadlen = 0U;
+    textlen = 0U;
+    text = false;
+}
+
+void AesGcm::add_aad(const void *data, size_t size)
+{
+    // The AAD is padded and closed once the text starts
+    if (text)
+    {
+        throw std::logic_error("AES-GCM AAD must precede the text");
+    }
+
+    const uint8_t *p = static_cast<const uint8_t*>(data);
+    const GcmBackend &backend = select_backend();
+    aadlen += size;
+
+    // Complete a partial block
+    if (buflen)
+    {
+        size_t n = (size < 16U - buflen) ? size : 16U - buflen;
+        std::memcpy(block + buflen, p, n);
+        buflen += n;
+        p += n;
+        size -= n;
+        if (buflen < 16U)
+        {
+            return;
+        }
+
+        backend.ghash(powers, x, block, 1U);
+        buflen = 0U;
+    }
+
+    // Hash whole blocks in place and keep the rest
+    backend.ghash(powers, x, p, size / 16U);
+    buflen = size % 16U;
+    if (buflen)
+    {
+        std::memcpy(block, p + size - buflen, buflen);
+    }
+}
+
+void AesGcm::flush()
+{
+    if (buflen)
+    {
+        std::memset(block + buflen, 0, 16U - buflen);
+        select_backend().ghash(powers, x, block, 1U);
+        buflen = 0U;
+    }
+}
+
+void AesGcm::crypt(const uint8_t *input, uint8_t *output, size_t size, bool encrypting)
+{
+    // Refuse text that would wrap the counter and reuse E(J0) as keystream
+    if (size > max_text_size - textlen)
+    {
+        throw std::invalid_argument("AES-GCM message is longer than 2^32 - 2 blocks");
+    }
+
+    // The AAD ends where the text starts
+    if (!text)
+    {
+        flush();
+        text = true;
+    }
+
+    const GcmBackend &backend = select_backend();
+    textlen += size;
+
+    // Use up the keystream of a partial block
+    for (; buflen && size; --size)
+    {
+        uint8_t in = *input++;
+        uint8_t out = in ^ stream[buflen];
+        block[buflen] = encrypting ? out : in;
+        *output++ = out;
+        if (++buflen == 16U)
+        {
+            backend.ghash(powers, x, block, 1U);
+            buflen = 0U;
+        }
+    }
+
+    // Process whole blocks
+    size_t blocks = size / 16U;
+    if (blocks)
+    {
+        if (encrypting)
+        {
+            backend.encrypt(aes, powers, counter, x, input, output, blocks);
+        }
+        else
+        {
+            backend.decrypt(aes, powers, counter, x, input, output, blocks);
+        }
+
+        input += blocks * 16U;
+        output += blocks * 16U;
+        size -= blocks * 16U;
+    }
+
+    // Start a partial block
+    if (size)
+    {
+        aes.encrypt(counter, stream, 1U);
+        increment32(counter);
+        for (size_t i = 0U; i < size; ++i)
+        {
+            uint8_t in = input[i];
+            uint8_t out = in ^ stream[i];
+            block[i] = encrypting ? out : in;
+            output[i] = out;
+        }
+
+        buflen = size;
+    }
+}
+
+void AesGcm::encrypt(const uint8_t *input, uint8_t *output, size_t size)
+{
+    crypt(input, output, size, true);
+}
+
+void AesGcm::decrypt(const uint8_t *input, uint8_t *output, size_t size)
+{
+    crypt(input, output, size, false);
+}
+
+void AesGcm::finish(uint8_t *tag, size_t size)
+{
+    if (size < min_tag_size || size > tag_size)
+    {
+        throw std::invalid_argument("AES-GCM tag must be 12 to 16 bytes");
+    }
+
+    flush();
+
+    // Hash the bit lengths of the AAD and the text
+    uint8_t lengths[16];
+    store_be64(lengths, aadlen * 8U);
+    store_be64(lengths + 8U, textlen * 8U);
+    select_backend().ghash(powers, x, lengths, 1U);
+
+    // Tag = E(J0) xor GHASH
+    uint8_t full[16];
+    aes.encrypt(j0, full, 1U);
+    for (size_t i = 0U; i < 16U; ++i)
+    {
+        full[i] ^= x[i];
+    }
+
+    std::memcpy(tag, full, size);
+    wipe(full, sizeof(full));
+}
+
+bool AesGcm::verify(const uint8_t *tag, size_t size)
+{
+    if (size < min_tag_size || size > tag_size)
+    {
+        throw std::invalid_argument("AES-GCM tag must be 12 to 16 bytes");
+    }
+
+    uint8_t expected[16];
+    finish(expected);
+
+    // Compare without an early exit
+    uint8_t diff = 0U;
+    for (size_t i = 0U; i < size; ++i)
+    {
+        diff |= static_cast<uint8_t>(expected[i] ^ tag[i]);
+    }
+
+    wipe(expected, sizeof(expected));
+    return diff == 0U;
+}
+
+void AesGcm::seal(const void *iv, size_t iv_size, const void *aad, size_t aad_size,
+    const uint8_t *input, uint8_t *output, size_t size, uint8_t *tag)
+{
+    start(iv, iv_size);
+    add_aad(aad, aad_size);
+    encrypt(input, output, size);
+    finish(tag);
+}
+
+bool AesGcm::open(const void *iv, size_t iv_size, const void *aad, size_t aad_size,
+    const uint8_t *input, uint8_t *output, size_t size, const uint8_t *tag)
+{
+    start(iv, iv_size);
+    add_aad(aad, aad_size);
+    decrypt(input, output, size);
+    if (!verify(tag))
+    {
+        wipe(output, size);
+        return false;
+    }
+
+    return true;
+}
+
+const char *AesGcm::backend()
+{
+    return select_backend().name;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "aes.hpp"
+
+/// AES-GCM authenticated encryption class (NIST SP 800-38D).
+/// With AES-NI and PCLMULQDQ, the CTR keystream and GHASH run stitched
+/// in one loop over eight blocks, multiplying by precomputed powers of
+/// H so the eight products share a single reduction. Without them, the
+/// keystream comes from Aes and GHASH uses a constant-time carry-less
+/// multiply built from integer multiplications, with no tables.
+///
+/// A message may be up to 2^32 - 2 blocks (about 64 GiB); longer text
+/// is rejected with std::invalid_argument rather than wrapping the
+/// counter. Tags are 12 to 16 bytes, as SP 800-38D recommends.
+///
+/// A message is processed as start(), any number of add_aad() calls,
+/// any number of encrypt() or decrypt() calls, then finish() or verify().
+/// add_aad() after encrypt() or decrypt() throws std::logic_error.
+class AesGcm
+{
+public:
+    /// Full tag size in bytes.
+    static const size_t tag_size = 16U;
+
+    /// Shortest tag size accepted by finish() and verify().
+    static const size_t min_tag_size = 12U;
+
+private:
+    /// Block cipher.
+    Aes aes;
+
+    /// Powers of the hash key H, in the backend's format.
+    uint8_t powers[8][16];
+
+    /// Pre-counter block J0.
+    uint8_t j0[16];
+
+    /// Counter block for the next keystream block.
+    uint8_t counter[16];
+
+    /// GHASH accumulator.
+    uint8_t x[16];
+
+    /// Keystream of the current partial block.
+    uint8_t stream[16];
+
+    /// Partial block of AAD or ciphertext awaiting GHASH.
+    uint8_t block[16];
+
+    /// Bytes in the partial block.
+    size_t buflen;
+
+    /// AAD size in bytes.
+    uint64_t aadlen;
+
+    /// Text size in bytes.
+    uint64_t textlen;
+
+    /// True once encryption or decryption has started.
+    bool text;
+
+    /// GHASH the partial block, zero padded.
+    void flush();
+
+    /// Process data in CTR mode and GHASH the ciphertext.
+    /// @param input                    Input data
+    /// @param output                   Output data (may equal input)
+    /// @param size                     Size of the data in bytes
+    /// @param encrypting               True to encrypt, false to decrypt
+    void crypt(const uint8_t *input, uint8_t *output, size_t size, bool encrypting);
+
+public:
+    /// Constructor.
+    /// @param key                      Pointer to the key
+    /// @param size                     Key size in bytes (16, 24 or 32)
+    AesGcm(const void *key, size_t size);
+
+    /// Destructor, wiping the key material.
+    ~AesGcm();
+
+    /// Delete copy constructor.
+    AesGcm(const AesGcm &) = delete;
+
+    /// Delete assignment operator.
+    AesGcm &operator=(const AesGcm &) = delete;
+
+    /// Set a new key.
+    /// @param key                      Pointer to the key
+    /// @param size                     Key size in bytes (16, 24 or 32)
+    void set_key(const void *key, size_t size);
+
+    /// Start a new message.
+    /// @param iv                       Pointer to the IV (nonce)
+    /// @param size                     IV size in bytes (12 recommended)
+    void start(const void *iv, size_t size);
+
+    /// Add additional authenticated data. Must precede encrypt() and decrypt();
+    /// a later call throws std::logic_error.
+    /// @param data                     Pointer to the data
+    /// @param size                     Size of the data in bytes
+    void add_aad(const void *data, size_t size);
+
+    /// Encrypt data.
+    /// @param input                    Plaintext
+    /// @param output                   Ciphertext (may equal input)
+    /// @param size                     Size of the data in bytes
+    void encrypt(const uint8_t *input, uint8_t *output, size_t size);
+
+    /// Decrypt data. The plaintext must not be used until verify() succeeds.
+    /// @param input                    Ciphertext
+    /// @param output                   Plaintext (may equal input)
+    /// @param size                     Size of the data in bytes
+    void decrypt(const uint8_t *input, uint8_t *output, size_t size);
+
+    /// Finish the message and compute the tag.
+    /// @param tag                      Output tag
+    /// @param size                     Tag size in bytes (12 to 16)
+    void finish(uint8_t *tag, size_t size = 16U);
+
+    /// Finish the message and check the tag in constant time.
+    /// @param tag                      Expected tag
+    /// @param size                     Tag size in bytes (12 to 16)
+    /// @return                         True if the tag matches
+    bool verify(const uint8_t *tag, size_t size = 16U);
+
+    /// Encrypt and authenticate a whole message.
+    /// @param iv                       Pointer to the IV (nonce)
+    /// @param iv_size                  IV size in bytes
+    /// @param aad                      Additional authenticated data
+    /// @param aad_size                 AAD size in bytes
+    /// @param input                    Plaintext
+    /// @param output                   Ciphertext (may equal input)
+    /// @param size                     Size of the plaintext in bytes
+    /// @param tag                      Output 16-byte tag
+    void seal(const void *iv, size_t iv_size, const void *aad, size_t aad_size,
+        const uint8_t *input, uint8_t *output, size_t size, uint8_t *tag);
+
+    /// Authenticate and decrypt a whole message. On failure, the output is zeroed.
+    /// @param iv                       Pointer to the IV (nonce)
+    /// @param iv_size                  IV size in bytes
+    /// @param aad                      Additional authenticated data
+    /// @param aad_size                 AAD size in bytes
+    /// @param input                    Ciphertext
+    /// @param output                   Plaintext (may equal input)
+    /// @param size                     Size of the ciphertext in bytes
+    /// @param tag                      Expected 16-byte tag
+    /// @return                         True if the tag matches
+    bool open(const void *iv, size_t iv_size, const void *aad, size_t aad_size,
+        const uint8_t *input, uint8_t *output, size_t size, const uint8_t *tag);
+
+    /// Get the name of the backend selected for this processor.
+    /// @return                         Backend name ("aes-ni+pclmul" or "portable")
+    static const char *backend();
+};
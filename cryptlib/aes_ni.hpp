@@ -0,0 +1,183 @@
+#pragma once
+
+#include "aes.hpp"
+#include "cpu_features.hpp"
+
+// AES-NI helpers shared by the AES modes.
+
+#if defined(CRYPTLIB_X86)
+#include <immintrin.h>
+
+// Encrypt one block with AES-NI
+CRYPTLIB_TARGET("aes,ssse3")
+inline __m128i encrypt_aesni(const __m128i *keys, size_t rounds, __m128i block)
+{
+    block = _mm_xor_si128(block, keys[0]);
+    for (size_t r = 1U; r < rounds; ++r)
+    {
+        block = _mm_aesenc_si128(block, keys[r]);
+    }
+
+    return _mm_aesenclast_si128(block, keys[rounds]);
+}
+
+// Decrypt one block with AES-NI (equivalent inverse cipher)
+CRYPTLIB_TARGET("aes,ssse3")
+inline __m128i decrypt_aesni(const __m128i *keys, size_t rounds, __m128i block)
+{
+    block = _mm_xor_si128(block, keys[0]);
+    for (size_t r = 1U; r < rounds; ++r)
+    {
+        block = _mm_aesdec_si128(block, keys[r]);
+    }
+
+    return _mm_aesdeclast_si128(block, keys[rounds]);
+}
+
+/// Eight blocks held in registers.
+/// Named members rather than an array, so compilers keep them in
+/// registers instead of spilling them through the stack every round.
+struct Aes8
+{
+    __m128i b0, b1, b2, b3, b4, b5, b6, b7;
+};
+
+// Load eight blocks
+CRYPTLIB_TARGET("aes,ssse3")
+inline Aes8 load8(const __m128i *p)
+{
+    return Aes8{
+        _mm_loadu_si128(p), _mm_loadu_si128(p + 1), _mm_loadu_si128(p + 2), _mm_loadu_si128(p + 3),
+        _mm_loadu_si128(p + 4), _mm_loadu_si128(p + 5), _mm_loadu_si128(p + 6), _mm_loadu_si128(p + 7) };
+}
+
+// Store eight blocks
+CRYPTLIB_TARGET("aes,ssse3")
+inline void store8(__m128i *p, const Aes8 &x)
+{
+    _mm_storeu_si128(p, x.b0);
+    _mm_storeu_si128(p + 1, x.b1);
+    _mm_storeu_si128(p + 2, x.b2);
+    _mm_storeu_si128(p + 3, x.b3);
+    _mm_storeu_si128(p + 4, x.b4);
+    _mm_storeu_si128(p + 5, x.b5);
+    _mm_storeu_si128(p + 6, x.b6);
+    _mm_storeu_si128(p + 7, x.b7);
+}
+
+// XOR eight blocks
+CRYPTLIB_TARGET("aes,ssse3")
+inline Aes8 xor8(const Aes8 &x, const Aes8 &y)
+{
+    return Aes8{
+        _mm_xor_si128(x.b0, y.b0), _mm_xor_si128(x.b1, y.b1), _mm_xor_si128(x.b2, y.b2), _mm_xor_si128(x.b3, y.b3),
+        _mm_xor_si128(x.b4, y.b4), _mm_xor_si128(x.b5, y.b5), _mm_xor_si128(x.b6, y.b6), _mm_xor_si128(x.b7, y.b7) };
+}
+
+// Add a round key to eight blocks
+CRYPTLIB_TARGET("aes,ssse3")
+inline void xor_key8(Aes8 &x, __m128i k)
+{
+    x.b0 = _mm_xor_si128(x.b0, k);
+    x.b1 = _mm_xor_si128(x.b1, k);
+    x.b2 = _mm_xor_si128(x.b2, k);
+    x.b3 = _mm_xor_si128(x.b3, k);
+    x.b4 = _mm_xor_si128(x.b4, k);
+    x.b5 = _mm_xor_si128(x.b5, k);
+    x.b6 = _mm_xor_si128(x.b6, k);
+    x.b7 = _mm_xor_si128(x.b7, k);
+}
+
+// Run one encryption round on eight blocks
+CRYPTLIB_TARGET("aes,ssse3")
+inline void aesenc8(Aes8 &x, __m128i k)
+{
+    x.b0 = _mm_aesenc_si128(x.b0, k);
+    x.b1 = _mm_aesenc_si128(x.b1, k);
+    x.b2 = _mm_aesenc_si128(x.b2, k);
+    x.b3 = _mm_aesenc_si128(x.b3, k);
+    x.b4 = _mm_aesenc_si128(x.b4, k);
+    x.b5 = _mm_aesenc_si128(x.b5, k);
+    x.b6 = _mm_aesenc_si128(x.b6, k);
+    x.b7 = _mm_aesenc_si128(x.b7, k);
+}
+
+// Run the final encryption round on eight blocks
+CRYPTLIB_TARGET("aes,ssse3")
+inline void aesenclast8(Aes8 &x, __m128i k)
+{
+    x.b0 = _mm_aesenclast_si128(x.b0, k);
+    x.b1 = _mm_aesenclast_si128(x.b1, k);
+    x.b2 = _mm_aesenclast_si128(x.b2, k);
+    x.b3 = _mm_aesenclast_si128(x.b3, k);
+    x.b4 = _mm_aesenclast_si128(x.b4, k);
+    x.b5 = _mm_aesenclast_si128(x.b5, k);
+    x.b6 = _mm_aesenclast_si128(x.b6, k);
+    x.b7 = _mm_aesenclast_si128(x.b7, k);
+}
+
+// Encrypt eight independent blocks with AES-NI, interleaving the rounds
+// so each aesenc issues while the previous block's is still in flight
+CRYPTLIB_TARGET("aes,ssse3")
+inline void encrypt8_aesni(const __m128i *keys, size_t rounds, Aes8 &x)
+{
+    xor_key8(x, keys[0]);
+    for (size_t r = 1U; r < rounds; ++r)
+    {
+        aesenc8(x, keys[r]);
+    }
+
+    aesenclast8(x, keys[rounds]);
+}
+
+// Run one decryption round on eight blocks
+CRYPTLIB_TARGET("aes,ssse3")
+inline void aesdec8(Aes8 &x, __m128i k)
+{
+    x.b0 = _mm_aesdec_si128(x.b0, k);
+    x.b1 = _mm_aesdec_si128(x.b1, k);
+    x.b2 = _mm_aesdec_si128(x.b2, k);
+    x.b3 = _mm_aesdec_si128(x.b3, k);
+    x.b4 = _mm_aesdec_si128(x.b4, k);
+    x.b5 = _mm_aesdec_si128(x.b5, k);
+    x.b6 = _mm_aesdec_si128(x.b6, k);
+    x.b7 = _mm_aesdec_si128(x.b7, k);
+}
+
+// Run the final decryption round on eight blocks
+CRYPTLIB_TARGET("aes,ssse3")
+inline void aesdeclast8(Aes8 &x, __m128i k)
+{
+    x.b0 = _mm_aesdeclast_si128(x.b0, k);
+    x.b1 = _mm_aesdeclast_si128(x.b1, k);
+    x.b2 = _mm_aesdeclast_si128(x.b2, k);
+    x.b3 = _mm_aesdeclast_si128(x.b3, k);
+    x.b4 = _mm_aesdeclast_si128(x.b4, k);
+    x.b5 = _mm_aesdeclast_si128(x.b5, k);
+    x.b6 = _mm_aesdeclast_si128(x.b6, k);
+    x.b7 = _mm_aesdeclast_si128(x.b7, k);
+}
+
+// Decrypt eight independent blocks with AES-NI, interleaving the rounds
+CRYPTLIB_TARGET("aes,ssse3")
+inline void decrypt8_aesni(const __m128i *keys, size_t rounds, Aes8 &x)
+{
+    xor_key8(x, keys[0]);
+    for (size_t r = 1U; r < rounds; ++r)
+    {
+        aesdec8(x, keys[r]);
+    }
+
+    aesdeclast8(x, keys[rounds]);
+}
+
+// Load round keys into registers
+CRYPTLIB_TARGET("aes,ssse3")
+inline void load_keys(__m128i *keys, const uint8_t (*source)[16], size_t rounds)
+{
+    for (size_t r = 0U; r <= rounds; ++r)
+    {
+        keys[r] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source[r]));
+    }
+}
+#endif
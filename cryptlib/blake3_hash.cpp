@@ -0,0 +1,964 @@
+#include "blake3_hash.hpp"
+#include "hash_lanes.hpp"
+#include <cstring>
+#include <thread>
+
+// Domain separation flags
+static const uint8_t chunk_start = 1U;
+static const uint8_t chunk_end = 2U;
+static const uint8_t parent = 4U;
+static const uint8_t root = 8U;
+
+// Most chunks or parents hashed by one hash_many call
+static const size_t max_degree = 16U;
+
+// Smallest subtree split between two threads
+static const size_t parallel_min = 256U * 1024U;
+
+// Initialisation vector, shared with SHA256
+static const uint32_t iv[8] =
+{
+    0x6A09E667U, 0xBB67AE85U, 0x3C6EF372U, 0xA54FF53AU,
+    0x510E527FU, 0x9B05688CU, 0x1F83D9ABU, 0x5BE0CD19U
+};
+
+// Message word order of each round
+static const uint8_t schedule[7][16] =
+{
+    {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+    {  2,  6,  3, 10,  7,  0,  4, 13,  1, 11, 12,  5,  9, 14, 15,  8 },
+    {  3,  4, 10, 12, 13,  2,  7, 14,  6,  5,  9,  0, 11, 15,  8,  1 },
+    { 10,  7, 12,  9, 14,  3, 13, 15,  4,  0, 11,  2,  5,  8,  1,  6 },
+    { 12, 13,  9, 11, 15, 10, 14,  8,  7,  2,  5,  3,  0,  1,  6,  4 },
+    {  9, 14, 11,  5,  8, 12, 15,  1, 13,  3,  0, 10,  2,  6,  4,  7 },
+    { 11, 15,  5,  0,  1,  9,  8,  6, 14, 10,  2, 12,  3,  4,  7, 13 }
+};
+
+// Rotate right
+static inline uint32_t rtr(uint32_t x, int c)
+{
+    return (x >> c) | (x << (32 - c));
+}
+
+// Read a little-endian word
+static inline uint32_t load32(const uint8_t *p)
+{
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+        (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Write little-endian words
+static inline void store32(uint8_t *p, const uint32_t *words, size_t count)
+{
+    for (size_t i = 0U; i < count * 4U; ++i)
+    {
+        p[i] = static_cast<uint8_t>(words[i / 4U] >> ((i % 4U) * 8U));
+    }
+}
+
+// Mix a column or diagonal of the state
+static inline void g(uint32_t *v, size_t a, size_t b, size_t c, size_t d, uint32_t x, uint32_t y)
+{
+    v[a] += v[b] + x;
+    v[d] = rtr(v[d] ^ v[a], 16);
+    v[c] += v[d];
+    v[b] = rtr(v[b] ^ v[c], 12);
+    v[a] += v[b] + y;
+    v[d] = rtr(v[d] ^ v[a], 8);
+    v[c] += v[d];
+    v[b] = rtr(v[b] ^ v[c], 7);
+}
+
+// Compress one block, writing the 16-word extended output
+static void compress(const uint32_t *cv, const uint8_t *block, uint8_t blocklen, uint64_t counter, uint8_t flags, uint32_t *out)
+{
+    uint32_t m[16];
+    for (size_t i = 0U; i < 16U; ++i)
+    {
+        m[i] = load32(block + i * 4U);
+    }
+
+    uint32_t v[16] =
+    {
+        cv[0], cv[1], cv[2], cv[3], cv[4], cv[5], cv[6], cv[7],
+        iv[0], iv[1], iv[2], iv[3],
+        static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32), blocklen, flags
+    };
+
+    for (size_t r = 0U; r < 7U; ++r)
+    {
+        const uint8_t *s = schedule[r];
+        g(v, 0U, 4U, 8U, 12U, m[s[0]], m[s[1]]);
+        g(v, 1U, 5U, 9U, 13U, m[s[2]], m[s[3]]);
+        g(v, 2U, 6U, 10U, 14U, m[s[4]], m[s[5]]);
+        g(v, 3U, 7U, 11U, 15U, m[s[6]], m[s[7]]);
+        g(v, 0U, 5U, 10U, 15U, m[s[8]], m[s[9]]);
+        g(v, 1U, 6U, 11U, 12U, m[s[10]], m[s[11]]);
+        g(v, 2U, 7U, 8U, 13U, m[s[12]], m[s[13]]);
+        g(v, 3U, 4U, 9U, 14U, m[s[14]], m[s[15]]);
+    }
+
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        out[i] = v[i] ^ v[i + 8U];
+        out[i + 8U] = v[i + 8U] ^ cv[i];
+    }
+}
+
+// Compress one block into the chaining value
+static void compress_in_place(uint32_t *cv, const uint8_t *block, uint8_t blocklen, uint64_t counter, uint8_t flags)
+{
+    uint32_t out[16];
+    compress(cv, block, blocklen, counter, flags, out);
+    std::memcpy(cv, out, 32U);
+}
+
+/// Final compression of a node, deferred until it is known whether the
+/// node is the root.
+struct Blake3Output
+{
+    uint32_t cv[8];
+    uint8_t block[64];
+    uint8_t blocklen;
+    uint64_t counter;
+    uint8_t flags;
+
+    /// Get the chaining value of a non-root node.
+    /// @param out                      Output buffer of 32 bytes
+    void chaining_value(uint8_t *out) const
+    {
+        uint32_t words[8];
+        std::memcpy(words, cv, 32U);
+        compress_in_place(words, block, blocklen, counter, flags);
+        store32(out, words, 8U);
+    }
+
+    /// Write the root output stream. Each 64-byte output block is an
+    /// independent compression with its own counter.
+    /// @param out                      Output buffer
+    /// @param size                     Output size in bytes
+    /// @param offset                   Offset into the output stream
+    void root_bytes(uint8_t *out, size_t size, uint64_t offset) const
+    {
+        uint64_t index = offset / 64U;
+        size_t skip = static_cast<size_t>(offset % 64U);
+        while (size)
+        {
+            uint32_t words[16];
+            uint8_t bytes[64];
+            compress(cv, block, blocklen, index++, static_cast<uint8_t>(flags | root), words);
+            store32(bytes, words, 16U);
+
+            size_t take = (64U - skip < size) ? 64U - skip : size;
+            std::memcpy(out, bytes + skip, take);
+            out += take;
+            size -= take;
+            skip = 0U;
+        }
+    }
+};
+
+// Get the output of a parent node
+static Blake3Output parent_output(const uint8_t *children, const uint32_t *key)
+{
+    Blake3Output output;
+    std::memcpy(output.cv, key, 32U);
+    std::memcpy(output.block, children, 64U);
+    output.blocklen = 64U;
+    output.counter = 0U;
+    output.flags = parent;
+    return output;
+}
+
+// Get the output of a chunk
+static Blake3Output chunk_output(const Blake3Chunk &chunk)
+{
+    Blake3Output output;
+    std::memcpy(output.cv, chunk.cv, 32U);
+    std::memcpy(output.block, chunk.block, 64U);
+    output.blocklen = static_cast<uint8_t>(chunk.blocklen);
+    output.counter = chunk.counter;
+    output.flags = static_cast<uint8_t>((chunk.blocks ? 0U : chunk_start) | chunk_end);
+    return output;
+}
+
+// Hash whole inputs of the same number of blocks, one after another
+static void hash_many_portable(
+    const uint8_t *const *inputs, size_t count, size_t blocks, const uint32_t *key,
+    uint64_t counter, bool increment, uint8_t flags, uint8_t start, uint8_t end, uint8_t *out)
+{
+    for (size_t i = 0U; i < count; ++i, out += 32U)
+    {
+        uint32_t cv[8];
+        std::memcpy(cv, key, 32U);
+        uint8_t blockflags = static_cast<uint8_t>(flags | start);
+        for (size_t b = 0U; b < blocks; ++b)
+        {
+            if (b + 1U == blocks)
+            {
+                blockflags |= end;
+            }
+
+            compress_in_place(cv, inputs[i] + b * 64U, 64U, counter, blockflags);
+            blockflags = flags;
+        }
+
+        store32(out, cv, 8U);
+        if (increment)
+        {
+            ++counter;
+        }
+    }
+}
+
+#if defined(CRYPTLIB_X86)
+// Rotate each lane right
+template <int C>
+CRYPTLIB_TARGET("sse4.1")
+static inline __m128i rtr_sse41(__m128i x)
+{
+    return _mm_or_si128(_mm_srli_epi32(x, C), _mm_slli_epi32(x, 32 - C));
+}
+
+// Mix a column or diagonal on four lanes. The 16 and 8 bit rotations are
+// byte shuffles.
+CRYPTLIB_TARGET("sse4.1")
+static CRYPTLIB_INLINE void g_sse41(__m128i &a, __m128i &b, __m128i &c, __m128i &d, __m128i x, __m128i y)
+{
+    const __m128i rot16 = _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m128i rot8 = _mm_setr_epi8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+    a = _mm_add_epi32(_mm_add_epi32(a, b), x);
+    d = _mm_shuffle_epi8(_mm_xor_si128(d, a), rot16);
+    c = _mm_add_epi32(c, d);
+    b = rtr_sse41<12>(_mm_xor_si128(b, c));
+    a = _mm_add_epi32(_mm_add_epi32(a, b), y);
+    d = _mm_shuffle_epi8(_mm_xor_si128(d, a), rot8);
+    c = _mm_add_epi32(c, d);
+    b = rtr_sse41<7>(_mm_xor_si128(b, c));
+}
+
+// Transpose a 4x4 matrix of words
+CRYPTLIB_TARGET("sse4.1")
+static CRYPTLIB_INLINE void transpose_sse41(__m128i *r)
+{
+    __m128i t0 = _mm_unpacklo_epi32(r[0], r[1]);
+    __m128i t1 = _mm_unpackhi_epi32(r[0], r[1]);
+    __m128i t2 = _mm_unpacklo_epi32(r[2], r[3]);
+    __m128i t3 = _mm_unpackhi_epi32(r[2], r[3]);
+    r[0] = _mm_unpacklo_epi64(t0, t2);
+    r[1] = _mm_unpackhi_epi64(t0, t2);
+    r[2] = _mm_unpacklo_epi64(t1, t3);
+    r[3] = _mm_unpackhi_epi64(t1, t3);
+}
+
+// Hash four inputs at once with SSE4.1, one per lane
+CRYPTLIB_TARGET("sse4.1")
+static void hash4_sse41(
+    const uint8_t *const *inputs, size_t blocks, const uint32_t *key,
+    uint64_t counter, bool increment, uint8_t flags, uint8_t start, uint8_t end, uint8_t *out)
+{
+    __m128i h[8];
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        h[i] = _mm_set1_epi32(static_cast<int>(key[i]));
+    }
+
+    alignas(16) uint32_t lo[4];
+    alignas(16) uint32_t hi[4];
+    for (size_t i = 0U; i < 4U; ++i)
+    {
+        uint64_t c = counter + (increment ? i : 0U);
+        lo[i] = static_cast<uint32_t>(c);
+        hi[i] = static_cast<uint32_t>(c >> 32);
+    }
+
+    uint8_t blockflags = static_cast<uint8_t>(flags | start);
+    for (size_t b = 0U; b < blocks; ++b)
+    {
+        if (b + 1U == blocks)
+        {
+            blockflags |= end;
+        }
+
+        // Populate message, word i of every lane gathered into m[i]
+        __m128i m[16];
+        for (size_t j = 0U; j < 16U; j += 4U)
+        {
+            for (size_t i = 0U; i < 4U; ++i)
+            {
+                m[j + i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inputs[i] + b * 64U + j * 4U));
+            }
+
+            transpose_sse41(m + j);
+        }
+
+        __m128i v[16] =
+        {
+            h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+            _mm_set1_epi32(static_cast<int>(iv[0])), _mm_set1_epi32(static_cast<int>(iv[1])),
+            _mm_set1_epi32(static_cast<int>(iv[2])), _mm_set1_epi32(static_cast<int>(iv[3])),
+            _mm_load_si128(reinterpret_cast<const __m128i*>(lo)), _mm_load_si128(reinterpret_cast<const __m128i*>(hi)),
+            _mm_set1_epi32(64), _mm_set1_epi32(blockflags)
+        };
+
+        for (size_t r = 0U; r < 7U; ++r)
+        {
+            const uint8_t *s = schedule[r];
+            g_sse41(v[0], v[4], v[8], v[12], m[s[0]], m[s[1]]);
+            g_sse41(v[1], v[5], v[9], v[13], m[s[2]], m[s[3]]);
+            g_sse41(v[2], v[6], v[10], v[14], m[s[4]], m[s[5]]);
+            g_sse41(v[3], v[7], v[11], v[15], m[s[6]], m[s[7]]);
+            g_sse41(v[0], v[5], v[10], v[15], m[s[8]], m[s[9]]);
+            g_sse41(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+            g_sse41(v[2], v[7], v[8], v[13], m[s[12]], m[s[13]]);
+            g_sse41(v[3], v[4], v[9], v[14], m[s[14]], m[s[15]]);
+        }
+
+        for (size_t i = 0U; i < 8U; ++i)
+        {
+            h[i] = _mm_xor_si128(v[i], v[i + 8U]);
+        }
+
+        blockflags = flags;
+    }
+
+    // Transpose the chaining values back to one per lane
+    transpose_sse41(h);
+    transpose_sse41(h + 4);
+    for (size_t i = 0U; i < 4U; ++i)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 32U), h[i]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 32U + 16U), h[i + 4U]);
+    }
+}
+
+// Rotate each lane right
+template <int C>
+CRYPTLIB_TARGET("avx2")
+static inline __m256i rtr_avx2(__m256i x)
+{
+    return _mm256_or_si256(_mm256_srli_epi32(x, C), _mm256_slli_epi32(x, 32 - C));
+}
+
+// Mix a column or diagonal on eight lanes
+CRYPTLIB_TARGET("avx2")
+static CRYPTLIB_INLINE void g_avx2(__m256i &a, __m256i &b, __m256i &c, __m256i &d, __m256i x, __m256i y)
+{
+    const __m256i rot16 = _mm256_setr_epi8(
+        2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+        2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m256i rot8 = _mm256_setr_epi8(
+        1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12,
+        1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+    a = _mm256_add_epi32(_mm256_add_epi32(a, b), x);
+    d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot16);
+    c = _mm256_add_epi32(c, d);
+    b = rtr_avx2<12>(_mm256_xor_si256(b, c));
+    a = _mm256_add_epi32(_mm256_add_epi32(a, b), y);
+    d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot8);
+    c = _mm256_add_epi32(c, d);
+    b = rtr_avx2<7>(_mm256_xor_si256(b, c));
+}
+
+// Hash eight inputs at once with AVX2, one per lane
+CRYPTLIB_TARGET("avx2")
+static void hash8_avx2(
+    const uint8_t *const *inputs, size_t blocks, const uint32_t *key,
+    uint64_t counter, bool increment, uint8_t flags, uint8_t start, uint8_t end, uint8_t *out)
+{
+    __m256i h[8];
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        h[i] = _mm256_set1_epi32(static_cast<int>(key[i]));
+    }
+
+    alignas(32) uint32_t lo[8];
+    alignas(32) uint32_t hi[8];
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        uint64_t c = counter + (increment ? i : 0U);
+        lo[i] = static_cast<uint32_t>(c);
+        hi[i] = static_cast<uint32_t>(c >> 32);
+    }
+
+    uint8_t blockflags = static_cast<uint8_t>(flags | start);
+    for (size_t b = 0U; b < blocks; ++b)
+    {
+        if (b + 1U == blocks)
+        {
+            blockflags |= end;
+        }
+
+        __m256i m[16];
+        transpose_avx2(inputs, b * 64U, m);
+        transpose_avx2(inputs, b * 64U + 32U, m + 8);
+
+        __m256i v[16] =
+        {
+            h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+            _mm256_set1_epi32(static_cast<int>(iv[0])), _mm256_set1_epi32(static_cast<int>(iv[1])),
+            _mm256_set1_epi32(static_cast<int>(iv[2])), _mm256_set1_epi32(static_cast<int>(iv[3])),
+            _mm256_load_si256(reinterpret_cast<const __m256i*>(lo)), _mm256_load_si256(reinterpret_cast<const __m256i*>(hi)),
+            _mm256_set1_epi32(64), _mm256_set1_epi32(blockflags)
+        };
+
+        for (size_t r = 0U; r < 7U; ++r)
+        {
+            const uint8_t *s = schedule[r];
+            g_avx2(v[0], v[4], v[8], v[12], m[s[0]], m[s[1]]);
+            g_avx2(v[1], v[5], v[9], v[13], m[s[2]], m[s[3]]);
+            g_avx2(v[2], v[6], v[10], v[14], m[s[4]], m[s[5]]);
+            g_avx2(v[3], v[7], v[11], v[15], m[s[6]], m[s[7]]);
+            g_avx2(v[0], v[5], v[10], v[15], m[s[8]], m[s[9]]);
+            g_avx2(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+            g_avx2(v[2], v[7], v[8], v[13], m[s[12]], m[s[13]]);
+            g_avx2(v[3], v[4], v[9], v[14], m[s[14]], m[s[15]]);
+        }
+
+        for (size_t i = 0U; i < 8U; ++i)
+        {
+            h[i] = _mm256_xor_si256(v[i], v[i + 8U]);
+        }
+
+        blockflags = flags;
+    }
+
+    // Transpose the chaining values back to one per lane
+    alignas(32) uint32_t words[8][8];
+    const uint8_t *rows[8];
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(words[i]), h[i]);
+        rows[i] = reinterpret_cast<const uint8_t*>(words[i]);
+    }
+
+    transpose_avx2(rows, 0U, h);
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 32U), h[i]);
+    }
+}
+
+// Mix a column or diagonal on sixteen lanes, with native rotations
+CRYPTLIB_TARGET("avx512f")
+static CRYPTLIB_INLINE void g_avx512(__m512i &a, __m512i &b, __m512i &c, __m512i &d, __m512i x, __m512i y)
+{
+    a = _mm512_add_epi32(_mm512_add_epi32(a, b), x);
+    d = _mm512_ror_epi32(_mm512_xor_si512(d, a), 16);
+    c = _mm512_add_epi32(c, d);
+    b = _mm512_ror_epi32(_mm512_xor_si512(b, c), 12);
+    a = _mm512_add_epi32(_mm512_add_epi32(a, b), y);
+    d = _mm512_ror_epi32(_mm512_xor_si512(d, a), 8);
+    c = _mm512_add_epi32(c, d);
+    b = _mm512_ror_epi32(_mm512_xor_si512(b, c), 7);
+}
+
+// Hash sixteen inputs at once with AVX-512, one per lane
+CRYPTLIB_TARGET("avx512f")
+static void hash16_avx512(
+    const uint8_t *const *inputs, size_t blocks, const uint32_t *key,
+    uint64_t counter, bool increment, uint8_t flags, uint8_t start, uint8_t end, uint8_t *out)
+{
+    __m512i h[8];
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        h[i] = _mm512_set1_epi32(static_cast<int>(key[i]));
+    }
+
+    alignas(64) uint32_t lo[16];
+    alignas(64) uint32_t hi[16];
+    for (size_t i = 0U; i < 16U; ++i)
+    {
+        uint64_t c = counter + (increment ? i : 0U);
+        lo[i] = static_cast<uint32_t>(c);
+        hi[i] = static_cast<uint32_t>(c >> 32);
+    }
+
+    uint8_t blockflags = static_cast<uint8_t>(flags | start);
+    for (size_t b = 0U; b < blocks; ++b)
+    {
+        if (b + 1U == blocks)
+        {
+            blockflags |= end;
+        }
+
+        // Populate message, transposing each group of eight lanes with AVX2
+        __m512i m[16];
+        for (size_t half = 0U; half < 2U; ++half)
+        {
+            __m256i l[8];
+            __m256i u[8];
+            transpose_avx2(inputs, b * 64U + half * 32U, l);
+            transpose_avx2(inputs + 8, b * 64U + half * 32U, u);
+            for (size_t i = 0U; i < 8U; ++i)
+            {
+                m[half * 8U + i] = _mm512_inserti64x4(_mm512_castsi256_si512(l[i]), u[i], 1);
+            }
+        }
+
+        __m512i v[16] =
+        {
+            h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+            _mm512_set1_epi32(static_cast<int>(iv[0])), _mm512_set1_epi32(static_cast<int>(iv[1])),
+            _mm512_set1_epi32(static_cast<int>(iv[2])), _mm512_set1_epi32(static_cast<int>(iv[3])),
+            _mm512_load_si512(lo), _mm512_load_si512(hi),
+            _mm512_set1_epi32(64), _mm512_set1_epi32(blockflags)
+        };
+
+        for (size_t r = 0U; r < 7U; ++r)
+        {
+            const uint8_t *s = schedule[r];
+            g_avx512(v[0], v[4], v[8], v[12], m[s[0]], m[s[1]]);
+            g_avx512(v[1], v[5], v[9], v[13], m[s[2]], m[s[3]]);
+            g_avx512(v[2], v[6], v[10], v[14], m[s[4]], m[s[5]]);
+            g_avx512(v[3], v[7], v[11], v[15], m[s[6]], m[s[7]]);
+            g_avx512(v[0], v[5], v[10], v[15], m[s[8]], m[s[9]]);
+            g_avx512(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+            g_avx512(v[2], v[7], v[8], v[13], m[s[12]], m[s[13]]);
+            g_avx512(v[3], v[4], v[9], v[14], m[s[14]], m[s[15]]);
+        }
+
+        for (size_t i = 0U; i < 8U; ++i)
+        {
+            h[i] = _mm512_xor_si512(v[i], v[i + 8U]);
+        }
+
+        blockflags = flags;
+    }
+
+    // Transpose the chaining values back to one per lane, eight lanes at a time
+    alignas(64) uint32_t words[8][16];
+    const uint8_t *rows[8];
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        _mm512_store_si512(words[i], h[i]);
+    }
+
+    for (size_t half = 0U; half < 2U; ++half)
+    {
+        __m256i w[8];
+        for (size_t i = 0U; i < 8U; ++i)
+        {
+            rows[i] = reinterpret_cast<const uint8_t*>(words[i] + half * 8U);
+        }
+
+        transpose_avx2(rows, 0U, w);
+        for (size_t i = 0U; i < 8U; ++i)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + (half * 8U + i) * 32U), w[i]);
+        }
+    }
+}
+
+// Hash inputs four at a time, the remainder one at a time
+static void hash_many_sse41(
+    const uint8_t *const *inputs, size_t count, size_t blocks, const uint32_t *key,
+    uint64_t counter, bool increment, uint8_t flags, uint8_t start, uint8_t end, uint8_t *out)
+{
+    for (; count >= 4U; count -= 4U, inputs += 4, out += 4U * 32U)
+    {
+        hash4_sse41(inputs, blocks, key, counter, increment, flags, start, end, out);
+        counter += increment ? 4U : 0U;
+    }
+
+    hash_many_portable(inputs, count, blocks, key, counter, increment, flags, start, end, out);
+}
+
+// Hash inputs eight at a time, the remainder with SSE4.1
+static void hash_many_avx2(
+    const uint8_t *const *inputs, size_t count, size_t blocks, const uint32_t *key,
+    uint64_t counter, bool increment, uint8_t flags, uint8_t start, uint8_t end, uint8_t *out)
+{
+    for (; count >= 8U; count -= 8U, inputs += 8, out += 8U * 32U)
+    {
+        hash8_avx2(inputs, blocks, key, counter, increment, flags, start, end, out);
+        counter += increment ? 8U : 0U;
+    }
+
+    hash_many_sse41(inputs, count, blocks, key, counter, increment, flags, start, end, out);
+}
+
+// Hash inputs sixteen at a time, the remainder with AVX2
+static void hash_many_avx512(
+    const uint8_t *const *inputs, size_t count, size_t blocks, const uint32_t *key,
+    uint64_t counter, bool increment, uint8_t flags, uint8_t start, uint8_t end, uint8_t *out)
+{
+    for (; count >= 16U; count -= 16U, inputs += 16, out += 16U * 32U)
+    {
+        hash16_avx512(inputs, blocks, key, counter, increment, flags, start, end, out);
+        counter += increment ? 16U : 0U;
+    }
+
+    hash_many_avx2(inputs, count, blocks, key, counter, increment, flags, start, end, out);
+}
+#endif
+
+/// Multi-input hashing backend.
+struct Blake3Backend
+{
+    /// Backend name.
+    const char *name;
+
+    /// Number of inputs hashed at once.
+    size_t degree;
+
+    /// Hash whole inputs of the same number of blocks. Chunks take
+    /// consecutive counters; parents all use counter zero.
+    void (*hash_many)(
+        const uint8_t *const *inputs, size_t count, size_t blocks, const uint32_t *key,
+        uint64_t counter, bool increment, uint8_t flags, uint8_t start, uint8_t end, uint8_t *out);
+};
+
+// Select the widest backend supported by the processor
+static const Blake3Backend &select_backend()
+{
+    static const Blake3Backend backend =
+#if defined(CRYPTLIB_X86)
+        (CpuFeatures::avx512f() && CpuFeatures::avx2()) ? Blake3Backend{ "avx512", 16U, hash_many_avx512 } :
+        CpuFeatures::avx2() ? Blake3Backend{ "avx2", 8U, hash_many_avx2 } :
+        CpuFeatures::sse41() ? Blake3Backend{ "sse4.1", 4U, hash_many_sse41 } :
+#endif
+        Blake3Backend{ "portable", 1U, hash_many_portable };
+    return backend;
+}
+
+// Round down to a power of two
+static uint64_t round_down_pow2(uint64_t x)
+{
+    uint64_t p = 1U;
+    while (p <= x / 2U)
+    {
+        p *= 2U;
+    }
+
+    return p;
+}
+
+// Count the set bits
+static size_t popcount(uint64_t x)
+{
+    size_t count = 0U;
+    for (; x; x &= x - 1U)
+    {
+        ++count;
+    }
+
+    return count;
+}
+
+// Hash the whole chunks of the input, plus a partial last chunk, writing
+// one chaining value per chunk
+static size_t compress_chunks(const uint8_t *input, size_t size, const uint32_t *key, uint64_t counter, uint8_t *out)
+{
+    const uint8_t *chunks[max_degree];
+    size_t count = 0U;
+    for (; size >= Blake3Hash::chunk_size; size -= Blake3Hash::chunk_size, input += Blake3Hash::chunk_size)
+    {
+        chunks[count++] = input;
+    }
+
+    select_backend().hash_many(chunks, count, Blake3Hash::chunk_size / 64U, key, counter, true, 0U, chunk_start, chunk_end, out);
+
+    if (size)
+    {
+        Blake3Chunk chunk;
+        chunk.start(key, counter + count);
+        chunk.add(input, size);
+        chunk_output(chunk).chaining_value(out + count * 32U);
+        ++count;
+    }
+
+    return count;
+}
+
+// Hash pairs of chaining values into their parents, passing an odd one
+// through
+static size_t compress_parents(const uint8_t *cvs, size_t count, const uint32_t *key, uint8_t *out)
+{
+    const uint8_t *parents[max_degree];
+    size_t pairs = 0U;
+    for (; count - pairs * 2U >= 2U; ++pairs)
+    {
+        parents[pairs] = cvs + pairs * 64U;
+    }
+
+    select_backend().hash_many(parents, pairs, 1U, key, 0U, false, parent, 0U, 0U, out);
+
+    if (count % 2U)
+    {
+        std::memcpy(out + pairs * 32U, cvs + pairs * 64U, 32U);
+        return pairs + 1U;
+    }
+
+    return pairs;
+}
+
+// Hash a subtree down to at most max_degree chaining values (at least
+// two unless the subtree is one chunk). The left side is the largest
+// power-of-two number of chunks, so the partial parents line up with a
+// serial hash. Large subtrees hash their left side on a worker thread.
+static size_t compress_subtree_wide(
+    const uint8_t *input, size_t size, const uint32_t *key, uint64_t counter, uint8_t *out, unsigned threads)
+{
+    const size_t degree = select_backend().degree;
+    if (size <= degree * Blake3Hash::chunk_size)
+    {
+        return compress_chunks(input, size, key, counter, out);
+    }
+
+    size_t left = static_cast<size_t>(round_down_pow2((size - 1U) / Blake3Hash::chunk_size)) * Blake3Hash::chunk_size;
+    size_t right = size - left;
+    uint64_t rightcounter = counter + left / Blake3Hash::chunk_size;
+
+    // The left side fills its outputs, except that a portable left side of
+    // several chunks still yields two
+    uint8_t cvs[2U * max_degree * 32U];
+    size_t width = (degree == 1U && left > Blake3Hash::chunk_size) ? 2U : degree;
+    size_t leftcount;
+    size_t rightcount;
+    if (threads > 1U && size >= parallel_min)
+    {
+        std::thread worker([&]()
+        {
+            leftcount = compress_subtree_wide(input, left, key, counter, cvs, threads / 2U);
+        });
+
+        rightcount = compress_subtree_wide(input + left, right, key, rightcounter, cvs + width * 32U, threads - threads / 2U);
+        worker.join();
+    }
+    else
+    {
+        leftcount = compress_subtree_wide(input, left, key, counter, cvs, 1U);
+        rightcount = compress_subtree_wide(input + left, right, key, rightcounter, cvs + width * 32U, 1U);
+    }
+
+    // A single chunk on the left means the right is also a single chunk
+    if (leftcount == 1U)
+    {
+        std::memcpy(out, cvs, 64U);
+        return 2U;
+    }
+
+    return compress_parents(cvs, leftcount + rightcount, key, out);
+}
+
+// Hash a subtree of more than one chunk down to the two children of its
+// root
+static void compress_subtree(const uint8_t *input, size_t size, const uint32_t *key, uint64_t counter, uint8_t *out, unsigned threads)
+{
+    uint8_t cvs[max_degree * 32U];
+    size_t count = compress_subtree_wide(input, size, key, counter, cvs, threads);
+
+    uint8_t parents[max_degree * 32U / 2U];
+    while (count > 2U)
+    {
+        count = compress_parents(cvs, count, key, parents);
+        std::memcpy(cvs, parents, count * 32U);
+    }
+
+    std::memcpy(out, cvs, 64U);
+}
+
+void Blake3Chunk::start(const uint32_t *key, uint64_t index)
+{
+    std::memcpy(cv, key, 32U);
+    std::memset(block, 0, sizeof(block));
+    blocklen = 0U;
+    blocks = 0U;
+    counter = index;
+}
+
+size_t Blake3Chunk::size() const
+{
+    return blocks * 64U + blocklen;
+}
+
+void Blake3Chunk::add(const uint8_t *data, size_t size)
+{
+    while (size)
+    {
+        // Compress a full block only once more data follows it
+        if (blocklen == 64U)
+        {
+            compress_in_place(cv, block, 64U, counter, blocks ? 0U : chunk_start);
+            ++blocks;
+            blocklen = 0U;
+            std::memset(block, 0, sizeof(block));
+        }
+
+        // Compress whole blocks straight from the input
+        if (blocklen == 0U)
+        {
+            for (; size > 64U; size -= 64U, data += 64U, ++blocks)
+            {
+                compress_in_place(cv, data, 64U, counter, blocks ? 0U : chunk_start);
+            }
+        }
+
+        size_t take = (64U - blocklen < size) ? 64U - blocklen : size;
+        std::memcpy(block + blocklen, data, take);
+        blocklen += take;
+        data += take;
+        size -= take;
+    }
+}
+
+Blake3Hash::Blake3Hash(unsigned threads) : tree(), threads(threads)
+{
+    if (this->threads == 0U)
+    {
+        this->threads = std::thread::hardware_concurrency();
+    }
+
+    if (this->threads == 0U)
+    {
+        this->threads = 1U;
+    }
+
+    tree.chunk.start(iv, 0U);
+}
+
+const char *Blake3Hash::backend()
+{
+    return select_backend().name;
+}
+
+void Blake3Hash::merge(uint64_t chunks)
+{
+    // Each set bit of the chunk count is one complete subtree
+    size_t target = popcount(chunks);
+    while (tree.depth > target)
+    {
+        parent_output(tree.stack[tree.depth - 2U], iv).chaining_value(tree.stack[tree.depth - 2U]);
+        --tree.depth;
+    }
+}
+
+void Blake3Hash::push(const uint8_t *cv, uint64_t chunks)
+{
+    merge(chunks);
+    std::memcpy(tree.stack[tree.depth++], cv, 32U);
+}
+
+void Blake3Hash::clear()
+{
+    tree.chunk.start(iv, 0U);
+    tree.depth = 0U;
+}
+
+void Blake3Hash::add(const void *data, size_t size)
+{
+    const uint8_t *input = static_cast<const uint8_t*>(data);
+
+    // Fill the partial chunk, finishing it only once more data follows
+    if (tree.chunk.size())
+    {
+        size_t take = (chunk_size - tree.chunk.size() < size) ? chunk_size - tree.chunk.size() : size;
+        tree.chunk.add(input, take);
+        input += take;
+        size -= take;
+        if (!size)
+        {
+            return;
+        }
+
+        uint8_t cv[32];
+        chunk_output(tree.chunk).chaining_value(cv);
+        push(cv, tree.chunk.counter);
+        tree.chunk.start(iv, tree.chunk.counter + 1U);
+    }
+
+    // Hash the largest subtrees that fit, keeping at least one byte back
+    // for the last chunk. A subtree must start at a multiple of its size.
+    while (size > chunk_size)
+    {
+        uint64_t subtree = round_down_pow2(size);
+        uint64_t offset = tree.chunk.counter * chunk_size;
+        while ((subtree - 1U) & offset)
+        {
+            subtree /= 2U;
+        }
+
+        uint64_t subchunks = subtree / chunk_size;
+        if (subtree <= chunk_size)
+        {
+            uint8_t cv[32];
+            tree.chunk.add(input, chunk_size);
+            chunk_output(tree.chunk).chaining_value(cv);
+            push(cv, tree.chunk.counter);
+        }
+        else
+        {
+            uint8_t cvs[64];
+            compress_subtree(input, static_cast<size_t>(subtree), iv, tree.chunk.counter, cvs, threads);
+            push(cvs, tree.chunk.counter);
+            push(cvs + 32U, tree.chunk.counter + subchunks / 2U);
+        }
+
+        tree.chunk.start(iv, tree.chunk.counter + subchunks);
+        input += subtree;
+        size -= static_cast<size_t>(subtree);
+    }
+
+    if (size)
+    {
+        tree.chunk.add(input, size);
+        merge(tree.chunk.counter);
+    }
+}
+
+void Blake3Hash::save(State &state) const
+{
+    state = tree;
+}
+
+void Blake3Hash::restore(const State &state)
+{
+    tree = state;
+}
+
+size_t Blake3Hash::size() const
+{
+    return digest_size;
+}
+
+void Blake3Hash::close(uint8_t *digest)
+{
+    close(digest, digest_size, 0U);
+}
+
+void Blake3Hash::close(Digest &digest)
+{
+    close(digest.data(), digest_size, 0U);
+}
+
+void Blake3Hash::close(uint8_t *output, size_t size, uint64_t offset)
+{
+    // A lone chunk is the root
+    Blake3Output node = chunk_output(tree.chunk);
+    if (tree.depth == 0U)
+    {
+        node.root_bytes(output, size, offset);
+        return;
+    }
+
+    // Otherwise fold the stack into the last chunk, newest subtree first.
+    // The chunk is empty when add() ended on a whole subtree, whose two
+    // halves are then the top of the stack.
+    size_t remaining = tree.depth;
+    if (!tree.chunk.size())
+    {
+        remaining -= 2U;
+        node = parent_output(tree.stack[remaining], iv);
+    }
+
+    for (; remaining; --remaining)
+    {
+        uint8_t children[64];
+        std::memcpy(children, tree.stack[remaining - 1U], 32U);
+        node.chaining_value(children + 32U);
+        node = parent_output(children, iv);
+    }
+
+    node.root_bytes(output, size, offset);
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "hash.hpp"
+
+/// BLAKE3 chunk state.
+struct Blake3Chunk
+{
+    /// Chaining value.
+    uint32_t cv[8];
+
+    /// Partial block.
+    uint8_t block[64];
+
+    /// Bytes in the partial block.
+    size_t blocklen;
+
+    /// Blocks compressed so far.
+    size_t blocks;
+
+    /// Chunk index.
+    uint64_t counter;
+
+    /// Start a new chunk.
+    /// @param key                      Key words
+    /// @param index                    Chunk index
+    void start(const uint32_t *key, uint64_t index);
+
+    /// Get the number of bytes added to the chunk.
+    /// @return                         Chunk length in bytes
+    size_t size() const;
+
+    /// Add data to the chunk. The last block is kept back, as it needs the
+    /// chunk end flag and may be the root.
+    /// @param data                     Pointer to the data to add
+    /// @param size                     Size of the data, not overflowing the chunk
+    void add(const uint8_t *data, size_t size);
+};
+
+/// BLAKE3 hash tree state.
+struct Blake3State
+{
+    /// Current chunk.
+    Blake3Chunk chunk;
+
+    /// Chaining values of completed subtrees, largest first.
+    uint8_t stack[54][32];
+
+    /// Number of chaining values on the stack.
+    size_t depth;
+};
+
+/// BLAKE3 hash class.
+/// The input is split into 1 KiB chunks, which are the leaves of a binary
+/// tree of 32-byte chaining values. Whole subtrees passed to add() are
+/// hashed many chunks at a time, one per SIMD lane (4 with SSE4.1, 8 with
+/// AVX2, 16 with AVX-512), and large subtrees are split between worker
+/// threads. The digest does not depend on how the data is split into
+/// add() calls or on the number of threads.
+class Blake3Hash : public Hash
+{
+public:
+    /// Default digest type.
+    typedef HashDigest<32U> Digest;
+
+    /// Default digest size in bytes.
+    static const size_t digest_size = 32U;
+
+    /// Chunk size in bytes.
+    static const size_t chunk_size = 1024U;
+
+    /// Midstate snapshot type.
+    typedef Blake3State State;
+
+private:
+    /// Tree state.
+    Blake3State tree;
+
+    /// Number of worker threads for large inputs.
+    unsigned threads;
+
+    /// Push the chaining value of a completed subtree, first merging the
+    /// subtrees it completes.
+    /// @param cv                       Chaining value
+    /// @param chunks                   Number of chunks before the subtree
+    void push(const uint8_t *cv, uint64_t chunks);
+
+    /// Merge completed subtrees.
+    /// @param chunks                   Total number of chunks so far
+    void merge(uint64_t chunks);
+
+public:
+    /// Constructor.
+    /// @param threads                  Number of worker threads for large inputs
+    ///                                 (0 for one per processor)
+    explicit Blake3Hash(unsigned threads = 1U);
+
+    /// Delete copy constructor.
+    Blake3Hash(const Blake3Hash &) = delete;
+
+    /// Delete assignment operator.
+    Blake3Hash &operator=(const Blake3Hash &) = delete;
+
+    /// Clear the hash to an initial state.
+    virtual void clear();
+
+    /// Add data to the hash.
+    /// @param data                     Pointer to the data to add
+    /// @param size                     Size of the data to add
+    virtual void add(const void *data, size_t size);
+
+    using Hash::add;
+
+    /// Get the digest size.
+    /// @return                         Digest size in bytes (32)
+    virtual size_t size() const;
+
+    /// Close the hash and write the digest without allocating.
+    /// @param digest                   Output buffer of 32 bytes
+    virtual void close(uint8_t *digest);
+
+    /// Close the hash and write the digest without allocating.
+    /// @param digest                   Output digest
+    void close(Digest &digest);
+
+    /// Close the hash and write extended output of any length (XOF).
+    /// The first 32 bytes are the digest. The hash state is not changed,
+    /// so more data may be added afterwards.
+    /// @param output                   Output buffer
+    /// @param size                     Output size in bytes
+    /// @param offset                   Offset into the output stream
+    void close(uint8_t *output, size_t size, uint64_t offset = 0U);
+
+    using Hash::close;
+
+    /// Save a snapshot of the hash midstate.
+    /// @param state                    Snapshot to write
+    void save(State &state) const;
+
+    /// Restore the hash midstate from a snapshot.
+    /// @param state                    Snapshot previously written by save()
+    void restore(const State &state);
+
+    /// Get the name of the SIMD backend selected for this processor.
+    /// @return                         Backend name ("avx512", "avx2", "sse4.1" or "portable")
+    static const char *backend();
+};
@@ -0,0 +1,465 @@
+#include "chacha20.hpp"
+#include "hash_lanes.hpp"
+#include <stdexcept>
+
+// Load a little-endian 32-bit word
+static inline uint32_t load_le32(const uint8_t *p)
+{
+    return static_cast<uint32_t>(p[0]) |
+           (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) |
+           (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Store a little-endian 32-bit word
+static inline void store_le32(uint8_t *p, uint32_t x)
+{
+    p[0] = static_cast<uint8_t>(x);
+    p[1] = static_cast<uint8_t>(x >> 8);
+    p[2] = static_cast<uint8_t>(x >> 16);
+    p[3] = static_cast<uint8_t>(x >> 24);
+}
+
+// Wipe memory in a way the compiler cannot elide
+static void wipe(void *data, size_t size)
+{
+    volatile uint8_t *p = static_cast<volatile uint8_t*>(data);
+    for (size_t i = 0U; i < size; ++i)
+    {
+        p[i] = 0U;
+    }
+}
+
+// Rotate a 32-bit word left
+static inline uint32_t rtl(uint32_t x, unsigned c)
+{
+    return (x << c) | (x >> (32U - c));
+}
+
+// Run a quarter round on four state words
+static inline void quarter_round(uint32_t *x, size_t a, size_t b, size_t c, size_t d)
+{
+    x[a] += x[b];
+    x[d] = rtl(x[d] ^ x[a], 16U);
+    x[c] += x[d];
+    x[b] = rtl(x[b] ^ x[c], 12U);
+    x[a] += x[b];
+    x[d] = rtl(x[d] ^ x[a], 8U);
+    x[c] += x[d];
+    x[b] = rtl(x[b] ^ x[c], 7U);
+}
+
+// Generate one keystream block with the portable implementation
+static void block_portable(const uint32_t *state, uint8_t *stream)
+{
+    uint32_t x[16];
+    for (size_t j = 0U; j < 16U; ++j)
+    {
+        x[j] = state[j];
+    }
+
+    // Ten double rounds: columns, then diagonals
+    for (size_t i = 0U; i < 10U; ++i)
+    {
+        quarter_round(x, 0U, 4U, 8U, 12U);
+        quarter_round(x, 1U, 5U, 9U, 13U);
+        quarter_round(x, 2U, 6U, 10U, 14U);
+        quarter_round(x, 3U, 7U, 11U, 15U);
+        quarter_round(x, 0U, 5U, 10U, 15U);
+        quarter_round(x, 1U, 6U, 11U, 12U);
+        quarter_round(x, 2U, 7U, 8U, 13U);
+        quarter_round(x, 3U, 4U, 9U, 14U);
+    }
+
+    for (size_t j = 0U; j < 16U; ++j)
+    {
+        store_le32(stream + j * 4U, x[j] + state[j]);
+    }
+
+    wipe(x, sizeof(x));
+}
+
+// Encrypt or decrypt with the portable implementation, one block at a time
+static void crypt_portable(uint32_t *state, const uint8_t *input, uint8_t *output, size_t size)
+{
+    uint8_t stream[64];
+    while (size)
+    {
+        block_portable(state, stream);
+        ++state[12];
+
+        size_t n = (size < 64U) ? size : 64U;
+        for (size_t i = 0U; i < n; ++i)
+        {
+            output[i] = input[i] ^ stream[i];
+        }
+
+        input += n;
+        output += n;
+        size -= n;
+    }
+
+    wipe(stream, sizeof(stream));
+}
+
+#if defined(CRYPTLIB_X86)
+// Rotate the words of four lanes left, by byte shuffles where possible
+template <int C>
+CRYPTLIB_TARGET("ssse3")
+static CRYPTLIB_INLINE __m128i rtl_ssse3(__m128i x)
+{
+    if (C == 16)
+    {
+        return _mm_shuffle_epi8(x, _mm_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2));
+    }
+
+    if (C == 8)
+    {
+        return _mm_shuffle_epi8(x, _mm_set_epi8(14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3));
+    }
+
+    return _mm_or_si128(_mm_slli_epi32(x, C), _mm_srli_epi32(x, 32 - C));
+}
+
+// Run a quarter round on four lanes
+CRYPTLIB_TARGET("ssse3")
+static CRYPTLIB_INLINE void quarter_round_ssse3(__m128i &a, __m128i &b, __m128i &c, __m128i &d)
+{
+    a = _mm_add_epi32(a, b);
+    d = rtl_ssse3<16>(_mm_xor_si128(d, a));
+    c = _mm_add_epi32(c, d);
+    b = rtl_ssse3<12>(_mm_xor_si128(b, c));
+    a = _mm_add_epi32(a, b);
+    d = rtl_ssse3<8>(_mm_xor_si128(d, a));
+    c = _mm_add_epi32(c, d);
+    b = rtl_ssse3<7>(_mm_xor_si128(b, c));
+}
+
+// Encrypt or decrypt four blocks with SSSE3. Lane i of vector j holds
+// word j of block i.
+CRYPTLIB_TARGET("ssse3")
+static void group_ssse3(const uint32_t *state, const uint8_t *input, uint8_t *output)
+{
+    __m128i s[16];
+    __m128i x[16];
+    for (size_t j = 0U; j < 16U; ++j)
+    {
+        s[j] = _mm_set1_epi32(static_cast<int>(state[j]));
+    }
+
+    s[12] = _mm_add_epi32(s[12], _mm_set_epi32(3, 2, 1, 0));
+    for (size_t j = 0U; j < 16U; ++j)
+    {
+        x[j] = s[j];
+    }
+
+    for (size_t i = 0U; i < 10U; ++i)
+    {
+        quarter_round_ssse3(x[0], x[4], x[8], x[12]);
+        quarter_round_ssse3(x[1], x[5], x[9], x[13]);
+        quarter_round_ssse3(x[2], x[6], x[10], x[14]);
+        quarter_round_ssse3(x[3], x[7], x[11], x[15]);
+        quarter_round_ssse3(x[0], x[5], x[10], x[15]);
+        quarter_round_ssse3(x[1], x[6], x[11], x[12]);
+        quarter_round_ssse3(x[2], x[7], x[8], x[13]);
+        quarter_round_ssse3(x[3], x[4], x[9], x[14]);
+    }
+
+    // Transpose each run of four words into a 16-byte piece of each block
+    for (size_t g = 0U; g < 4U; ++g)
+    {
+        __m128i a = _mm_add_epi32(x[g * 4U], s[g * 4U]);
+        __m128i b = _mm_add_epi32(x[g * 4U + 1U], s[g * 4U + 1U]);
+        __m128i c = _mm_add_epi32(x[g * 4U + 2U], s[g * 4U + 2U]);
+        __m128i d = _mm_add_epi32(x[g * 4U + 3U], s[g * 4U + 3U]);
+        __m128i t0 = _mm_unpacklo_epi32(a, b);
+        __m128i t1 = _mm_unpackhi_epi32(a, b);
+        __m128i t2 = _mm_unpacklo_epi32(c, d);
+        __m128i t3 = _mm_unpackhi_epi32(c, d);
+        __m128i pieces[4] =
+        {
+            _mm_unpacklo_epi64(t0, t2),
+            _mm_unpackhi_epi64(t0, t2),
+            _mm_unpacklo_epi64(t1, t3),
+            _mm_unpackhi_epi64(t1, t3)
+        };
+
+        for (size_t i = 0U; i < 4U; ++i)
+        {
+            const __m128i *in = reinterpret_cast<const __m128i*>(input + i * 64U + g * 16U);
+            __m128i *out = reinterpret_cast<__m128i*>(output + i * 64U + g * 16U);
+            _mm_storeu_si128(out, _mm_xor_si128(_mm_loadu_si128(in), pieces[i]));
+        }
+    }
+}
+
+// Rotate the words of eight lanes left, by byte shuffles where possible
+template <int C>
+CRYPTLIB_TARGET("avx2")
+static CRYPTLIB_INLINE __m256i rtl_avx2(__m256i x)
+{
+    if (C == 16)
+    {
+        return _mm256_shuffle_epi8(x, _mm256_set_epi8(
+            13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+            13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2));
+    }
+
+    if (C == 8)
+    {
+        return _mm256_shuffle_epi8(x, _mm256_set_epi8(
+            14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3,
+            14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3));
+    }
+
+    return _mm256_or_si256(_mm256_slli_epi32(x, C), _mm256_srli_epi32(x, 32 - C));
+}
+
+// Run a quarter round on eight lanes
+CRYPTLIB_TARGET("avx2")
+static CRYPTLIB_INLINE void quarter_round_avx2(__m256i &a, __m256i &b, __m256i &c, __m256i &d)
+{
+    a = _mm256_add_epi32(a, b);
+    d = rtl_avx2<16>(_mm256_xor_si256(d, a));
+    c = _mm256_add_epi32(c, d);
+    b = rtl_avx2<12>(_mm256_xor_si256(b, c));
+    a = _mm256_add_epi32(a, b);
+    d = rtl_avx2<8>(_mm256_xor_si256(d, a));
+    c = _mm256_add_epi32(c, d);
+    b = rtl_avx2<7>(_mm256_xor_si256(b, c));
+}
+
+// Encrypt or decrypt eight blocks with AVX2, as group_ssse3()
+CRYPTLIB_TARGET("avx2")
+static void group_avx2(const uint32_t *state, const uint8_t *input, uint8_t *output)
+{
+    __m256i x[16];
+    for (size_t j = 0U; j < 16U; ++j)
+    {
+        x[j] = _mm256_set1_epi32(static_cast<int>(state[j]));
+    }
+
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    x[12] = _mm256_add_epi32(x[12], lanes);
+
+    for (size_t i = 0U; i < 10U; ++i)
+    {
+        quarter_round_avx2(x[0], x[4], x[8], x[12]);
+        quarter_round_avx2(x[1], x[5], x[9], x[13]);
+        quarter_round_avx2(x[2], x[6], x[10], x[14]);
+        quarter_round_avx2(x[3], x[7], x[11], x[15]);
+        quarter_round_avx2(x[0], x[5], x[10], x[15]);
+        quarter_round_avx2(x[1], x[6], x[11], x[12]);
+        quarter_round_avx2(x[2], x[7], x[8], x[13]);
+        quarter_round_avx2(x[3], x[4], x[9], x[14]);
+    }
+
+    // Transpose back through memory, one row per state word
+    alignas(32) uint32_t words[16][8];
+    const uint8_t *rows[16];
+    for (size_t j = 0U; j < 16U; ++j)
+    {
+        __m256i s = _mm256_set1_epi32(static_cast<int>(state[j]));
+        if (j == 12U)
+        {
+            s = _mm256_add_epi32(s, lanes);
+        }
+
+        _mm256_store_si256(reinterpret_cast<__m256i*>(words[j]), _mm256_add_epi32(x[j], s));
+        rows[j] = reinterpret_cast<const uint8_t*>(words[j]);
+    }
+
+    __m256i lo[8];
+    __m256i hi[8];
+    transpose_avx2(rows, 0U, lo);
+    transpose_avx2(rows + 8, 0U, hi);
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        const __m256i *in = reinterpret_cast<const __m256i*>(input + i * 64U);
+        __m256i *out = reinterpret_cast<__m256i*>(output + i * 64U);
+        _mm256_storeu_si256(out, _mm256_xor_si256(_mm256_loadu_si256(in), lo[i]));
+        _mm256_storeu_si256(out + 1, _mm256_xor_si256(_mm256_loadu_si256(in + 1), hi[i]));
+    }
+}
+
+// Run a quarter round on sixteen lanes
+CRYPTLIB_TARGET("avx512f")
+static CRYPTLIB_INLINE void quarter_round_avx512(__m512i &a, __m512i &b, __m512i &c, __m512i &d)
+{
+    a = _mm512_add_epi32(a, b);
+    d = _mm512_rol_epi32(_mm512_xor_si512(d, a), 16);
+    c = _mm512_add_epi32(c, d);
+    b = _mm512_rol_epi32(_mm512_xor_si512(b, c), 12);
+    a = _mm512_add_epi32(a, b);
+    d = _mm512_rol_epi32(_mm512_xor_si512(d, a), 8);
+    c = _mm512_add_epi32(c, d);
+    b = _mm512_rol_epi32(_mm512_xor_si512(b, c), 7);
+}
+
+// Encrypt or decrypt sixteen blocks with AVX-512, as group_ssse3()
+CRYPTLIB_TARGET("avx512f")
+static void group_avx512(const uint32_t *state, const uint8_t *input, uint8_t *output)
+{
+    __m512i s[16];
+    __m512i x[16];
+    for (size_t j = 0U; j < 16U; ++j)
+    {
+        s[j] = _mm512_set1_epi32(static_cast<int>(state[j]));
+    }
+
+    s[12] = _mm512_add_epi32(s[12], _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+    for (size_t j = 0U; j < 16U; ++j)
+    {
+        x[j] = s[j];
+    }
+
+    for (size_t i = 0U; i < 10U; ++i)
+    {
+        quarter_round_avx512(x[0], x[4], x[8], x[12]);
+        quarter_round_avx512(x[1], x[5], x[9], x[13]);
+        quarter_round_avx512(x[2], x[6], x[10], x[14]);
+        quarter_round_avx512(x[3], x[7], x[11], x[15]);
+        quarter_round_avx512(x[0], x[5], x[10], x[15]);
+        quarter_round_avx512(x[1], x[6], x[11], x[12]);
+        quarter_round_avx512(x[2], x[7], x[8], x[13]);
+        quarter_round_avx512(x[3], x[4], x[9], x[14]);
+    }
+
+    // Transpose back through memory, each half of the lanes with AVX2
+    alignas(64) uint32_t words[16][16];
+    const uint8_t *rows[16];
+    for (size_t j = 0U; j < 16U; ++j)
+    {
+        _mm512_store_si512(words[j], _mm512_add_epi32(x[j], s[j]));
+        rows[j] = reinterpret_cast<const uint8_t*>(words[j]);
+    }
+
+    for (size_t half = 0U; half < 2U; ++half)
+    {
+        __m256i lo[8];
+        __m256i hi[8];
+        transpose_avx2(rows, half * 32U, lo);
+        transpose_avx2(rows + 8, half * 32U, hi);
+        for (size_t i = 0U; i < 8U; ++i)
+        {
+            const __m256i *in = reinterpret_cast<const __m256i*>(input + (half * 8U + i) * 64U);
+            __m256i *out = reinterpret_cast<__m256i*>(output + (half * 8U + i) * 64U);
+            _mm256_storeu_si256(out, _mm256_xor_si256(_mm256_loadu_si256(in), lo[i]));
+            _mm256_storeu_si256(out + 1, _mm256_xor_si256(_mm256_loadu_si256(in + 1), hi[i]));
+        }
+    }
+}
+
+// Encrypt or decrypt with a kernel that generates N blocks at a time. A
+// tail of more than half a group is staged through a local buffer; a
+// shorter one is left to the next narrower kernel.
+template <size_t N, void (*Group)(const uint32_t *state, const uint8_t *input, uint8_t *output), void (*Tail)(uint32_t *state, const uint8_t *input, uint8_t *output, size_t size)>
+static void crypt_groups(uint32_t *state, const uint8_t *input, uint8_t *output, size_t size)
+{
+    for (; size >= N * 64U; size -= N * 64U, input += N * 64U, output += N * 64U)
+    {
+        Group(state, input, output);
+        state[12] += static_cast<uint32_t>(N);
+    }
+
+    if (size > N * 32U)
+    {
+        uint8_t buffer[N * 64U] = {};
+        std::memcpy(buffer, input, size);
+        Group(state, buffer, buffer);
+        std::memcpy(output, buffer, size);
+        state[12] += static_cast<uint32_t>((size + 63U) / 64U);
+        wipe(buffer, sizeof(buffer));
+    }
+    else if (size)
+    {
+        Tail(state, input, output, size);
+    }
+}
+#endif
+
+/// ChaCha20 backend.
+struct ChaCha20Backend
+{
+    /// Backend name.
+    const char *name;
+
+    /// Number of lanes.
+    size_t lanes;
+
+    /// Encrypt or decrypt data, advancing the block counter in state word 12.
+    void (*crypt)(uint32_t *state, const uint8_t *input, uint8_t *output, size_t size);
+};
+
+// Select the fastest backend supported by the processor
+static const ChaCha20Backend &select_backend()
+{
+    static const ChaCha20Backend backend =
+#if defined(CRYPTLIB_X86)
+        (CpuFeatures::avx512f() && CpuFeatures::avx2()) ?
+            ChaCha20Backend{ "avx512", 16U, crypt_groups<16U, group_avx512, crypt_groups<8U, group_avx2, crypt_groups<4U, group_ssse3, crypt_portable>>> } :
+        CpuFeatures::avx2() ?
+            ChaCha20Backend{ "avx2", 8U, crypt_groups<8U, group_avx2, crypt_groups<4U, group_ssse3, crypt_portable>> } :
+        CpuFeatures::ssse3() ?
+            ChaCha20Backend{ "ssse3", 4U, crypt_groups<4U, group_ssse3, crypt_portable> } :
+#endif
+        ChaCha20Backend{ "portable", 1U, crypt_portable };
+    return backend;
+}
+
+ChaCha20::ChaCha20(const void *key, size_t size) : key()
+{
+    set_key(key, size);
+}
+
+ChaCha20::~ChaCha20()
+{
+    wipe(key, sizeof(key));
+}
+
+void ChaCha20::set_key(const void *key, size_t size)
+{
+    if (size != key_size)
+    {
+        throw std::invalid_argument("ChaCha20 key must be 32 bytes");
+    }
+
+    const uint8_t *p = static_cast<const uint8_t*>(key);
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        this->key[i] = load_le32(p + i * 4U);
+    }
+}
+
+void ChaCha20::crypt(const uint8_t *nonce, uint32_t &counter, const uint8_t *input, uint8_t *output, size_t size)
+{
+    // Reusing keystream after the counter wraps would reveal the XOR of
+    // two plaintexts
+    uint64_t blocks = static_cast<uint64_t>(size / 64U) + ((size % 64U) ? 1U : 0U);
+    if (blocks > (1ULL << 32) - counter)
+    {
+        throw std::invalid_argument("ChaCha20 block counter would wrap");
+    }
+
+    // Constants "expand 32-byte k", key, counter and nonce
+    uint32_t state[16] =
+    {
+        0x61707865U, 0x3320646eU, 0x79622d32U, 0x6b206574U,
+        key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+        counter, load_le32(nonce), load_le32(nonce + 4), load_le32(nonce + 8)
+    };
+
+    select_backend().crypt(state, input, output, size);
+    counter = state[12];
+    wipe(state, sizeof(state));
+}
+
+const char *ChaCha20::backend()
+{
+    return select_backend().name;
+}
+
+size_t ChaCha20::lanes()
+{
+    return select_backend().lanes;
+}
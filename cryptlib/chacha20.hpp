@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// ChaCha20 stream cipher class (RFC 8439).
+/// Uses a 256-bit key, a 96-bit nonce and a 32-bit block counter. The
+/// keystream is generated 16 (AVX-512), 8 (AVX2) or 4 (SSSE3) blocks at a
+/// time, one block per SIMD lane with each state word in its own register,
+/// so no shuffles are needed between rounds. A shorter tail falls through
+/// to the narrower kernels. The rounds use only additions, rotations and
+/// XORs, so every backend runs in constant time.
+class ChaCha20
+{
+public:
+    /// Key size in bytes.
+    static const size_t key_size = 32U;
+
+    /// Nonce size in bytes.
+    static const size_t nonce_size = 12U;
+
+    /// Keystream block size in bytes.
+    static const size_t block_size = 64U;
+
+private:
+    /// Key words.
+    uint32_t key[8];
+
+public:
+    /// Constructor.
+    /// @param key                      Pointer to the key
+    /// @param size                     Key size in bytes (32)
+    ChaCha20(const void *key, size_t size);
+
+    /// Destructor, wiping the key.
+    ~ChaCha20();
+
+    /// Delete copy constructor.
+    ChaCha20(const ChaCha20 &) = delete;
+
+    /// Delete assignment operator.
+    ChaCha20 &operator=(const ChaCha20 &) = delete;
+
+    /// Set a new key.
+    /// @param key                      Pointer to the key
+    /// @param size                     Key size in bytes (32)
+    void set_key(const void *key, size_t size);
+
+    /// Encrypt or decrypt data.
+    /// A partial final block consumes a whole counter value. Data that
+    /// would need blocks past counter 2^32 - 1 is rejected with
+    /// std::invalid_argument rather than reusing keystream.
+    /// @param nonce                    Pointer to the 12-byte nonce
+    /// @param counter                  Block counter, updated for the next call
+    ///                                 (0 once the last block has been used)
+    /// @param input                    Input data
+    /// @param output                   Output data (may equal input)
+    /// @param size                     Size of the data in bytes
+    void crypt(const uint8_t *nonce, uint32_t &counter, const uint8_t *input, uint8_t *output, size_t size);
+
+    /// Get the name of the backend selected for this processor.
+    /// @return                         Backend name ("avx512", "avx2", "ssse3" or "portable")
+    static const char *backend();
+
+    /// Get the number of keystream blocks generated in parallel by the selected backend.
+    /// @return                         Number of SIMD lanes
+    static size_t lanes();
+};
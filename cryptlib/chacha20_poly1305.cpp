@@ -0,0 +1,254 @@
+#include "chacha20_poly1305.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+// Zero bytes, for the all-zero initial MAC key and the padding
+static const uint8_t zeros[32] = {};
+
+// Largest text of one message: keystream blocks 1 to 2^32 - 1
+static const uint64_t max_text_size = 64ULL * 0xffffffffULL;
+
+// Text processed per keystream call, small enough to stay in L1 cache
+// until the MAC reads it
+static const size_t chunk_size = 8192U;
+
+// Store a little-endian 64-bit word
+static inline void store_le64(uint8_t *p, uint64_t x)
+{
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        p[i] = static_cast<uint8_t>(x >> (i * 8U));
+    }
+}
+
+// Wipe memory in a way the compiler cannot elide
+static void wipe(void *data, size_t size)
+{
+    volatile uint8_t *p = static_cast<volatile uint8_t*>(data);
+    for (size_t i = 0U; i < size; ++i)
+    {
+        p[i] = 0U;
+    }
+}
+
+ChaCha20Poly1305::ChaCha20Poly1305(const void *key, size_t size) :
+    cipher(key, size), mac(zeros), nonce(), counter(0U), stream(), streampos(0U), aadlen(0U), textlen(0U), text(false)
+{
+}
+
+ChaCha20Poly1305::~ChaCha20Poly1305()
+{
+    wipe(stream, sizeof(stream));
+}
+
+void ChaCha20Poly1305::set_key(const void *key, size_t size)
+{
+    cipher.set_key(key, size);
+}
+
+void ChaCha20Poly1305::start(const void *nonce, size_t size)
+{
+    if (size != nonce_size)
+    {
+        throw std::invalid_argument("ChaCha20-Poly1305 nonce must be 12 bytes");
+    }
+
+    std::memcpy(this->nonce, nonce, nonce_size);
+
+    // The one-time MAC key is the start of keystream block 0
+    uint8_t block[64] = {};
+    counter = 0U;
+    cipher.crypt(this->nonce, counter, block, block, sizeof(block));
+    mac.set_key(block);
+    wipe(block, sizeof(block));
+
+    streampos = 0U;
+    aadlen = 0U;
+    textlen = 0U;
+    text = false;
+}
+
+void ChaCha20Poly1305::add_aad(const void *data, size_t size)
+{
+    // The AAD is padded and closed once the text starts
+    if (text)
+    {
+        throw std::logic_error("ChaCha20-Poly1305 AAD must precede the text");
+    }
+
+    mac.add(data, size);
+    aadlen += size;
+}
+
+void ChaCha20Poly1305::crypt(const uint8_t *input, uint8_t *output, size_t size, bool encrypting)
+{
+    // Refuse text that would wrap the block counter and reuse keystream
+    if (size > max_text_size - textlen)
+    {
+        throw std::invalid_argument("ChaCha20-Poly1305 message is longer than 256 GiB");
+    }
+
+    // The AAD ends where the text starts, padded to a whole block
+    if (!text)
+    {
+        mac.add(zeros, (16U - aadlen % 16U) % 16U);
+        text = true;
+    }
+
+    textlen += size;
+
+    // Use up the keystream of a partial block
+    if (streampos && size)
+    {
+        size_t n = (size < 64U - streampos) ? size : 64U - streampos;
+        if (!encrypting)
+        {
+            mac.add(input, n);
+        }
+
+        for (size_t i = 0U; i < n; ++i)
+        {
+            output[i] = input[i] ^ stream[streampos + i];
+        }
+
+        if (encrypting)
+        {
+            mac.add(output, n);
+        }
+
+        streampos = (streampos + n) % 64U;
+        input += n;
+        output += n;
+        size -= n;
+    }
+
+    // Process whole blocks a chunk at a time; decryption authenticates the
+    // ciphertext before overwriting it
+    while (size >= 64U)
+    {
+        size_t n = size - size % 64U;
+        n = (n < chunk_size) ? n : chunk_size;
+        if (!encrypting)
+        {
+            mac.add(input, n);
+        }
+
+        cipher.crypt(nonce, counter, input, output, n);
+        if (encrypting)
+        {
+            mac.add(output, n);
+        }
+
+        input += n;
+        output += n;
+        size -= n;
+    }
+
+    // Start a partial block
+    if (size)
+    {
+        std::memset(stream, 0, sizeof(stream));
+        cipher.crypt(nonce, counter, stream, stream, sizeof(stream));
+        if (!encrypting)
+        {
+            mac.add(input, size);
+        }
+
+        for (size_t i = 0U; i < size; ++i)
+        {
+            output[i] = input[i] ^ stream[i];
+        }
+
+        if (encrypting)
+        {
+            mac.add(output, size);
+        }
+
+        streampos = size;
+    }
+}
+
+void ChaCha20Poly1305::encrypt(const uint8_t *input, uint8_t *output, size_t size)
+{
+    crypt(input, output, size, true);
+}
+
+void ChaCha20Poly1305::decrypt(const uint8_t *input, uint8_t *output, size_t size)
+{
+    crypt(input, output, size, false);
+}
+
+void ChaCha20Poly1305::finish(uint8_t *tag, size_t size)
+{
+    // Pad the AAD (if there was no text) and the text, then add the lengths
+    if (!text)
+    {
+        mac.add(zeros, (16U - aadlen % 16U) % 16U);
+        text = true;
+    }
+
+    mac.add(zeros, (16U - textlen % 16U) % 16U);
+    uint8_t lengths[16];
+    store_le64(lengths, aadlen);
+    store_le64(lengths + 8U, textlen);
+    mac.add(lengths, sizeof(lengths));
+
+    uint8_t full[16];
+    mac.close(full);
+    std::memcpy(tag, full, (size < 16U) ? size : 16U);
+    wipe(full, sizeof(full));
+    wipe(stream, sizeof(stream));
+    streampos = 0U;
+}
+
+bool ChaCha20Poly1305::verify(const uint8_t *tag, size_t size)
+{
+    uint8_t expected[16];
+    finish(expected);
+
+    // Compare without an early exit
+    if (size > 16U)
+    {
+        size = 16U;
+    }
+
+    uint8_t diff = 0U;
+    for (size_t i = 0U; i < size; ++i)
+    {
+        diff |= static_cast<uint8_t>(expected[i] ^ tag[i]);
+    }
+
+    wipe(expected, sizeof(expected));
+    return diff == 0U && size > 0U;
+}
+
+void ChaCha20Poly1305::seal(const void *nonce, size_t nonce_size, const void *aad, size_t aad_size,
+    const uint8_t *input, uint8_t *output, size_t size, uint8_t *tag)
+{
+    start(nonce, nonce_size);
+    add_aad(aad, aad_size);
+    encrypt(input, output, size);
+    finish(tag);
+}
+
+bool ChaCha20Poly1305::open(const void *nonce, size_t nonce_size, const void *aad, size_t aad_size,
+    const uint8_t *input, uint8_t *output, size_t size, const uint8_t *tag)
+{
+    start(nonce, nonce_size);
+    add_aad(aad, aad_size);
+    decrypt(input, output, size);
+    if (!verify(tag))
+    {
+        wipe(output, size);
+        return false;
+    }
+
+    return true;
+}
+
+const char *ChaCha20Poly1305::backend()
+{
+    static const std::string name = std::string(ChaCha20::backend()) + "+" + Poly1305::backend();
+    return name.c_str();
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "chacha20.hpp"
+#include "poly1305.hpp"
+
+/// ChaCha20-Poly1305 authenticated encryption class (RFC 8439).
+/// The text is encrypted and authenticated in chunks of a few kilobytes,
+/// so Poly1305 reads the ciphertext while it is still in cache from the
+/// keystream pass; both run in SIMD lanes where the processor allows.
+/// A message may be up to 256 GiB (2^32 - 1 keystream blocks); longer
+/// text is rejected with std::invalid_argument rather than wrapping the
+/// block counter.
+///
+/// A message is processed as start(), any number of add_aad() calls,
+/// any number of encrypt() or decrypt() calls, then finish() or verify().
+/// add_aad() after encrypt() or decrypt() throws std::logic_error.
+class ChaCha20Poly1305
+{
+public:
+    /// Key size in bytes.
+    static const size_t key_size = ChaCha20::key_size;
+
+    /// Nonce size in bytes.
+    static const size_t nonce_size = ChaCha20::nonce_size;
+
+    /// Tag size in bytes.
+    static const size_t tag_size = Poly1305::tag_size;
+
+private:
+    /// Stream cipher.
+    ChaCha20 cipher;
+
+    /// Authenticator, keyed per message.
+    Poly1305 mac;
+
+    /// Nonce of the current message.
+    uint8_t nonce[12];
+
+    /// Block counter for the next keystream block.
+    uint32_t counter;
+
+    /// Keystream of the current partial block.
+    uint8_t stream[64];
+
+    /// Bytes of the partial block used so far.
+    size_t streampos;
+
+    /// AAD size in bytes.
+    uint64_t aadlen;
+
+    /// Text size in bytes.
+    uint64_t textlen;
+
+    /// True once encryption or decryption has started.
+    bool text;
+
+    /// Process data with the keystream and authenticate the ciphertext.
+    /// @param input                    Input data
+    /// @param output                   Output data (may equal input)
+    /// @param size                     Size of the data in bytes
+    /// @param encrypting               True to encrypt, false to decrypt
+    void crypt(const uint8_t *input, uint8_t *output, size_t size, bool encrypting);
+
+public:
+    /// Constructor.
+    /// @param key                      Pointer to the key
+    /// @param size                     Key size in bytes (32)
+    ChaCha20Poly1305(const void *key, size_t size);
+
+    /// Destructor, wiping the key material.
+    ~ChaCha20Poly1305();
+
+    /// Delete copy constructor.
+    ChaCha20Poly1305(const ChaCha20Poly1305 &) = delete;
+
+    /// Delete assignment operator.
+    ChaCha20Poly1305 &operator=(const ChaCha20Poly1305 &) = delete;
+
+    /// Set a new key.
+    /// @param key                      Pointer to the key
+    /// @param size                     Key size in bytes (32)
+    void set_key(const void *key, size_t size);
+
+    /// Start a new message.
+    /// @param nonce                    Pointer to the nonce
+    /// @param size                     Nonce size in bytes (12)
+    void start(const void *nonce, size_t size);
+
+    /// Add additional authenticated data. Must precede encrypt() and decrypt();
+    /// a later call throws std::logic_error.
+    /// @param data                     Pointer to the data
+    /// @param size                     Size of the data in bytes
+    void add_aad(const void *data, size_t size);
+
+    /// Encrypt data.
+    /// @param input                    Plaintext
+    /// @param output                   Ciphertext (may equal input)
+    /// @param size                     Size of the data in bytes
+    void encrypt(const uint8_t *input, uint8_t *output, size_t size);
+
+    /// Decrypt data. The plaintext must not be used until verify() succeeds.
+    /// @param input                    Ciphertext
+    /// @param output                   Plaintext (may equal input)
+    /// @param size                     Size of the data in bytes
+    void decrypt(const uint8_t *input, uint8_t *output, size_t size);
+
+    /// Finish the message and compute the tag.
+    /// @param tag                      Output tag
+    /// @param size                     Tag size in bytes (up to 16)
+    void finish(uint8_t *tag, size_t size = 16U);
+
+    /// Finish the message and check the tag in constant time.
+    /// @param tag                      Expected tag
+    /// @param size                     Tag size in bytes (up to 16)
+    /// @return                         True if the tag matches
+    bool verify(const uint8_t *tag, size_t size = 16U);
+
+    /// Encrypt and authenticate a whole message.
+    /// @param nonce                    Pointer to the nonce
+    /// @param nonce_size               Nonce size in bytes (12)
+    /// @param aad                      Additional authenticated data
+    /// @param aad_size                 AAD size in bytes
+    /// @param input                    Plaintext
+    /// @param output                   Ciphertext (may equal input)
+    /// @param size                     Size of the plaintext in bytes
+    /// @param tag                      Output 16-byte tag
+    void seal(const void *nonce, size_t nonce_size, const void *aad, size_t aad_size,
+        const uint8_t *input, uint8_t *output, size_t size, uint8_t *tag);
+
+    /// Authenticate and decrypt a whole message. On failure, the output is zeroed.
+    /// @param nonce                    Pointer to the nonce
+    /// @param nonce_size               Nonce size in bytes (12)
+    /// @param aad                      Additional authenticated data
+    /// @param aad_size                 AAD size in bytes
+    /// @param input                    Ciphertext
+    /// @param output                   Plaintext (may equal input)
+    /// @param size                     Size of the ciphertext in bytes
+    /// @param tag                      Expected 16-byte tag
+    /// @return                         True if the tag matches
+    bool open(const void *nonce, size_t nonce_size, const void *aad, size_t aad_size,
+        const uint8_t *input, uint8_t *output, size_t size, const uint8_t *tag);
+
+    /// Get the names of the backends selected for this processor.
+    /// @return                         Backend names, as "<ChaCha20 backend>+<Poly1305 backend>"
+    static const char *backend();
+};
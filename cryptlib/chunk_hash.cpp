@@ -0,0 +1,310 @@
+#include "chunk_hash.hpp"
+#include "cpu_features.hpp"
+#include <stdexcept>
+
+/// Gear hash table: a random 64-bit value for each byte value.
+struct GearTable
+{
+    /// Table values.
+    uint64_t values[256];
+};
+
+// Fill the gear table from a splitmix64 sequence, usable in constant expressions
+static constexpr GearTable make_gear_table(uint64_t seed)
+{
+    GearTable table = {};
+    for (size_t i = 0U; i < 256U; ++i)
+    {
+        seed += 0x9e3779b97f4a7c15ULL;
+        uint64_t z = seed;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        table.values[i] = z ^ (z >> 31);
+    }
+
+    return table;
+}
+
+// Shift every gear table value left by one bit
+static constexpr GearTable shift_gear_table(const GearTable &table)
+{
+    GearTable shifted = {};
+    for (size_t i = 0U; i < 256U; ++i)
+    {
+        shifted.values[i] = table.values[i] << 1;
+    }
+
+    return shifted;
+}
+
+// Gear table; boundaries, and so chunk digests, depend on its values
+static constexpr GearTable gear = make_gear_table(0x4643444333323536ULL);
+
+// Gear table shifted left, for the first of two bytes rolled at once
+static constexpr GearTable gear_shifted = shift_gear_table(gear);
+
+// Get a boundary mask of the bits just below the top bit. The rolling hash
+// shifts left, so its high bits depend on the most bytes; the top bit is
+// left out so the mask can be shifted left by one.
+static uint64_t high_bits(unsigned bits)
+{
+    return (~0ULL << (64U - bits)) >> 1;
+}
+
+// Roll the hash over data[i..end) until a byte leaves the masked bits of
+// the hash all zero. Bytes are rolled two at a time: after the first of a
+// pair, the hash is the one-byte hash shifted left by one, so it is tested
+// against the shifted mask.
+static CRYPTLIB_INLINE size_t roll(const uint8_t *data, size_t i, size_t end, uint64_t mask, uint64_t &hash, bool &cut)
+{
+    const uint64_t shifted = mask << 1;
+    uint64_t h = hash;
+    cut = true;
+    for (; i + 2U <= end; i += 2U)
+    {
+        h = (h << 2) + gear_shifted.values[data[i]];
+        if (!(h & shifted))
+        {
+            return i + 1U;
+        }
+
+        h += gear.values[data[i + 1U]];
+        if (!(h & mask))
+        {
+            return i + 2U;
+        }
+    }
+
+    if (i < end)
+    {
+        h = (h << 1) + gear.values[data[i]];
+        if (!(h & mask))
+        {
+            return i + 1U;
+        }
+
+        ++i;
+    }
+
+    cut = false;
+    hash = h;
+    return i;
+}
+
+ChunkHash::ChunkHash(size_t min_size, size_t avg_size, size_t max_size, bool threaded) :
+    minsize(min_size), normalsize(avg_size), maxsize(max_size), masksmall(0U), masklarge(0U),
+    fingerprint(0U), length(0U), offset(0U), engine(), ready(), worker(), lock(), changed(),
+    job(nullptr), scanned(0U), hashed(0U), cuts(), stop(false)
+{
+    if (min_size < 64U || min_size > avg_size || avg_size > max_size)
+    {
+        throw std::invalid_argument("Chunk sizes must satisfy 64 <= min <= avg <= max");
+    }
+
+    // Round the average size to the nearest power of two
+    unsigned bits = 6U;
+    while ((static_cast<uint64_t>(3U) << (bits - 1U)) <= avg_size)
+    {
+        ++bits;
+    }
+
+    // Normalized chunking: one more mask bit before the normal size and
+    // one fewer after it narrows the spread of chunk sizes
+    masksmall = high_bits(bits + 1U);
+    masklarge = high_bits(bits - 1U);
+
+    if (threaded)
+    {
+        worker = std::thread([this]() { run(); });
+    }
+}
+
+ChunkHash::~ChunkHash()
+{
+    if (worker.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stop = true;
+            changed.notify_all();
+        }
+
+        worker.join();
+    }
+}
+
+size_t ChunkHash::scan(const uint8_t *data, size_t size, bool &cut)
+{
+    uint64_t hash = fingerprint;
+    size_t i = 0U;
+
+    // Cut-point skipping: no boundary is possible below the minimum size
+    if (length < minsize)
+    {
+        i = (minsize - length < size) ? minsize - length : size;
+    }
+
+    // Stricter mask up to the normal size, looser mask up to the maximum
+    size_t normal = (length < normalsize) ? normalsize - length : 0U;
+    size_t limit = maxsize - length;
+    normal = (normal < size) ? normal : size;
+    limit = (limit < size) ? limit : size;
+
+    i = roll(data, i, normal, masksmall, hash, cut);
+    if (!cut)
+    {
+        i = roll(data, i, limit, masklarge, hash, cut);
+    }
+
+    // A chunk reaching the maximum size ends there
+    if (cut || length + i == maxsize)
+    {
+        cut = true;
+        fingerprint = 0U;
+        length = 0U;
+    }
+    else
+    {
+        fingerprint = hash;
+        length += i;
+    }
+
+    return i;
+}
+
+void ChunkHash::run()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;)
+    {
+        changed.wait(guard, [&]() { return stop || !cuts.empty() || scanned > hashed; });
+        if (stop)
+        {
+            return;
+        }
+
+        // Hash up to the next boundary, or as far as the scan has got
+        const uint8_t *data = job;
+        size_t from = hashed;
+        bool cut = !cuts.empty();
+        Cut next = cut ? cuts.front() : Cut{ scanned, 0U, 0U };
+        guard.unlock();
+
+        engine.add(data + from, next.end - from);
+        Chunk chunk = { next.offset, next.size, Digest() };
+        if (cut)
+        {
+            engine.close(chunk.digest.data());
+            engine.clear();
+        }
+
+        guard.lock();
+        hashed = next.end;
+        if (cut)
+        {
+            cuts.pop_front();
+            ready.push_back(chunk);
+        }
+
+        changed.notify_all();
+    }
+}
+
+void ChunkHash::add(const void *data, size_t size)
+{
+    const uint8_t *p = static_cast<const uint8_t*>(data);
+    if (!threaded())
+    {
+        // Hash each piece of a chunk right after scanning it
+        for (size_t pos = 0U; pos < size;)
+        {
+            uint64_t start = offset;
+            size_t before = length;
+            bool cut;
+            size_t n = scan(p + pos, size - pos, cut);
+            engine.add(p + pos, n);
+            pos += n;
+
+            if (cut)
+            {
+                Chunk chunk = { start, before + n, Digest() };
+                engine.close(chunk.digest.data());
+                engine.clear();
+                offset += chunk.size;
+                ready.push_back(chunk);
+            }
+        }
+
+        return;
+    }
+
+    if (!size)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        job = p;
+        scanned = 0U;
+        hashed = 0U;
+    }
+
+    // Scan ahead of the worker, handing over each boundary as it is found
+    for (size_t pos = 0U; pos < size;)
+    {
+        uint64_t start = offset;
+        size_t before = length;
+        bool cut;
+        size_t n = scan(p + pos, size - pos, cut);
+        pos += n;
+
+        std::lock_guard<std::mutex> guard(lock);
+        if (cut)
+        {
+            cuts.push_back(Cut{ pos, start, before + n });
+            offset += before + n;
+        }
+
+        scanned = pos;
+        changed.notify_all();
+    }
+
+    // The data must be hashed before the caller can reuse it
+    std::unique_lock<std::mutex> guard(lock);
+    changed.wait(guard, [&]() { return hashed == size; });
+    job = nullptr;
+    scanned = 0U;
+    hashed = 0U;
+}
+
+void ChunkHash::close()
+{
+    // The worker is idle between calls to add()
+    std::lock_guard<std::mutex> guard(lock);
+    if (length)
+    {
+        Chunk chunk = { offset, length, Digest() };
+        engine.close(chunk.digest.data());
+        ready.push_back(chunk);
+    }
+
+    engine.clear();
+    fingerprint = 0U;
+    length = 0U;
+    offset = 0U;
+}
+
+size_t ChunkHash::take(std::vector<Chunk> &chunks)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    size_t count = ready.size();
+    chunks.insert(chunks.end(), ready.begin(), ready.end());
+    ready.clear();
+    return count;
+}
+
+bool ChunkHash::threaded() const
+{
+    return worker.joinable();
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "sha256_engine.hpp"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Content-defined chunking and fingerprinting class.
+/// Splits a stream into variable-size chunks with FastCDC (a gear rolling
+/// hash with cut-point skipping below the minimum size and normalized
+/// chunking around the average size) and hashes each chunk with SHA256
+/// in the same pass, so every byte is hashed while it is still in cache
+/// from the boundary scan. Optionally a worker thread hashes the chunks
+/// while the caller's thread scans ahead for the next boundaries. Chunks
+/// may span calls to add(); boundaries depend only on the content and the
+/// sizes, not on how the stream is split between calls.
+class ChunkHash
+{
+public:
+    /// SHA256 digest type.
+    typedef Sha256Engine::Digest Digest;
+
+    /// Chunk of the stream.
+    struct Chunk
+    {
+        /// Offset of the chunk in the stream
+        uint64_t offset;
+
+        /// Size of the chunk
+        size_t size;
+
+        /// SHA256 digest of the chunk
+        Digest digest;
+    };
+
+    /// Default minimum chunk size.
+    static const size_t default_min_size = 2048U;
+
+    /// Default average chunk size.
+    static const size_t default_avg_size = 8192U;
+
+    /// Default maximum chunk size.
+    static const size_t default_max_size = 65536U;
+
+private:
+    /// Boundary found by the scan, handed to the worker.
+    struct Cut
+    {
+        /// End of the chunk in the current buffer
+        size_t end;
+
+        /// Offset of the chunk in the stream
+        uint64_t offset;
+
+        /// Size of the chunk
+        size_t size;
+    };
+
+    /// Minimum chunk size.
+    size_t minsize;
+
+    /// Normal chunk size, where the boundary mask is relaxed.
+    size_t normalsize;
+
+    /// Maximum chunk size.
+    size_t maxsize;
+
+    /// Boundary mask below the normal size (more bits, fewer cuts).
+    uint64_t masksmall;
+
+    /// Boundary mask above the normal size (fewer bits, more cuts).
+    uint64_t masklarge;
+
+    /// Rolling hash of the current chunk.
+    uint64_t fingerprint;
+
+    /// Bytes of the current chunk scanned so far.
+    size_t length;
+
+    /// Stream offset of the current chunk.
+    uint64_t offset;
+
+    /// SHA256 engine of the chunk being hashed.
+    Sha256Engine engine;
+
+    /// Finished chunks not yet taken.
+    std::vector<Chunk> ready;
+
+    /// Worker thread, if threaded.
+    std::thread worker;
+
+    /// Lock for the state shared with the worker.
+    std::mutex lock;
+
+    /// Signalled when the shared state changes.
+    std::condition_variable changed;
+
+    /// Buffer being hashed by the worker.
+    const uint8_t *job;
+
+    /// Bytes of the buffer scanned so far.
+    size_t scanned;
+
+    /// Bytes of the buffer hashed so far.
+    size_t hashed;
+
+    /// Boundaries found in the buffer and not yet hashed.
+    std::deque<Cut> cuts;
+
+    /// Set to stop the worker.
+    bool stop;
+
+    /// Scan for the end of the current chunk.
+    /// @param data                     Pointer to the data
+    /// @param size                     Size of the data
+    /// @param cut                      Set if the chunk ends in the data
+    /// @return                         Number of bytes of the data in the current chunk
+    size_t scan(const uint8_t *data, size_t size, bool &cut);
+
+    /// Hash chunks as the scan finds their boundaries, on the worker thread.
+    void run();
+
+public:
+    /// Constructor.
+    /// @param min_size                 Minimum chunk size (at least 64)
+    /// @param avg_size                 Average chunk size (at least min_size); the
+    ///                                 boundary masks use the nearest power of two
+    /// @param max_size                 Maximum chunk size (at least avg_size)
+    /// @param threaded                 Hash the chunks on a worker thread
+    explicit ChunkHash(size_t min_size = default_min_size, size_t avg_size = default_avg_size, size_t max_size = default_max_size, bool threaded = false);
+
+    /// Delete copy constructor.
+    ChunkHash(const ChunkHash &) = delete;
+
+    /// Delete assignment operator.
+    ChunkHash &operator=(const ChunkHash &) = delete;
+
+    /// Destructor.
+    ~ChunkHash();
+
+    /// Add data to the stream.
+    /// The data is no longer referenced when the call returns.
+    /// @param data                     Pointer to the data to add
+    /// @param size                     Size of the data to add
+    void add(const void *data, size_t size);
+
+    /// End the stream, emitting the last chunk, and start a new stream at offset 0.
+    void close();
+
+    /// Move the finished chunks to a list.
+    /// @param chunks                   List to append the chunks to, in stream order
+    /// @return                         Number of chunks appended
+    size_t take(std::vector<Chunk> &chunks);
+
+    /// Check whether the chunks are hashed on a worker thread.
+    /// @return                         True if threaded
+    bool threaded() const;
+};
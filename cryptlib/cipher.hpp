@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// Block cipher interface.
+class BlockCipher
+{
+public:
+    /// Destructor.
+    virtual ~BlockCipher() = default;
+
+    /// Get the block size.
+    /// @return                         Block size in bytes
+    virtual size_t block_size() const = 0;
+
+    /// Encrypt whole blocks independently (ECB).
+    /// @param input                    Plaintext blocks
+    /// @param output                   Ciphertext blocks (may equal input)
+    /// @param blocks                   Number of blocks
+    virtual void encrypt(const uint8_t *input, uint8_t *output, size_t blocks) = 0;
+
+    /// Decrypt whole blocks independently (ECB).
+    /// @param input                    Ciphertext blocks
+    /// @param output                   Plaintext blocks (may equal input)
+    /// @param blocks                   Number of blocks
+    virtual void decrypt(const uint8_t *input, uint8_t *output, size_t blocks) = 0;
+};
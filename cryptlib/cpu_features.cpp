@@ -0,0 +1,139 @@
+#include "cpu_features.hpp"
+
+#if defined(CRYPTLIB_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+/// Detected feature flags.
+struct Features
+{
+    bool ssse3;
+    bool sse41;
+    bool aes;
+    bool pclmul;
+    bool sha;
+    bool avx2;
+    bool avx512f;
+};
+
+// Execute the CPUID instruction
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+#if defined(CRYPTLIB_X86) && defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+    regs[0] = static_cast<uint32_t>(r[0]);
+    regs[1] = static_cast<uint32_t>(r[1]);
+    regs[2] = static_cast<uint32_t>(r[2]);
+    regs[3] = static_cast<uint32_t>(r[3]);
+#elif defined(CRYPTLIB_X86)
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#else
+    (void)leaf;
+    (void)subleaf;
+    regs[0] = regs[1] = regs[2] = regs[3] = 0U;
+#endif
+}
+
+// Read the enabled register state mask (XCR0)
+static uint64_t xgetbv()
+{
+#if defined(CRYPTLIB_X86) && defined(_MSC_VER)
+    return _xgetbv(0);
+#elif defined(CRYPTLIB_X86)
+    uint32_t lo;
+    uint32_t hi;
+    __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+#else
+    return 0U;
+#endif
+}
+
+// Probe the processor
+static Features detect()
+{
+    Features f = {};
+
+    // Get the highest supported leaf
+    uint32_t regs[4];
+    cpuid(0U, 0U, regs);
+    uint32_t max = regs[0];
+
+    // Leaf 1 holds the SSE feature bits
+    bool ymm = false;
+    bool zmm = false;
+    if (max >= 1U)
+    {
+        cpuid(1U, 0U, regs);
+        f.ssse3 = (regs[2] & (1U << 9)) != 0U;
+        f.sse41 = (regs[2] & (1U << 19)) != 0U;
+        f.aes = (regs[2] & (1U << 25)) != 0U;
+        f.pclmul = (regs[2] & (1U << 1)) != 0U;
+
+        // The AVX registers are only usable if the OS saves them (OSXSAVE + XCR0)
+        if ((regs[2] & (1U << 27)) != 0U)
+        {
+            uint64_t xcr0 = xgetbv();
+            ymm = (xcr0 & 0x06U) == 0x06U;
+            zmm = (xcr0 & 0xE6U) == 0xE6U;
+        }
+    }
+
+    // Leaf 7 holds the extended feature bits
+    if (max >= 7U)
+    {
+        cpuid(7U, 0U, regs);
+        f.sha = (regs[1] & (1U << 29)) != 0U;
+        f.avx2 = ymm && (regs[1] & (1U << 5)) != 0U;
+        f.avx512f = zmm && (regs[1] & (1U << 16)) != 0U;
+    }
+
+    return f;
+}
+
+// Get the features, probing on first use
+static const Features &features()
+{
+    static const Features f = detect();
+    return f;
+}
+
+bool CpuFeatures::ssse3()
+{
+    return features().ssse3;
+}
+
+bool CpuFeatures::sse41()
+{
+    return features().sse41;
+}
+
+bool CpuFeatures::aes()
+{
+    return features().aes;
+}
+
+bool CpuFeatures::pclmul()
+{
+    return features().pclmul;
+}
+
+bool CpuFeatures::sha()
+{
+    return features().sha;
+}
+
+bool CpuFeatures::avx2()
+{
+    return features().avx2;
+}
+
+bool CpuFeatures::avx512f()
+{
+    return features().avx512f;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+/// Defined when compiling for an x86 or x64 processor.
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CRYPTLIB_X86 1
+#endif
+
+/// Enable an instruction set extension for a single function.
+/// MSVC allows intrinsics anywhere so this expands to nothing; GCC and
+/// Clang need the target attribute to accept the intrinsics.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define CRYPTLIB_TARGET(isa)
+#else
+#define CRYPTLIB_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+/// Force a function to be inlined. Used for SIMD helpers that pass blocks
+/// by reference, which would otherwise go through memory if outlined.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define CRYPTLIB_INLINE __forceinline
+#else
+#define CRYPTLIB_INLINE inline __attribute__((always_inline))
+#endif
+
+/// Processor feature detection.
+class CpuFeatures
+{
+public:
+    /// Test for SSSE3 support.
+    /// @return                         True if supported
+    static bool ssse3();
+
+    /// Test for SSE4.1 support.
+    /// @return                         True if supported
+    static bool sse41();
+
+    /// Test for the AES instructions (AES-NI).
+    /// @return                         True if supported
+    static bool aes();
+
+    /// Test for the carry-less multiplication instruction (PCLMULQDQ).
+    /// @return                         True if supported
+    static bool pclmul();
+
+    /// Test for the SHA extensions (SHA-NI).
+    /// @return                         True if supported
+    static bool sha();
+
+    /// Test for AVX2 support (including operating system support).
+    /// @return                         True if supported
+    static bool avx2();
+
+    /// Test for AVX-512 Foundation support (including operating system support).
+    /// @return                         True if supported
+    static bool avx512f();
+};
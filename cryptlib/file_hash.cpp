@@ -0,0 +1,392 @@
+#include "file_hash.hpp"
+#include "blake3_hash.hpp"
+#include "md5_hash.hpp"
+#include "sha1_hash.hpp"
+#include "sha256_hash.hpp"
+#include "sha512_hash.hpp"
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Hash a file through a read-only memory map
+// Returns false if the file cannot be mapped, leaving the hash untouched
+static bool hash_mapped(const char *path, Hash &hash)
+{
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 || static_cast<uint64_t>(size.QuadPart) > SIZE_MAX)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+    {
+        return false;
+    }
+
+    const void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!view)
+    {
+        return false;
+    }
+
+    hash.add(view, static_cast<size_t>(size.QuadPart));
+    UnmapViewOfFile(view);
+    return true;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0 ||
+        static_cast<uint64_t>(info.st_size) > SIZE_MAX)
+    {
+        close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(info.st_size);
+    void *view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+    {
+        return false;
+    }
+
+    // Ask for aggressive read-ahead; pages behind the hash can be dropped
+    madvise(view, size, MADV_SEQUENTIAL);
+    madvise(view, size, MADV_WILLNEED);
+
+    hash.add(view, size);
+    munmap(view, size);
+    return true;
+#endif
+}
+
+// Hash a file with buffered reads
+static bool hash_read(const char *path, Hash &hash)
+{
+    bool stdin_path = std::strcmp(path, "-") == 0;
+    std::FILE *file = stdin_path ? stdin : std::fopen(path, "rb");
+    if (!file)
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> buffer(1U << 20);
+    size_t count;
+    while ((count = std::fread(buffer.data(), 1U, buffer.size(), file)) != 0U)
+    {
+        hash.add(buffer.data(), count);
+    }
+
+    bool ok = !std::ferror(file);
+    if (!stdin_path)
+    {
+        std::fclose(file);
+    }
+
+    return ok;
+}
+
+/// Work-stealing queue of file indices.
+/// Each worker pops from the front of its own queue and steals from the
+/// back of the others when its own runs dry.
+struct WorkQueue
+{
+    /// Queue lock
+    std::mutex lock;
+
+    /// Queued file indices
+    std::deque<size_t> items;
+};
+
+std::unique_ptr<Hash> FileHash::create(Algorithm algorithm)
+{
+    switch (algorithm)
+    {
+    case md5:
+        return std::unique_ptr<Hash>(new Md5Hash());
+
+    case sha1:
+        return std::unique_ptr<Hash>(new Sha1Hash());
+
+    case sha384:
+        return std::unique_ptr<Hash>(new Sha384Hash());
+
+    case sha512:
+        return std::unique_ptr<Hash>(new Sha512Hash());
+
+    case sha512_256:
+        return std::unique_ptr<Hash>(new Sha512_256Hash());
+
+    case blake3:
+        return std::unique_ptr<Hash>(new Blake3Hash());
+
+    default:
+        return std::unique_ptr<Hash>(new Sha256Hash());
+    }
+}
+
+bool FileHash::parse(const char *name, Algorithm &algorithm)
+{
+    static const struct
+    {
+        const char *name;
+        Algorithm algorithm;
+    } names[] =
+    {
+        { "md5", md5 },
+        { "sha1", sha1 },
+        { "sha256", sha256 },
+        { "sha384", sha384 },
+        { "sha512", sha512 },
+        { "sha512-256", sha512_256 },
+        { "blake3", blake3 }
+    };
+
+    for (const auto &entry : names)
+    {
+        if (std::strcmp(entry.name, name) == 0)
+        {
+            algorithm = entry.algorithm;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool FileHash::hash(const char *path, Hash &hash, uint8_t *digest)
+{
+    hash.clear();
+    if (std::strcmp(path, "-") != 0 && hash_mapped(path, hash))
+    {
+        hash.close(digest);
+        return true;
+    }
+
+    // Empty files, pipes and other unmappable files are read instead
+    hash.clear();
+    if (!hash_read(path, hash))
+    {
+        return false;
+    }
+
+    hash.close(digest);
+    return true;
+}
+
+std::vector<FileHash::Result> FileHash::hash(const std::vector<std::string> &paths, Algorithm algorithm, unsigned threads)
+{
+    std::vector<Result> results(paths.size());
+    if (threads == 0U)
+    {
+        threads = std::thread::hardware_concurrency();
+    }
+
+    if (threads > paths.size())
+    {
+        threads = static_cast<unsigned>(paths.size());
+    }
+
+    if (threads == 0U)
+    {
+        return results;
+    }
+
+    // Deal contiguous runs of files to each worker
+    std::vector<WorkQueue> queues(threads);
+    for (size_t i = 0U; i < paths.size(); ++i)
+    {
+        queues[i * threads / paths.size()].items.push_back(i);
+    }
+
+    auto worker = [&](unsigned self)
+    {
+        std::unique_ptr<Hash> hash = create(algorithm);
+        std::vector<uint8_t> digest(hash->size());
+
+        for (;;)
+        {
+            // Take from our own queue first, then steal from the others
+            bool found = false;
+            size_t index = 0U;
+            for (unsigned i = 0U; i < threads && !found; ++i)
+            {
+                WorkQueue &queue = queues[(self + i) % threads];
+                std::lock_guard<std::mutex> guard(queue.lock);
+                if (!queue.items.empty())
+                {
+                    found = true;
+                    if (i == 0U)
+                    {
+                        index = queue.items.front();
+                        queue.items.pop_front();
+                    }
+                    else
+                    {
+                        index = queue.items.back();
+                        queue.items.pop_back();
+                    }
+                }
+            }
+
+            // No work is added once started, so empty queues mean we are done
+            if (!found)
+            {
+                return;
+            }
+
+            results[index].path = paths[index];
+            if (FileHash::hash(paths[index].c_str(), *hash, digest.data()))
+            {
+                results[index].digest = digest;
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1U; i < threads; ++i)
+    {
+        pool.emplace_back(worker, i);
+    }
+
+    worker(0U);
+    for (std::thread &thread : pool)
+    {
+        thread.join();
+    }
+
+    return results;
+}
+
+std::string FileHash::format(const Result &result)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    // Paths containing backslashes or newlines are escaped and the line
+    // is prefixed with a backslash, as sha256sum does
+    bool escape = result.path.find_first_of("\\\n") != std::string::npos;
+
+    std::string line;
+    if (escape)
+    {
+        line += '\\';
+    }
+
+    for (uint8_t byte : result.digest)
+    {
+        line += hex[byte >> 4];
+        line += hex[byte & 15U];
+    }
+
+    line += "  ";
+    for (char c : result.path)
+    {
+        if (escape && c == '\\')
+        {
+            line += "\\\\";
+        }
+        else if (escape && c == '\n')
+        {
+            line += "\\n";
+        }
+        else
+        {
+            line += c;
+        }
+    }
+
+    line += '\n';
+    return line;
+}
+
+bool FileHash::parse(const std::string &line, Entry &entry)
+{
+    size_t pos = 0U;
+    bool escape = !line.empty() && line[0] == '\\';
+    if (escape)
+    {
+        ++pos;
+    }
+
+    // Hex digest
+    entry.digest.clear();
+    for (; pos + 1U < line.size() && line[pos] != ' '; pos += 2U)
+    {
+        int value = 0;
+        for (size_t i = 0U; i < 2U; ++i)
+        {
+            char c = line[pos + i];
+            int nibble =
+                (c >= '0' && c <= '9') ? c - '0' :
+                (c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+                (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+            if (nibble < 0)
+            {
+                return false;
+            }
+
+            value = value * 16 + nibble;
+        }
+
+        entry.digest.push_back(static_cast<uint8_t>(value));
+    }
+
+    // Separator: two spaces (text mode) or a space and an asterisk (binary mode)
+    if (entry.digest.empty() || pos + 2U >= line.size() || line[pos] != ' ' ||
+        (line[pos + 1U] != ' ' && line[pos + 1U] != '*'))
+    {
+        return false;
+    }
+
+    // Path, unescaping if needed
+    entry.path.clear();
+    for (pos += 2U; pos < line.size(); ++pos)
+    {
+        char c = line[pos];
+        if (escape && c == '\\' && pos + 1U < line.size())
+        {
+            c = line[++pos];
+            if (c == 'n')
+            {
+                c = '\n';
+            }
+            else if (c != '\\')
+            {
+                return false;
+            }
+        }
+
+        entry.path += c;
+    }
+
+    return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "hash.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+/// File hashing class.
+/// Hashes files through read-only memory maps with sequential access hints,
+/// falling back to buffered reads for pipes and other unmappable files.
+/// Many files are spread over a work-stealing pool of worker threads.
+/// Manifests use the sha256sum/md5sum/sha1sum/sha512sum line format.
+class FileHash
+{
+public:
+    /// Hash algorithm.
+    enum Algorithm
+    {
+        md5,
+        sha1,
+        sha256,
+        sha384,
+        sha512,
+        sha512_256,
+        blake3
+    };
+
+    /// Result of hashing one file.
+    struct Result
+    {
+        /// File path
+        std::string path;
+
+        /// File digest (empty if the file could not be read)
+        std::vector<uint8_t> digest;
+    };
+
+    /// Manifest entry.
+    struct Entry
+    {
+        /// File path
+        std::string path;
+
+        /// Expected digest
+        std::vector<uint8_t> digest;
+    };
+
+    /// Create a hash object for an algorithm.
+    /// @param algorithm                Hash algorithm
+    /// @return                         New hash object
+    static std::unique_ptr<Hash> create(Algorithm algorithm);
+
+    /// Look up an algorithm by name.
+    /// @param name                     Algorithm name ("md5", "sha1", "sha256", "sha384",
+    ///                                 "sha512", "sha512-256" or "blake3")
+    /// @param algorithm                Output algorithm
+    /// @return                         True if the name is known
+    static bool parse(const char *name, Algorithm &algorithm);
+
+    /// Hash a single file.
+    /// @param path                     File path ("-" for standard input)
+    /// @param hash                     Hash object to use
+    /// @param digest                   Output buffer of hash.size() bytes
+    /// @return                         True on success
+    static bool hash(const char *path, Hash &hash, uint8_t *digest);
+
+    /// Hash many files in parallel.
+    /// @param paths                    File paths
+    /// @param algorithm                Hash algorithm
+    /// @param threads                  Number of worker threads (0 for one per processor)
+    /// @return                         Results in the order of the paths
+    static std::vector<Result> hash(const std::vector<std::string> &paths, Algorithm algorithm, unsigned threads = 0U);
+
+    /// Format a result as a manifest line.
+    /// @param result                   Result to format
+    /// @return                         Line in sha256sum format, with a trailing newline
+    static std::string format(const Result &result);
+
+    /// Parse a manifest line.
+    /// @param line                     Line in sha256sum format, without the trailing newline
+    /// @param entry                    Output entry
+    /// @return                         True if the line is well formed
+    static bool parse(const std::string &line, Entry &entry);
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+// Declarations shared by the C interfaces to the hash functions.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Data buffer descriptor.
+typedef struct HashData
+{
+    /// Pointer to the data
+    const void *data;
+
+    /// Size of the data
+    size_t size;
+} HashData;
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,8 +1,71 @@
 #pragma once
 
+#include "hash.h"
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
+/// Fixed-size message digest.
+/// @tparam N                           Digest size in bytes
+template <size_t N>
+struct HashDigest
+{
+    /// Digest bytes
+    uint8_t bytes[N];
+
+    /// Get the digest size.
+    /// @return                         Digest size in bytes
+    static constexpr size_t size() { return N; }
+
+    /// Get a pointer to the digest bytes.
+    /// @return                         Pointer to the digest bytes
+    constexpr uint8_t *data() { return bytes; }
+
+    /// Get a pointer to the digest bytes.
+    /// @return                         Pointer to the digest bytes
+    constexpr const uint8_t *data() const { return bytes; }
+
+    /// Access a digest byte.
+    /// @param i                        Byte index
+    /// @return                         Reference to the byte
+    constexpr uint8_t &operator[](size_t i) { return bytes[i]; }
+
+    /// Access a digest byte.
+    /// @param i                        Byte index
+    /// @return                         Reference to the byte
+    constexpr const uint8_t &operator[](size_t i) const { return bytes[i]; }
+
+    /// Get an iterator to the first byte.
+    constexpr const uint8_t *begin() const { return bytes; }
+
+    /// Get an iterator past the last byte.
+    constexpr const uint8_t *end() const { return bytes + N; }
+
+    /// Compare two digests.
+    /// @param other                    Digest to compare with
+    /// @return                         True if the digests are equal
+    constexpr bool operator==(const HashDigest &other) const
+    {
+        for (size_t i = 0U; i < N; ++i)
+        {
+            if (bytes[i] != other.bytes[i])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /// Compare two digests.
+    /// @param other                    Digest to compare with
+    /// @return                         True if the digests differ
+    constexpr bool operator!=(const HashDigest &other) const
+    {
+        return !(*this == other);
+    }
+};
+
 /// Hash interface.
 class Hash
 {
@@ -15,7 +78,33 @@ public:
     /// @param size                     Size of the data to add
 	virtual void add(const void *data, size_t size) = 0;
 
+    /// Add a list of data segments to the hash, as if each was added in
+    /// turn, with a single virtual call. Suits fragment chains and the
+    /// pointer/length pairs of a POSIX struct iovec array.
+    /// @param segments                 Data segments
+    /// @param count                    Number of segments
+    virtual void add(const HashData *segments, size_t count)
+    {
+        for (size_t i = 0U; i < count; ++i)
+        {
+            add(segments[i].data, segments[i].size);
+        }
+    }
+
+    /// Get the digest size.
+    /// @return                         Digest size in bytes
+    virtual size_t size() const = 0;
+
+    /// Close the hash and write the digest without allocating.
+    /// @param digest                   Output buffer of size() bytes
+    virtual void close(uint8_t *digest) = 0;
+
     /// Close the hash and calculate the digest.
     /// @return                         Message digest
-	virtual std::vector<uint8_t> close() = 0;
+    std::vector<uint8_t> close()
+    {
+        std::vector<uint8_t> digest(size());
+        close(digest.data());
+        return digest;
+    }
 };
\ No newline at end of file
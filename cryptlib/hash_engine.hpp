@@ -0,0 +1,411 @@
+#pragma once
+
+#include "hash.hpp"
+#include "hash_stats.hpp"
+#include <cstring>
+#include <type_traits>
+
+/// Hash engine base class.
+/// Provides the block buffering, padding and length encoding shared by the
+/// Merkle-Damgard hashes. The derived engine is bound at compile time
+/// (CRTP) and supplies the compression function
+///     constexpr void process(const uint8_t *blocks, size_t count);
+/// so add() and close() are statically dispatched and can be inlined into
+/// the caller. Engines with a constexpr process() can hash in constant
+/// expressions. The derived engine also names its HashStats::Algorithm in
+///     static const HashStats::Algorithm algorithm;
+/// (HashStats::untracked for constant expression engines), under which the
+/// engine counts its work when built with CRYPTLIB_STATS.
+/// @tparam Derived                     Derived engine class
+/// @tparam Word                        State word type
+/// @tparam StateWords                  Number of state words
+/// @tparam BlockSize                   Block size in bytes
+/// @tparam DigestSize                  Digest size in bytes
+/// @tparam BigEndian                   Encode the length and digest big-endian
+template <typename Derived, typename Word, size_t StateWords, size_t BlockSize, size_t DigestSize, bool BigEndian>
+class HashEngine
+{
+public:
+    /// Digest type.
+    typedef HashDigest<DigestSize> Digest;
+
+    /// Block size in bytes.
+    static const size_t block_size = BlockSize;
+
+    /// Digest size in bytes.
+    static const size_t digest_size = DigestSize;
+
+    /// Number of state words.
+    static const size_t state_words = StateWords;
+
+    /// True if the length and digest are encoded big-endian.
+    static const bool big_endian = BigEndian;
+
+protected:
+    /// State vector.
+    Word state[StateWords];
+
+    /// Accumulation buffer.
+    uint8_t buffer[BlockSize];
+
+    /// Accumulation buffer length.
+    size_t buflen;
+
+    /// Total bit count.
+    uint64_t totlen;
+
+    /// Constructor.
+    constexpr HashEngine() : state(), buffer(), buflen(0U), totlen(0U) {}
+
+    /// Rotate a word left.
+    static constexpr Word rtl(Word x, size_t c)
+    {
+        return static_cast<Word>((x << c) | (x >> (sizeof(Word) * 8U - c)));
+    }
+
+    /// Rotate a word right.
+    static constexpr Word rtr(Word x, size_t c)
+    {
+        return static_cast<Word>((x >> c) | (x << (sizeof(Word) * 8U - c)));
+    }
+
+private:
+    /// Get the derived engine.
+    constexpr Derived &derived()
+    {
+        return static_cast<Derived&>(*this);
+    }
+
+    /// Count an instrumentation event, or nothing without CRYPTLIB_STATS.
+    /// @param counter                  Counter
+    /// @param n                        Amount to add
+    constexpr void tally(HashStats::Counter counter, uint64_t n)
+    {
+#if defined(CRYPTLIB_STATS)
+        if (Derived::algorithm != HashStats::untracked)
+        {
+            HashStats::count(Derived::algorithm, counter, n);
+        }
+#else
+        (void)counter;
+        (void)n;
+#endif
+    }
+
+    /// Process whole blocks with the derived engine, counting the call and
+    /// timing it when the sampling interval comes round.
+    /// @param blocks                   Pointer to the blocks to process
+    /// @param count                    Number of blocks
+    constexpr void transform(const uint8_t *blocks, size_t count)
+    {
+#if defined(CRYPTLIB_STATS)
+        if (Derived::algorithm != HashStats::untracked)
+        {
+            tally(HashStats::blocks, count);
+            tally(HashStats::calls, 1U);
+            if (HashStats::sample())
+            {
+                uint64_t start = HashStats::now();
+                derived().process(blocks, count);
+                tally(HashStats::ticks, HashStats::now() - start);
+                tally(HashStats::samples, 1U);
+                return;
+            }
+        }
+#endif
+        derived().process(blocks, count);
+    }
+
+    /// Process whole blocks in place.
+    constexpr void absorb(const uint8_t *data, size_t blocks)
+    {
+        transform(data, blocks);
+    }
+
+    /// Process whole blocks of another byte type by copying through the buffer.
+    template <typename T>
+    constexpr void absorb(const T *data, size_t blocks)
+    {
+        for (; blocks; --blocks, data += BlockSize)
+        {
+            for (size_t i = 0U; i < BlockSize; ++i)
+            {
+                buffer[i] = static_cast<uint8_t>(data[i]);
+            }
+
+            tally(HashStats::copies, 1U);
+            transform(buffer, 1U);
+        }
+    }
+
+    /// Write the digest from the state vector.
+    constexpr void output(uint8_t *digest) const
+    {
+        for (size_t i = 0U; i < DigestSize; ++i)
+        {
+            size_t shift = (BigEndian ? sizeof(Word) - 1U - i % sizeof(Word) : i % sizeof(Word)) * 8U;
+            digest[i] = static_cast<uint8_t>(state[i / sizeof(Word)] >> shift);
+        }
+    }
+
+public:
+    /// Add data to the hash.
+    /// @param data                     Pointer to the bytes or characters to add
+    /// @param size                     Size of the data to add
+    template <typename T, typename = typename std::enable_if<sizeof(T) == 1U>::type>
+    constexpr void add(const T *data, size_t size)
+    {
+        totlen += static_cast<uint64_t>(size) * 8U;
+        tally(HashStats::bytes, size);
+
+        // Complete any partially filled block first
+        if (buflen)
+        {
+            tally(HashStats::copies, 1U);
+            size_t use = (size < BlockSize - buflen) ? size : BlockSize - buflen;
+            for (size_t i = 0U; i < use; ++i)
+            {
+                buffer[buflen + i] = static_cast<uint8_t>(data[i]);
+            }
+
+            data += use;
+            size -= use;
+            buflen += use;
+
+            // Wait for more data if the block is still incomplete
+            if (buflen < BlockSize)
+            {
+                return;
+            }
+
+            transform(buffer, 1U);
+            buflen = 0U;
+        }
+
+        // Process full blocks directly from the caller's buffer
+        size_t blocks = size / BlockSize;
+        if (blocks)
+        {
+            absorb(data, blocks);
+            data += blocks * BlockSize;
+            size -= blocks * BlockSize;
+        }
+
+        // Buffer the remaining partial block
+        if (size)
+        {
+            tally(HashStats::copies, 1U);
+        }
+
+        for (size_t i = 0U; i < size; ++i)
+        {
+            buffer[i] = static_cast<uint8_t>(data[i]);
+        }
+
+        buflen = size;
+    }
+
+    /// Add data to the hash.
+    /// @param data                     Pointer to the data to add
+    /// @param size                     Size of the data to add
+    void add(const void *data, size_t size)
+    {
+        add(static_cast<const uint8_t*>(data), size);
+    }
+
+    /// Add a list of data segments to the hash. Blocks that straddle
+    /// segments are assembled in a local staging area and processed
+    /// several at a time; whole blocks inside a segment are processed in
+    /// place.
+    /// @param segments                 Data segments
+    /// @param count                    Number of segments
+    void add(const HashData *segments, size_t count)
+    {
+        const size_t stageblocks = 8U;
+        uint8_t stage[BlockSize * stageblocks];
+        std::memcpy(stage, buffer, buflen);
+        size_t staged = buflen;
+
+        for (; count; --count, ++segments)
+        {
+            const uint8_t *data = static_cast<const uint8_t*>(segments->data);
+            size_t size = segments->size;
+            totlen += static_cast<uint64_t>(size) * 8U;
+            tally(HashStats::bytes, size);
+
+            while (size)
+            {
+                size_t partial = staged % BlockSize;
+                if (!partial && size >= BlockSize)
+                {
+                    // At a block boundary: flush the staged blocks, then
+                    // process the segment's whole blocks in place
+                    if (staged)
+                    {
+                        transform(stage, staged / BlockSize);
+                        staged = 0U;
+                    }
+
+                    size_t blocks = size / BlockSize;
+                    transform(data, blocks);
+                    data += blocks * BlockSize;
+                    size -= blocks * BlockSize;
+                    continue;
+                }
+
+                // Stage bytes up to the end of the current block
+                size_t use = (size < BlockSize - partial) ? size : BlockSize - partial;
+                std::memcpy(stage + staged, data, use);
+                tally(HashStats::copies, 1U);
+                data += use;
+                size -= use;
+                staged += use;
+                if (staged == sizeof(stage))
+                {
+                    transform(stage, stageblocks);
+                    staged = 0U;
+                }
+            }
+        }
+
+        // Process the staged whole blocks and keep the partial one
+        size_t blocks = staged / BlockSize;
+        if (blocks)
+        {
+            transform(stage, blocks);
+        }
+
+        buflen = staged - blocks * BlockSize;
+        std::memcpy(buffer, stage + blocks * BlockSize, buflen);
+    }
+
+    /// Close the hash and write the digest.
+    /// @param digest                   Output buffer of DigestSize bytes
+    constexpr void close(uint8_t *digest)
+    {
+        // The length field is 8 bytes for 64-byte blocks and 16 for 128-byte blocks
+        const size_t lenpos = BlockSize - BlockSize / 8U;
+
+        // Pad, spilling into an extra block if the length does not fit
+        tally(HashStats::finals, 1U);
+        buffer[buflen++] = 0x80U;
+        if (buflen > lenpos)
+        {
+            while (buflen < BlockSize)
+            {
+                buffer[buflen++] = 0x00U;
+            }
+
+            transform(buffer, 1U);
+            buflen = 0U;
+        }
+
+        while (buflen < BlockSize - 8U)
+        {
+            buffer[buflen++] = 0x00U;
+        }
+
+        // Add length
+        for (size_t i = 0U; i < 8U; ++i)
+        {
+            buffer[buflen++] = static_cast<uint8_t>(totlen >> (BigEndian ? 56U - i * 8U : i * 8U));
+        }
+
+        transform(buffer, 1U);
+        buflen = 0U;
+        output(digest);
+    }
+
+    /// Close the hash and return the digest.
+    /// @return                         Message digest
+    constexpr Digest close()
+    {
+        Digest digest = {};
+        close(digest.data());
+        return digest;
+    }
+
+    /// Close the hash with a final block that the caller has already
+    /// padded and length-encoded, and write the digest. Suits inner loops
+    /// that hash fixed-length messages from a saved midstate, where the
+    /// padding never changes. Nothing may be buffered.
+    /// @param block                    Pointer to the padded final block
+    /// @param digest                   Output buffer of DigestSize bytes
+    constexpr void close_block(const uint8_t *block, uint8_t *digest)
+    {
+        tally(HashStats::finals, 1U);
+        transform(block, 1U);
+        output(digest);
+    }
+
+    /// Get the state vector, for code that runs the compression function
+    /// on several midstates in parallel.
+    /// @return                         Pointer to the state words
+    constexpr const Word *midstate() const
+    {
+        return state;
+    }
+
+    /// Hash a message in one call, bypassing the streaming buffer.
+    /// Messages that pad to one or two blocks (up to 55 or 119 bytes with
+    /// 64-byte blocks) are padded in place and compressed with a single
+    /// process() call. Longer messages are compressed in place up
+    /// to the tail.
+    /// @param data                     Pointer to the message
+    /// @param size                     Size of the message
+    /// @param digest                   Output buffer of DigestSize bytes
+    static void hash(const void *data, size_t size, uint8_t *digest)
+    {
+        const size_t lenpos = BlockSize - BlockSize / 8U;
+        const uint8_t *message = static_cast<const uint8_t*>(data);
+        const uint64_t bits = static_cast<uint64_t>(size) * 8U;
+        Derived engine;
+        engine.tally(HashStats::bytes, size);
+        engine.tally(HashStats::finals, 1U);
+
+        // Leave at most a whole block and a tail that shares its padded block
+        if (size >= BlockSize + lenpos)
+        {
+            size_t whole = size / BlockSize;
+            engine.transform(message, whole);
+            message += whole * BlockSize;
+            size -= whole * BlockSize;
+        }
+
+        // Pad into the engine buffer, which the constructor has cleared, or
+        // into a cleared local block pair if the length does not fit. The
+        // word copy and whole-word length store compile to plain moves; a
+        // bounded memcpy() is expanded to string instructions whose startup
+        // cost rivals the compression of a block.
+        uint8_t pair[2U * BlockSize];
+        uint8_t *tail = engine.buffer;
+        size_t blocks = 1U;
+        if (size >= lenpos)
+        {
+            std::memset(pair, 0, sizeof(pair));
+            tail = pair;
+            blocks = 2U;
+        }
+
+        size_t pos = 0U;
+        for (; pos + 8U <= size; pos += 8U)
+        {
+            std::memcpy(tail + pos, message + pos, 8U);
+        }
+        for (; pos < size; ++pos)
+        {
+            tail[pos] = message[pos];
+        }
+        tail[size] = 0x80U;
+        engine.tally(HashStats::copies, 1U);
+        uint8_t length[8];
+        for (size_t i = 0U; i < 8U; ++i)
+        {
+            length[i] = static_cast<uint8_t>(bits >> (BigEndian ? 56U - i * 8U : i * 8U));
+        }
+        std::memcpy(tail + blocks * BlockSize - 8U, length, 8U);
+
+        engine.transform(tail, blocks);
+        engine.output(digest);
+    }
+};
@@ -0,0 +1,201 @@
+#pragma once
+
+#include "hash.hpp"
+#include "cpu_features.hpp"
+#include <cstring>
+
+// Lane scheduling shared by the multi-buffer hashes.
+
+#if defined(CRYPTLIB_X86)
+#include <immintrin.h>
+#endif
+
+/// Message scheduled onto a SIMD lane.
+/// @tparam BigEndian                   Encode the length big-endian
+template <bool BigEndian>
+struct HashLane
+{
+    /// Next full block of message data.
+    const uint8_t *data;
+
+    /// Full message blocks remaining.
+    size_t blocks;
+
+    /// Final padded block(s) holding the message tail, padding and length.
+    uint8_t tail[128];
+
+    /// Number of final padded blocks.
+    size_t tailblocks;
+
+    /// Number of final padded blocks already processed.
+    size_t tailpos;
+
+    /// Digest output.
+    uint8_t *digest;
+
+    /// Start hashing a message.
+    /// @param message                  Message to hash
+    /// @param out                      Digest output
+    void start(const HashData &message, uint8_t *out)
+    {
+        // Full blocks are hashed in place
+        data = static_cast<const uint8_t*>(message.data);
+        blocks = message.size / 64U;
+
+        // Build the padded tail blocks
+        size_t rem = message.size % 64U;
+        tailblocks = (rem < 56U) ? 1U : 2U;
+        tailpos = 0U;
+        std::memset(tail, 0, sizeof(tail));
+        if (rem)
+        {
+            std::memcpy(tail, data + blocks * 64U, rem);
+        }
+        tail[rem] = 0x80U;
+
+        // Add the bit length
+        uint64_t len = static_cast<uint64_t>(message.size) * 8U;
+        uint8_t *end = tail + tailblocks * 64U - 8U;
+        for (size_t i = 0U; i < 8U; ++i, len >>= 8)
+        {
+            end[BigEndian ? 7U - i : i] = static_cast<uint8_t>(len);
+        }
+
+        digest = out;
+    }
+
+    /// Get the next block to process.
+    /// @return                         Pointer to the 64-byte block
+    const uint8_t *block() const
+    {
+        return blocks ? data : tail + tailpos * 64U;
+    }
+
+    /// Advance past the block returned by block().
+    /// @return                         True if the message is complete
+    bool advance()
+    {
+        if (blocks)
+        {
+            data += 64U;
+            --blocks;
+            return false;
+        }
+
+        return ++tailpos == tailblocks;
+    }
+};
+
+// Hash messages on N lanes, refilling each lane as its message completes.
+// The compression function processes one block per lane on the transposed
+// state, updating only the active lanes.
+template <typename Engine, size_t N>
+void hash_lanes(
+    const HashData *messages,
+    size_t count,
+    uint8_t *digests,
+    void (*compress)(uint32_t (*state)[N], const uint8_t *const *blocks, uint32_t active))
+{
+    static const uint8_t idle[64] = {};
+    const size_t words = Engine::state_words;
+    const size_t size = Engine::digest_size;
+
+    // Transposed state: state[word][lane]
+    alignas(64) uint32_t state[words][N];
+    HashLane<Engine::big_endian> lanes[N];
+    const uint8_t *blocks[N];
+    uint32_t active = 0U;
+    size_t next = 0U;
+
+    // Start a message on a lane
+    auto start = [&](size_t lane)
+    {
+        lanes[lane].start(messages[next], digests + next * size);
+        for (size_t j = 0U; j < words; ++j)
+        {
+            state[j][lane] = Engine::iv[j];
+        }
+
+        active |= 1U << lane;
+        ++next;
+    };
+
+    // Fill the lanes
+    for (size_t lane = 0U; lane < N && next < count; ++lane)
+    {
+        start(lane);
+    }
+
+    while (active)
+    {
+        // Gather one block from each lane; idle lanes hash a dummy block
+        for (size_t lane = 0U; lane < N; ++lane)
+        {
+            blocks[lane] = (active & (1U << lane)) ? lanes[lane].block() : idle;
+        }
+
+        compress(state, blocks, active);
+
+        // Advance the lanes, emitting digests for finished messages
+        for (size_t lane = 0U; lane < N; ++lane)
+        {
+            if (!(active & (1U << lane)) || !lanes[lane].advance())
+            {
+                continue;
+            }
+
+            uint8_t *out = lanes[lane].digest;
+            for (size_t i = 0U; i < size; ++i)
+            {
+                size_t shift = (Engine::big_endian ? 3U - i % 4U : i % 4U) * 8U;
+                out[i] = static_cast<uint8_t>(state[i / 4U][lane] >> shift);
+            }
+
+            active &= ~(1U << lane);
+            if (next < count)
+            {
+                start(lane);
+            }
+        }
+    }
+}
+
+#if defined(CRYPTLIB_X86)
+// Load 32 bytes from each of eight lanes as eight word vectors, word i of
+// every lane gathered into w[i]
+CRYPTLIB_TARGET("avx2")
+inline void transpose_avx2(const uint8_t *const *blocks, size_t offset, __m256i *w)
+{
+    __m256i r[8];
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        r[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blocks[i] + offset));
+    }
+
+    // Transpose the 8x8 matrix of words
+    __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+    __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+    __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+    __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+    w[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    w[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    w[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    w[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    w[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    w[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    w[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    w[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+#endif
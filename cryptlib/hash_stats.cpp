@@ -0,0 +1,173 @@
+#include "hash_stats.hpp"
+#include "cpu_features.hpp"
+#include "sha1_hash.hpp"
+#include "sha256_hash.hpp"
+#include "sha512_hash.hpp"
+#include <chrono>
+#include <mutex>
+
+#if defined(CRYPTLIB_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+std::atomic<uint32_t> HashStats::interval(0U);
+
+/// Registry of the per-thread counter blocks.
+struct Registry
+{
+    /// Guards the list and the exited thread totals.
+    std::mutex lock;
+
+    /// First live block.
+    HashStats::Local *head;
+
+    /// Totals of the threads that have exited.
+    uint64_t exited[HashStats::algorithms][HashStats::counters];
+};
+
+// Get the registry, constructed on first use so blocks of threads started
+// during static initialization can register
+static Registry &registry()
+{
+    static Registry instance = {};
+    return instance;
+}
+
+HashStats::Local::Local() : since(0U), prev(nullptr)
+{
+    for (size_t i = 0U; i < algorithms; ++i)
+    {
+        for (size_t j = 0U; j < counters; ++j)
+        {
+            values[i][j].store(0U, std::memory_order_relaxed);
+        }
+    }
+
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+    next = reg.head;
+    if (next)
+    {
+        next->prev = this;
+    }
+
+    reg.head = this;
+}
+
+HashStats::Local::~Local()
+{
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+    for (size_t i = 0U; i < algorithms; ++i)
+    {
+        for (size_t j = 0U; j < counters; ++j)
+        {
+            reg.exited[i][j] += values[i][j].load(std::memory_order_relaxed);
+        }
+    }
+
+    if (prev)
+    {
+        prev->next = next;
+    }
+    else
+    {
+        reg.head = next;
+    }
+
+    if (next)
+    {
+        next->prev = prev;
+    }
+}
+
+double HashStats::Snapshot::compress_ticks(Algorithm algorithm) const
+{
+    uint64_t taken = values[algorithm][samples];
+    if (!taken)
+    {
+        return 0.0;
+    }
+
+    // Scale the mean sampled call up to every call
+    return static_cast<double>(values[algorithm][ticks]) / static_cast<double>(taken) *
+           static_cast<double>(values[algorithm][calls]);
+}
+
+uint64_t HashStats::now()
+{
+#if defined(CRYPTLIB_X86)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+void HashStats::set_sample_interval(uint32_t every)
+{
+    interval.store(every, std::memory_order_relaxed);
+}
+
+void HashStats::snapshot(Snapshot &snapshot)
+{
+    Registry &reg = registry();
+    {
+        std::lock_guard<std::mutex> guard(reg.lock);
+        for (size_t i = 0U; i < algorithms; ++i)
+        {
+            for (size_t j = 0U; j < counters; ++j)
+            {
+                snapshot.values[i][j] = reg.exited[i][j];
+            }
+        }
+
+        for (const Local *block = reg.head; block; block = block->next)
+        {
+            for (size_t i = 0U; i < algorithms; ++i)
+            {
+                for (size_t j = 0U; j < counters; ++j)
+                {
+                    snapshot.values[i][j] += block->values[i][j].load(std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    snapshot.backends[md5] = "portable";
+    snapshot.backends[sha1] = Sha1Hash::backend();
+    snapshot.backends[sha256] = Sha256Hash::backend();
+    snapshot.backends[sha512] = Sha512Hash::backend();
+}
+
+const char *HashStats::name(Algorithm algorithm)
+{
+    static const char *const names[algorithms] = { "md5", "sha1", "sha256", "sha512" };
+    return (algorithm < untracked) ? names[algorithm] : "untracked";
+}
+
+const char *HashStats::name(Counter counter)
+{
+    static const char *const names[counters] = { "bytes", "blocks", "copies", "finals", "calls", "samples", "ticks" };
+    return (counter < untallied) ? names[counter] : "untallied";
+}
+
+void HashStats::print(const Snapshot &snapshot, std::FILE *file)
+{
+    for (size_t i = 0U; i < algorithms; ++i)
+    {
+        Algorithm algorithm = static_cast<Algorithm>(i);
+        std::fprintf(file, "%s backend=%s", name(algorithm), snapshot.backends[i]);
+        for (size_t j = 0U; j < counters; ++j)
+        {
+            std::fprintf(file, " %s=%llu", name(static_cast<Counter>(j)),
+                static_cast<unsigned long long>(snapshot.values[i][j]));
+        }
+
+        std::fprintf(file, " compress_ticks=%.0f\n", snapshot.compress_ticks(algorithm));
+    }
+}
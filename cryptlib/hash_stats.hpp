@@ -0,0 +1,180 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+/// Hash engine instrumentation.
+/// When the library is built with CRYPTLIB_STATS defined, the hash engines
+/// count the bytes absorbed, blocks compressed, partial-buffer copies and
+/// finalizations of each algorithm, along with the process() calls made to
+/// the selected backend. Every thread counts into its own block with plain
+/// relaxed stores, so the hot path takes no locks and shares no cache
+/// lines; snapshot() sums the blocks of all threads, live and exited.
+/// A sample interval can also be set to time every Nth process() call with
+/// the processor timestamp counter.
+/// Without CRYPTLIB_STATS the engine hooks compile to nothing, the
+/// counters stay at zero and the engines remain usable in constant
+/// expressions.
+class HashStats
+{
+public:
+    /// Instrumented algorithm. SHA-384 and SHA-512/256 count as SHA-512.
+    enum Algorithm
+    {
+        md5,
+        sha1,
+        sha256,
+        sha512,
+        untracked
+    };
+
+    /// Counter.
+    enum Counter
+    {
+        bytes,
+        blocks,
+        copies,
+        finals,
+        calls,
+        samples,
+        ticks,
+        untallied
+    };
+
+    /// Number of instrumented algorithms.
+    static const size_t algorithms = untracked;
+
+    /// Number of counters per algorithm.
+    static const size_t counters = untallied;
+
+    /// Counter totals across all threads.
+    struct Snapshot
+    {
+        /// Counter values by algorithm and counter
+        uint64_t values[algorithms][counters];
+
+        /// Name of the backend selected for each algorithm
+        const char *backends[algorithms];
+
+        /// Get a counter value.
+        /// @param algorithm            Algorithm
+        /// @param counter              Counter
+        /// @return                     Counter value
+        uint64_t get(Algorithm algorithm, Counter counter) const
+        {
+            return values[algorithm][counter];
+        }
+
+        /// Estimate the timestamp ticks spent compressing from the samples.
+        /// @param algorithm            Algorithm
+        /// @return                     Estimated ticks, or 0 without samples
+        double compress_ticks(Algorithm algorithm) const;
+    };
+
+    /// Per-thread counters.
+    struct Local
+    {
+        /// Counter values by algorithm and counter
+        std::atomic<uint64_t> values[algorithms][counters];
+
+        /// process() calls since the last sample
+        uint32_t since;
+
+        /// Adjacent blocks in the registry
+        Local *prev;
+        Local *next;
+
+        /// Constructor, registering the block.
+        Local();
+
+        /// Destructor, folding the counts into the exited thread totals.
+        ~Local();
+    };
+
+private:
+    /// Time every Nth process() call (0 for none).
+    static std::atomic<uint32_t> interval;
+
+public:
+    /// Test whether the instrumentation is compiled in.
+    /// @return                         True if built with CRYPTLIB_STATS
+    static constexpr bool enabled()
+    {
+#if defined(CRYPTLIB_STATS)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /// Get the counters of the calling thread.
+    /// @return                         Per-thread counters
+    static Local &local()
+    {
+        static thread_local Local block;
+        return block;
+    }
+
+    /// Add to a counter of the calling thread.
+    /// Only the owning thread writes its block, so a relaxed load and
+    /// store suffice and no locked instruction is needed.
+    /// @param algorithm                Algorithm
+    /// @param counter                  Counter
+    /// @param n                        Amount to add
+    static void count(Algorithm algorithm, Counter counter, uint64_t n)
+    {
+        std::atomic<uint64_t> &value = local().values[algorithm][counter];
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    /// Decide whether to time the calling thread's next process() call.
+    /// @return                         True to take a sample
+    static bool sample()
+    {
+        uint32_t every = interval.load(std::memory_order_relaxed);
+        if (!every)
+        {
+            return false;
+        }
+
+        Local &block = local();
+        if (++block.since < every)
+        {
+            return false;
+        }
+
+        block.since = 0U;
+        return true;
+    }
+
+    /// Read the timestamp counter (nanoseconds where there is none).
+    /// @return                         Timestamp in ticks
+    static uint64_t now();
+
+    /// Set the cycle sampling interval.
+    /// @param every                    Time every Nth process() call (0 to stop sampling)
+    static void set_sample_interval(uint32_t every);
+
+    /// Sum the counters of all threads. Counts from other threads that are
+    /// hashing at the time may be a few events behind.
+    /// @param snapshot                 Snapshot to write
+    static void snapshot(Snapshot &snapshot);
+
+    /// Get the name of an algorithm.
+    /// @param algorithm                Algorithm
+    /// @return                         Algorithm name
+    static const char *name(Algorithm algorithm);
+
+    /// Get the name of a counter.
+    /// @param counter                  Counter
+    /// @return                         Counter name
+    static const char *name(Counter counter);
+
+    /// Write a snapshot as one line of name=value pairs per algorithm, for
+    /// logs and metric scrapers.
+    /// @param snapshot                 Snapshot to write
+    /// @param file                     Output file
+    static void print(const Snapshot &snapshot, std::FILE *file);
+};
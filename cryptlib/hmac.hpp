@@ -0,0 +1,187 @@
+#pragma once
+
+#include "md5_engine.hpp"
+#include "sha1_engine.hpp"
+#include "sha256_engine.hpp"
+#include "sha512_engine.hpp"
+
+/// HMAC class (RFC 2104).
+/// The inner and outer keyed midstates are computed once per key, so each
+/// message costs only its own blocks plus one outer block.
+/// @tparam Engine                      Hash engine type
+template <typename Engine>
+class Hmac : public Hash
+{
+public:
+    /// MAC digest type.
+    typedef typename Engine::Digest Digest;
+
+private:
+    /// Engine after absorbing the key XOR ipad block.
+    Engine inner;
+
+    /// Engine after absorbing the key XOR opad block.
+    Engine outer;
+
+    /// Engine absorbing the current message.
+    Engine engine;
+
+public:
+    /// Constructor.
+    /// @param key                      Pointer to the key
+    /// @param size                     Size of the key
+    Hmac(const void *key, size_t size)
+    {
+        set_key(key, size);
+    }
+
+    /// Delete copy constructor.
+    Hmac(const Hmac &) = delete;
+
+    /// Delete assignment operator.
+    Hmac &operator=(const Hmac &) = delete;
+
+    /// Set a new key and clear the MAC to an initial state.
+    /// @param key                      Pointer to the key
+    /// @param size                     Size of the key
+    void set_key(const void *key, size_t size)
+    {
+        // Keys longer than a block are hashed first
+        uint8_t block[Engine::block_size] = {};
+        if (size > Engine::block_size)
+        {
+            Engine hash;
+            hash.add(key, size);
+            hash.close(block);
+        }
+        else
+        {
+            const uint8_t *bytes = static_cast<const uint8_t*>(key);
+            for (size_t i = 0U; i < size; ++i)
+            {
+                block[i] = bytes[i];
+            }
+        }
+
+        // Absorb the padded key blocks into the keyed midstates
+        for (size_t i = 0U; i < Engine::block_size; ++i)
+        {
+            block[i] ^= 0x36U;
+        }
+
+        inner.clear();
+        inner.add(block, Engine::block_size);
+
+        for (size_t i = 0U; i < Engine::block_size; ++i)
+        {
+            block[i] ^= 0x36U ^ 0x5CU;
+        }
+
+        outer.clear();
+        outer.add(block, Engine::block_size);
+
+        // Wipe the key material from the stack
+        volatile uint8_t *wipe = block;
+        for (size_t i = 0U; i < Engine::block_size; ++i)
+        {
+            wipe[i] = 0U;
+        }
+
+        engine = inner;
+    }
+
+    /// Clear the MAC to an initial state, keeping the key.
+    virtual void clear()
+    {
+        engine = inner;
+    }
+
+    /// Add data to the MAC.
+    /// @param data                     Pointer to the data to add
+    /// @param size                     Size of the data to add
+    virtual void add(const void *data, size_t size)
+    {
+        engine.add(data, size);
+    }
+
+    /// Add a list of data segments to the MAC.
+    /// @param segments                 Data segments
+    /// @param count                    Number of segments
+    virtual void add(const HashData *segments, size_t count)
+    {
+        engine.add(segments, count);
+    }
+
+    /// Get the MAC size.
+    /// @return                         MAC size in bytes
+    virtual size_t size() const
+    {
+        return Digest::size();
+    }
+
+    /// Close the MAC and write it without allocating.
+    /// @param mac                      Output buffer of size() bytes
+    virtual void close(uint8_t *mac)
+    {
+        uint8_t digest[Engine::digest_size];
+        engine.close(digest);
+
+        Engine hash = outer;
+        hash.add(digest, Engine::digest_size);
+        hash.close(mac);
+    }
+
+    /// Close the MAC and write it without allocating.
+    /// @param mac                      Output MAC
+    void close(Digest &mac)
+    {
+        close(mac.data());
+    }
+
+    using Hash::close;
+
+    /// Get the engine holding the keyed inner (key XOR ipad) midstate.
+    /// @return                         Inner midstate
+    const Engine &inner_midstate() const
+    {
+        return inner;
+    }
+
+    /// Get the engine holding the keyed outer (key XOR opad) midstate.
+    /// @return                         Outer midstate
+    const Engine &outer_midstate() const
+    {
+        return outer;
+    }
+
+    /// Calculate the MACs of many messages under the current key.
+    /// @param messages                 Messages to authenticate
+    /// @param count                    Number of messages
+    /// @param macs                     Output buffer of count * size() bytes
+    void mac(const HashData *messages, size_t count, uint8_t *macs)
+    {
+        for (size_t i = 0U; i < count; ++i, macs += Engine::digest_size)
+        {
+            engine = inner;
+            engine.add(messages[i].data, messages[i].size);
+            close(macs);
+        }
+
+        engine = inner;
+    }
+};
+
+/// HMAC-MD5 class.
+typedef Hmac<Md5Engine> HmacMd5;
+
+/// HMAC-SHA1 class.
+typedef Hmac<Sha1Engine> HmacSha1;
+
+/// HMAC-SHA256 class.
+typedef Hmac<Sha256Engine> HmacSha256;
+
+/// HMAC-SHA384 class.
+typedef Hmac<Sha384Engine> HmacSha384;
+
+/// HMAC-SHA512 class.
+typedef Hmac<Sha512Engine> HmacSha512;
\ No newline at end of file
@@ -1,13 +0,0 @@
-#include "md5.h"
-#include <stdint.h>
-
-
-/// MD5 State structure
-struct MD5State
-{
-	/// State words
-	uint32_t s[4];
-
-	/// Block buffer
-	uint8_t b[64];
-};
\ No newline at end of file
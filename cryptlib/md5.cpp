@@ -0,0 +1,48 @@
+#include "md5.h"
+#include "md5_batch.hpp"
+#include "md5_engine.hpp"
+#include <new>
+
+static_assert(sizeof(Md5Engine) <= sizeof(MD5Context), "MD5Context is too small for the engine");
+static_assert(alignof(Md5Engine) <= alignof(MD5Context), "MD5Context is underaligned for the engine");
+
+// Get the engine held in a context
+static Md5Engine &engine_of(MD5Context *context)
+{
+    return *reinterpret_cast<Md5Engine*>(context);
+}
+
+size_t MD5ContextSize(void)
+{
+    return sizeof(MD5Context);
+}
+
+size_t MD5ContextAlign(void)
+{
+    return alignof(MD5Context);
+}
+
+void MD5Init(MD5Context *context)
+{
+    new (context) Md5Engine();
+}
+
+void MD5Add(MD5Context *context, const void *data, size_t size)
+{
+    engine_of(context).add(data, size);
+}
+
+void MD5Close(MD5Context *context, uint8_t *digest)
+{
+    engine_of(context).close(digest);
+}
+
+void MD5Hash(const void *data, size_t size, uint8_t *digest)
+{
+    Md5Engine::hash(data, size, digest);
+}
+
+void MD5HashBatch(const HashData *messages, size_t count, uint8_t *digests)
+{
+    Md5Batch::hash(messages, count, digests);
+}
@@ -1,7 +1,62 @@
 #pragma once
 
-typedef void *MD5;
+#include "hash.h"
 
-MD5 MD5Create(void);
+#ifdef __cplusplus
+extern "C" {
+#endif
 
-void MD5Add()
+/// MD5 context size in bytes.
+#define MD5_CONTEXT_SIZE 128
+
+/// MD5 digest size in bytes.
+#define MD5_DIGEST_SIZE 16
+
+/// MD5 context, allocated by the caller (on the stack or embedded in
+/// another structure). The contents are private to the library.
+typedef struct MD5Context
+{
+    /// Opaque engine storage
+    uint64_t opaque[MD5_CONTEXT_SIZE / 8];
+} MD5Context;
+
+/// Get the size of MD5Context, for callers that cannot read this header.
+/// @return                             Context size in bytes
+size_t MD5ContextSize(void);
+
+/// Get the alignment of MD5Context, for callers that cannot read this header.
+/// @return                             Context alignment in bytes
+size_t MD5ContextAlign(void);
+
+/// Initialize a context to hash a new message.
+/// @param context                      Context to initialize
+void MD5Init(MD5Context *context);
+
+/// Add data to the hash.
+/// @param context                      Initialized context
+/// @param data                         Pointer to the data to add
+/// @param size                         Size of the data to add
+void MD5Add(MD5Context *context, const void *data, size_t size);
+
+/// Close the hash and write the digest. The context must be initialized
+/// again before reuse.
+/// @param context                      Initialized context
+/// @param digest                       Output buffer of 16 bytes
+void MD5Close(MD5Context *context, uint8_t *digest);
+
+/// Calculate the digest of a message in one call.
+/// @param data                         Pointer to the message
+/// @param size                         Size of the message
+/// @param digest                       Output buffer of 16 bytes
+void MD5Hash(const void *data, size_t size, uint8_t *digest);
+
+/// Calculate the digests of a batch of independent messages in one call,
+/// using the multi-buffer backend where available.
+/// @param messages                     Array of messages to hash
+/// @param count                        Number of messages
+/// @param digests                      Output array of count 16-byte digests
+void MD5HashBatch(const HashData *messages, size_t count, uint8_t *digests);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,232 @@
+#include "md5_batch.hpp"
+#include "md5_hash.hpp"
+#include "hash_lanes.hpp"
+
+#if defined(CRYPTLIB_X86)
+template <int C>
+CRYPTLIB_TARGET("avx2")
+static inline __m256i rtl(__m256i x)
+{
+    return _mm256_or_si256(_mm256_slli_epi32(x, C), _mm256_srli_epi32(x, 32 - C));
+}
+
+// One MD5 step on eight lanes. The caller rotates the roles of the state
+// words instead of moving them.
+template <int S>
+CRYPTLIB_TARGET("avx2")
+static inline void step_avx2(__m256i &a, __m256i b, __m256i f, __m256i m, size_t i)
+{
+    a = _mm256_add_epi32(_mm256_add_epi32(a, f), _mm256_add_epi32(m, _mm256_set1_epi32(static_cast<int>(Md5Engine::k[i]))));
+    a = _mm256_add_epi32(b, rtl<S>(a));
+}
+
+// Process one block on each of eight lanes with AVX2
+CRYPTLIB_TARGET("avx2")
+static void compress_avx2(uint32_t (*state)[8], const uint8_t *const *blocks, uint32_t active)
+{
+    // Populate message; MD5 words are little-endian, so no byte swap
+    __m256i m[16];
+    transpose_avx2(blocks, 0U, m);
+    transpose_avx2(blocks, 32U, m + 8);
+
+    // Populate state
+    __m256i s[4];
+    for (size_t j = 0U; j < 4U; ++j)
+    {
+        s[j] = _mm256_load_si256(reinterpret_cast<const __m256i*>(state[j]));
+    }
+
+    __m256i a = s[0];
+    __m256i b = s[1];
+    __m256i c = s[2];
+    __m256i d = s[3];
+    const __m256i ones = _mm256_set1_epi32(-1);
+
+    // Process loop, one pass per round function, four steps per iteration
+    for (size_t i = 0U; i < 16U; i += 4U)
+    {
+        step_avx2<7>(a, b, _mm256_xor_si256(d, _mm256_and_si256(b, _mm256_xor_si256(c, d))), m[i], i);
+        step_avx2<12>(d, a, _mm256_xor_si256(c, _mm256_and_si256(a, _mm256_xor_si256(b, c))), m[i + 1U], i + 1U);
+        step_avx2<17>(c, d, _mm256_xor_si256(b, _mm256_and_si256(d, _mm256_xor_si256(a, b))), m[i + 2U], i + 2U);
+        step_avx2<22>(b, c, _mm256_xor_si256(a, _mm256_and_si256(c, _mm256_xor_si256(d, a))), m[i + 3U], i + 3U);
+    }
+
+    for (size_t i = 16U; i < 32U; i += 4U)
+    {
+        step_avx2<5>(a, b, _mm256_xor_si256(c, _mm256_and_si256(d, _mm256_xor_si256(b, c))), m[(5U * i + 1U) & 15U], i);
+        step_avx2<9>(d, a, _mm256_xor_si256(b, _mm256_and_si256(c, _mm256_xor_si256(a, b))), m[(5U * i + 6U) & 15U], i + 1U);
+        step_avx2<14>(c, d, _mm256_xor_si256(a, _mm256_and_si256(b, _mm256_xor_si256(d, a))), m[(5U * i + 11U) & 15U], i + 2U);
+        step_avx2<20>(b, c, _mm256_xor_si256(d, _mm256_and_si256(a, _mm256_xor_si256(c, d))), m[(5U * i + 16U) & 15U], i + 3U);
+    }
+
+    for (size_t i = 32U; i < 48U; i += 4U)
+    {
+        step_avx2<4>(a, b, _mm256_xor_si256(_mm256_xor_si256(b, c), d), m[(3U * i + 5U) & 15U], i);
+        step_avx2<11>(d, a, _mm256_xor_si256(_mm256_xor_si256(a, b), c), m[(3U * i + 8U) & 15U], i + 1U);
+        step_avx2<16>(c, d, _mm256_xor_si256(_mm256_xor_si256(d, a), b), m[(3U * i + 11U) & 15U], i + 2U);
+        step_avx2<23>(b, c, _mm256_xor_si256(_mm256_xor_si256(c, d), a), m[(3U * i + 14U) & 15U], i + 3U);
+    }
+
+    for (size_t i = 48U; i < 64U; i += 4U)
+    {
+        step_avx2<6>(a, b, _mm256_xor_si256(c, _mm256_or_si256(b, _mm256_xor_si256(d, ones))), m[(7U * i) & 15U], i);
+        step_avx2<10>(d, a, _mm256_xor_si256(b, _mm256_or_si256(a, _mm256_xor_si256(c, ones))), m[(7U * i + 7U) & 15U], i + 1U);
+        step_avx2<15>(c, d, _mm256_xor_si256(a, _mm256_or_si256(d, _mm256_xor_si256(b, ones))), m[(7U * i + 14U) & 15U], i + 2U);
+        step_avx2<21>(b, c, _mm256_xor_si256(d, _mm256_or_si256(c, _mm256_xor_si256(a, ones))), m[(7U * i + 21U) & 15U], i + 3U);
+    }
+
+    // Update the state vector of the active lanes
+    const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    __m256i mask = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int>(active)), bits), bits);
+    const __m256i x[4] = { a, b, c, d };
+    for (size_t j = 0U; j < 4U; ++j)
+    {
+        __m256i sum = _mm256_add_epi32(s[j], x[j]);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(state[j]), _mm256_blendv_epi8(s[j], sum, mask));
+    }
+}
+
+// One MD5 step on sixteen lanes
+template <int S>
+CRYPTLIB_TARGET("avx512f")
+static inline void step_avx512(__m512i &a, __m512i b, __m512i f, __m512i m, size_t i)
+{
+    a = _mm512_add_epi32(_mm512_add_epi32(a, f), _mm512_add_epi32(m, _mm512_set1_epi32(static_cast<int>(Md5Engine::k[i]))));
+    a = _mm512_add_epi32(b, _mm512_rol_epi32(a, S));
+}
+
+// Process one block on each of sixteen lanes with AVX-512
+CRYPTLIB_TARGET("avx512f")
+static void compress_avx512(uint32_t (*state)[16], const uint8_t *const *blocks, uint32_t active)
+{
+    // Populate message, transposing each half of the lanes with AVX2
+    __m512i m[16];
+    for (size_t half = 0U; half < 2U; ++half)
+    {
+        __m256i lo[8];
+        __m256i hi[8];
+        transpose_avx2(blocks, half * 32U, lo);
+        transpose_avx2(blocks + 8, half * 32U, hi);
+        for (size_t i = 0U; i < 8U; ++i)
+        {
+            m[half * 8U + i] = _mm512_inserti64x4(_mm512_castsi256_si512(lo[i]), hi[i], 1);
+        }
+    }
+
+    // Populate state
+    __m512i s[4];
+    for (size_t j = 0U; j < 4U; ++j)
+    {
+        s[j] = _mm512_load_si512(state[j]);
+    }
+
+    __m512i a = s[0];
+    __m512i b = s[1];
+    __m512i c = s[2];
+    __m512i d = s[3];
+
+    // Process loop; the round functions are single ternary logic operations
+    for (size_t i = 0U; i < 16U; i += 4U)
+    {
+        step_avx512<7>(a, b, _mm512_ternarylogic_epi32(b, c, d, 0xCA), m[i], i);
+        step_avx512<12>(d, a, _mm512_ternarylogic_epi32(a, b, c, 0xCA), m[i + 1U], i + 1U);
+        step_avx512<17>(c, d, _mm512_ternarylogic_epi32(d, a, b, 0xCA), m[i + 2U], i + 2U);
+        step_avx512<22>(b, c, _mm512_ternarylogic_epi32(c, d, a, 0xCA), m[i + 3U], i + 3U);
+    }
+
+    for (size_t i = 16U; i < 32U; i += 4U)
+    {
+        step_avx512<5>(a, b, _mm512_ternarylogic_epi32(d, b, c, 0xCA), m[(5U * i + 1U) & 15U], i);
+        step_avx512<9>(d, a, _mm512_ternarylogic_epi32(c, a, b, 0xCA), m[(5U * i + 6U) & 15U], i + 1U);
+        step_avx512<14>(c, d, _mm512_ternarylogic_epi32(b, d, a, 0xCA), m[(5U * i + 11U) & 15U], i + 2U);
+        step_avx512<20>(b, c, _mm512_ternarylogic_epi32(a, c, d, 0xCA), m[(5U * i + 16U) & 15U], i + 3U);
+    }
+
+    for (size_t i = 32U; i < 48U; i += 4U)
+    {
+        step_avx512<4>(a, b, _mm512_ternarylogic_epi32(b, c, d, 0x96), m[(3U * i + 5U) & 15U], i);
+        step_avx512<11>(d, a, _mm512_ternarylogic_epi32(a, b, c, 0x96), m[(3U * i + 8U) & 15U], i + 1U);
+        step_avx512<16>(c, d, _mm512_ternarylogic_epi32(d, a, b, 0x96), m[(3U * i + 11U) & 15U], i + 2U);
+        step_avx512<23>(b, c, _mm512_ternarylogic_epi32(c, d, a, 0x96), m[(3U * i + 14U) & 15U], i + 3U);
+    }
+
+    for (size_t i = 48U; i < 64U; i += 4U)
+    {
+        step_avx512<6>(a, b, _mm512_ternarylogic_epi32(b, c, d, 0x39), m[(7U * i) & 15U], i);
+        step_avx512<10>(d, a, _mm512_ternarylogic_epi32(a, b, c, 0x39), m[(7U * i + 7U) & 15U], i + 1U);
+        step_avx512<15>(c, d, _mm512_ternarylogic_epi32(d, a, b, 0x39), m[(7U * i + 14U) & 15U], i + 2U);
+        step_avx512<21>(b, c, _mm512_ternarylogic_epi32(c, d, a, 0x39), m[(7U * i + 21U) & 15U], i + 3U);
+    }
+
+    // Update the state vector of the active lanes
+    const __m512i x[4] = { a, b, c, d };
+    for (size_t j = 0U; j < 4U; ++j)
+    {
+        _mm512_store_si512(state[j], _mm512_mask_add_epi32(s[j], static_cast<__mmask16>(active), s[j], x[j]));
+    }
+}
+#endif
+
+// Hash messages one at a time with the single-stream engine
+static void hash_serial(const HashData *messages, size_t count, uint8_t *digests)
+{
+    Md5Hash hash;
+    for (size_t i = 0U; i < count; ++i)
+    {
+        hash.clear();
+        hash.add(messages[i].data, messages[i].size);
+        hash.close(digests + i * 16U);
+    }
+}
+
+/// Multi-buffer backend.
+struct Md5BatchBackend
+{
+    /// Backend name.
+    const char *name;
+
+    /// Number of lanes.
+    size_t lanes;
+
+    /// Batch hashing function.
+    void (*hash)(const HashData *messages, size_t count, uint8_t *digests);
+};
+
+#if defined(CRYPTLIB_X86)
+static void hash_avx2(const HashData *messages, size_t count, uint8_t *digests)
+{
+    hash_lanes<Md5Engine, 8>(messages, count, digests, compress_avx2);
+}
+
+static void hash_avx512(const HashData *messages, size_t count, uint8_t *digests)
+{
+    hash_lanes<Md5Engine, 16>(messages, count, digests, compress_avx512);
+}
+#endif
+
+// Select the widest backend supported by the processor
+static const Md5BatchBackend &select_backend()
+{
+    static const Md5BatchBackend backend =
+#if defined(CRYPTLIB_X86)
+        CpuFeatures::avx512f() ? Md5BatchBackend{ "avx512", 16U, hash_avx512 } :
+        CpuFeatures::avx2() ? Md5BatchBackend{ "avx2", 8U, hash_avx2 } :
+#endif
+        Md5BatchBackend{ "serial", 1U, hash_serial };
+    return backend;
+}
+
+void Md5Batch::hash(const HashData *messages, size_t count, uint8_t *digests)
+{
+    select_backend().hash(messages, count, digests);
+}
+
+const char *Md5Batch::backend()
+{
+    return select_backend().name;
+}
+
+size_t Md5Batch::lanes()
+{
+    return select_backend().lanes;
+}
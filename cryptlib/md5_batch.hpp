@@ -0,0 +1,30 @@
+#pragma once
+
+#include "hash.hpp"
+
+/// MD5 multi-buffer hash class.
+/// Hashes many independent messages at once by running the compression
+/// function for 8 (AVX2) or 16 (AVX-512) messages in parallel SIMD lanes.
+/// Messages of different lengths are scheduled onto lanes as earlier ones
+/// finish; idle lanes are masked out. Digests are identical to those of
+/// separate Md5Hash runs.
+class Md5Batch
+{
+public:
+    /// MD5 digest size in bytes.
+    static const size_t digest_size = 16U;
+
+    /// Hash a batch of independent messages.
+    /// @param messages                 Array of messages to hash
+    /// @param count                    Number of messages
+    /// @param digests                  Output array of count 16-byte digests
+    static void hash(const HashData *messages, size_t count, uint8_t *digests);
+
+    /// Get the name of the backend selected for this processor.
+    /// @return                         Backend name ("avx512", "avx2" or "serial")
+    static const char *backend();
+
+    /// Get the number of messages hashed in parallel by the selected backend.
+    /// @return                         Number of SIMD lanes
+    static size_t lanes();
+};
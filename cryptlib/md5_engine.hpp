@@ -0,0 +1,169 @@
+#pragma once
+
+#include "hash_engine.hpp"
+
+/// MD5 hash engine.
+/// Statically dispatched MD5 implementation usable in constant expressions.
+/// @tparam Portable                    Build the engine for constant expressions,
+///                                     leaving it out of the instrumentation
+template <bool Portable>
+class BasicMd5Engine : public HashEngine<BasicMd5Engine<Portable>, uint32_t, 4U, 64U, 16U, false>
+{
+    /// Base engine type.
+    typedef HashEngine<BasicMd5Engine<Portable>, uint32_t, 4U, 64U, 16U, false> Base;
+
+public:
+    /// Instrumentation counters used by the engine.
+    static const HashStats::Algorithm algorithm = Portable ? HashStats::untracked : HashStats::md5;
+
+    /// Per round shift table.
+    static constexpr size_t s[64] =
+    {
+         7U, 12U, 17U, 22U,  7U, 12U, 17U, 22U,  7U, 12U, 17U, 22U,  7U, 12U, 17U, 22U,
+         5U,  9U, 14U, 20U,  5U,  9U, 14U, 20U,  5U,  9U, 14U, 20U,  5U,  9U, 14U, 20U,
+         4U, 11U, 16U, 23U,  4U, 11U, 16U, 23U,  4U, 11U, 16U, 23U,  4U, 11U, 16U, 23U,
+         6U, 10U, 15U, 21U,  6U, 10U, 15U, 21U,  6U, 10U, 15U, 21U,  6U, 10U, 15U, 21U,
+    };
+
+    /// Key schedule table (binary integer part of sines of integers).
+    static constexpr uint32_t k[64] =
+    {
+        0xD76AA478U, 0xE8C7B756U, 0x242070DBU, 0xC1BDCEEEU,
+        0xF57C0FAFU, 0x4787C62AU, 0xA8304613U, 0xFD469501U,
+        0x698098D8U, 0x8B44F7AFU, 0xFFFF5BB1U, 0x895CD7BEU,
+        0x6B901122U, 0xFD987193U, 0xA679438EU, 0x49B40821U,
+        0xF61E2562U, 0xC040B340U, 0x265E5A51U, 0xE9B6C7AAU,
+        0xD62F105DU, 0x02441453U, 0xD8A1E681U, 0xE7D3FBC8U,
+        0x21E1CDE6U, 0xC33707D6U, 0xF4D50D87U, 0x455A14EDU,
+        0xA9E3E905U, 0xFCEFA3F8U, 0x676F02D9U, 0x8D2A4C8AU,
+        0xFFFA3942U, 0x8771F681U, 0x6D9D6122U, 0xFDE5380CU,
+        0xA4BEEA44U, 0x4BDECFA9U, 0xF6BB4B60U, 0xBEBFBC70U,
+        0x289B7EC6U, 0xEAA127FAU, 0xD4EF3085U, 0x04881D05U,
+        0xD9D4D039U, 0xE6DB99E5U, 0x1FA27CF8U, 0xC4AC5665U,
+        0xF4292244U, 0x432AFF97U, 0xAB9423A7U, 0xFC93A039U,
+        0x655B59C3U, 0x8F0CCC92U, 0xFFEFF47DU, 0x85845DD1U,
+        0x6FA87E4FU, 0xFE2CE6E0U, 0xA3014314U, 0x4E0811A1U,
+        0xF7537E82U, 0xBD3AF235U, 0x2AD7D2BBU, 0xEB86D391U
+    };
+
+    /// Initial state vector.
+    static constexpr uint32_t iv[4] =
+    {
+        0x67452301U, 0xEFCDAB89U, 0x98BADCFEU, 0x10325476U
+    };
+
+    /// Constructor.
+    constexpr BasicMd5Engine()
+    {
+        clear();
+    }
+
+    /// Clear the hash to an initial state.
+    constexpr void clear()
+    {
+        // Seed the state vector
+        for (size_t i = 0U; i < 4U; ++i)
+        {
+            this->state[i] = iv[i];
+        }
+
+        // Clear buffer and total lengths
+        this->buflen = 0U;
+        this->totlen = 0U;
+    }
+
+    /// Perform one MD5 round.
+    /// @param a                        State word a
+    /// @param b                        State word b
+    /// @param c                        State word c
+    /// @param d                        State word d
+    /// @param f                        Round function output
+    /// @param m                        Message word
+    /// @param i                        Round index
+    static constexpr void step(uint32_t &a, uint32_t &b, uint32_t &c, uint32_t &d, uint32_t f, uint32_t m, size_t i)
+    {
+        f = f + a + k[i] + m;
+        a = d;
+        d = c;
+        c = b;
+        b = b + Base::rtl(f, s[i]);
+    }
+
+    /// Process full blocks.
+    /// @param blocks                   Pointer to the blocks to process
+    /// @param count                    Number of 64-byte blocks
+    constexpr void process(const uint8_t *blocks, size_t count)
+    {
+        for (; count; --count, blocks += 64U)
+        {
+            // Populate state
+            uint32_t a = this->state[0];
+            uint32_t b = this->state[1];
+            uint32_t c = this->state[2];
+            uint32_t d = this->state[3];
+
+            // Populate message
+            uint32_t m[16] = {};
+            for (size_t i = 0U; i < 16U; ++i)
+            {
+                m[i] = (static_cast<uint32_t>(blocks[i * 4    ])      ) |
+                       (static_cast<uint32_t>(blocks[i * 4 + 1]) <<  8) |
+                       (static_cast<uint32_t>(blocks[i * 4 + 2]) << 16) |
+                       (static_cast<uint32_t>(blocks[i * 4 + 3]) << 24);
+            }
+
+            // Process loop, one pass per round function
+            for (size_t i = 0U; i < 16U; ++i)
+            {
+                step(a, b, c, d, (b & c) | (~b & d), m[i], i);
+            }
+
+            for (size_t i = 16U; i < 32U; ++i)
+            {
+                step(a, b, c, d, (d & b) | (~d & c), m[(5U * i + 1) & 15U], i);
+            }
+
+            for (size_t i = 32U; i < 48U; ++i)
+            {
+                step(a, b, c, d, b ^ c ^ d, m[(3U * i + 5) & 15U], i);
+            }
+
+            for (size_t i = 48U; i < 64U; ++i)
+            {
+                step(a, b, c, d, c ^ (b | ~d), m[(7U * i) & 15U], i);
+            }
+
+            // Update the state vector
+            this->state[0] += a;
+            this->state[1] += b;
+            this->state[2] += c;
+            this->state[3] += d;
+        }
+    }
+};
+
+template <bool Portable>
+constexpr size_t BasicMd5Engine<Portable>::s[64];
+
+template <bool Portable>
+constexpr uint32_t BasicMd5Engine<Portable>::k[64];
+
+template <bool Portable>
+constexpr uint32_t BasicMd5Engine<Portable>::iv[4];
+
+/// MD5 hash engine for run-time use.
+typedef BasicMd5Engine<false> Md5Engine;
+
+/// MD5 hash engine usable in constant expressions.
+typedef BasicMd5Engine<true> Md5ConstEngine;
+
+/// Calculate the MD5 digest of a string, usable in constant expressions.
+/// @param str                          String literal (the terminator is not hashed)
+/// @return                             Message digest
+template <size_t N>
+constexpr Md5Engine::Digest md5(const char (&str)[N])
+{
+    Md5ConstEngine engine;
+    engine.add(str, N - 1U);
+    return engine.close();
+}
@@ -1,24 +1,20 @@
 #pragma once
 
-#include "hash.hpp"
+#include "md5_engine.hpp"
 
 /// MD5 Hash class.
 class Md5Hash : public Hash
 {
-    /// MD5 state vector.
-	uint32_t state[4];
-
-    /// MD5 accumulation buffer.
-	uint8_t buffer[64];
-
-    /// MD5 accumulation boffer length.
-    size_t buflen;
+public:
+    /// MD5 digest type.
+    typedef Md5Engine::Digest Digest;
 
-    /// MD5 total bit count
-    uint64_t totlen;
+    /// MD5 midstate snapshot type.
+    typedef Md5Engine State;
 
-    /// Process a full block
-    void process();
+private:
+    /// MD5 engine.
+    Md5Engine engine;
 
 public:
     /// Constructor.
@@ -38,7 +34,38 @@ public:
     /// @param size                     Size of the data to add
     virtual void add(const void *data, size_t size);
 
-    /// Close the hash and calculate the digest.
-    /// @return                         Message digest
-    virtual std::vector<uint8_t> close();
+    /// Add a list of data segments to the hash.
+    /// @param segments                 Data segments
+    /// @param count                    Number of segments
+    virtual void add(const HashData *segments, size_t count);
+
+    /// Get the digest size.
+    /// @return                         Digest size in bytes (16)
+    virtual size_t size() const;
+
+    /// Close the hash and write the digest without allocating.
+    /// @param digest                   Output buffer of 16 bytes
+    virtual void close(uint8_t *digest);
+
+    /// Close the hash and write the digest without allocating.
+    /// @param digest                   Output digest
+    void close(Digest &digest);
+
+    using Hash::close;
+
+    /// Save a snapshot of the hash midstate.
+    /// @param state                    Snapshot to write
+    void save(State &state) const;
+
+    /// Restore the hash midstate from a snapshot.
+    /// @param state                    Snapshot previously written by save()
+    void restore(const State &state);
+
+    /// Hash a short or whole message in one call, without the streaming
+    /// state. Up to 55 bytes take a single padded block and up to 119 bytes
+    /// two, which keeps per-call latency low for tiny inputs.
+    /// @param data                     Pointer to the message
+    /// @param size                     Size of the message
+    /// @param digest                   Output buffer of 16 bytes
+    static void hash(const void *data, size_t size, uint8_t *digest);
 };
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "hmac.hpp"
+#include <cstring>
+
+/// PBKDF2 derivation request.
+struct Pbkdf2Params
+{
+    /// Password
+    const void *password;
+
+    /// Size of the password
+    size_t password_size;
+
+    /// Salt
+    const void *salt;
+
+    /// Size of the salt
+    size_t salt_size;
+
+    /// Iteration count (at least 1)
+    uint32_t iterations;
+
+    /// Output key
+    uint8_t *key;
+
+    /// Size of the output key
+    size_t key_size;
+};
+
+/// PBKDF2 key derivation class (RFC 8018) with HMAC as the pseudorandom function.
+/// The password is absorbed into the HMAC inner and outer midstates once.
+/// Every iteration after the first then MACs a message of one digest, so
+/// the inner and outer hashes are each a single block with fixed padding,
+/// compressed straight from the midstates without buffering.
+/// @tparam Engine                      Hash engine type
+template <typename Engine>
+class Pbkdf2
+{
+public:
+    /// Iterate one output block from its first HMAC output.
+    /// @param hmac                     HMAC keyed with the password
+    /// @param u                        First HMAC output U1, replaced by the last
+    /// @param t                        Output block, U1 XOR ... XOR Uc
+    /// @param iterations               Iterations after the first
+    static void iterate(const Hmac<Engine> &hmac, uint8_t *u, uint8_t *t, uint32_t iterations)
+    {
+        const size_t size = Engine::digest_size;
+        const size_t block = Engine::block_size;
+
+        // Both hashes take one digest after a keyed block, so the two final
+        // blocks share their padding and length
+        uint8_t inner[block] = {};
+        uint8_t outer[block] = {};
+        uint64_t bits = static_cast<uint64_t>(block + size) * 8U;
+        inner[size] = outer[size] = 0x80U;
+        for (size_t i = 0U; i < 8U; ++i)
+        {
+            size_t pos = Engine::big_endian ? block - 1U - i : block - 8U + i;
+            inner[pos] = outer[pos] = static_cast<uint8_t>(bits >> (i * 8U));
+        }
+
+        std::memcpy(inner, u, size);
+        for (; iterations; --iterations)
+        {
+            Engine hash = hmac.inner_midstate();
+            hash.close_block(inner, outer);
+            hash = hmac.outer_midstate();
+            hash.close_block(outer, inner);
+            for (size_t i = 0U; i < size; ++i)
+            {
+                t[i] ^= inner[i];
+            }
+        }
+
+        std::memcpy(u, inner, size);
+    }
+
+    /// Calculate the first HMAC output of an output block, U1 = HMAC(password, salt || INT(index)).
+    /// @param hmac                     HMAC keyed with the password
+    /// @param salt                     Pointer to the salt
+    /// @param salt_size                Size of the salt
+    /// @param index                    Output block index, from 1
+    /// @param u                        Output buffer of Engine::digest_size bytes
+    static void first(Hmac<Engine> &hmac, const void *salt, size_t salt_size, uint32_t index, uint8_t *u)
+    {
+        const uint8_t counter[4] =
+        {
+            static_cast<uint8_t>(index >> 24),
+            static_cast<uint8_t>(index >> 16),
+            static_cast<uint8_t>(index >> 8),
+            static_cast<uint8_t>(index)
+        };
+
+        hmac.clear();
+        hmac.add(salt, salt_size);
+        hmac.add(counter, sizeof(counter));
+        hmac.close(u);
+    }
+
+    /// Derive a key.
+    /// @param password                 Pointer to the password
+    /// @param password_size            Size of the password
+    /// @param salt                     Pointer to the salt
+    /// @param salt_size                Size of the salt
+    /// @param iterations               Iteration count (at least 1)
+    /// @param key                      Output buffer for the key
+    /// @param key_size                 Size of the key
+    static void derive(const void *password, size_t password_size, const void *salt, size_t salt_size, uint32_t iterations, uint8_t *key, size_t key_size)
+    {
+        const size_t size = Engine::digest_size;
+        Hmac<Engine> hmac(password, password_size);
+
+        for (uint32_t index = 1U; key_size; ++index)
+        {
+            uint8_t u[size];
+            uint8_t t[size];
+            first(hmac, salt, salt_size, index, u);
+            std::memcpy(t, u, size);
+            iterate(hmac, u, t, iterations ? iterations - 1U : 0U);
+
+            size_t use = (key_size < size) ? key_size : size;
+            std::memcpy(key, t, use);
+            key += use;
+            key_size -= use;
+        }
+    }
+
+    /// Derive a batch of keys.
+    /// @param params                   Derivation requests
+    /// @param count                    Number of requests
+    static void derive(const Pbkdf2Params *params, size_t count)
+    {
+        for (size_t i = 0U; i < count; ++i)
+        {
+            const Pbkdf2Params &p = params[i];
+            derive(p.password, p.password_size, p.salt, p.salt_size, p.iterations, p.key, p.key_size);
+        }
+    }
+};
+
+/// PBKDF2-HMAC-SHA1 class.
+typedef Pbkdf2<Sha1Engine> Pbkdf2Sha1;
+
+/// PBKDF2-HMAC-SHA384 class.
+typedef Pbkdf2<Sha384Engine> Pbkdf2Sha384;
+
+/// PBKDF2-HMAC-SHA512 class.
+typedef Pbkdf2<Sha512Engine> Pbkdf2Sha512;
@@ -0,0 +1,286 @@
+#include "pbkdf2_sha256.hpp"
+#include "sha256_lanes.hpp"
+
+/// Transposed lane state: word j of lane i at [j][i].
+/// @tparam N                           Number of lanes
+template <size_t N>
+struct Pbkdf2Lanes
+{
+    /// Keyed inner midstates.
+    alignas(64) uint32_t inner[8][N];
+
+    /// Keyed outer midstates.
+    alignas(64) uint32_t outer[8][N];
+
+    /// Latest HMAC outputs.
+    alignas(64) uint32_t u[8][N];
+
+    /// Running output blocks.
+    alignas(64) uint32_t t[8][N];
+};
+
+/// Output block scheduled onto a lane.
+struct Pbkdf2Slot
+{
+    /// Iterations left.
+    uint32_t remaining;
+
+    /// Output position in the key.
+    uint8_t *key;
+
+    /// Bytes of the block to output.
+    size_t size;
+};
+
+#if defined(CRYPTLIB_X86)
+// Run iterations on eight lanes with AVX2
+CRYPTLIB_TARGET("avx2")
+static void iterate_avx2(Pbkdf2Lanes<8> &lanes, uint32_t iterations)
+{
+    __m256i inner[8];
+    __m256i outer[8];
+    __m256i u[8];
+    __m256i t[8];
+    __m256i x[8];
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        inner[j] = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes.inner[j]));
+        outer[j] = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes.outer[j]));
+        u[j] = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes.u[j]));
+        t[j] = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes.t[j]));
+    }
+
+    for (; iterations; --iterations)
+    {
+        sha256_compress_short_avx2(inner, u, 96U, x);
+        sha256_compress_short_avx2(outer, x, 96U, u);
+        for (size_t j = 0U; j < 8U; ++j)
+        {
+            t[j] = _mm256_xor_si256(t[j], u[j]);
+        }
+    }
+
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes.u[j]), u[j]);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes.t[j]), t[j]);
+    }
+}
+
+// Run iterations on sixteen lanes with AVX-512
+CRYPTLIB_TARGET("avx512f")
+static void iterate_avx512(Pbkdf2Lanes<16> &lanes, uint32_t iterations)
+{
+    __m512i inner[8];
+    __m512i outer[8];
+    __m512i u[8];
+    __m512i t[8];
+    __m512i x[8];
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        inner[j] = _mm512_load_si512(lanes.inner[j]);
+        outer[j] = _mm512_load_si512(lanes.outer[j]);
+        u[j] = _mm512_load_si512(lanes.u[j]);
+        t[j] = _mm512_load_si512(lanes.t[j]);
+    }
+
+    for (; iterations; --iterations)
+    {
+        sha256_compress_short_avx512(inner, u, 96U, x);
+        sha256_compress_short_avx512(outer, x, 96U, u);
+        for (size_t j = 0U; j < 8U; ++j)
+        {
+            t[j] = _mm512_xor_si512(t[j], u[j]);
+        }
+    }
+
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        _mm512_store_si512(lanes.u[j], u[j]);
+        _mm512_store_si512(lanes.t[j], t[j]);
+    }
+}
+#endif
+
+// Iterate the output blocks of all requests on N lanes. Every active lane
+// runs until the one nearest completion finishes, without leaving the
+// registers; finished lanes are written out and refilled with the next
+// output block.
+template <size_t N>
+static void derive_lanes(const Pbkdf2Params *params, size_t count, void (*iterate)(Pbkdf2Lanes<N> &lanes, uint32_t iterations))
+{
+    Pbkdf2Lanes<N> lanes = {};
+    Pbkdf2Slot slots[N];
+    uint32_t active = 0U;
+    size_t request = 0U;
+    size_t offset = 0U;
+
+    // Start the next output block on a lane
+    auto start = [&](size_t lane)
+    {
+        while (request < count && offset >= params[request].key_size)
+        {
+            ++request;
+            offset = 0U;
+        }
+
+        if (request == count)
+        {
+            return;
+        }
+
+        const Pbkdf2Params &p = params[request];
+        Hmac<Sha256Engine> hmac(p.password, p.password_size);
+        uint8_t u[32];
+        Pbkdf2<Sha256Engine>::first(hmac, p.salt, p.salt_size, static_cast<uint32_t>(offset / 32U + 1U), u);
+
+        const uint32_t *inner = hmac.inner_midstate().midstate();
+        const uint32_t *outer = hmac.outer_midstate().midstate();
+        for (size_t j = 0U; j < 8U; ++j)
+        {
+            uint32_t word = (static_cast<uint32_t>(u[j * 4U    ]) << 24) |
+                            (static_cast<uint32_t>(u[j * 4U + 1]) << 16) |
+                            (static_cast<uint32_t>(u[j * 4U + 2]) <<  8) |
+                            (static_cast<uint32_t>(u[j * 4U + 3])      );
+            lanes.inner[j][lane] = inner[j];
+            lanes.outer[j][lane] = outer[j];
+            lanes.u[j][lane] = word;
+            lanes.t[j][lane] = word;
+        }
+
+        slots[lane].remaining = p.iterations ? p.iterations - 1U : 0U;
+        slots[lane].key = p.key + offset;
+        slots[lane].size = (p.key_size - offset < 32U) ? p.key_size - offset : 32U;
+        offset += 32U;
+        active |= 1U << lane;
+    };
+
+    for (size_t lane = 0U; lane < N; ++lane)
+    {
+        start(lane);
+    }
+
+    while (active)
+    {
+        // Run to the nearest completion; idle lanes iterate harmlessly
+        uint32_t step = 0xFFFFFFFFU;
+        for (size_t lane = 0U; lane < N; ++lane)
+        {
+            if ((active & (1U << lane)) && slots[lane].remaining < step)
+            {
+                step = slots[lane].remaining;
+            }
+        }
+
+        if (step)
+        {
+            iterate(lanes, step);
+        }
+
+        for (size_t lane = 0U; lane < N; ++lane)
+        {
+            if (!(active & (1U << lane)))
+            {
+                continue;
+            }
+
+            slots[lane].remaining -= step;
+            if (slots[lane].remaining)
+            {
+                continue;
+            }
+
+            for (size_t i = 0U; i < slots[lane].size; ++i)
+            {
+                slots[lane].key[i] = static_cast<uint8_t>(lanes.t[i / 4U][lane] >> ((3U - i % 4U) * 8U));
+            }
+
+            active &= ~(1U << lane);
+            start(lane);
+        }
+    }
+
+    // Wipe the keyed midstates from the stack
+    volatile uint32_t *wipe = &lanes.inner[0][0];
+    for (size_t i = 0U; i < sizeof(lanes) / sizeof(uint32_t); ++i)
+    {
+        wipe[i] = 0U;
+    }
+}
+
+// Derive the keys one output block at a time with the single-stream backend
+static void derive_serial(const Pbkdf2Params *params, size_t count)
+{
+    Pbkdf2<Sha256Engine>::derive(params, count);
+}
+
+/// Multi-lane backend.
+struct Pbkdf2Backend
+{
+    /// Backend name.
+    const char *name;
+
+    /// Number of lanes.
+    size_t lanes;
+
+    /// Batch derivation function.
+    void (*derive)(const Pbkdf2Params *params, size_t count);
+};
+
+#if defined(CRYPTLIB_X86)
+static void derive_avx2(const Pbkdf2Params *params, size_t count)
+{
+    derive_lanes<8>(params, count, iterate_avx2);
+}
+
+static void derive_avx512(const Pbkdf2Params *params, size_t count)
+{
+    derive_lanes<16>(params, count, iterate_avx512);
+}
+#endif
+
+// Select the fastest backend supported by the processor
+static const Pbkdf2Backend &select_backend()
+{
+    static const Pbkdf2Backend backend =
+#if defined(CRYPTLIB_X86)
+        CpuFeatures::avx512f() ? Pbkdf2Backend{ "avx512", 16U, derive_avx512 } :
+        CpuFeatures::avx2() ? Pbkdf2Backend{ "avx2", 8U, derive_avx2 } :
+#endif
+        Pbkdf2Backend{ "serial", 1U, derive_serial };
+    return backend;
+}
+
+void Pbkdf2Sha256::derive(const void *password, size_t password_size, const void *salt, size_t salt_size, uint32_t iterations, uint8_t *key, size_t key_size)
+{
+    Pbkdf2Params params = { password, password_size, salt, salt_size, iterations, key, key_size };
+    derive(&params, 1U);
+}
+
+void Pbkdf2Sha256::derive(const Pbkdf2Params *params, size_t count)
+{
+    // A single output block leaves all lanes but one idle
+    size_t blocks = 0U;
+    for (size_t i = 0U; i < count && blocks < 2U; ++i)
+    {
+        blocks += (params[i].key_size + 31U) / 32U;
+    }
+
+    if (blocks < 2U)
+    {
+        derive_serial(params, count);
+        return;
+    }
+
+    select_backend().derive(params, count);
+}
+
+const char *Pbkdf2Sha256::backend()
+{
+    return select_backend().name;
+}
+
+size_t Pbkdf2Sha256::lanes()
+{
+    return select_backend().lanes;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "pbkdf2.hpp"
+
+/// PBKDF2-HMAC-SHA256 class.
+/// Runs the iterations of many output blocks at once, whether they come
+/// from one long key or from a batch of separate derivations, in 8 (AVX2)
+/// or 16 (AVX-512) SIMD lanes. Each lane keeps its inner and outer keyed
+/// midstates and its running HMAC output in transposed registers; the
+/// fixed one-block messages are padded in registers, so an iteration is
+/// two compressions with no loads, transposes or byte swaps. A lane whose
+/// output block is finished is refilled with the next one. A single output
+/// block, or a processor without AVX2, runs through Pbkdf2<Sha256Engine>
+/// on the single-stream backend.
+class Pbkdf2Sha256
+{
+public:
+    /// Derive a key.
+    /// @param password                 Pointer to the password
+    /// @param password_size            Size of the password
+    /// @param salt                     Pointer to the salt
+    /// @param salt_size                Size of the salt
+    /// @param iterations               Iteration count (at least 1)
+    /// @param key                      Output buffer for the key
+    /// @param key_size                 Size of the key
+    static void derive(const void *password, size_t password_size, const void *salt, size_t salt_size, uint32_t iterations, uint8_t *key, size_t key_size);
+
+    /// Derive a batch of keys, sharing the SIMD lanes between them.
+    /// @param params                   Derivation requests
+    /// @param count                    Number of requests
+    static void derive(const Pbkdf2Params *params, size_t count);
+
+    /// Get the name of the backend selected for this processor.
+    /// @return                         Backend name ("avx512", "avx2" or "serial")
+    static const char *backend();
+
+    /// Get the number of output blocks iterated in parallel by the selected backend.
+    /// @return                         Number of SIMD lanes
+    static size_t lanes();
+};
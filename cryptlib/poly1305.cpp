@@ -0,0 +1,469 @@
+#include "poly1305.hpp"
+#include "cpu_features.hpp"
+#include <cstring>
+
+#if defined(CRYPTLIB_X86)
+#include <immintrin.h>
+#endif
+
+// Mask of a radix 2^26 limb
+static const uint32_t mask26 = 0x3ffffffU;
+
+// Bit 128 of a full block, in the top limb
+static const uint32_t hibit = 1U << 24;
+
+// Load a little-endian 32-bit word
+static inline uint32_t load_le32(const uint8_t *p)
+{
+    return static_cast<uint32_t>(p[0]) |
+           (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) |
+           (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Store a little-endian 32-bit word
+static inline void store_le32(uint8_t *p, uint32_t x)
+{
+    p[0] = static_cast<uint8_t>(x);
+    p[1] = static_cast<uint8_t>(x >> 8);
+    p[2] = static_cast<uint8_t>(x >> 16);
+    p[3] = static_cast<uint8_t>(x >> 24);
+}
+
+// Wipe memory in a way the compiler cannot elide
+static void wipe(void *data, size_t size)
+{
+    volatile uint8_t *p = static_cast<volatile uint8_t*>(data);
+    for (size_t i = 0U; i < size; ++i)
+    {
+        p[i] = 0U;
+    }
+}
+
+// Multiply two 32-bit values to 64 bits
+static inline uint64_t mul(uint32_t x, uint32_t y)
+{
+    return static_cast<uint64_t>(x) * y;
+}
+
+// Carry 64-bit limb sums into radix 2^26 limbs, folding the carry out of
+// the top limb back in times 5. Limb 1 may be left slightly over 26 bits.
+static inline void carry(uint64_t *d, uint32_t *out)
+{
+    d[1] += d[0] >> 26;
+    d[2] += d[1] >> 26;
+    d[3] += d[2] >> 26;
+    d[4] += d[3] >> 26;
+    uint64_t c = (d[0] & mask26) + (d[4] >> 26) * 5U;
+    out[0] = static_cast<uint32_t>(c) & mask26;
+    out[1] = static_cast<uint32_t>(d[1] & mask26) + static_cast<uint32_t>(c >> 26);
+    out[2] = static_cast<uint32_t>(d[2]) & mask26;
+    out[3] = static_cast<uint32_t>(d[3]) & mask26;
+    out[4] = static_cast<uint32_t>(d[4]) & mask26;
+}
+
+// Multiply two numbers modulo 2^130 - 5, partially reduced. The output may
+// alias an input.
+static inline void multiply(const uint32_t *a, const uint32_t *b, uint32_t *out)
+{
+    const uint32_t s1 = b[1] * 5U;
+    const uint32_t s2 = b[2] * 5U;
+    const uint32_t s3 = b[3] * 5U;
+    const uint32_t s4 = b[4] * 5U;
+    uint64_t d[5] =
+    {
+        mul(a[0], b[0]) + mul(a[1], s4) + mul(a[2], s3) + mul(a[3], s2) + mul(a[4], s1),
+        mul(a[0], b[1]) + mul(a[1], b[0]) + mul(a[2], s4) + mul(a[3], s3) + mul(a[4], s2),
+        mul(a[0], b[2]) + mul(a[1], b[1]) + mul(a[2], b[0]) + mul(a[3], s4) + mul(a[4], s3),
+        mul(a[0], b[3]) + mul(a[1], b[2]) + mul(a[2], b[1]) + mul(a[3], b[0]) + mul(a[4], s4),
+        mul(a[0], b[4]) + mul(a[1], b[3]) + mul(a[2], b[2]) + mul(a[3], b[1]) + mul(a[4], b[0])
+    };
+    carry(d, out);
+}
+
+// Process 16-byte blocks one at a time: h = (h + m) * r
+static void blocks_portable(const uint32_t (*powers)[5], uint32_t *h, const uint8_t *m, size_t blocks, uint32_t top)
+{
+    for (; blocks; --blocks, m += 16U)
+    {
+        h[0] += load_le32(m) & mask26;
+        h[1] += (load_le32(m + 3) >> 2) & mask26;
+        h[2] += (load_le32(m + 6) >> 4) & mask26;
+        h[3] += load_le32(m + 9) >> 6;
+        h[4] += (load_le32(m + 12) >> 8) | top;
+        multiply(h, powers[0], h);
+    }
+}
+
+#if defined(CRYPTLIB_X86)
+// Multiply the lanes of a by the lanes of r modulo 2^130 - 5, with s = 5r
+CRYPTLIB_TARGET("avx2")
+static CRYPTLIB_INLINE void multiply_avx2(__m256i *a, const __m256i *r, const __m256i *s)
+{
+    __m256i d0 = _mm256_mul_epu32(a[0], r[0]);
+    __m256i d1 = _mm256_mul_epu32(a[0], r[1]);
+    __m256i d2 = _mm256_mul_epu32(a[0], r[2]);
+    __m256i d3 = _mm256_mul_epu32(a[0], r[3]);
+    __m256i d4 = _mm256_mul_epu32(a[0], r[4]);
+    d0 = _mm256_add_epi64(d0, _mm256_mul_epu32(a[1], s[4]));
+    d1 = _mm256_add_epi64(d1, _mm256_mul_epu32(a[1], r[0]));
+    d2 = _mm256_add_epi64(d2, _mm256_mul_epu32(a[1], r[1]));
+    d3 = _mm256_add_epi64(d3, _mm256_mul_epu32(a[1], r[2]));
+    d4 = _mm256_add_epi64(d4, _mm256_mul_epu32(a[1], r[3]));
+    d0 = _mm256_add_epi64(d0, _mm256_mul_epu32(a[2], s[3]));
+    d1 = _mm256_add_epi64(d1, _mm256_mul_epu32(a[2], s[4]));
+    d2 = _mm256_add_epi64(d2, _mm256_mul_epu32(a[2], r[0]));
+    d3 = _mm256_add_epi64(d3, _mm256_mul_epu32(a[2], r[1]));
+    d4 = _mm256_add_epi64(d4, _mm256_mul_epu32(a[2], r[2]));
+    d0 = _mm256_add_epi64(d0, _mm256_mul_epu32(a[3], s[2]));
+    d1 = _mm256_add_epi64(d1, _mm256_mul_epu32(a[3], s[3]));
+    d2 = _mm256_add_epi64(d2, _mm256_mul_epu32(a[3], s[4]));
+    d3 = _mm256_add_epi64(d3, _mm256_mul_epu32(a[3], r[0]));
+    d4 = _mm256_add_epi64(d4, _mm256_mul_epu32(a[3], r[1]));
+    d0 = _mm256_add_epi64(d0, _mm256_mul_epu32(a[4], s[1]));
+    d1 = _mm256_add_epi64(d1, _mm256_mul_epu32(a[4], s[2]));
+    d2 = _mm256_add_epi64(d2, _mm256_mul_epu32(a[4], s[3]));
+    d3 = _mm256_add_epi64(d3, _mm256_mul_epu32(a[4], s[4]));
+    d4 = _mm256_add_epi64(d4, _mm256_mul_epu32(a[4], r[0]));
+
+    const __m256i mask = _mm256_set1_epi64x(mask26);
+    d1 = _mm256_add_epi64(d1, _mm256_srli_epi64(d0, 26));
+    d2 = _mm256_add_epi64(d2, _mm256_srli_epi64(d1, 26));
+    d3 = _mm256_add_epi64(d3, _mm256_srli_epi64(d2, 26));
+    d4 = _mm256_add_epi64(d4, _mm256_srli_epi64(d3, 26));
+    __m256i c = _mm256_srli_epi64(d4, 26);
+    d0 = _mm256_add_epi64(_mm256_and_si256(d0, mask), _mm256_add_epi64(c, _mm256_slli_epi64(c, 2)));
+    a[0] = _mm256_and_si256(d0, mask);
+    a[1] = _mm256_add_epi64(_mm256_and_si256(d1, mask), _mm256_srli_epi64(d0, 26));
+    a[2] = _mm256_and_si256(d2, mask);
+    a[3] = _mm256_and_si256(d3, mask);
+    a[4] = _mm256_and_si256(d4, mask);
+}
+
+// Process blocks four at a time with AVX2, one block per lane. Lane j
+// accumulates blocks j, j + 4, ... multiplied by r^4 per step; the last
+// step multiplies it by r^(4 - j) instead.
+CRYPTLIB_TARGET("avx2")
+static void blocks_avx2(const uint32_t (*powers)[5], uint32_t *h, const uint8_t *m, size_t blocks, uint32_t top)
+{
+    const size_t groups = blocks / 4U;
+    if (groups)
+    {
+        const __m256i mask = _mm256_set1_epi64x(mask26);
+        const __m256i high = _mm256_set1_epi64x(top);
+        __m256i r[5];
+        __m256i s[5];
+        __m256i a[5];
+        for (size_t i = 0U; i < 5U; ++i)
+        {
+            r[i] = _mm256_set1_epi64x(powers[3][i]);
+            s[i] = _mm256_add_epi64(r[i], _mm256_slli_epi64(r[i], 2));
+            a[i] = _mm256_set_epi64x(0, 0, 0, h[i]);
+        }
+
+        for (size_t g = 0U; g < groups; ++g, m += 64U)
+        {
+            if (g + 1U == groups)
+            {
+                for (size_t i = 0U; i < 5U; ++i)
+                {
+                    r[i] = _mm256_setr_epi64x(powers[3][i], powers[2][i], powers[1][i], powers[0][i]);
+                    s[i] = _mm256_add_epi64(r[i], _mm256_slli_epi64(r[i], 2));
+                }
+            }
+
+            // Gather the low and high halves of the four blocks
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m));
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m + 32U));
+            __m256i lo = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(x, y), 0xD8);
+            __m256i hi = _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(x, y), 0xD8);
+
+            a[0] = _mm256_add_epi64(a[0], _mm256_and_si256(lo, mask));
+            a[1] = _mm256_add_epi64(a[1], _mm256_and_si256(_mm256_srli_epi64(lo, 26), mask));
+            a[2] = _mm256_add_epi64(a[2], _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(lo, 52), _mm256_slli_epi64(hi, 12)), mask));
+            a[3] = _mm256_add_epi64(a[3], _mm256_and_si256(_mm256_srli_epi64(hi, 14), mask));
+            a[4] = _mm256_add_epi64(a[4], _mm256_or_si256(_mm256_srli_epi64(hi, 40), high));
+            multiply_avx2(a, r, s);
+        }
+
+        // Sum the lanes
+        alignas(32) uint64_t lanes[5][4];
+        uint64_t d[5];
+        for (size_t i = 0U; i < 5U; ++i)
+        {
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[i]), a[i]);
+            d[i] = lanes[i][0] + lanes[i][1] + lanes[i][2] + lanes[i][3];
+        }
+
+        carry(d, h);
+    }
+
+    blocks_portable(powers, h, m, blocks % 4U, top);
+}
+
+// Multiply the lanes of a by the lanes of r modulo 2^130 - 5, with s = 5r
+CRYPTLIB_TARGET("avx512f")
+static CRYPTLIB_INLINE void multiply_avx512(__m512i *a, const __m512i *r, const __m512i *s)
+{
+    __m512i d0 = _mm512_mul_epu32(a[0], r[0]);
+    __m512i d1 = _mm512_mul_epu32(a[0], r[1]);
+    __m512i d2 = _mm512_mul_epu32(a[0], r[2]);
+    __m512i d3 = _mm512_mul_epu32(a[0], r[3]);
+    __m512i d4 = _mm512_mul_epu32(a[0], r[4]);
+    d0 = _mm512_add_epi64(d0, _mm512_mul_epu32(a[1], s[4]));
+    d1 = _mm512_add_epi64(d1, _mm512_mul_epu32(a[1], r[0]));
+    d2 = _mm512_add_epi64(d2, _mm512_mul_epu32(a[1], r[1]));
+    d3 = _mm512_add_epi64(d3, _mm512_mul_epu32(a[1], r[2]));
+    d4 = _mm512_add_epi64(d4, _mm512_mul_epu32(a[1], r[3]));
+    d0 = _mm512_add_epi64(d0, _mm512_mul_epu32(a[2], s[3]));
+    d1 = _mm512_add_epi64(d1, _mm512_mul_epu32(a[2], s[4]));
+    d2 = _mm512_add_epi64(d2, _mm512_mul_epu32(a[2], r[0]));
+    d3 = _mm512_add_epi64(d3, _mm512_mul_epu32(a[2], r[1]));
+    d4 = _mm512_add_epi64(d4, _mm512_mul_epu32(a[2], r[2]));
+    d0 = _mm512_add_epi64(d0, _mm512_mul_epu32(a[3], s[2]));
+    d1 = _mm512_add_epi64(d1, _mm512_mul_epu32(a[3], s[3]));
+    d2 = _mm512_add_epi64(d2, _mm512_mul_epu32(a[3], s[4]));
+    d3 = _mm512_add_epi64(d3, _mm512_mul_epu32(a[3], r[0]));
+    d4 = _mm512_add_epi64(d4, _mm512_mul_epu32(a[3], r[1]));
+    d0 = _mm512_add_epi64(d0, _mm512_mul_epu32(a[4], s[1]));
+    d1 = _mm512_add_epi64(d1, _mm512_mul_epu32(a[4], s[2]));
+    d2 = _mm512_add_epi64(d2, _mm512_mul_epu32(a[4], s[3]));
+    d3 = _mm512_add_epi64(d3, _mm512_mul_epu32(a[4], s[4]));
+    d4 = _mm512_add_epi64(d4, _mm512_mul_epu32(a[4], r[0]));
+
+    const __m512i mask = _mm512_set1_epi64(mask26);
+    d1 = _mm512_add_epi64(d1, _mm512_srli_epi64(d0, 26));
+    d2 = _mm512_add_epi64(d2, _mm512_srli_epi64(d1, 26));
+    d3 = _mm512_add_epi64(d3, _mm512_srli_epi64(d2, 26));
+    d4 = _mm512_add_epi64(d4, _mm512_srli_epi64(d3, 26));
+    __m512i c = _mm512_srli_epi64(d4, 26);
+    d0 = _mm512_add_epi64(_mm512_and_si512(d0, mask), _mm512_add_epi64(c, _mm512_slli_epi64(c, 2)));
+    a[0] = _mm512_and_si512(d0, mask);
+    a[1] = _mm512_add_epi64(_mm512_and_si512(d1, mask), _mm512_srli_epi64(d0, 26));
+    a[2] = _mm512_and_si512(d2, mask);
+    a[3] = _mm512_and_si512(d3, mask);
+    a[4] = _mm512_and_si512(d4, mask);
+}
+
+// Process blocks eight at a time with AVX-512, as blocks_avx2() with r^8
+CRYPTLIB_TARGET("avx512f")
+static void blocks_avx512(const uint32_t (*powers)[5], uint32_t *h, const uint8_t *m, size_t blocks, uint32_t top)
+{
+    const size_t groups = blocks / 8U;
+    if (groups)
+    {
+        const __m512i mask = _mm512_set1_epi64(mask26);
+        const __m512i high = _mm512_set1_epi64(top);
+        const __m512i even = _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0);
+        const __m512i odd = _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1);
+        __m512i r[5];
+        __m512i s[5];
+        __m512i a[5];
+        for (size_t i = 0U; i < 5U; ++i)
+        {
+            r[i] = _mm512_set1_epi64(powers[7][i]);
+            s[i] = _mm512_add_epi64(r[i], _mm512_slli_epi64(r[i], 2));
+            a[i] = _mm512_set_epi64(0, 0, 0, 0, 0, 0, 0, h[i]);
+        }
+
+        for (size_t g = 0U; g < groups; ++g, m += 128U)
+        {
+            if (g + 1U == groups)
+            {
+                for (size_t i = 0U; i < 5U; ++i)
+                {
+                    r[i] = _mm512_set_epi64(powers[0][i], powers[1][i], powers[2][i], powers[3][i],
+                        powers[4][i], powers[5][i], powers[6][i], powers[7][i]);
+                    s[i] = _mm512_add_epi64(r[i], _mm512_slli_epi64(r[i], 2));
+                }
+            }
+
+            // Gather the low and high halves of the eight blocks
+            __m512i x = _mm512_loadu_si512(m);
+            __m512i y = _mm512_loadu_si512(m + 64U);
+            __m512i lo = _mm512_permutex2var_epi64(x, even, y);
+            __m512i hi = _mm512_permutex2var_epi64(x, odd, y);
+
+            a[0] = _mm512_add_epi64(a[0], _mm512_and_si512(lo, mask));
+            a[1] = _mm512_add_epi64(a[1], _mm512_and_si512(_mm512_srli_epi64(lo, 26), mask));
+            a[2] = _mm512_add_epi64(a[2], _mm512_and_si512(_mm512_or_si512(_mm512_srli_epi64(lo, 52), _mm512_slli_epi64(hi, 12)), mask));
+            a[3] = _mm512_add_epi64(a[3], _mm512_and_si512(_mm512_srli_epi64(hi, 14), mask));
+            a[4] = _mm512_add_epi64(a[4], _mm512_or_si512(_mm512_srli_epi64(hi, 40), high));
+            multiply_avx512(a, r, s);
+        }
+
+        // Sum the lanes
+        uint64_t d[5];
+        for (size_t i = 0U; i < 5U; ++i)
+        {
+            d[i] = static_cast<uint64_t>(_mm512_reduce_add_epi64(a[i]));
+        }
+
+        carry(d, h);
+    }
+
+    blocks_avx2(powers, h, m, blocks % 8U, top);
+}
+#endif
+
+/// Poly1305 backend.
+struct Poly1305Backend
+{
+    /// Backend name.
+    const char *name;
+
+    /// Process 16-byte blocks, with the given top limb bit.
+    void (*blocks)(const uint32_t (*powers)[5], uint32_t *h, const uint8_t *m, size_t blocks, uint32_t top);
+};
+
+// Select the fastest backend supported by the processor
+static const Poly1305Backend &select_backend()
+{
+    static const Poly1305Backend backend =
+#if defined(CRYPTLIB_X86)
+        (CpuFeatures::avx512f() && CpuFeatures::avx2()) ? Poly1305Backend{ "avx512", blocks_avx512 } :
+        CpuFeatures::avx2() ? Poly1305Backend{ "avx2", blocks_avx2 } :
+#endif
+        Poly1305Backend{ "portable", blocks_portable };
+    return backend;
+}
+
+Poly1305::Poly1305(const void *key) : powers(), pad(), h(), block(), buflen(0U)
+{
+    set_key(key);
+}
+
+Poly1305::~Poly1305()
+{
+    wipe(powers, sizeof(powers));
+    wipe(pad, sizeof(pad));
+    wipe(h, sizeof(h));
+    wipe(block, sizeof(block));
+}
+
+void Poly1305::set_key(const void *key)
+{
+    const uint8_t *k = static_cast<const uint8_t*>(key);
+
+    // Clamp r and split it into limbs
+    powers[0][0] = load_le32(k) & 0x3ffffffU;
+    powers[0][1] = (load_le32(k + 3) >> 2) & 0x3ffff03U;
+    powers[0][2] = (load_le32(k + 6) >> 4) & 0x3ffc0ffU;
+    powers[0][3] = (load_le32(k + 9) >> 6) & 0x3f03fffU;
+    powers[0][4] = (load_le32(k + 12) >> 8) & 0x00fffffU;
+    for (size_t i = 1U; i < 8U; ++i)
+    {
+        multiply(powers[i - 1U], powers[0], powers[i]);
+    }
+
+    for (size_t i = 0U; i < 4U; ++i)
+    {
+        pad[i] = load_le32(k + 16U + i * 4U);
+    }
+
+    std::memset(h, 0, sizeof(h));
+    buflen = 0U;
+}
+
+void Poly1305::add(const void *data, size_t size)
+{
+    const uint8_t *p = static_cast<const uint8_t*>(data);
+    const Poly1305Backend &backend = select_backend();
+
+    // Complete a partial block
+    if (buflen)
+    {
+        size_t n = (size < 16U - buflen) ? size : 16U - buflen;
+        std::memcpy(block + buflen, p, n);
+        buflen += n;
+        p += n;
+        size -= n;
+        if (buflen < 16U)
+        {
+            return;
+        }
+
+        backend.blocks(powers, h, block, 1U, hibit);
+        buflen = 0U;
+    }
+
+    // Process whole blocks in place and keep the rest
+    backend.blocks(powers, h, p, size / 16U, hibit);
+    buflen = size % 16U;
+    if (buflen)
+    {
+        std::memcpy(block, p + size - buflen, buflen);
+    }
+}
+
+void Poly1305::close(uint8_t *tag)
+{
+    // A partial block is padded with a 1 byte instead of bit 128
+    if (buflen)
+    {
+        block[buflen] = 1U;
+        std::memset(block + buflen + 1U, 0, 15U - buflen);
+        blocks_portable(powers, h, block, 1U, 0U);
+    }
+
+    // Carry fully, then compute h - p and keep it unless it is negative
+    uint32_t c = h[1] >> 26;
+    h[1] &= mask26;
+    h[2] += c;
+    c = h[2] >> 26;
+    h[2] &= mask26;
+    h[3] += c;
+    c = h[3] >> 26;
+    h[3] &= mask26;
+    h[4] += c;
+    c = h[4] >> 26;
+    h[4] &= mask26;
+    h[0] += c * 5U;
+    c = h[0] >> 26;
+    h[0] &= mask26;
+    h[1] += c;
+
+    uint32_t g[5];
+    g[0] = h[0] + 5U;
+    g[1] = h[1] + (g[0] >> 26);
+    g[2] = h[2] + (g[1] >> 26);
+    g[3] = h[3] + (g[2] >> 26);
+    g[4] = h[4] + (g[3] >> 26) - (1U << 26);
+    g[0] &= mask26;
+    g[1] &= mask26;
+    g[2] &= mask26;
+    g[3] &= mask26;
+
+    const uint32_t select = (g[4] >> 31) - 1U;
+    for (size_t i = 0U; i < 5U; ++i)
+    {
+        h[i] = (h[i] & ~select) | (g[i] & select);
+    }
+
+    // Tag = (h + s) mod 2^128
+    uint32_t words[4] =
+    {
+        h[0] | (h[1] << 26),
+        (h[1] >> 6) | (h[2] << 20),
+        (h[2] >> 12) | (h[3] << 14),
+        (h[3] >> 18) | (h[4] << 8)
+    };
+
+    uint64_t f = 0U;
+    for (size_t i = 0U; i < 4U; ++i)
+    {
+        f += static_cast<uint64_t>(words[i]) + pad[i];
+        store_le32(tag + i * 4U, static_cast<uint32_t>(f));
+        f >>= 32;
+    }
+
+    wipe(g, sizeof(g));
+    wipe(words, sizeof(words));
+    std::memset(h, 0, sizeof(h));
+    buflen = 0U;
+}
+
+const char *Poly1305::backend()
+{
+    return select_backend().name;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// Poly1305 one-time authenticator class (RFC 8439).
+/// The accumulator is kept in radix 2^26 so products fit 32x32-bit
+/// multiplications. Long messages are split over 4 (AVX2) or 8 (AVX-512)
+/// SIMD lanes: each lane takes every fourth (eighth) block and multiplies
+/// by r^4 (r^8) per step, and the last step multiplies the lanes by r^4..r
+/// (r^8..r) so their sum equals the serial result. The powers of r are
+/// computed once when the key is set. Every backend runs in constant time.
+///
+/// A key must authenticate only one message.
+class Poly1305
+{
+public:
+    /// Key size in bytes.
+    static const size_t key_size = 32U;
+
+    /// Tag size in bytes.
+    static const size_t tag_size = 16U;
+
+private:
+    /// Powers r^1..r^8 of the clamped key, in radix 2^26.
+    uint32_t powers[8][5];
+
+    /// Key half s, added to the tag.
+    uint32_t pad[4];
+
+    /// Accumulator, in radix 2^26.
+    uint32_t h[5];
+
+    /// Partial block awaiting processing.
+    uint8_t block[16];
+
+    /// Bytes in the partial block.
+    size_t buflen;
+
+public:
+    /// Constructor.
+    /// @param key                      Pointer to the 32-byte key
+    explicit Poly1305(const void *key);
+
+    /// Destructor, wiping the key material.
+    ~Poly1305();
+
+    /// Delete copy constructor.
+    Poly1305(const Poly1305 &) = delete;
+
+    /// Delete assignment operator.
+    Poly1305 &operator=(const Poly1305 &) = delete;
+
+    /// Set a new key and start a new message.
+    /// @param key                      Pointer to the 32-byte key
+    void set_key(const void *key);
+
+    /// Add data to the message.
+    /// @param data                     Pointer to the data
+    /// @param size                     Size of the data in bytes
+    void add(const void *data, size_t size);
+
+    /// Finish the message, compute the tag and clear the accumulator.
+    /// @param tag                      Output 16-byte tag
+    void close(uint8_t *tag);
+
+    /// Get the name of the backend selected for this processor.
+    /// @return                         Backend name ("avx512", "avx2" or "portable")
+    static const char *backend();
+};
@@ -0,0 +1,54 @@
+#include "sha1.h"
+#include "sha1_engine.hpp"
+#include <new>
+
+static_assert(sizeof(Sha1Engine) <= sizeof(SHA1Context), "SHA1Context is too small for the engine");
+static_assert(alignof(Sha1Engine) <= alignof(SHA1Context), "SHA1Context is underaligned for the engine");
+
+// Get the engine held in a context
+static Sha1Engine &engine_of(SHA1Context *context)
+{
+    return *reinterpret_cast<Sha1Engine*>(context);
+}
+
+size_t SHA1ContextSize(void)
+{
+    return sizeof(SHA1Context);
+}
+
+size_t SHA1ContextAlign(void)
+{
+    return alignof(SHA1Context);
+}
+
+void SHA1Init(SHA1Context *context)
+{
+    new (context) Sha1Engine();
+}
+
+void SHA1Add(SHA1Context *context, const void *data, size_t size)
+{
+    engine_of(context).add(data, size);
+}
+
+void SHA1Close(SHA1Context *context, uint8_t *digest)
+{
+    engine_of(context).close(digest);
+}
+
+void SHA1Hash(const void *data, size_t size, uint8_t *digest)
+{
+    Sha1Engine::hash(data, size, digest);
+}
+
+void SHA1HashBatch(const HashData *messages, size_t count, uint8_t *digests)
+{
+    // There is no multi-buffer SHA1; the SHA-NI or SIMD backend hashes each message
+    Sha1Engine engine;
+    for (size_t i = 0U; i < count; ++i)
+    {
+        engine.clear();
+        engine.add(messages[i].data, messages[i].size);
+        engine.close(digests + i * 20U);
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "hash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// SHA1 context size in bytes.
+#define SHA1_CONTEXT_SIZE 128
+
+/// SHA1 digest size in bytes.
+#define SHA1_DIGEST_SIZE 20
+
+/// SHA1 context, allocated by the caller (on the stack or embedded in
+/// another structure). The contents are private to the library.
+typedef struct SHA1Context
+{
+    /// Opaque engine storage
+    uint64_t opaque[SHA1_CONTEXT_SIZE / 8];
+} SHA1Context;
+
+/// Get the size of SHA1Context, for callers that cannot read this header.
+/// @return                             Context size in bytes
+size_t SHA1ContextSize(void);
+
+/// Get the alignment of SHA1Context, for callers that cannot read this header.
+/// @return                             Context alignment in bytes
+size_t SHA1ContextAlign(void);
+
+/// Initialize a context to hash a new message.
+/// @param context                      Context to initialize
+void SHA1Init(SHA1Context *context);
+
+/// Add data to the hash.
+/// @param context                      Initialized context
+/// @param data                         Pointer to the data to add
+/// @param size                         Size of the data to add
+void SHA1Add(SHA1Context *context, const void *data, size_t size);
+
+/// Close the hash and write the digest. The context must be initialized
+/// again before reuse.
+/// @param context                      Initialized context
+/// @param digest                       Output buffer of 20 bytes
+void SHA1Close(SHA1Context *context, uint8_t *digest);
+
+/// Calculate the digest of a message in one call.
+/// @param data                         Pointer to the message
+/// @param size                         Size of the message
+/// @param digest                       Output buffer of 20 bytes
+void SHA1Hash(const void *data, size_t size, uint8_t *digest);
+
+/// Calculate the digests of a batch of independent messages in one call.
+/// @param messages                     Array of messages to hash
+/// @param count                        Number of messages
+/// @param digests                      Output array of count 20-byte digests
+void SHA1HashBatch(const HashData *messages, size_t count, uint8_t *digests);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,220 @@
+#pragma once
+
+#include "hash_engine.hpp"
+
+/// Process SHA1 blocks with the backend selected for this processor.
+/// @param state                        SHA1 state vector
+/// @param blocks                       Pointer to the blocks to process
+/// @param count                        Number of 64-byte blocks
+void sha1_process(uint32_t *state, const uint8_t *blocks, size_t count);
+
+/// SHA1 hash engine.
+/// @tparam Portable                    Use only the portable compression function,
+///                                     making the engine usable in constant expressions
+template <bool Portable>
+class BasicSha1Engine : public HashEngine<BasicSha1Engine<Portable>, uint32_t, 5U, 64U, 20U, true>
+{
+    /// Base engine type.
+    typedef HashEngine<BasicSha1Engine<Portable>, uint32_t, 5U, 64U, 20U, true> Base;
+
+    /// Choose function (rounds 0-19).
+    static constexpr uint32_t ch(uint32_t b, uint32_t c, uint32_t d)
+    {
+        return d ^ (b & (c ^ d));
+    }
+
+    /// Parity function (rounds 20-39 and 60-79).
+    static constexpr uint32_t parity(uint32_t b, uint32_t c, uint32_t d)
+    {
+        return b ^ c ^ d;
+    }
+
+    /// Majority function (rounds 40-59).
+    static constexpr uint32_t maj(uint32_t b, uint32_t c, uint32_t d)
+    {
+        return (b & c) | (d & (b | c));
+    }
+
+    /// Run one round. The caller rotates the roles of the working
+    /// variables instead of moving them.
+    /// @param a                        Working variable a
+    /// @param b                        Working variable b, rotated in place
+    /// @param e                        Working variable e, receiving the round output
+    /// @param f                        Round function of b, c and d
+    /// @param wk                       Message word plus round constant
+    static constexpr void round(uint32_t a, uint32_t &b, uint32_t &e, uint32_t f, uint32_t wk)
+    {
+        e += Base::rtl(a, 5U) + f + wk;
+        b = Base::rtl(b, 30U);
+    }
+
+public:
+    /// Instrumentation counters used by the engine.
+    static const HashStats::Algorithm algorithm = Portable ? HashStats::untracked : HashStats::sha1;
+
+    /// Round constants, one per group of 20 rounds.
+    static constexpr uint32_t k[4] =
+    {
+        0x5A827999U, 0x6ED9EBA1U, 0x8F1BBCDCU, 0xCA62C1D6U
+    };
+
+    /// Initial state vector.
+    static constexpr uint32_t iv[5] =
+    {
+        0x67452301U, 0xEFCDAB89U, 0x98BADCFEU, 0x10325476U, 0xC3D2E1F0U
+    };
+
+    /// Constructor.
+    constexpr BasicSha1Engine()
+    {
+        clear();
+    }
+
+    /// Clear the hash to an initial state.
+    constexpr void clear()
+    {
+        // Seed the state vector
+        for (size_t i = 0U; i < 5U; ++i)
+        {
+            this->state[i] = iv[i];
+        }
+
+        // Clear buffer and total lengths
+        this->buflen = 0U;
+        this->totlen = 0U;
+    }
+
+    /// Process full blocks.
+    /// @param blocks                   Pointer to the blocks to process
+    /// @param count                    Number of 64-byte blocks
+    constexpr void process(const uint8_t *blocks, size_t count)
+    {
+        if (Portable)
+        {
+            for (; count; --count, blocks += 64U)
+            {
+                compress(this->state, blocks);
+            }
+        }
+        else
+        {
+            sha1_process(this->state, blocks, count);
+        }
+    }
+
+    /// Expand a block into the 80 message words with the round constants added.
+    /// @param block                    Pointer to the 64-byte block
+    /// @param wk                       Output array of 80 words
+    static constexpr void schedule(const uint8_t *block, uint32_t *wk)
+    {
+        // Populate message
+        uint32_t w[16] = {};
+        for (size_t i = 0U; i < 16U; ++i)
+        {
+            w[i] = (static_cast<uint32_t>(block[i * 4    ]) << 24) |
+                   (static_cast<uint32_t>(block[i * 4 + 1]) << 16) |
+                   (static_cast<uint32_t>(block[i * 4 + 2]) <<  8) |
+                   (static_cast<uint32_t>(block[i * 4 + 3])      );
+            wk[i] = w[i] + k[0];
+        }
+
+        // Extend message words in a rolling window
+        for (size_t i = 16U; i < 80U; ++i)
+        {
+            w[i & 15U] = Base::rtl(w[(i - 3U) & 15U] ^ w[(i - 8U) & 15U] ^ w[(i - 14U) & 15U] ^ w[i & 15U], 1U);
+            wk[i] = w[i & 15U] + k[i / 20U];
+        }
+    }
+
+    /// Run the 80 rounds on a precomputed schedule.
+    /// The rounds are unrolled by five, which brings the working variables
+    /// back to their original roles, so there are no moves and no branches
+    /// on the round index.
+    /// @param state                    SHA1 state vector
+    /// @param wk                       Message words plus round constants, as made by schedule()
+    static constexpr void rounds(uint32_t *state, const uint32_t *wk)
+    {
+        // Populate state
+        uint32_t a = state[0];
+        uint32_t b = state[1];
+        uint32_t c = state[2];
+        uint32_t d = state[3];
+        uint32_t e = state[4];
+
+        for (size_t i = 0U; i < 20U; i += 5U)
+        {
+            round(a, b, e, ch(b, c, d), wk[i]);
+            round(e, a, d, ch(a, b, c), wk[i + 1U]);
+            round(d, e, c, ch(e, a, b), wk[i + 2U]);
+            round(c, d, b, ch(d, e, a), wk[i + 3U]);
+            round(b, c, a, ch(c, d, e), wk[i + 4U]);
+        }
+
+        for (size_t i = 20U; i < 40U; i += 5U)
+        {
+            round(a, b, e, parity(b, c, d), wk[i]);
+            round(e, a, d, parity(a, b, c), wk[i + 1U]);
+            round(d, e, c, parity(e, a, b), wk[i + 2U]);
+            round(c, d, b, parity(d, e, a), wk[i + 3U]);
+            round(b, c, a, parity(c, d, e), wk[i + 4U]);
+        }
+
+        for (size_t i = 40U; i < 60U; i += 5U)
+        {
+            round(a, b, e, maj(b, c, d), wk[i]);
+            round(e, a, d, maj(a, b, c), wk[i + 1U]);
+            round(d, e, c, maj(e, a, b), wk[i + 2U]);
+            round(c, d, b, maj(d, e, a), wk[i + 3U]);
+            round(b, c, a, maj(c, d, e), wk[i + 4U]);
+        }
+
+        for (size_t i = 60U; i < 80U; i += 5U)
+        {
+            round(a, b, e, parity(b, c, d), wk[i]);
+            round(e, a, d, parity(a, b, c), wk[i + 1U]);
+            round(d, e, c, parity(e, a, b), wk[i + 2U]);
+            round(c, d, b, parity(d, e, a), wk[i + 3U]);
+            round(b, c, a, parity(c, d, e), wk[i + 4U]);
+        }
+
+        // Update the state vector
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+
+    /// Process a single block with the portable compression function.
+    /// @param state                    SHA1 state vector
+    /// @param block                    Pointer to the 64-byte block
+    static constexpr void compress(uint32_t *state, const uint8_t *block)
+    {
+        uint32_t wk[80] = {};
+        schedule(block, wk);
+        rounds(state, wk);
+    }
+};
+
+template <bool Portable>
+constexpr uint32_t BasicSha1Engine<Portable>::k[4];
+
+template <bool Portable>
+constexpr uint32_t BasicSha1Engine<Portable>::iv[5];
+
+/// SHA1 hash engine using the fastest backend for the processor.
+typedef BasicSha1Engine<false> Sha1Engine;
+
+/// SHA1 hash engine usable in constant expressions.
+typedef BasicSha1Engine<true> Sha1ConstEngine;
+
+/// Calculate the SHA1 digest of a string, usable in constant expressions.
+/// @param str                          String literal (the terminator is not hashed)
+/// @return                             Message digest
+template <size_t N>
+constexpr Sha1Engine::Digest sha1(const char (&str)[N])
+{
+    Sha1ConstEngine engine;
+    engine.add(str, N - 1U);
+    return engine.close();
+}
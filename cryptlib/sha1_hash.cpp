@@ -1,181 +1,321 @@
 #include "sha1_hash.hpp"
-#include <algorithm>
-#include <cstring>
+#include "cpu_features.hpp"
 
-static inline uint32_t rtl(uint32_t x, size_t c)
+#if defined(CRYPTLIB_X86)
+#include <immintrin.h>
+#endif
+
+// Process blocks with the portable implementation
+static void process_scalar(uint32_t *state, const uint8_t *blocks, size_t count)
+{
+    for (; count; --count, blocks += 64U)
+    {
+        Sha1Engine::compress(state, blocks);
+    }
+}
+
+#if defined(CRYPTLIB_X86)
+// Rotate each 32-bit lane left
+template <int C>
+CRYPTLIB_TARGET("ssse3")
+static inline __m128i rtl_epi32(__m128i x)
 {
-    return (x << c) | (x >> (32 - c));
+    return _mm_or_si128(_mm_slli_epi32(x, C), _mm_srli_epi32(x, 32 - C));
 }
 
-void Sha1Hash::process()
+// Expand a block into the 80 message words plus round constants, four words at a time
+CRYPTLIB_TARGET("ssse3")
+static void schedule_ssse3(const uint8_t *block, uint32_t *wk)
 {
-    // Populate state
-    uint32_t a = state[0];
-    uint32_t b = state[1];
-    uint32_t c = state[2];
-    uint32_t d = state[3];
-    uint32_t e = state[4];
+    // Byte swap mask for big-endian message words
+    const __m128i swap = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
 
     // Populate message
-    uint32_t w[80];
-    for (size_t i = 0U; i < 16U; ++i)
+    __m128i w[20];
+    for (size_t g = 0U; g < 4U; ++g)
     {
-        w[i] = (buffer[i * 4    ] << 24) |
-               (buffer[i * 4 + 1] << 16) |
-               (buffer[i * 4 + 2] <<  8) |
-               (buffer[i * 4 + 3]      );
+        w[g] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block) + g), swap);
     }
 
-    // Extend message words
-    for (size_t i = 16U; i < 80U; ++i)
+    // Words 16-31: the last lane depends on the first lane of the same group,
+    // so it is computed without that term and corrected afterwards
+    for (size_t g = 4U; g < 8U; ++g)
     {
-        w[i] = rtl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1U);
+        __m128i t = _mm_xor_si128(_mm_xor_si128(w[g - 4], _mm_alignr_epi8(w[g - 3], w[g - 4], 8)),
+            _mm_xor_si128(w[g - 2], _mm_srli_si128(w[g - 1], 4)));
+        t = rtl_epi32<1>(t);
+        w[g] = _mm_xor_si128(t, rtl_epi32<1>(_mm_slli_si128(t, 12)));
     }
 
-    // Process loop
-    for (size_t i = 0U; i < 80U; ++i)
+    // Words 32-79 use the equivalent recurrence
+    // w[i] = rtl(w[i-6] ^ w[i-16] ^ w[i-28] ^ w[i-32], 2),
+    // which has no dependency within a group of four
+    for (size_t g = 8U; g < 20U; ++g)
     {
-        uint32_t f;
-        uint32_t k;
-        if (i < 20U)
-        {
-            f = (b & c) | (~b & d);
-            k = 0x5A827999U;
-        }
-        else if (i < 40U)
-        {
-            f = b ^ c ^ d;
-            k = 0x6ED9EBA1U;
-        }
-        else if (i < 60U)
-        {
-            f = (b & c) | (b & d) | (c & d);
-            k = 0x8F1BBCDCU;
-        }
-        else
-        {
-            f = b ^ c ^ d;
-            k = 0xCA62C1D6U;
-        }
-
-        uint32_t tmp = rtl(a, 5U) + f + e + k + w[i];
-        e = d;
-        d = c;
-        c = rtl(b, 30U);
-        b = a;
-        a = tmp;
+        __m128i t = _mm_xor_si128(_mm_xor_si128(_mm_alignr_epi8(w[g - 1], w[g - 2], 8), w[g - 4]),
+            _mm_xor_si128(w[g - 7], w[g - 8]));
+        w[g] = rtl_epi32<2>(t);
     }
 
-    // Update the state vector
-    state[0] += a;
-    state[1] += b;
-    state[2] += c;
-    state[3] += d;
-    state[4] += e;
+    // Add the round constants
+    for (size_t g = 0U; g < 20U; ++g)
+    {
+        __m128i k = _mm_set1_epi32(static_cast<int>(Sha1Engine::k[g / 5U]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(wk) + g, _mm_add_epi32(w[g], k));
+    }
 }
 
-Sha1Hash::Sha1Hash()
+// Process blocks with an SSSE3 message schedule
+CRYPTLIB_TARGET("ssse3")
+static void process_ssse3(uint32_t *state, const uint8_t *blocks, size_t count)
 {
-    clear();
+    uint32_t wk[80];
+    for (; count; --count, blocks += 64U)
+    {
+        schedule_ssse3(blocks, wk);
+        Sha1Engine::rounds(state, wk);
+    }
 }
 
-void Sha1Hash::clear()
+// Rotate each 32-bit lane left
+template <int C>
+CRYPTLIB_TARGET("avx2")
+static inline __m256i rtl_epi32(__m256i x)
 {
-    // Seed the state vector
-    state[0] = 0x67452301U;
-    state[1] = 0xEFCDAB89U;
-    state[2] = 0x98BADCFEU;
-    state[3] = 0x10325476U;
-    state[4] = 0xC3D2E1F0U;
-
-    // Clear buffer and total lengths
-    buflen = 0U;
-    totlen = 0U;
+    return _mm256_or_si256(_mm256_slli_epi32(x, C), _mm256_srli_epi32(x, 32 - C));
 }
 
-void Sha1Hash::add(const void *data, size_t size)
+// Expand two blocks at once, one per 128-bit lane. The AVX2 byte shifts and
+// alignr work within each lane, so this is the SSSE3 schedule run twice over
+CRYPTLIB_TARGET("avx2")
+static void schedule_avx2(const uint8_t *block, uint32_t *wk0, uint32_t *wk1)
 {
-    // Loop through the user provided data
-    while (size)
+    // Byte swap mask for big-endian message words
+    const __m256i swap = _mm256_set_epi8(
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+
+    // Populate message
+    const __m128i *in = reinterpret_cast<const __m128i*>(block);
+    __m256i w[20];
+    for (size_t g = 0U; g < 4U; ++g)
+    {
+        __m256i m = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(in + g)), _mm_loadu_si128(in + 4 + g), 1);
+        w[g] = _mm256_shuffle_epi8(m, swap);
+    }
+
+    // Words 16-31, correcting the last lane of each group
+    for (size_t g = 4U; g < 8U; ++g)
+    {
+        __m256i t = _mm256_xor_si256(_mm256_xor_si256(w[g - 4], _mm256_alignr_epi8(w[g - 3], w[g - 4], 8)),
+            _mm256_xor_si256(w[g - 2], _mm256_srli_si256(w[g - 1], 4)));
+        t = rtl_epi32<1>(t);
+        w[g] = _mm256_xor_si256(t, rtl_epi32<1>(_mm256_slli_si256(t, 12)));
+    }
+
+    // Words 32-79
+    for (size_t g = 8U; g < 20U; ++g)
+    {
+        __m256i t = _mm256_xor_si256(_mm256_xor_si256(_mm256_alignr_epi8(w[g - 1], w[g - 2], 8), w[g - 4]),
+            _mm256_xor_si256(w[g - 7], w[g - 8]));
+        w[g] = rtl_epi32<2>(t);
+    }
+
+    // Add the round constants and split the blocks
+    for (size_t g = 0U; g < 20U; ++g)
     {
-        // Calculate how much data to use on this pass
-        size_t use = std::min(64U - buflen, size);
-
-        // Copy the data into the buffer
-        std::memcpy(buffer + buflen, data, use);
-
-        // Update the pointers, counters and accumulators
-        data = static_cast<const uint8_t*>(data) + use;
-        size -= use;
-        buflen += use;
-        totlen += use * 8U;
-
-        // If we've accumulated a full block then process
-        if (buflen == 64U)
-        {
-            buflen = 0U;
-            process();
-        }
+        __m256i x = _mm256_add_epi32(w[g], _mm256_set1_epi32(static_cast<int>(Sha1Engine::k[g / 5U])));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(wk0) + g, _mm256_castsi256_si128(x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(wk1) + g, _mm256_extracti128_si256(x, 1));
     }
 }
 
-std::vector<uint8_t> Sha1Hash::close()
+// Process blocks with an AVX2 message schedule, two blocks per schedule pass
+CRYPTLIB_TARGET("avx2")
+static void process_avx2(uint32_t *state, const uint8_t *blocks, size_t count)
 {
-    // Save original length
-    uint64_t len = totlen;
+    uint32_t wk0[80];
+    uint32_t wk1[80];
+    for (; count >= 2U; count -= 2U, blocks += 128U)
+    {
+        schedule_avx2(blocks, wk0, wk1);
+        Sha1Engine::rounds(state, wk0);
+        Sha1Engine::rounds(state, wk1);
+    }
 
-    // Pad buffer
-    static const uint8_t pad[] =
+    if (count)
     {
-        0x80U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U,
-        0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U,
-        0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U,
-        0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U,
-        0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U,
-        0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U,
-        0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U,
-        0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U,
-    };
-
-    // Add padding
-    size_t padlen = ((buflen < 56U) ? 56U : 120U) - buflen;
-    add(pad, padlen);
-
-    // Add length
-    uint8_t bitlen[] =
+        schedule_ssse3(blocks, wk0);
+        Sha1Engine::rounds(state, wk0);
+    }
+}
+
+// Run four rounds with the SHA extensions. The E input is derived from the
+// a of four rounds ago (sha1nexte), which is then replaced by the current abcd
+template <int F>
+CRYPTLIB_TARGET("sha,sse4.1")
+static inline void rounds4_shani(__m128i &abcd, __m128i &prev, __m128i msg)
+{
+    __m128i e = _mm_sha1nexte_epu32(prev, msg);
+    prev = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e, F);
+}
+
+// Extend the next four message words and rotate the message window
+CRYPTLIB_TARGET("sha,sse4.1")
+static inline __m128i extend_shani(__m128i &m0, __m128i &m1, __m128i &m2, __m128i &m3)
+{
+    __m128i next = _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(m0, m1), m2), m3);
+    m0 = m1;
+    m1 = m2;
+    m2 = m3;
+    m3 = next;
+    return next;
+}
+
+// Process blocks with the SHA extensions
+CRYPTLIB_TARGET("sha,sse4.1")
+static void process_shani(uint32_t *state, const uint8_t *blocks, size_t count)
+{
+    // Byte swap mask for big-endian message words, also reversing the word order
+    const __m128i swap = _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+
+    // sha1rnds4 keeps a in the highest lane and e in a separate register
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1B);
+    __m128i e0 = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+
+    for (; count; --count, blocks += 64U)
     {
-        static_cast<uint8_t>(len >> 56),
-        static_cast<uint8_t>(len >> 48),
-        static_cast<uint8_t>(len >> 40),
-        static_cast<uint8_t>(len >> 32),
-        static_cast<uint8_t>(len >> 24),
-        static_cast<uint8_t>(len >> 16),
-        static_cast<uint8_t>(len >> 8),
-        static_cast<uint8_t>(len),
-    };
-    add(bitlen, 8U);
-
-    // Return the digest
-    return {
-        static_cast<uint8_t>(state[0] >> 24),
-        static_cast<uint8_t>(state[0] >> 16),
-        static_cast<uint8_t>(state[0] >> 8),
-        static_cast<uint8_t>(state[0]),
-        static_cast<uint8_t>(state[1] >> 24),
-        static_cast<uint8_t>(state[1] >> 16),
-        static_cast<uint8_t>(state[1] >> 8),
-        static_cast<uint8_t>(state[1]),
-        static_cast<uint8_t>(state[2] >> 24),
-        static_cast<uint8_t>(state[2] >> 16),
-        static_cast<uint8_t>(state[2] >> 8),
-        static_cast<uint8_t>(state[2]),
-        static_cast<uint8_t>(state[3] >> 24),
-        static_cast<uint8_t>(state[3] >> 16),
-        static_cast<uint8_t>(state[3] >> 8),
-        static_cast<uint8_t>(state[3]),
-        static_cast<uint8_t>(state[4] >> 24),
-        static_cast<uint8_t>(state[4] >> 16),
-        static_cast<uint8_t>(state[4] >> 8),
-        static_cast<uint8_t>(state[4]),
-    };
+        // Save state
+        __m128i abcd_save = abcd;
+        __m128i e0_save = e0;
+
+        // Populate message
+        const __m128i *msg = reinterpret_cast<const __m128i*>(blocks);
+        __m128i m0 = _mm_shuffle_epi8(_mm_loadu_si128(msg), swap);
+        __m128i m1 = _mm_shuffle_epi8(_mm_loadu_si128(msg + 1), swap);
+        __m128i m2 = _mm_shuffle_epi8(_mm_loadu_si128(msg + 2), swap);
+        __m128i m3 = _mm_shuffle_epi8(_mm_loadu_si128(msg + 3), swap);
+
+        // Rounds 0-3 take e directly
+        __m128i prev = abcd;
+        abcd = _mm_sha1rnds4_epu32(abcd, _mm_add_epi32(e0, m0), 0);
+
+        // Rounds 4-19
+        rounds4_shani<0>(abcd, prev, m1);
+        rounds4_shani<0>(abcd, prev, m2);
+        rounds4_shani<0>(abcd, prev, m3);
+        rounds4_shani<0>(abcd, prev, extend_shani(m0, m1, m2, m3));
+
+        // Rounds 20-39
+        rounds4_shani<1>(abcd, prev, extend_shani(m0, m1, m2, m3));
+        rounds4_shani<1>(abcd, prev, extend_shani(m0, m1, m2, m3));
+        rounds4_shani<1>(abcd, prev, extend_shani(m0, m1, m2, m3));
+        rounds4_shani<1>(abcd, prev, extend_shani(m0, m1, m2, m3));
+        rounds4_shani<1>(abcd, prev, extend_shani(m0, m1, m2, m3));
+
+        // Rounds 40-59
+        rounds4_shani<2>(abcd, prev, extend_shani(m0, m1, m2, m3));
+        rounds4_shani<2>(abcd, prev, extend_shani(m0, m1, m2, m3));
+        rounds4_shani<2>(abcd, prev, extend_shani(m0, m1, m2, m3));
+        rounds4_shani<2>(abcd, prev, extend_shani(m0, m1, m2, m3));
+        rounds4_shani<2>(abcd, prev, extend_shani(m0, m1, m2, m3));
+
+        // Rounds 60-79
+        rounds4_shani<3>(abcd, prev, extend_shani(m0, m1, m2, m3));
+        rounds4_shani<3>(abcd, prev, extend_shani(m0, m1, m2, m3));
+        rounds4_shani<3>(abcd, prev, extend_shani(m0, m1, m2, m3));
+        rounds4_shani<3>(abcd, prev, extend_shani(m0, m1, m2, m3));
+        rounds4_shani<3>(abcd, prev, extend_shani(m0, m1, m2, m3));
+
+        // Update the state vector; e is the a of the last four rounds, rotated
+        e0 = _mm_sha1nexte_epu32(prev, e0_save);
+        abcd = _mm_add_epi32(abcd, abcd_save);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_shuffle_epi32(abcd, 0x1B));
+    state[4] = static_cast<uint32_t>(_mm_extract_epi32(e0, 3));
+}
+#endif
+
+/// Block processing backend.
+struct Sha1Backend
+{
+    /// Backend name.
+    const char *name;
+
+    /// Block processing function.
+    void (*process)(uint32_t *state, const uint8_t *blocks, size_t count);
+};
+
+// Select the fastest backend supported by the processor
+static const Sha1Backend &select_backend()
+{
+    static const Sha1Backend backend =
+#if defined(CRYPTLIB_X86)
+        (CpuFeatures::sha() && CpuFeatures::sse41()) ? Sha1Backend{ "sha-ni", process_shani } :
+        CpuFeatures::avx2() ? Sha1Backend{ "avx2", process_avx2 } :
+        CpuFeatures::ssse3() ? Sha1Backend{ "ssse3", process_ssse3 } :
+#endif
+        Sha1Backend{ "scalar", process_scalar };
+    return backend;
+}
+
+void sha1_process(uint32_t *state, const uint8_t *blocks, size_t count)
+{
+    select_backend().process(state, blocks, count);
+}
+
+const char *Sha1Hash::backend()
+{
+    return select_backend().name;
+}
+
+Sha1Hash::Sha1Hash() : engine()
+{
+}
+
+void Sha1Hash::clear()
+{
+    engine.clear();
+}
+
+void Sha1Hash::add(const void *data, size_t size)
+{
+    engine.add(data, size);
+}
+
+void Sha1Hash::add(const HashData *segments, size_t count)
+{
+    engine.add(segments, count);
+}
+
+size_t Sha1Hash::size() const
+{
+    return Digest::size();
+}
+
+void Sha1Hash::close(uint8_t *digest)
+{
+    engine.close(digest);
+}
+
+void Sha1Hash::close(Digest &digest)
+{
+    engine.close(digest.data());
+}
+
+void Sha1Hash::save(State &state) const
+{
+    state = engine;
+}
+
+void Sha1Hash::restore(const State &state)
+{
+    engine = state;
+}
+
+void Sha1Hash::hash(const void *data, size_t size, uint8_t *digest)
+{
+    Sha1Engine::hash(data, size, digest);
 }
@@ -1,24 +1,20 @@
 #pragma once
 
-#include "hash.hpp"
+#include "sha1_engine.hpp"
 
 /// SHA1 Hash class.
 class Sha1Hash : public Hash
 {
-    /// SHA1 state vector.
-    uint32_t state[5];
-
-    /// SHA1 accumulation buffer.
-    uint8_t buffer[64];
-
-    /// SHA1 accumulation boffer length.
-    size_t buflen;
+public:
+    /// SHA1 digest type.
+    typedef Sha1Engine::Digest Digest;
 
-    /// SHA1 total bit count
-    uint64_t totlen;
+    /// SHA1 midstate snapshot type.
+    typedef Sha1Engine State;
 
-    /// Process a full block
-    void process();
+private:
+    /// SHA1 engine.
+    Sha1Engine engine;
 
 public:
     /// Constructor.
@@ -38,7 +34,42 @@ public:
     /// @param size                     Size of the data to add
     virtual void add(const void *data, size_t size);
 
-    /// Close the hash and calculate the digest.
-    /// @return                         Message digest
-    virtual std::vector<uint8_t> close();
+    /// Add a list of data segments to the hash.
+    /// @param segments                 Data segments
+    /// @param count                    Number of segments
+    virtual void add(const HashData *segments, size_t count);
+
+    /// Get the digest size.
+    /// @return                         Digest size in bytes (20)
+    virtual size_t size() const;
+
+    /// Close the hash and write the digest without allocating.
+    /// @param digest                   Output buffer of 20 bytes
+    virtual void close(uint8_t *digest);
+
+    /// Close the hash and write the digest without allocating.
+    /// @param digest                   Output digest
+    void close(Digest &digest);
+
+    using Hash::close;
+
+    /// Save a snapshot of the hash midstate.
+    /// @param state                    Snapshot to write
+    void save(State &state) const;
+
+    /// Restore the hash midstate from a snapshot.
+    /// @param state                    Snapshot previously written by save()
+    void restore(const State &state);
+
+    /// Hash a short or whole message in one call, without the streaming
+    /// state. Up to 55 bytes take a single padded block and up to 119 bytes
+    /// two, which keeps per-call latency low for tiny inputs.
+    /// @param data                     Pointer to the message
+    /// @param size                     Size of the message
+    /// @param digest                   Output buffer of 20 bytes
+    static void hash(const void *data, size_t size, uint8_t *digest);
+
+    /// Get the name of the block processing backend selected for this processor.
+    /// @return                         Backend name ("sha-ni", "avx2", "ssse3" or "scalar")
+    static const char *backend();
 };
@@ -0,0 +1,48 @@
+#include "sha256.h"
+#include "sha256_batch.hpp"
+#include "sha256_engine.hpp"
+#include <new>
+
+static_assert(sizeof(Sha256Engine) <= sizeof(SHA256Context), "SHA256Context is too small for the engine");
+static_assert(alignof(Sha256Engine) <= alignof(SHA256Context), "SHA256Context is underaligned for the engine");
+
+// Get the engine held in a context
+static Sha256Engine &engine_of(SHA256Context *context)
+{
+    return *reinterpret_cast<Sha256Engine*>(context);
+}
+
+size_t SHA256ContextSize(void)
+{
+    return sizeof(SHA256Context);
+}
+
+size_t SHA256ContextAlign(void)
+{
+    return alignof(SHA256Context);
+}
+
+void SHA256Init(SHA256Context *context)
+{
+    new (context) Sha256Engine();
+}
+
+void SHA256Add(SHA256Context *context, const void *data, size_t size)
+{
+    engine_of(context).add(data, size);
+}
+
+void SHA256Close(SHA256Context *context, uint8_t *digest)
+{
+    engine_of(context).close(digest);
+}
+
+void SHA256Hash(const void *data, size_t size, uint8_t *digest)
+{
+    Sha256Engine::hash(data, size, digest);
+}
+
+void SHA256HashBatch(const HashData *messages, size_t count, uint8_t *digests)
+{
+    Sha256Batch::hash(messages, count, digests);
+}
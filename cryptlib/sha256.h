@@ -0,0 +1,62 @@
+#pragma once
+
+#include "hash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// SHA256 context size in bytes.
+#define SHA256_CONTEXT_SIZE 128
+
+/// SHA256 digest size in bytes.
+#define SHA256_DIGEST_SIZE 32
+
+/// SHA256 context, allocated by the caller (on the stack or embedded in
+/// another structure). The contents are private to the library.
+typedef struct SHA256Context
+{
+    /// Opaque engine storage
+    uint64_t opaque[SHA256_CONTEXT_SIZE / 8];
+} SHA256Context;
+
+/// Get the size of SHA256Context, for callers that cannot read this header.
+/// @return                             Context size in bytes
+size_t SHA256ContextSize(void);
+
+/// Get the alignment of SHA256Context, for callers that cannot read this header.
+/// @return                             Context alignment in bytes
+size_t SHA256ContextAlign(void);
+
+/// Initialize a context to hash a new message.
+/// @param context                      Context to initialize
+void SHA256Init(SHA256Context *context);
+
+/// Add data to the hash.
+/// @param context                      Initialized context
+/// @param data                         Pointer to the data to add
+/// @param size                         Size of the data to add
+void SHA256Add(SHA256Context *context, const void *data, size_t size);
+
+/// Close the hash and write the digest. The context must be initialized
+/// again before reuse.
+/// @param context                      Initialized context
+/// @param digest                       Output buffer of 32 bytes
+void SHA256Close(SHA256Context *context, uint8_t *digest);
+
+/// Calculate the digest of a message in one call.
+/// @param data                         Pointer to the message
+/// @param size                         Size of the message
+/// @param digest                       Output buffer of 32 bytes
+void SHA256Hash(const void *data, size_t size, uint8_t *digest);
+
+/// Calculate the digests of a batch of independent messages in one call,
+/// using the multi-buffer backend where available.
+/// @param messages                     Array of messages to hash
+/// @param count                        Number of messages
+/// @param digests                      Output array of count 32-byte digests
+void SHA256HashBatch(const HashData *messages, size_t count, uint8_t *digests);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,124 @@
+#include "sha256_batch.hpp"
+#include "sha256_hash.hpp"
+#include "sha256_lanes.hpp"
+
+#if defined(CRYPTLIB_X86)
+// Process one block on each of eight lanes with AVX2
+CRYPTLIB_TARGET("avx2")
+static void compress_avx2(uint32_t (*state)[8], const uint8_t *const *blocks, uint32_t active)
+{
+    // Populate message
+    __m256i w[16];
+    sha256_load_avx2(blocks, 0U, w);
+    sha256_load_avx2(blocks, 32U, w + 8);
+
+    // Populate state
+    __m256i s[8];
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        s[j] = _mm256_load_si256(reinterpret_cast<const __m256i*>(state[j]));
+    }
+
+    __m256i x[8];
+    sha256_compress_avx2(s, w, x);
+
+    // Update the state vector of the active lanes
+    const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    __m256i mask = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int>(active)), bits), bits);
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(state[j]), _mm256_blendv_epi8(s[j], x[j], mask));
+    }
+}
+
+// Process one block on each of sixteen lanes with AVX-512
+CRYPTLIB_TARGET("avx512f")
+static void compress_avx512(uint32_t (*state)[16], const uint8_t *const *blocks, uint32_t active)
+{
+    // Populate message
+    __m512i w[16];
+    sha256_load_avx512(blocks, 0U, w);
+    sha256_load_avx512(blocks, 32U, w + 8);
+
+    // Populate state
+    __m512i s[8];
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        s[j] = _mm512_load_si512(state[j]);
+    }
+
+    __m512i x[8];
+    sha256_compress_avx512(s, w, x);
+
+    // Update the state vector of the active lanes
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        _mm512_store_si512(state[j], _mm512_mask_mov_epi32(s[j], static_cast<__mmask16>(active), x[j]));
+    }
+}
+#endif
+
+// Hash messages one at a time with the single-stream backend
+static void hash_serial(const HashData *messages, size_t count, uint8_t *digests)
+{
+    Sha256Hash hash;
+    for (size_t i = 0U; i < count; ++i)
+    {
+        hash.clear();
+        hash.add(messages[i].data, messages[i].size);
+        hash.close(digests + i * 32U);
+    }
+}
+
+/// Multi-buffer backend.
+struct Sha256BatchBackend
+{
+    /// Backend name.
+    const char *name;
+
+    /// Number of lanes.
+    size_t lanes;
+
+    /// Batch hashing function.
+    void (*hash)(const HashData *messages, size_t count, uint8_t *digests);
+};
+
+#if defined(CRYPTLIB_X86)
+static void hash_avx2(const HashData *messages, size_t count, uint8_t *digests)
+{
+    hash_lanes<Sha256Engine, 8>(messages, count, digests, compress_avx2);
+}
+
+static void hash_avx512(const HashData *messages, size_t count, uint8_t *digests)
+{
+    hash_lanes<Sha256Engine, 16>(messages, count, digests, compress_avx512);
+}
+#endif
+
+// Select the fastest backend supported by the processor. A single SHA-NI
+// stream outruns eight AVX2 lanes, so AVX2 is only used without SHA-NI.
+static const Sha256BatchBackend &select_backend()
+{
+    static const Sha256BatchBackend backend =
+#if defined(CRYPTLIB_X86)
+        CpuFeatures::avx512f() ? Sha256BatchBackend{ "avx512", 16U, hash_avx512 } :
+        (CpuFeatures::avx2() && !CpuFeatures::sha()) ? Sha256BatchBackend{ "avx2", 8U, hash_avx2 } :
+#endif
+        Sha256BatchBackend{ "serial", 1U, hash_serial };
+    return backend;
+}
+
+void Sha256Batch::hash(const HashData *messages, size_t count, uint8_t *digests)
+{
+    select_backend().hash(messages, count, digests);
+}
+
+const char *Sha256Batch::backend()
+{
+    return select_backend().name;
+}
+
+size_t Sha256Batch::lanes()
+{
+    return select_backend().lanes;
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "hash_engine.hpp"
+
+/// Process SHA256 blocks with the backend selected for this processor.
+/// @param state                        SHA256 state vector
+/// @param blocks                       Pointer to the blocks to process
+/// @param count                        Number of 64-byte blocks
+void sha256_process(uint32_t *state, const uint8_t *blocks, size_t count);
+
+/// SHA256 hash engine.
+/// @tparam Portable                    Use only the portable compression function,
+///                                     making the engine usable in constant expressions
+template <bool Portable>
+class BasicSha256Engine : public HashEngine<BasicSha256Engine<Portable>, uint32_t, 8U, 64U, 32U, true>
+{
+    /// Base engine type.
+    typedef HashEngine<BasicSha256Engine<Portable>, uint32_t, 8U, 64U, 32U, true> Base;
+
+public:
+    /// Instrumentation counters used by the engine.
+    static const HashStats::Algorithm algorithm = Portable ? HashStats::untracked : HashStats::sha256;
+
+    /// Round constants.
+    static constexpr uint32_t k[64] =
+    {
+        0x428a2f98U, 0x71374491U, 0xb5c0fbcfU, 0xe9b5dba5U, 0x3956c25bU, 0x59f111f1U, 0x923f82a4U, 0xab1c5ed5U,
+        0xd807aa98U, 0x12835b01U, 0x243185beU, 0x550c7dc3U, 0x72be5d74U, 0x80deb1feU, 0x9bdc06a7U, 0xc19bf174U,
+        0xe49b69c1U, 0xefbe4786U, 0x0fc19dc6U, 0x240ca1ccU, 0x2de92c6fU, 0x4a7484aaU, 0x5cb0a9dcU, 0x76f988daU,
+        0x983e5152U, 0xa831c66dU, 0xb00327c8U, 0xbf597fc7U, 0xc6e00bf3U, 0xd5a79147U, 0x06ca6351U, 0x14292967U,
+        0x27b70a85U, 0x2e1b2138U, 0x4d2c6dfcU, 0x53380d13U, 0x650a7354U, 0x766a0abbU, 0x81c2c92eU, 0x92722c85U,
+        0xa2bfe8a1U, 0xa81a664bU, 0xc24b8b70U, 0xc76c51a3U, 0xd192e819U, 0xd6990624U, 0xf40e3585U, 0x106aa070U,
+        0x19a4c116U, 0x1e376c08U, 0x2748774cU, 0x34b0bcb5U, 0x391c0cb3U, 0x4ed8aa4aU, 0x5b9cca4fU, 0x682e6ff3U,
+        0x748f82eeU, 0x78a5636fU, 0x84c87814U, 0x8cc70208U, 0x90befffaU, 0xa4506cebU, 0xbef9a3f7U, 0xc67178f2
+    };
+
+    /// Initial state vector.
+    static constexpr uint32_t iv[8] =
+    {
+        0x6a09e667U, 0xbb67ae85U, 0x3c6ef372U, 0xa54ff53aU, 0x510e527fU, 0x9b05688cU, 0x1f83d9abU, 0x5be0cd19U
+    };
+
+    /// Constructor.
+    constexpr BasicSha256Engine()
+    {
+        clear();
+    }
+
+    /// Clear the hash to an initial state.
+    constexpr void clear()
+    {
+        // Seed the state vector
+        for (size_t i = 0U; i < 8U; ++i)
+        {
+            this->state[i] = iv[i];
+        }
+
+        // Clear buffer and total lengths
+        this->buflen = 0U;
+        this->totlen = 0U;
+    }
+
+    /// Process full blocks.
+    /// @param blocks                   Pointer to the blocks to process
+    /// @param count                    Number of 64-byte blocks
+    constexpr void process(const uint8_t *blocks, size_t count)
+    {
+        if (Portable)
+        {
+            for (; count; --count, blocks += 64U)
+            {
+                compress(this->state, blocks);
+            }
+        }
+        else
+        {
+            sha256_process(this->state, blocks, count);
+        }
+    }
+
+    /// Process a single block with the portable compression function.
+    /// @param state                    SHA256 state vector
+    /// @param block                    Pointer to the 64-byte block
+    static constexpr void compress(uint32_t *state, const uint8_t *block)
+    {
+        // Populate state
+        uint32_t a = state[0];
+        uint32_t b = state[1];
+        uint32_t c = state[2];
+        uint32_t d = state[3];
+        uint32_t e = state[4];
+        uint32_t f = state[5];
+        uint32_t g = state[6];
+        uint32_t h = state[7];
+
+        // Populate message
+        uint32_t w[64] = {};
+        for (size_t i = 0U; i < 16U; ++i)
+        {
+            w[i] = (static_cast<uint32_t>(block[i * 4    ]) << 24) |
+                   (static_cast<uint32_t>(block[i * 4 + 1]) << 16) |
+                   (static_cast<uint32_t>(block[i * 4 + 2]) <<  8) |
+                   (static_cast<uint32_t>(block[i * 4 + 3])      );
+        }
+
+        // Extend message words
+        for (size_t i = 16U; i < 64U; ++i)
+        {
+            uint32_t s0 = Base::rtr(w[i - 15], 7) ^ Base::rtr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = Base::rtr(w[i - 2], 17) ^ Base::rtr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        // Process loop
+        for (size_t i = 0U; i < 64U; ++i)
+        {
+            uint32_t s1 = Base::rtr(e, 6) ^ Base::rtr(e, 11) ^ Base::rtr(e, 25);
+            uint32_t ch = (e & f) ^ (~e & g);
+            uint32_t tmp1 = h + s1 + ch + k[i] + w[i];
+            uint32_t s0 = Base::rtr(a, 2) ^ Base::rtr(a, 13) ^ Base::rtr(a, 22);
+            uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t tmp2 = s0 + maj;
+
+            h = g;
+            g = f;
+            f = e;
+            e = d + tmp1;
+            d = c;
+            c = b;
+            b = a;
+            a = tmp1 + tmp2;
+        }
+
+        // Update the state vector
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+};
+
+template <bool Portable>
+constexpr uint32_t BasicSha256Engine<Portable>::k[64];
+
+template <bool Portable>
+constexpr uint32_t BasicSha256Engine<Portable>::iv[8];
+
+/// SHA256 hash engine using the fastest backend for the processor.
+typedef BasicSha256Engine<false> Sha256Engine;
+
+/// SHA256 hash engine usable in constant expressions.
+typedef BasicSha256Engine<true> Sha256ConstEngine;
+
+/// Calculate the SHA256 digest of a string, usable in constant expressions.
+/// @param str                          String literal (the terminator is not hashed)
+/// @return                             Message digest
+template <size_t N>
+constexpr Sha256Engine::Digest sha256(const char (&str)[N])
+{
+    Sha256ConstEngine engine;
+    engine.add(str, N - 1U);
+    return engine.close();
+}
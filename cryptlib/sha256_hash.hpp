@@ -1,24 +1,20 @@
 #pragma once
 
-#include "hash.hpp"
+#include "sha256_engine.hpp"
 
 /// SHA256 Hash class.
 class Sha256Hash : public Hash
 {
-    /// SHA256 state vector.
-    uint32_t state[8];
-
-    /// SHA256 accumulation buffer.
-    uint8_t buffer[64];
-
-    /// SHA256 accumulation boffer length.
-    size_t buflen;
+public:
+    /// SHA256 digest type.
+    typedef Sha256Engine::Digest Digest;
 
-    /// SHA256 total bit count
-    uint64_t totlen;
+    /// SHA256 midstate snapshot type.
+    typedef Sha256Engine State;
 
-    /// Process a full block
-    void process();
+private:
+    /// SHA256 engine.
+    Sha256Engine engine;
 
 public:
     /// Constructor.
@@ -38,7 +34,44 @@ public:
     /// @param size                     Size of the data to add
     virtual void add(const void *data, size_t size);
 
-    /// Close the hash and calculate the digest.
-    /// @return                         Message digest
-    virtual std::vector<uint8_t> close();
+    /// Add a list of data segments to the hash.
+    /// @param segments                 Data segments
+    /// @param count                    Number of segments
+    virtual void add(const HashData *segments, size_t count);
+
+    /// Get the digest size.
+    /// @return                         Digest size in bytes (32)
+    virtual size_t size() const;
+
+    /// Close the hash and write the digest without allocating.
+    /// @param digest                   Output buffer of 32 bytes
+    virtual void close(uint8_t *digest);
+
+    /// Close the hash and write the digest without allocating.
+    /// @param digest                   Output digest
+    void close(Digest &digest);
+
+    using Hash::close;
+
+    /// Save a snapshot of the hash midstate.
+    /// Absorbing a shared prefix once and restoring the snapshot before each
+    /// message avoids re-processing the prefix.
+    /// @param state                    Snapshot to write
+    void save(State &state) const;
+
+    /// Restore the hash midstate from a snapshot.
+    /// @param state                    Snapshot previously written by save()
+    void restore(const State &state);
+
+    /// Hash a short or whole message in one call, without the streaming
+    /// state. Up to 55 bytes take a single padded block and up to 119 bytes
+    /// two, which keeps per-call latency low for tiny inputs.
+    /// @param data                     Pointer to the message
+    /// @param size                     Size of the message
+    /// @param digest                   Output buffer of 32 bytes
+    static void hash(const void *data, size_t size, uint8_t *digest);
+
+    /// Get the name of the block processing backend selected for this processor.
+    /// @return                         Backend name ("sha-ni" or "scalar")
+    static const char *backend();
 };
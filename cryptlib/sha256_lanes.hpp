@@ -0,0 +1,276 @@
+#pragma once
+
+#include "sha256_engine.hpp"
+#include "hash_lanes.hpp"
+
+// SHA256 compression on transposed SIMD lanes whose messages are already
+// in registers, shared by the multi-lane kernels that build fixed-format
+// blocks without going through memory. Lane i of vector j holds word j of
+// lane i's state or message.
+
+#if defined(CRYPTLIB_X86)
+template <int C>
+CRYPTLIB_TARGET("avx2")
+CRYPTLIB_INLINE __m256i sha256_rtr_avx2(__m256i x)
+{
+    return _mm256_or_si256(_mm256_srli_epi32(x, C), _mm256_slli_epi32(x, 32 - C));
+}
+
+// Run one round on eight lanes. v holds the working variables a to h and
+// wk the message word plus the round constant.
+CRYPTLIB_TARGET("avx2")
+CRYPTLIB_INLINE void sha256_round_avx2(__m256i *v, __m256i wk)
+{
+    __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(sha256_rtr_avx2<6>(v[4]), sha256_rtr_avx2<11>(v[4])), sha256_rtr_avx2<25>(v[4]));
+    __m256i ch = _mm256_xor_si256(_mm256_and_si256(v[4], v[5]), _mm256_andnot_si256(v[4], v[6]));
+    __m256i tmp1 = _mm256_add_epi32(_mm256_add_epi32(v[7], s1), _mm256_add_epi32(ch, wk));
+    __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(sha256_rtr_avx2<2>(v[0]), sha256_rtr_avx2<13>(v[0])), sha256_rtr_avx2<22>(v[0]));
+    __m256i maj = _mm256_or_si256(_mm256_and_si256(v[0], _mm256_or_si256(v[1], v[2])), _mm256_and_si256(v[1], v[2]));
+    __m256i tmp2 = _mm256_add_epi32(s0, maj);
+
+    v[7] = v[6];
+    v[6] = v[5];
+    v[5] = v[4];
+    v[4] = _mm256_add_epi32(v[3], tmp1);
+    v[3] = v[2];
+    v[2] = v[1];
+    v[1] = v[0];
+    v[0] = _mm256_add_epi32(tmp1, tmp2);
+}
+
+// Compress one block on each of eight lanes from the states s, expanding
+// the message words w in place, and write the new states to out
+CRYPTLIB_TARGET("avx2")
+CRYPTLIB_INLINE void sha256_compress_avx2(const __m256i *s, __m256i *w, __m256i *out)
+{
+    __m256i v[8];
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        v[j] = s[j];
+    }
+
+    // Process loop, extending the message words as they are needed
+    for (size_t i = 0U; i < 64U; ++i)
+    {
+        if (i >= 16U)
+        {
+            __m256i w15 = w[(i - 15U) & 15U];
+            __m256i w2 = w[(i - 2U) & 15U];
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(sha256_rtr_avx2<7>(w15), sha256_rtr_avx2<18>(w15)), _mm256_srli_epi32(w15, 3));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(sha256_rtr_avx2<17>(w2), sha256_rtr_avx2<19>(w2)), _mm256_srli_epi32(w2, 10));
+            w[i & 15U] = _mm256_add_epi32(_mm256_add_epi32(w[i & 15U], s0), _mm256_add_epi32(w[(i - 7U) & 15U], s1));
+        }
+
+        sha256_round_avx2(v, _mm256_add_epi32(w[i & 15U], _mm256_set1_epi32(static_cast<int>(Sha256Engine::k[i]))));
+    }
+
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        out[j] = _mm256_add_epi32(s[j], v[j]);
+    }
+}
+
+// Compress a block that is the same on every lane from its precomputed
+// schedule wk (message words plus round constants), so no message words
+// are expanded
+CRYPTLIB_TARGET("avx2")
+CRYPTLIB_INLINE void sha256_compress_wk_avx2(const __m256i *s, const uint32_t *wk, __m256i *out)
+{
+    __m256i v[8];
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        v[j] = s[j];
+    }
+
+    for (size_t i = 0U; i < 64U; ++i)
+    {
+        sha256_round_avx2(v, _mm256_set1_epi32(static_cast<int>(wk[i])));
+    }
+
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        out[j] = _mm256_add_epi32(s[j], v[j]);
+    }
+}
+
+// Compress the final block of a message of size bytes on each of eight
+// lanes, whose last 32 bytes are the message words m. The rest of the
+// block is the padding and length, which are the same on every lane.
+CRYPTLIB_TARGET("avx2")
+CRYPTLIB_INLINE void sha256_compress_short_avx2(const __m256i *s, const __m256i *m, uint64_t size, __m256i *out)
+{
+    __m256i w[16];
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        w[i] = m[i];
+        w[i + 8U] = _mm256_setzero_si256();
+    }
+
+    w[8] = _mm256_set1_epi32(static_cast<int>(0x80000000U));
+    w[14] = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(size >> 29)));
+    w[15] = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(size << 3)));
+    sha256_compress_avx2(s, w, out);
+}
+
+// Load 32 bytes from each of eight lanes as eight big-endian word vectors
+CRYPTLIB_TARGET("avx2")
+CRYPTLIB_INLINE void sha256_load_avx2(const uint8_t *const *blocks, size_t offset, __m256i *w)
+{
+    const __m256i swap = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+    transpose_avx2(blocks, offset, w);
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        w[i] = _mm256_shuffle_epi8(w[i], swap);
+    }
+}
+
+// Store the states of eight lanes as big-endian digests, 32 bytes apart
+CRYPTLIB_TARGET("avx2")
+CRYPTLIB_INLINE void sha256_store_avx2(const __m256i *s, uint8_t *digests)
+{
+    const __m256i swap = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+    // Transpose back through memory, one row per state word
+    alignas(32) uint32_t words[8][8];
+    const uint8_t *rows[8];
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(words[j]), s[j]);
+        rows[j] = reinterpret_cast<const uint8_t*>(words[j]);
+    }
+
+    __m256i d[8];
+    transpose_avx2(rows, 0U, d);
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(digests + i * 32U), _mm256_shuffle_epi8(d[i], swap));
+    }
+}
+
+// Run one round on sixteen lanes, as sha256_round_avx2()
+CRYPTLIB_TARGET("avx512f")
+CRYPTLIB_INLINE void sha256_round_avx512(__m512i *v, __m512i wk)
+{
+    __m512i s1 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(v[4], 6), _mm512_ror_epi32(v[4], 11), _mm512_ror_epi32(v[4], 25), 0x96);
+    __m512i ch = _mm512_ternarylogic_epi32(v[4], v[5], v[6], 0xCA);
+    __m512i tmp1 = _mm512_add_epi32(_mm512_add_epi32(v[7], s1), _mm512_add_epi32(ch, wk));
+    __m512i s0 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(v[0], 2), _mm512_ror_epi32(v[0], 13), _mm512_ror_epi32(v[0], 22), 0x96);
+    __m512i maj = _mm512_ternarylogic_epi32(v[0], v[1], v[2], 0xE8);
+    __m512i tmp2 = _mm512_add_epi32(s0, maj);
+
+    v[7] = v[6];
+    v[6] = v[5];
+    v[5] = v[4];
+    v[4] = _mm512_add_epi32(v[3], tmp1);
+    v[3] = v[2];
+    v[2] = v[1];
+    v[1] = v[0];
+    v[0] = _mm512_add_epi32(tmp1, tmp2);
+}
+
+// Compress one block on each of sixteen lanes, as sha256_compress_avx2()
+CRYPTLIB_TARGET("avx512f")
+CRYPTLIB_INLINE void sha256_compress_avx512(const __m512i *s, __m512i *w, __m512i *out)
+{
+    __m512i v[8];
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        v[j] = s[j];
+    }
+
+    // Process loop, extending the message words as they are needed
+    for (size_t i = 0U; i < 64U; ++i)
+    {
+        if (i >= 16U)
+        {
+            __m512i w15 = w[(i - 15U) & 15U];
+            __m512i w2 = w[(i - 2U) & 15U];
+            __m512i s0 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(w15, 7), _mm512_ror_epi32(w15, 18), _mm512_srli_epi32(w15, 3), 0x96);
+            __m512i s1 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(w2, 17), _mm512_ror_epi32(w2, 19), _mm512_srli_epi32(w2, 10), 0x96);
+            w[i & 15U] = _mm512_add_epi32(_mm512_add_epi32(w[i & 15U], s0), _mm512_add_epi32(w[(i - 7U) & 15U], s1));
+        }
+
+        sha256_round_avx512(v, _mm512_add_epi32(w[i & 15U], _mm512_set1_epi32(static_cast<int>(Sha256Engine::k[i]))));
+    }
+
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        out[j] = _mm512_add_epi32(s[j], v[j]);
+    }
+}
+
+// Compress a block that is the same on every lane from its precomputed
+// schedule, as sha256_compress_wk_avx2()
+CRYPTLIB_TARGET("avx512f")
+CRYPTLIB_INLINE void sha256_compress_wk_avx512(const __m512i *s, const uint32_t *wk, __m512i *out)
+{
+    __m512i v[8];
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        v[j] = s[j];
+    }
+
+    for (size_t i = 0U; i < 64U; ++i)
+    {
+        sha256_round_avx512(v, _mm512_set1_epi32(static_cast<int>(wk[i])));
+    }
+
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        out[j] = _mm512_add_epi32(s[j], v[j]);
+    }
+}
+// Compress the final block of a message of size bytes on each of sixteen
+// lanes, as sha256_compress_short_avx2()
+CRYPTLIB_TARGET("avx512f")
+CRYPTLIB_INLINE void sha256_compress_short_avx512(const __m512i *s, const __m512i *m, uint64_t size, __m512i *out)
+{
+    __m512i w[16];
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        w[i] = m[i];
+        w[i + 8U] = _mm512_setzero_si512();
+    }
+
+    w[8] = _mm512_set1_epi32(static_cast<int>(0x80000000U));
+    w[14] = _mm512_set1_epi32(static_cast<int>(static_cast<uint32_t>(size >> 29)));
+    w[15] = _mm512_set1_epi32(static_cast<int>(static_cast<uint32_t>(size << 3)));
+    sha256_compress_avx512(s, w, out);
+}
+
+// Load 32 bytes from each of sixteen lanes as eight big-endian word
+// vectors, transposing each half of the lanes with AVX2
+CRYPTLIB_TARGET("avx512f")
+CRYPTLIB_INLINE void sha256_load_avx512(const uint8_t *const *blocks, size_t offset, __m512i *w)
+{
+    __m256i lo[8];
+    __m256i hi[8];
+    sha256_load_avx2(blocks, offset, lo);
+    sha256_load_avx2(blocks + 8, offset, hi);
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        w[i] = _mm512_inserti64x4(_mm512_castsi256_si512(lo[i]), hi[i], 1);
+    }
+}
+
+// Store the states of sixteen lanes as big-endian digests, 32 bytes apart
+CRYPTLIB_TARGET("avx512f")
+CRYPTLIB_INLINE void sha256_store_avx512(const __m512i *s, uint8_t *digests)
+{
+    __m256i lo[8];
+    __m256i hi[8];
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        lo[j] = _mm512_castsi512_si256(s[j]);
+        hi[j] = _mm512_extracti64x4_epi64(s[j], 1);
+    }
+
+    sha256_store_avx2(lo, digests);
+    sha256_store_avx2(hi, digests + 256U);
+}
+#endif
@@ -0,0 +1,436 @@
+#include "sha256_nodes.hpp"
+#include "sha256_lanes.hpp"
+
+/// Message schedule of a constant block, with the round constants added.
+struct Sha256Schedule
+{
+    /// Message words plus round constants for each round.
+    uint32_t wk[64];
+};
+
+// Rotate right, usable in constant expressions
+static constexpr uint32_t ror32(uint32_t x, unsigned n)
+{
+    return (x >> n) | (x << (32U - n));
+}
+
+// Expand the padding block that follows a message of size bytes, a
+// multiple of the block size
+static constexpr Sha256Schedule padding_schedule(uint64_t size)
+{
+    uint32_t w[64] = {};
+    w[0] = 0x80000000U;
+    w[14] = static_cast<uint32_t>(size >> 29);
+    w[15] = static_cast<uint32_t>(size << 3);
+    for (size_t i = 16U; i < 64U; ++i)
+    {
+        uint32_t s0 = ror32(w[i - 15], 7) ^ ror32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ror32(w[i - 2], 17) ^ ror32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    Sha256Schedule schedule = {};
+    for (size_t i = 0U; i < 64U; ++i)
+    {
+        schedule.wk[i] = w[i] + Sha256Engine::k[i];
+    }
+
+    return schedule;
+}
+
+// Schedule of the second block of a 64-byte message
+static constexpr Sha256Schedule pad64 = padding_schedule(64U);
+
+// Compress a constant block from its schedule with the portable implementation
+static void compress_wk(uint32_t *state, const uint32_t *wk)
+{
+    uint32_t a = state[0];
+    uint32_t b = state[1];
+    uint32_t c = state[2];
+    uint32_t d = state[3];
+    uint32_t e = state[4];
+    uint32_t f = state[5];
+    uint32_t g = state[6];
+    uint32_t h = state[7];
+
+    for (size_t i = 0U; i < 64U; ++i)
+    {
+        uint32_t s1 = ror32(e, 6) ^ ror32(e, 11) ^ ror32(e, 25);
+        uint32_t ch = (e & f) ^ (~e & g);
+        uint32_t tmp1 = h + s1 + ch + wk[i];
+        uint32_t s0 = ror32(a, 2) ^ ror32(a, 13) ^ ror32(a, 22);
+        uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t tmp2 = s0 + maj;
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + tmp1;
+        d = c;
+        c = b;
+        b = a;
+        a = tmp1 + tmp2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+// Write a state vector as a big-endian digest
+static void store_digest(const uint32_t *state, uint8_t *digest)
+{
+    for (size_t i = 0U; i < 32U; ++i)
+    {
+        digest[i] = static_cast<uint8_t>(state[i / 4U] >> ((3U - i % 4U) * 8U));
+    }
+}
+
+// Hash one 64-byte input with the portable implementation
+static void hash64_scalar(const uint8_t *input, uint8_t *digest)
+{
+    uint32_t state[8];
+    std::memcpy(state, Sha256Engine::iv, sizeof(state));
+    Sha256Engine::compress(state, input);
+    compress_wk(state, pad64.wk);
+    store_digest(state, digest);
+}
+
+// Hash one 32-byte input with the portable implementation
+static void hash32_scalar(const uint8_t *input, uint8_t *digest)
+{
+    uint8_t block[64] = {};
+    std::memcpy(block, input, 32U);
+    block[32] = 0x80U;
+    block[62] = 0x01U;
+
+    uint32_t state[8];
+    std::memcpy(state, Sha256Engine::iv, sizeof(state));
+    Sha256Engine::compress(state, block);
+    store_digest(state, digest);
+}
+
+#if defined(CRYPTLIB_X86)
+// Run the 64 rounds on S interleaved streams with the SHA extensions,
+// expanding the message words m in place. The four message vectors of a
+// stream rotate through m instead of being moved.
+template <size_t S>
+CRYPTLIB_TARGET("sha,sse4.1")
+static CRYPTLIB_INLINE void rounds_shani(__m128i *abef, __m128i *cdgh, __m128i (*m)[4])
+{
+    for (size_t i = 0U; i < 16U; ++i)
+    {
+        __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Sha256Engine::k + i * 4U));
+        for (size_t s = 0U; s < S; ++s)
+        {
+            __m128i wk = _mm_add_epi32(m[s][i & 3U], k);
+            cdgh[s] = _mm_sha256rnds2_epu32(cdgh[s], abef[s], wk);
+            abef[s] = _mm_sha256rnds2_epu32(abef[s], cdgh[s], _mm_shuffle_epi32(wk, 0x0E));
+
+            // Extend the next four message words
+            __m128i next = _mm_add_epi32(_mm_sha256msg1_epu32(m[s][i & 3U], m[s][(i + 1U) & 3U]), _mm_alignr_epi8(m[s][(i + 3U) & 3U], m[s][(i + 2U) & 3U], 4));
+            m[s][i & 3U] = _mm_sha256msg2_epu32(next, m[s][(i + 3U) & 3U]);
+        }
+    }
+}
+
+// Run the 64 rounds of a constant block from its schedule wk on S
+// interleaved streams with the SHA extensions
+template <size_t S>
+CRYPTLIB_TARGET("sha,sse4.1")
+static CRYPTLIB_INLINE void rounds_wk_shani(__m128i *abef, __m128i *cdgh, const uint32_t *wk)
+{
+    for (size_t i = 0U; i < 64U; i += 4U)
+    {
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(wk + i));
+        for (size_t s = 0U; s < S; ++s)
+        {
+            cdgh[s] = _mm_sha256rnds2_epu32(cdgh[s], abef[s], w);
+            abef[s] = _mm_sha256rnds2_epu32(abef[s], cdgh[s], _mm_shuffle_epi32(w, 0x0E));
+        }
+    }
+}
+
+// Store a state in ABEF/CDGH form as a big-endian digest
+CRYPTLIB_TARGET("sha,sse4.1")
+static CRYPTLIB_INLINE void store_shani(__m128i abef, __m128i cdgh, uint8_t *digest)
+{
+    const __m128i swap = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+
+    __m128i tmp = _mm_shuffle_epi32(abef, 0x1B);
+    cdgh = _mm_shuffle_epi32(cdgh, 0xB1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(digest), _mm_shuffle_epi8(_mm_blend_epi16(tmp, cdgh, 0xF0), swap));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(digest + 16), _mm_shuffle_epi8(_mm_alignr_epi8(cdgh, tmp, 8), swap));
+}
+
+// Hash S 64-byte inputs as interleaved streams with the SHA extensions
+template <size_t S>
+CRYPTLIB_TARGET("sha,sse4.1")
+static void hash64_shani(const uint8_t *inputs, uint8_t *digests)
+{
+    const __m128i swap = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+    const uint32_t *iv = Sha256Engine::iv;
+    const __m128i abef_iv = _mm_set_epi32(static_cast<int>(iv[0]), static_cast<int>(iv[1]), static_cast<int>(iv[4]), static_cast<int>(iv[5]));
+    const __m128i cdgh_iv = _mm_set_epi32(static_cast<int>(iv[2]), static_cast<int>(iv[3]), static_cast<int>(iv[6]), static_cast<int>(iv[7]));
+
+    // Populate message and state
+    __m128i m[S][4];
+    __m128i abef[S];
+    __m128i cdgh[S];
+    for (size_t s = 0U; s < S; ++s)
+    {
+        const __m128i *msg = reinterpret_cast<const __m128i*>(inputs + s * 64U);
+        for (size_t i = 0U; i < 4U; ++i)
+        {
+            m[s][i] = _mm_shuffle_epi8(_mm_loadu_si128(msg + i), swap);
+        }
+
+        abef[s] = abef_iv;
+        cdgh[s] = cdgh_iv;
+    }
+
+    // Message block
+    rounds_shani<S>(abef, cdgh, m);
+
+    __m128i abef_save[S];
+    __m128i cdgh_save[S];
+    for (size_t s = 0U; s < S; ++s)
+    {
+        abef[s] = abef_save[s] = _mm_add_epi32(abef[s], abef_iv);
+        cdgh[s] = cdgh_save[s] = _mm_add_epi32(cdgh[s], cdgh_iv);
+    }
+
+    // Padding block
+    rounds_wk_shani<S>(abef, cdgh, pad64.wk);
+
+    for (size_t s = 0U; s < S; ++s)
+    {
+        store_shani(_mm_add_epi32(abef[s], abef_save[s]), _mm_add_epi32(cdgh[s], cdgh_save[s]), digests + s * 32U);
+    }
+}
+
+// Hash S 32-byte inputs as interleaved streams with the SHA extensions
+template <size_t S>
+CRYPTLIB_TARGET("sha,sse4.1")
+static void hash32_shani(const uint8_t *inputs, uint8_t *digests)
+{
+    const __m128i swap = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+    const uint32_t *iv = Sha256Engine::iv;
+    const __m128i abef_iv = _mm_set_epi32(static_cast<int>(iv[0]), static_cast<int>(iv[1]), static_cast<int>(iv[4]), static_cast<int>(iv[5]));
+    const __m128i cdgh_iv = _mm_set_epi32(static_cast<int>(iv[2]), static_cast<int>(iv[3]), static_cast<int>(iv[6]), static_cast<int>(iv[7]));
+
+    // Populate message and state; the second half of the block is the
+    // padding and the 256-bit length
+    __m128i m[S][4];
+    __m128i abef[S];
+    __m128i cdgh[S];
+    for (size_t s = 0U; s < S; ++s)
+    {
+        const __m128i *msg = reinterpret_cast<const __m128i*>(inputs + s * 32U);
+        m[s][0] = _mm_shuffle_epi8(_mm_loadu_si128(msg), swap);
+        m[s][1] = _mm_shuffle_epi8(_mm_loadu_si128(msg + 1), swap);
+        m[s][2] = _mm_set_epi32(0, 0, 0, static_cast<int>(0x80000000U));
+        m[s][3] = _mm_set_epi32(256, 0, 0, 0);
+        abef[s] = abef_iv;
+        cdgh[s] = cdgh_iv;
+    }
+
+    rounds_shani<S>(abef, cdgh, m);
+
+    for (size_t s = 0U; s < S; ++s)
+    {
+        store_shani(_mm_add_epi32(abef[s], abef_iv), _mm_add_epi32(cdgh[s], cdgh_iv), digests + s * 32U);
+    }
+}
+
+// Hash eight 64-byte inputs with AVX2
+CRYPTLIB_TARGET("avx2")
+static void hash64_avx2(const uint8_t *inputs, uint8_t *digests)
+{
+    const uint8_t *blocks[8];
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        blocks[i] = inputs + i * 64U;
+    }
+
+    __m256i w[16];
+    sha256_load_avx2(blocks, 0U, w);
+    sha256_load_avx2(blocks, 32U, w + 8);
+
+    __m256i s[8];
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        s[j] = _mm256_set1_epi32(static_cast<int>(Sha256Engine::iv[j]));
+    }
+
+    sha256_compress_avx2(s, w, s);
+    sha256_compress_wk_avx2(s, pad64.wk, s);
+    sha256_store_avx2(s, digests);
+}
+
+// Hash eight 32-byte inputs with AVX2
+CRYPTLIB_TARGET("avx2")
+static void hash32_avx2(const uint8_t *inputs, uint8_t *digests)
+{
+    const uint8_t *blocks[8];
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        blocks[i] = inputs + i * 32U;
+    }
+
+    __m256i m[8];
+    sha256_load_avx2(blocks, 0U, m);
+
+    __m256i s[8];
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        s[j] = _mm256_set1_epi32(static_cast<int>(Sha256Engine::iv[j]));
+    }
+
+    sha256_compress_short_avx2(s, m, 32U, s);
+    sha256_store_avx2(s, digests);
+}
+
+// Hash sixteen 64-byte inputs with AVX-512
+CRYPTLIB_TARGET("avx512f")
+static void hash64_avx512(const uint8_t *inputs, uint8_t *digests)
+{
+    const uint8_t *blocks[16];
+    for (size_t i = 0U; i < 16U; ++i)
+    {
+        blocks[i] = inputs + i * 64U;
+    }
+
+    __m512i w[16];
+    sha256_load_avx512(blocks, 0U, w);
+    sha256_load_avx512(blocks, 32U, w + 8);
+
+    __m512i s[8];
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        s[j] = _mm512_set1_epi32(static_cast<int>(Sha256Engine::iv[j]));
+    }
+
+    sha256_compress_avx512(s, w, s);
+    sha256_compress_wk_avx512(s, pad64.wk, s);
+    sha256_store_avx512(s, digests);
+}
+
+// Hash sixteen 32-byte inputs with AVX-512
+CRYPTLIB_TARGET("avx512f")
+static void hash32_avx512(const uint8_t *inputs, uint8_t *digests)
+{
+    const uint8_t *blocks[16];
+    for (size_t i = 0U; i < 16U; ++i)
+    {
+        blocks[i] = inputs + i * 32U;
+    }
+
+    __m512i m[8];
+    sha256_load_avx512(blocks, 0U, m);
+
+    __m512i s[8];
+    for (size_t j = 0U; j < 8U; ++j)
+    {
+        s[j] = _mm512_set1_epi32(static_cast<int>(Sha256Engine::iv[j]));
+    }
+
+    sha256_compress_short_avx512(s, m, 32U, s);
+    sha256_store_avx512(s, digests);
+}
+#endif
+
+// Hash count inputs of Size bytes, N at a time. A partial last group is
+// staged through local buffers, so the kernel always sees N inputs. Each
+// group is loaded before its digests are stored, so the digests may
+// overwrite the inputs.
+template <size_t N, size_t Size, void (*Kernel)(const uint8_t *inputs, uint8_t *digests)>
+static void hash_groups(const uint8_t *inputs, size_t count, uint8_t *digests)
+{
+    for (; count >= N; count -= N, inputs += N * Size, digests += N * 32U)
+    {
+        Kernel(inputs, digests);
+    }
+
+    if (count)
+    {
+        uint8_t in[N * Size] = {};
+        uint8_t out[N * 32U];
+        std::memcpy(in, inputs, count * Size);
+        Kernel(in, out);
+        std::memcpy(digests, out, count * 32U);
+    }
+}
+
+/// Node hashing backend.
+struct Sha256NodesBackend
+{
+    /// Backend name.
+    const char *name;
+
+    /// Number of lanes.
+    size_t lanes;
+
+    /// 64-byte input hashing function.
+    void (*hash64)(const uint8_t *inputs, size_t count, uint8_t *digests);
+
+    /// 32-byte input hashing function.
+    void (*hash32)(const uint8_t *inputs, size_t count, uint8_t *digests);
+};
+
+// Select the fastest backend supported by the processor. Sixteen AVX-512
+// lanes outrun two SHA-NI streams, which in turn outrun eight AVX2 lanes.
+static const Sha256NodesBackend &select_backend()
+{
+    static const Sha256NodesBackend backend =
+#if defined(CRYPTLIB_X86)
+        CpuFeatures::avx512f() ? Sha256NodesBackend{ "avx512", 16U, hash_groups<16U, 64U, hash64_avx512>, hash_groups<16U, 32U, hash32_avx512> } :
+        (CpuFeatures::sha() && CpuFeatures::sse41()) ? Sha256NodesBackend{ "sha-ni", 2U, hash_groups<2U, 64U, hash64_shani<2U>>, hash_groups<2U, 32U, hash32_shani<2U>> } :
+        CpuFeatures::avx2() ? Sha256NodesBackend{ "avx2", 8U, hash_groups<8U, 64U, hash64_avx2>, hash_groups<8U, 32U, hash32_avx2> } :
+#endif
+        Sha256NodesBackend{ "scalar", 1U, hash_groups<1U, 64U, hash64_scalar>, hash_groups<1U, 32U, hash32_scalar> };
+    return backend;
+}
+
+void Sha256Nodes::hash64(const uint8_t *inputs, size_t count, uint8_t *digests)
+{
+    select_backend().hash64(inputs, count, digests);
+}
+
+void Sha256Nodes::hash32(const uint8_t *inputs, size_t count, uint8_t *digests)
+{
+    select_backend().hash32(inputs, count, digests);
+}
+
+void Sha256Nodes::reduce(uint8_t *nodes, size_t count)
+{
+    while (count > 1U)
+    {
+        // Hash the pairs of this level into the front of the array
+        size_t pairs = count / 2U;
+        hash64(nodes, pairs, nodes);
+
+        // Carry an odd node up unchanged
+        if (count % 2U)
+        {
+            std::memmove(nodes + pairs * 32U, nodes + (count - 1U) * 32U, 32U);
+        }
+
+        count = pairs + count % 2U;
+    }
+}
+
+const char *Sha256Nodes::backend()
+{
+    return select_backend().name;
+}
+
+size_t Sha256Nodes::lanes()
+{
+    return select_backend().lanes;
+}
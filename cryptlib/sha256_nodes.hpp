@@ -0,0 +1,50 @@
+#pragma once
+
+#include "sha256_engine.hpp"
+
+/// SHA256 fixed-size node hash class.
+/// Hashes arrays of 64-byte inputs (a pair of child digests) or 32-byte
+/// inputs (a single digest) to 32-byte digests, as in the interior levels
+/// of a Merkle tree. The padding block of a 64-byte message never changes,
+/// so its message schedule and round constants are precomputed once and
+/// its compression expands no message words; a 32-byte message fits in
+/// one block whose second half is constant. Inputs are hashed 16 (AVX-512)
+/// or 8 (AVX2) at a time in transposed SIMD lanes, or two interleaved
+/// streams at a time with the SHA extensions. Digests are identical to
+/// those of Sha256Hash.
+class Sha256Nodes
+{
+public:
+    /// SHA256 digest size in bytes.
+    static const size_t digest_size = 32U;
+
+    /// Hash an array of 64-byte inputs.
+    /// @param inputs                   Pointer to count consecutive 64-byte inputs
+    /// @param count                    Number of inputs
+    /// @param digests                  Output array of count 32-byte digests,
+    ///                                 which may start at inputs
+    static void hash64(const uint8_t *inputs, size_t count, uint8_t *digests);
+
+    /// Hash an array of 32-byte inputs.
+    /// @param inputs                   Pointer to count consecutive 32-byte inputs
+    /// @param count                    Number of inputs
+    /// @param digests                  Output array of count 32-byte digests,
+    ///                                 which may start at inputs
+    static void hash32(const uint8_t *inputs, size_t count, uint8_t *digests);
+
+    /// Reduce a level of digests to a root, one level at a time, in place.
+    /// Each pair of nodes is replaced by SHA256(left || right); a node
+    /// without a right sibling is carried up unchanged.
+    /// @param nodes                    Array of count 32-byte digests; the
+    ///                                 root is left in the first 32 bytes
+    /// @param count                    Number of digests (at least 1)
+    static void reduce(uint8_t *nodes, size_t count);
+
+    /// Get the name of the backend selected for this processor.
+    /// @return                         Backend name ("avx512", "sha-ni", "avx2" or "scalar")
+    static const char *backend();
+
+    /// Get the number of inputs hashed in parallel by the selected backend.
+    /// @return                         Number of SIMD lanes or interleaved streams
+    static size_t lanes();
+};
@@ -0,0 +1,307 @@
+#include "sha256_tree.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <utility>
+
+// Sidecar index file signature
+static const uint8_t index_magic[8] = { 'S', '2', '5', '6', 'T', 'R', 'E', 'E' };
+
+// Get the number of leaves covering the data
+static size_t leaf_count(uint64_t size, size_t leaf_size)
+{
+    return (size == 0U) ? 1U : static_cast<size_t>((size + leaf_size - 1U) / leaf_size);
+}
+
+// Write a little-endian 64-bit value
+static bool write_u64(std::FILE *file, uint64_t value)
+{
+    uint8_t bytes[8];
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        bytes[i] = static_cast<uint8_t>(value >> (i * 8U));
+    }
+
+    return std::fwrite(bytes, 1U, 8U, file) == 8U;
+}
+
+// Read a little-endian 64-bit value
+static bool read_u64(std::FILE *file, uint64_t &value)
+{
+    uint8_t bytes[8];
+    if (std::fread(bytes, 1U, 8U, file) != 8U)
+    {
+        return false;
+    }
+
+    value = 0U;
+    for (size_t i = 0U; i < 8U; ++i)
+    {
+        value |= static_cast<uint64_t>(bytes[i]) << (i * 8U);
+    }
+
+    return true;
+}
+
+Sha256Tree::Sha256Tree(size_t leaf_size) : leafsize(leaf_size ? leaf_size : default_leaf_size), datasize(0U), levels()
+{
+}
+
+void Sha256Tree::hash_leaves(const uint8_t *data, const std::vector<size_t> &leaves, unsigned threads)
+{
+    std::vector<Digest> &digests = levels[0];
+    std::atomic<size_t> next(0U);
+
+    // Each worker claims the next unhashed leaf until none remain
+    auto worker = [&]()
+    {
+        const uint8_t prefix = 0x00U;
+        for (size_t i = next++; i < leaves.size(); i = next++)
+        {
+            uint64_t offset = static_cast<uint64_t>(leaves[i]) * leafsize;
+            size_t size = static_cast<size_t>((datasize - offset < leafsize) ? datasize - offset : leafsize);
+
+            Sha256Engine engine;
+            engine.add(&prefix, 1U);
+            engine.add(data + offset, size);
+            engine.close(digests[leaves[i]].data());
+        }
+    };
+
+    if (threads == 0U)
+    {
+        threads = std::thread::hardware_concurrency();
+    }
+
+    if (threads > leaves.size())
+    {
+        threads = static_cast<unsigned>(leaves.size());
+    }
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1U; i < threads; ++i)
+    {
+        pool.emplace_back(worker);
+    }
+
+    worker();
+    for (std::thread &thread : pool)
+    {
+        thread.join();
+    }
+}
+
+void Sha256Tree::hash_nodes(std::vector<uint8_t> dirty)
+{
+    const uint8_t prefix = 0x01U;
+
+    size_t level = 0U;
+    while (levels[level].size() > 1U)
+    {
+        if (levels.size() == level + 1U)
+        {
+            levels.emplace_back();
+        }
+
+        const std::vector<Digest> &children = levels[level];
+        std::vector<Digest> &parents = levels[level + 1U];
+        size_t count = children.size();
+        size_t old = parents.size();
+        parents.resize((count + 1U) / 2U);
+
+        // Recompute parents of dirty children, and parents new to this level
+        std::vector<uint8_t> next(parents.size());
+        for (size_t i = 0U; i < parents.size(); ++i)
+        {
+            size_t left = i * 2U;
+            size_t right = left + 1U;
+            if (i < old && !dirty[left] && (right == count || !dirty[right]))
+            {
+                continue;
+            }
+
+            next[i] = 1U;
+            if (right == count)
+            {
+                parents[i] = children[left];
+                continue;
+            }
+
+            Sha256Engine engine;
+            engine.add(&prefix, 1U);
+            engine.add(children[left].data(), Digest::size());
+            engine.add(children[right].data(), Digest::size());
+            engine.close(parents[i].data());
+        }
+
+        dirty.swap(next);
+        ++level;
+    }
+
+    levels.resize(level + 1U);
+}
+
+void Sha256Tree::build(const void *data, size_t size, unsigned threads)
+{
+    datasize = size;
+    levels.assign(1U, std::vector<Digest>(leaf_count(datasize, leafsize)));
+
+    std::vector<size_t> leaves(levels[0].size());
+    for (size_t i = 0U; i < leaves.size(); ++i)
+    {
+        leaves[i] = i;
+    }
+
+    hash_leaves(static_cast<const uint8_t*>(data), leaves, threads);
+    hash_nodes(std::vector<uint8_t>(leaves.size(), 1U));
+}
+
+void Sha256Tree::update(const void *data, size_t size, size_t offset, size_t length, unsigned threads)
+{
+    if (levels.empty())
+    {
+        build(data, size, threads);
+        return;
+    }
+
+    size_t old_count = levels[0].size();
+    size_t count = leaf_count(size, leafsize);
+    std::vector<uint8_t> dirty(count);
+
+    // Leaves overlapping the modified range
+    if (length && offset < size)
+    {
+        size_t last = (length > size - offset) ? size - 1U : offset + length - 1U;
+        for (size_t i = offset / leafsize; i <= last / leafsize; ++i)
+        {
+            dirty[i] = 1U;
+        }
+    }
+
+    // A change in size dirties the old and new final leaves and any added ones
+    if (size != datasize)
+    {
+        size_t first = ((old_count < count) ? old_count : count) - 1U;
+        for (size_t i = first; i < count; ++i)
+        {
+            dirty[i] = 1U;
+        }
+    }
+
+    std::vector<size_t> leaves;
+    for (size_t i = 0U; i < count; ++i)
+    {
+        if (dirty[i])
+        {
+            leaves.push_back(i);
+        }
+    }
+
+    datasize = size;
+    levels[0].resize(count);
+    hash_leaves(static_cast<const uint8_t*>(data), leaves, threads);
+    hash_nodes(dirty);
+}
+
+const Sha256Tree::Digest &Sha256Tree::root() const
+{
+    return levels.back()[0];
+}
+
+size_t Sha256Tree::leaf_size() const
+{
+    return leafsize;
+}
+
+size_t Sha256Tree::leaves() const
+{
+    return levels.empty() ? 0U : levels[0].size();
+}
+
+const Sha256Tree::Digest &Sha256Tree::leaf(size_t index) const
+{
+    return levels[0][index];
+}
+
+bool Sha256Tree::save(const char *path) const
+{
+    if (levels.empty())
+    {
+        return false;
+    }
+
+    std::FILE *file = std::fopen(path, "wb");
+    if (!file)
+    {
+        return false;
+    }
+
+    // Write the header followed by the leaf digests
+    bool ok =
+        std::fwrite(index_magic, 1U, sizeof(index_magic), file) == sizeof(index_magic) &&
+        write_u64(file, leafsize) &&
+        write_u64(file, datasize);
+
+    for (size_t i = 0U; ok && i < levels[0].size(); ++i)
+    {
+        ok = std::fwrite(levels[0][i].data(), 1U, Digest::size(), file) == Digest::size();
+    }
+
+    return (std::fclose(file) == 0) && ok;
+}
+
+bool Sha256Tree::load(const char *path)
+{
+    std::FILE *file = std::fopen(path, "rb");
+    if (!file)
+    {
+        return false;
+    }
+
+    // Validate the header
+    uint8_t magic[sizeof(index_magic)];
+    uint64_t leaf_size = 0U;
+    uint64_t size = 0U;
+    bool ok =
+        std::fread(magic, 1U, sizeof(magic), file) == sizeof(magic) &&
+        std::equal(magic, magic + sizeof(magic), index_magic) &&
+        read_u64(file, leaf_size) &&
+        read_u64(file, size) &&
+        leaf_size != 0U &&
+        static_cast<size_t>(leaf_size) == leaf_size;
+
+    // Read the leaf digests one at a time, so a corrupt size fails on the
+    // first missing digest instead of allocating for all of them
+    uint64_t count = 0U;
+    if (ok)
+    {
+        count = (size == 0U) ? 1U : size / leaf_size + ((size % leaf_size) ? 1U : 0U);
+    }
+
+    std::vector<Digest> digests;
+    for (uint64_t i = 0U; ok && i < count; ++i)
+    {
+        Digest digest;
+        ok = digests.size() < digests.max_size() &&
+            std::fread(digest.data(), 1U, Digest::size(), file) == Digest::size();
+        if (ok)
+        {
+            digests.push_back(digest);
+        }
+    }
+
+    // Nothing may follow the digests
+    ok = ok && std::fgetc(file) == EOF;
+    std::fclose(file);
+    if (!ok)
+    {
+        return false;
+    }
+
+    leafsize = static_cast<size_t>(leaf_size);
+    datasize = size;
+    levels.assign(1U, std::move(digests));
+    hash_nodes(std::vector<uint8_t>(levels[0].size(), 1U));
+    return true;
+}
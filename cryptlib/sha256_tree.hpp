@@ -0,0 +1,89 @@
+#pragma once
+
+#include "sha256_engine.hpp"
+#include <vector>
+
+/// SHA256 Merkle tree hash class.
+/// Splits the data into fixed-size leaves and combines the leaf digests
+/// into a binary Merkle tree. Leaves are hashed as SHA256(0x00 || chunk)
+/// and interior nodes as SHA256(0x01 || left || right); a node without a
+/// right sibling is carried up unchanged. The leaf digests can be saved to
+/// a sidecar index so a later update() after a small edit only re-hashes
+/// the dirty leaves and the nodes on their paths to the root.
+class Sha256Tree
+{
+public:
+    /// SHA256 digest type.
+    typedef Sha256Engine::Digest Digest;
+
+    /// Default leaf size in bytes (1 MiB).
+    static const size_t default_leaf_size = 1U << 20;
+
+private:
+    /// Leaf size in bytes.
+    size_t leafsize;
+
+    /// Size of the hashed data.
+    uint64_t datasize;
+
+    /// Tree levels, from the leaf digests up to the root.
+    std::vector<std::vector<Digest>> levels;
+
+    /// Hash the listed leaves of the data.
+    /// @param data                     Pointer to the data
+    /// @param leaves                   Indices of the leaves to hash
+    /// @param threads                  Number of worker threads
+    void hash_leaves(const uint8_t *data, const std::vector<size_t> &leaves, unsigned threads);
+
+    /// Recompute the interior nodes above the dirty leaves.
+    /// @param dirty                    Dirty flag for each leaf
+    void hash_nodes(std::vector<uint8_t> dirty);
+
+public:
+    /// Constructor.
+    /// @param leaf_size                Leaf size in bytes
+    explicit Sha256Tree(size_t leaf_size = default_leaf_size);
+
+    /// Hash all the data.
+    /// @param data                     Pointer to the data
+    /// @param size                     Size of the data
+    /// @param threads                  Number of worker threads (0 for one per processor)
+    void build(const void *data, size_t size, unsigned threads = 0U);
+
+    /// Re-hash the data after a modification.
+    /// Only the leaves overlapping the modified range, and any leaves added
+    /// or truncated by a change in size, are read.
+    /// @param data                     Pointer to the modified data
+    /// @param size                     Size of the modified data
+    /// @param offset                   Offset of the modified range
+    /// @param length                   Length of the modified range
+    /// @param threads                  Number of worker threads (0 for one per processor)
+    void update(const void *data, size_t size, size_t offset, size_t length, unsigned threads = 0U);
+
+    /// Get the root digest.
+    /// @return                         Merkle root digest
+    const Digest &root() const;
+
+    /// Get the leaf size.
+    /// @return                         Leaf size in bytes
+    size_t leaf_size() const;
+
+    /// Get the number of leaves.
+    /// @return                         Number of leaves (at least 1 once built)
+    size_t leaves() const;
+
+    /// Get a leaf digest.
+    /// @param index                    Leaf index
+    /// @return                         Leaf digest
+    const Digest &leaf(size_t index) const;
+
+    /// Save the leaf digests to a sidecar index file.
+    /// @param path                     Index file path
+    /// @return                         True on success
+    bool save(const char *path) const;
+
+    /// Load the leaf digests from a sidecar index file and rebuild the tree.
+    /// @param path                     Index file path
+    /// @return                         True on success
+    bool load(const char *path);
+};
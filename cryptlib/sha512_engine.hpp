@@ -0,0 +1,294 @@
+#pragma once
+
+#include "hash_engine.hpp"
+
+/// Process SHA512 blocks with the backend selected for this processor.
+/// @param state                        SHA512 state vector
+/// @param blocks                       Pointer to the blocks to process
+/// @param count                        Number of 128-byte blocks
+void sha512_process(uint64_t *state, const uint8_t *blocks, size_t count);
+
+/// SHA512 family initial state vectors.
+/// @tparam DigestSize                  Digest size in bytes (64 for SHA512,
+///                                     48 for SHA384, 32 for SHA512/256)
+template <size_t DigestSize>
+struct Sha512Iv;
+
+/// SHA512 initial state vector.
+template <>
+struct Sha512Iv<64U>
+{
+    /// Get a word of the initial state vector.
+    /// @param i                        Word index (0 to 7)
+    /// @return                         Initial state word
+    static constexpr uint64_t iv(size_t i)
+    {
+        const uint64_t words[8] =
+        {
+            0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+            0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+        };
+
+        return words[i];
+    }
+};
+
+/// SHA384 initial state vector.
+template <>
+struct Sha512Iv<48U>
+{
+    /// Get a word of the initial state vector.
+    /// @param i                        Word index (0 to 7)
+    /// @return                         Initial state word
+    static constexpr uint64_t iv(size_t i)
+    {
+        const uint64_t words[8] =
+        {
+            0xcbbb9d5dc1059ed8ULL, 0x629a292a367cd507ULL, 0x9159015a3070dd17ULL, 0x152fecd8f70e5939ULL,
+            0x67332667ffc00b31ULL, 0x8eb44a8768581511ULL, 0xdb0c2e0d64f98fa7ULL, 0x47b5481dbefa4fa4ULL
+        };
+
+        return words[i];
+    }
+};
+
+/// SHA512/256 initial state vector.
+template <>
+struct Sha512Iv<32U>
+{
+    /// Get a word of the initial state vector.
+    /// @param i                        Word index (0 to 7)
+    /// @return                         Initial state word
+    static constexpr uint64_t iv(size_t i)
+    {
+        const uint64_t words[8] =
+        {
+            0x22312194fc2bf72cULL, 0x9f555fa3c84c64c2ULL, 0x2393b86b6f53b151ULL, 0x963877195940eabdULL,
+            0x96283ee2a88effe3ULL, 0xbe5e1e2553863992ULL, 0x2b0199fc2c85b8aaULL, 0x0eb72ddc81c52ca2ULL
+        };
+
+        return words[i];
+    }
+};
+
+/// SHA512 family hash engine.
+/// The whole family shares the compression function on 128-byte blocks of
+/// 64-bit words; the members differ only in the initial state vector and
+/// the number of digest bytes kept.
+/// @tparam DigestSize                  Digest size in bytes (64, 48 or 32)
+/// @tparam Portable                    Use only the portable compression function,
+///                                     making the engine usable in constant expressions
+template <size_t DigestSize, bool Portable>
+class BasicSha512Engine : public HashEngine<BasicSha512Engine<DigestSize, Portable>, uint64_t, 8U, 128U, DigestSize, true>
+{
+    /// Base engine type.
+    typedef HashEngine<BasicSha512Engine<DigestSize, Portable>, uint64_t, 8U, 128U, DigestSize, true> Base;
+
+    /// Choose function.
+    static constexpr uint64_t ch(uint64_t e, uint64_t f, uint64_t g)
+    {
+        return g ^ (e & (f ^ g));
+    }
+
+    /// Majority function.
+    static constexpr uint64_t maj(uint64_t a, uint64_t b, uint64_t c)
+    {
+        return (a & b) | (c & (a | b));
+    }
+
+    /// Run one round. The caller rotates the roles of the working
+    /// variables instead of moving them.
+    /// @param a                        Working variable a
+    /// @param b                        Working variable b
+    /// @param c                        Working variable c
+    /// @param d                        Working variable d, receiving the new e
+    /// @param e                        Working variable e
+    /// @param f                        Working variable f
+    /// @param g                        Working variable g
+    /// @param h                        Working variable h, receiving the new a
+    /// @param wk                       Message word plus round constant
+    static constexpr void round(
+        uint64_t a, uint64_t b, uint64_t c, uint64_t &d,
+        uint64_t e, uint64_t f, uint64_t g, uint64_t &h, uint64_t wk)
+    {
+        uint64_t tmp1 = h + (Base::rtr(e, 14U) ^ Base::rtr(e, 18U) ^ Base::rtr(e, 41U)) + ch(e, f, g) + wk;
+        d += tmp1;
+        h = tmp1 + (Base::rtr(a, 28U) ^ Base::rtr(a, 34U) ^ Base::rtr(a, 39U)) + maj(a, b, c);
+    }
+
+public:
+    /// Instrumentation counters used by the engine.
+    static const HashStats::Algorithm algorithm = Portable ? HashStats::untracked : HashStats::sha512;
+
+    /// Round constants.
+    static constexpr uint64_t k[80] =
+    {
+        0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+        0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+        0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+        0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+        0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+        0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+        0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+        0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+        0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+        0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+        0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+        0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+        0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+        0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+        0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+        0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+        0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+        0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+        0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+        0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+    };
+
+    /// Constructor.
+    constexpr BasicSha512Engine()
+    {
+        clear();
+    }
+
+    /// Clear the hash to an initial state.
+    constexpr void clear()
+    {
+        // Seed the state vector
+        for (size_t i = 0U; i < 8U; ++i)
+        {
+            this->state[i] = Sha512Iv<DigestSize>::iv(i);
+        }
+
+        // Clear buffer and total lengths
+        this->buflen = 0U;
+        this->totlen = 0U;
+    }
+
+    /// Process full blocks.
+    /// @param blocks                   Pointer to the blocks to process
+    /// @param count                    Number of 128-byte blocks
+    constexpr void process(const uint8_t *blocks, size_t count)
+    {
+        if (Portable)
+        {
+            for (; count; --count, blocks += 128U)
+            {
+                compress(this->state, blocks);
+            }
+        }
+        else
+        {
+            sha512_process(this->state, blocks, count);
+        }
+    }
+
+    /// Expand a block into the 80 message words with the round constants added.
+    /// @param block                    Pointer to the 128-byte block
+    /// @param wk                       Output array of 80 words
+    static constexpr void schedule(const uint8_t *block, uint64_t *wk)
+    {
+        // Populate message
+        uint64_t w[16] = {};
+        for (size_t i = 0U; i < 16U; ++i)
+        {
+            w[i] = (static_cast<uint64_t>(block[i * 8    ]) << 56) |
+                   (static_cast<uint64_t>(block[i * 8 + 1]) << 48) |
+                   (static_cast<uint64_t>(block[i * 8 + 2]) << 40) |
+                   (static_cast<uint64_t>(block[i * 8 + 3]) << 32) |
+                   (static_cast<uint64_t>(block[i * 8 + 4]) << 24) |
+                   (static_cast<uint64_t>(block[i * 8 + 5]) << 16) |
+                   (static_cast<uint64_t>(block[i * 8 + 6]) <<  8) |
+                   (static_cast<uint64_t>(block[i * 8 + 7])      );
+
+            wk[i] = w[i] + k[i];
+        }
+
+        // Extend message words in a rolling window
+        for (size_t i = 16U; i < 80U; ++i)
+        {
+            uint64_t w15 = w[(i - 15U) & 15U];
+            uint64_t w2 = w[(i - 2U) & 15U];
+            uint64_t s0 = Base::rtr(w15, 1U) ^ Base::rtr(w15, 8U) ^ (w15 >> 7);
+            uint64_t s1 = Base::rtr(w2, 19U) ^ Base::rtr(w2, 61U) ^ (w2 >> 6);
+            w[i & 15U] += s0 + w[(i - 7U) & 15U] + s1;
+            wk[i] = w[i & 15U] + k[i];
+        }
+    }
+
+    /// Run the 80 rounds on a precomputed schedule.
+    /// The rounds are unrolled by eight, which brings the working variables
+    /// back to their original roles, so there are no moves.
+    /// @param state                    SHA512 state vector
+    /// @param wk                       Message words plus round constants, as made by schedule()
+    static constexpr void rounds(uint64_t *state, const uint64_t *wk)
+    {
+        // Populate state
+        uint64_t a = state[0];
+        uint64_t b = state[1];
+        uint64_t c = state[2];
+        uint64_t d = state[3];
+        uint64_t e = state[4];
+        uint64_t f = state[5];
+        uint64_t g = state[6];
+        uint64_t h = state[7];
+
+        for (size_t i = 0U; i < 80U; i += 8U)
+        {
+            round(a, b, c, d, e, f, g, h, wk[i]);
+            round(h, a, b, c, d, e, f, g, wk[i + 1U]);
+            round(g, h, a, b, c, d, e, f, wk[i + 2U]);
+            round(f, g, h, a, b, c, d, e, wk[i + 3U]);
+            round(e, f, g, h, a, b, c, d, wk[i + 4U]);
+            round(d, e, f, g, h, a, b, c, wk[i + 5U]);
+            round(c, d, e, f, g, h, a, b, wk[i + 6U]);
+            round(b, c, d, e, f, g, h, a, wk[i + 7U]);
+        }
+
+        // Update the state vector
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+
+    /// Process a single block with the portable compression function.
+    /// @param state                    SHA512 state vector
+    /// @param block                    Pointer to the 128-byte block
+    static constexpr void compress(uint64_t *state, const uint8_t *block)
+    {
+        uint64_t wk[80] = {};
+        schedule(block, wk);
+        rounds(state, wk);
+    }
+};
+
+template <size_t DigestSize, bool Portable>
+constexpr uint64_t BasicSha512Engine<DigestSize, Portable>::k[80];
+
+/// SHA512 hash engine using the fastest backend for the processor.
+typedef BasicSha512Engine<64U, false> Sha512Engine;
+
+/// SHA384 hash engine using the fastest backend for the processor.
+typedef BasicSha512Engine<48U, false> Sha384Engine;
+
+/// SHA512/256 hash engine using the fastest backend for the processor.
+typedef BasicSha512Engine<32U, false> Sha512_256Engine;
+
+/// SHA512 hash engine usable in constant expressions.
+typedef BasicSha512Engine<64U, true> Sha512ConstEngine;
+
+/// Calculate the SHA512 digest of a string, usable in constant expressions.
+/// @param str                          String literal (the terminator is not hashed)
+/// @return                             Message digest
+template <size_t N>
+constexpr Sha512Engine::Digest sha512(const char (&str)[N])
+{
+    Sha512ConstEngine engine;
+    engine.add(str, N - 1U);
+    return engine.close();
+}
@@ -0,0 +1,218 @@
+#include "sha512_hash.hpp"
+#include "cpu_features.hpp"
+
+#if defined(CRYPTLIB_X86)
+#include <immintrin.h>
+#endif
+
+// Process blocks with the portable implementation
+static void process_scalar(uint64_t *state, const uint8_t *blocks, size_t count)
+{
+    for (; count; --count, blocks += 128U)
+    {
+        Sha512Engine::compress(state, blocks);
+    }
+}
+
+#if defined(CRYPTLIB_X86)
+// Rotate each 64-bit lane right
+template <int C>
+CRYPTLIB_TARGET("avx2")
+static inline __m256i rtr_epi64(__m256i x)
+{
+    return _mm256_or_si256(_mm256_srli_epi64(x, C), _mm256_slli_epi64(x, 64 - C));
+}
+
+// Rotate each 64-bit lane right
+template <int C>
+CRYPTLIB_TARGET("avx2")
+static inline __m128i rtr_epi64(__m128i x)
+{
+    return _mm_or_si128(_mm_srli_epi64(x, C), _mm_slli_epi64(x, 64 - C));
+}
+
+// Expand a block into the 80 message words plus round constants, two words
+// at a time. Each word depends on the one two places back, so the words of
+// a pair are independent.
+CRYPTLIB_TARGET("avx2")
+static void schedule_sse(const uint8_t *block, uint64_t *wk)
+{
+    // Byte swap mask for big-endian message words
+    const __m128i swap = _mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+
+    // Populate message
+    const __m128i *in = reinterpret_cast<const __m128i*>(block);
+    const __m128i *k = reinterpret_cast<const __m128i*>(Sha512Engine::k);
+    __m128i w[40];
+    for (size_t p = 0U; p < 8U; ++p)
+    {
+        w[p] = _mm_shuffle_epi8(_mm_loadu_si128(in + p), swap);
+    }
+
+    // Extend message words
+    for (size_t p = 8U; p < 40U; ++p)
+    {
+        __m128i w15 = _mm_alignr_epi8(w[p - 7], w[p - 8], 8);
+        __m128i w7 = _mm_alignr_epi8(w[p - 3], w[p - 4], 8);
+        __m128i w2 = w[p - 1];
+        __m128i s0 = _mm_xor_si128(_mm_xor_si128(rtr_epi64<1>(w15), rtr_epi64<8>(w15)), _mm_srli_epi64(w15, 7));
+        __m128i s1 = _mm_xor_si128(_mm_xor_si128(rtr_epi64<19>(w2), rtr_epi64<61>(w2)), _mm_srli_epi64(w2, 6));
+        w[p] = _mm_add_epi64(_mm_add_epi64(w[p - 8], s0), _mm_add_epi64(w7, s1));
+    }
+
+    // Add the round constants
+    for (size_t p = 0U; p < 40U; ++p)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(wk) + p, _mm_add_epi64(w[p], _mm_loadu_si128(k + p)));
+    }
+}
+
+// Expand two blocks at once, one per 128-bit lane. The AVX2 alignr works
+// within each lane, so this is the two-word schedule run twice over
+CRYPTLIB_TARGET("avx2")
+static void schedule_avx2(const uint8_t *block, uint64_t *wk0, uint64_t *wk1)
+{
+    // Byte swap mask for big-endian message words
+    const __m256i swap = _mm256_set_epi8(
+        8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+        8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+
+    // Populate message
+    const __m128i *in = reinterpret_cast<const __m128i*>(block);
+    const __m128i *k = reinterpret_cast<const __m128i*>(Sha512Engine::k);
+    __m256i w[40];
+    for (size_t p = 0U; p < 8U; ++p)
+    {
+        __m256i m = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(in + p)), _mm_loadu_si128(in + 8 + p), 1);
+        w[p] = _mm256_shuffle_epi8(m, swap);
+    }
+
+    // Extend message words
+    for (size_t p = 8U; p < 40U; ++p)
+    {
+        __m256i w15 = _mm256_alignr_epi8(w[p - 7], w[p - 8], 8);
+        __m256i w7 = _mm256_alignr_epi8(w[p - 3], w[p - 4], 8);
+        __m256i w2 = w[p - 1];
+        __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rtr_epi64<1>(w15), rtr_epi64<8>(w15)), _mm256_srli_epi64(w15, 7));
+        __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rtr_epi64<19>(w2), rtr_epi64<61>(w2)), _mm256_srli_epi64(w2, 6));
+        w[p] = _mm256_add_epi64(_mm256_add_epi64(w[p - 8], s0), _mm256_add_epi64(w7, s1));
+    }
+
+    // Add the round constants and split the blocks
+    for (size_t p = 0U; p < 40U; ++p)
+    {
+        __m256i x = _mm256_add_epi64(w[p], _mm256_broadcastsi128_si256(_mm_loadu_si128(k + p)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(wk0) + p, _mm256_castsi256_si128(x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(wk1) + p, _mm256_extracti128_si256(x, 1));
+    }
+}
+
+// Process blocks with an AVX2 message schedule, two blocks per schedule pass
+CRYPTLIB_TARGET("avx2")
+static void process_avx2(uint64_t *state, const uint8_t *blocks, size_t count)
+{
+    uint64_t wk0[80];
+    uint64_t wk1[80];
+    for (; count >= 2U; count -= 2U, blocks += 256U)
+    {
+        schedule_avx2(blocks, wk0, wk1);
+        Sha512Engine::rounds(state, wk0);
+        Sha512Engine::rounds(state, wk1);
+    }
+
+    if (count)
+    {
+        schedule_sse(blocks, wk0);
+        Sha512Engine::rounds(state, wk0);
+    }
+}
+#endif
+
+/// Block processing backend.
+struct Sha512Backend
+{
+    /// Backend name.
+    const char *name;
+
+    /// Block processing function.
+    void (*process)(uint64_t *state, const uint8_t *blocks, size_t count);
+};
+
+// Select the fastest backend supported by the processor
+static const Sha512Backend &select_backend()
+{
+    static const Sha512Backend backend =
+#if defined(CRYPTLIB_X86)
+        CpuFeatures::avx2() ? Sha512Backend{ "avx2", process_avx2 } :
+#endif
+        Sha512Backend{ "scalar", process_scalar };
+    return backend;
+}
+
+void sha512_process(uint64_t *state, const uint8_t *blocks, size_t count)
+{
+    select_backend().process(state, blocks, count);
+}
+
+template <size_t DigestSize>
+const char *BasicSha512Hash<DigestSize>::backend()
+{
+    return select_backend().name;
+}
+
+template <size_t DigestSize>
+BasicSha512Hash<DigestSize>::BasicSha512Hash() : engine()
+{
+}
+
+template <size_t DigestSize>
+void BasicSha512Hash<DigestSize>::clear()
+{
+    engine.clear();
+}
+
+template <size_t DigestSize>
+void BasicSha512Hash<DigestSize>::add(const void *data, size_t size)
+{
+    engine.add(data, size);
+}
+
+template <size_t DigestSize>
+void BasicSha512Hash<DigestSize>::add(const HashData *segments, size_t count)
+{
+    engine.add(segments, count);
+}
+
+template <size_t DigestSize>
+size_t BasicSha512Hash<DigestSize>::size() const
+{
+    return Digest::size();
+}
+
+template <size_t DigestSize>
+void BasicSha512Hash<DigestSize>::close(uint8_t *digest)
+{
+    engine.close(digest);
+}
+
+template <size_t DigestSize>
+void BasicSha512Hash<DigestSize>::close(Digest &digest)
+{
+    engine.close(digest.data());
+}
+
+template <size_t DigestSize>
+void BasicSha512Hash<DigestSize>::save(State &state) const
+{
+    state = engine;
+}
+
+template <size_t DigestSize>
+void BasicSha512Hash<DigestSize>::restore(const State &state)
+{
+    engine = state;
+}
+
+template class BasicSha512Hash<64U>;
+template class BasicSha512Hash<48U>;
+template class BasicSha512Hash<32U>;
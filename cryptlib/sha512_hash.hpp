@@ -0,0 +1,85 @@
+#pragma once
+
+#include "sha512_engine.hpp"
+
+/// SHA512 family Hash class.
+/// On 64-bit processors without SHA-NI, SHA512 and its truncations are
+/// faster per byte than SHA256, as each round of 64-bit words covers
+/// twice the data.
+/// @tparam DigestSize                  Digest size in bytes (64 for SHA512,
+///                                     48 for SHA384, 32 for SHA512/256)
+template <size_t DigestSize>
+class BasicSha512Hash : public Hash
+{
+public:
+    /// SHA512 family engine type.
+    typedef BasicSha512Engine<DigestSize, false> Engine;
+
+    /// Digest type.
+    typedef typename Engine::Digest Digest;
+
+    /// Midstate snapshot type.
+    typedef Engine State;
+
+private:
+    /// SHA512 family engine.
+    Engine engine;
+
+public:
+    /// Constructor.
+    BasicSha512Hash();
+
+    /// Delete copy constructor.
+    BasicSha512Hash(const BasicSha512Hash &) = delete;
+
+    /// Delete assignment operator.
+    BasicSha512Hash &operator=(const BasicSha512Hash &) = delete;
+
+    /// Clear the hash to an initial state.
+    virtual void clear();
+
+    /// Add data to the hash.
+    /// @param data                     Pointer to the data to add
+    /// @param size                     Size of the data to add
+    virtual void add(const void *data, size_t size);
+
+    /// Add a list of data segments to the hash.
+    /// @param segments                 Data segments
+    /// @param count                    Number of segments
+    virtual void add(const HashData *segments, size_t count);
+
+    /// Get the digest size.
+    /// @return                         Digest size in bytes (DigestSize)
+    virtual size_t size() const;
+
+    /// Close the hash and write the digest without allocating.
+    /// @param digest                   Output buffer of DigestSize bytes
+    virtual void close(uint8_t *digest);
+
+    /// Close the hash and write the digest without allocating.
+    /// @param digest                   Output digest
+    void close(Digest &digest);
+
+    using Hash::close;
+
+    /// Save a snapshot of the hash midstate.
+    /// @param state                    Snapshot to write
+    void save(State &state) const;
+
+    /// Restore the hash midstate from a snapshot.
+    /// @param state                    Snapshot previously written by save()
+    void restore(const State &state);
+
+    /// Get the name of the block processing backend selected for this processor.
+    /// @return                         Backend name ("avx2" or "scalar")
+    static const char *backend();
+};
+
+/// SHA512 Hash class.
+typedef BasicSha512Hash<64U> Sha512Hash;
+
+/// SHA384 Hash class.
+typedef BasicSha512Hash<48U> Sha384Hash;
+
+/// SHA512/256 Hash class.
+typedef BasicSha512Hash<32U> Sha512_256Hash;
@@ -0,0 +1,567 @@
+#include "stream_hash.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define CRYPTLIB_IO_URING 1
+#endif
+#endif
+
+#if defined(CRYPTLIB_IO_URING)
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+// Alignment of O_DIRECT buffers, offsets and sizes
+static const size_t io_alignment = 4096U;
+
+// Round a pointer up to the I/O alignment
+static uint8_t *align_buffer(std::vector<uint8_t> &storage)
+{
+    uintptr_t p = reinterpret_cast<uintptr_t>(storage.data());
+    return storage.data() + ((io_alignment - p % io_alignment) % io_alignment);
+}
+
+#if defined(CRYPTLIB_IO_URING)
+/// Minimal io_uring instance driven through the raw system calls, so no
+/// liburing is needed. Only vectored reads are queued.
+class Uring
+{
+private:
+    /// Ring file descriptor.
+    int fd;
+
+    /// Submission queue ring mapping.
+    void *sq;
+
+    /// Completion queue ring mapping (may alias sq).
+    void *cq;
+
+    /// Mapping sizes.
+    size_t sqsize;
+    size_t cqsize;
+    size_t sqessize;
+
+    /// Submission queue entries.
+    io_uring_sqe *sqes;
+
+    /// Ring indices shared with the kernel.
+    unsigned *sqtail;
+    unsigned *sqmask;
+    unsigned *sqarray;
+    unsigned *cqhead;
+    unsigned *cqtail;
+    unsigned *cqmask;
+
+    /// Completion queue entries.
+    io_uring_cqe *cqes;
+
+    /// Entries queued but not yet submitted.
+    unsigned pending;
+
+public:
+    /// Constructor.
+    Uring() : fd(-1), sq(MAP_FAILED), cq(MAP_FAILED), sqsize(0U), cqsize(0U), sqessize(0U), sqes(nullptr), pending(0U)
+    {
+    }
+
+    /// Delete copy constructor.
+    Uring(const Uring &) = delete;
+
+    /// Delete assignment operator.
+    Uring &operator=(const Uring &) = delete;
+
+    /// Destructor.
+    ~Uring()
+    {
+        close();
+    }
+
+    /// Tear down the rings. The kernel cancels any reads still in flight,
+    /// but may finish doing so after this returns.
+    void close()
+    {
+        if (sqes)
+        {
+            munmap(sqes, sqessize);
+            sqes = nullptr;
+        }
+
+        if (cq != MAP_FAILED && cq != sq)
+        {
+            munmap(cq, cqsize);
+        }
+
+        if (sq != MAP_FAILED)
+        {
+            munmap(sq, sqsize);
+        }
+
+        sq = cq = MAP_FAILED;
+        if (fd >= 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    /// Set up the rings.
+    /// @param entries                  Submission queue size
+    /// @return                         False if io_uring is unavailable
+    bool open(unsigned entries)
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        sqsize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqsize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0U;
+        if (single)
+        {
+            sqsize = cqsize = (sqsize > cqsize) ? sqsize : cqsize;
+        }
+
+        sq = mmap(nullptr, sqsize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sq == MAP_FAILED)
+        {
+            return false;
+        }
+
+        cq = single ? sq : mmap(nullptr, cqsize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cq == MAP_FAILED)
+        {
+            return false;
+        }
+
+        sqessize = params.sq_entries * sizeof(io_uring_sqe);
+        void *entriesmap = mmap(nullptr, sqessize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (entriesmap == MAP_FAILED)
+        {
+            return false;
+        }
+
+        uint8_t *s = static_cast<uint8_t*>(sq);
+        uint8_t *c = static_cast<uint8_t*>(cq);
+        sqes = static_cast<io_uring_sqe*>(entriesmap);
+        sqtail = reinterpret_cast<unsigned*>(s + params.sq_off.tail);
+        sqmask = reinterpret_cast<unsigned*>(s + params.sq_off.ring_mask);
+        sqarray = reinterpret_cast<unsigned*>(s + params.sq_off.array);
+        cqhead = reinterpret_cast<unsigned*>(c + params.cq_off.head);
+        cqtail = reinterpret_cast<unsigned*>(c + params.cq_off.tail);
+        cqmask = reinterpret_cast<unsigned*>(c + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(c + params.cq_off.cqes);
+        return true;
+    }
+
+    /// Queue a read; the vector must stay valid until it completes.
+    /// @param file                     File descriptor
+    /// @param iov                      Read buffer
+    /// @param offset                   File offset
+    /// @param tag                      Tag returned with the completion
+    void read(int file, const iovec *iov, uint64_t offset, uint64_t tag)
+    {
+        unsigned tail = *sqtail;
+        unsigned index = tail & *sqmask;
+        io_uring_sqe *sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READV;
+        sqe->fd = file;
+        sqe->addr = reinterpret_cast<uintptr_t>(iov);
+        sqe->len = 1U;
+        sqe->off = offset;
+        sqe->user_data = tag;
+        sqarray[index] = index;
+        __atomic_store_n(sqtail, tail + 1U, __ATOMIC_RELEASE);
+        ++pending;
+    }
+
+    /// Submit the queued reads and optionally wait for a completion.
+    /// @param wait                     Number of completions to wait for
+    /// @return                         False on error
+    bool submit(unsigned wait)
+    {
+        for (;;)
+        {
+            long ret = syscall(__NR_io_uring_enter, fd, pending, wait, wait ? IORING_ENTER_GETEVENTS : 0U, nullptr, 0U);
+            if (ret >= 0)
+            {
+                pending -= static_cast<unsigned>(ret);
+                return true;
+            }
+
+            if (errno != EINTR)
+            {
+                return false;
+            }
+        }
+    }
+
+    /// Take a completion.
+    /// @param tag                      Tag of the completed read
+    /// @param result                   Bytes read or negated error number
+    /// @return                         False if no completion is ready
+    bool reap(uint64_t &tag, int &result)
+    {
+        unsigned head = *cqhead;
+        if (head == __atomic_load_n(cqtail, __ATOMIC_ACQUIRE))
+        {
+            return false;
+        }
+
+        const io_uring_cqe &cqe = cqes[head & *cqmask];
+        tag = cqe.user_data;
+        result = cqe.res;
+        __atomic_store_n(cqhead, head + 1U, __ATOMIC_RELEASE);
+        return true;
+    }
+};
+
+/// Buffer with a read in flight.
+struct UringSlot
+{
+    /// Aligned buffer.
+    uint8_t *buffer;
+
+    /// Vector of the read in flight.
+    iovec iov;
+
+    /// File offset of the buffer.
+    uint64_t offset;
+
+    /// Bytes expected.
+    size_t size;
+
+    /// Bytes read so far.
+    size_t filled;
+
+    /// Set when the buffer is complete.
+    bool done;
+
+    /// Set if the read in flight was issued with O_DIRECT.
+    bool direct;
+};
+#endif
+
+StreamHash::StreamHash(size_t depth, size_t buffer_size, Method method) :
+    depth(depth ? depth : 1U),
+    buffersize((buffer_size + io_alignment - 1U) / io_alignment * io_alignment),
+    method(method),
+    last()
+{
+    if (buffersize == 0U)
+    {
+        buffersize = io_alignment;
+    }
+
+    last.method = "readahead";
+}
+
+bool StreamHash::hash_uring(const char *path, Hash &hash, bool &ok)
+{
+#if defined(CRYPTLIB_IO_URING)
+    // Bypass the page cache where the file system allows
+    bool direct = true;
+    int fd = open(path, O_RDONLY | O_DIRECT);
+    if (fd < 0)
+    {
+        direct = false;
+        fd = open(path, O_RDONLY);
+    }
+
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+
+        return false;
+    }
+
+    Uring ring;
+    if (!ring.open(static_cast<unsigned>(depth)))
+    {
+        close(fd);
+        return false;
+    }
+
+    std::vector<uint8_t> storage(depth * buffersize + io_alignment);
+    std::vector<UringSlot> slots(depth);
+    for (size_t i = 0U; i < depth; ++i)
+    {
+        slots[i].buffer = align_buffer(storage) + i * buffersize;
+    }
+
+    const uint64_t size = static_cast<uint64_t>(info.st_size);
+    uint64_t next = 0U;
+    size_t inflight = 0U;
+
+    // Queue a read of the rest of a slot's buffer. Reads ask for the whole
+    // aligned buffer; the last one comes back short at the end of the file.
+    auto queue = [&](size_t i)
+    {
+        UringSlot &slot = slots[i];
+        slot.iov.iov_base = slot.buffer + slot.filled;
+        slot.iov.iov_len = buffersize - slot.filled;
+        slot.direct = direct;
+        ring.read(fd, &slot.iov, slot.offset + slot.filled, i);
+        ++inflight;
+    };
+
+    // Start reading the next buffer of the file into a slot
+    auto start = [&](size_t i)
+    {
+        UringSlot &slot = slots[i];
+        slot.offset = next;
+        slot.size = static_cast<size_t>((size - next < buffersize) ? size - next : buffersize);
+        slot.filled = 0U;
+        slot.done = false;
+        next += buffersize;
+        queue(i);
+    };
+
+    for (size_t i = 0U; i < depth && next < size; ++i)
+    {
+        start(i);
+    }
+
+    ok = true;
+    uint64_t hashed = 0U;
+    for (size_t current = 0U; ok && hashed < size; current = (current + 1U) % depth)
+    {
+        // Wait for the next buffer in file order, recording any others
+        // that complete first
+        UringSlot &slot = slots[current];
+        while (ok && !slot.done)
+        {
+            ok = ring.submit(1U);
+            uint64_t tag;
+            int result;
+            while (ok && ring.reap(tag, result))
+            {
+                UringSlot &completed = slots[tag];
+                --inflight;
+                if (result == -EINVAL && completed.direct)
+                {
+                    // The file system rejected direct I/O; retry this read,
+                    // and any others already issued direct, buffered
+                    if (direct)
+                    {
+                        direct = false;
+                        ok = fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT) == 0;
+                    }
+
+                    if (ok)
+                    {
+                        queue(static_cast<size_t>(tag));
+                    }
+                }
+                else if (result < 0)
+                {
+                    ok = false;
+                }
+                else if (result == 0 || completed.filled + static_cast<size_t>(result) >= completed.size)
+                {
+                    // A read at the end of a file that shrank comes back empty
+                    completed.filled += static_cast<size_t>(result);
+                    completed.size = completed.filled < completed.size ? completed.filled : completed.size;
+                    completed.done = true;
+                }
+                else
+                {
+                    completed.filled += static_cast<size_t>(result);
+                    queue(static_cast<size_t>(tag));
+                }
+            }
+        }
+
+        if (!ok)
+        {
+            break;
+        }
+
+        // Hash the buffer, then reuse it for the next read
+        hash.add(slot.buffer, slot.size);
+        hashed += slot.size;
+        if (slot.offset + slot.size < size && slot.size < buffersize)
+        {
+            break;
+        }
+
+        if (next < size)
+        {
+            start(current);
+            ok = ring.submit(0U);
+        }
+    }
+
+    // Let every read still in flight land before its buffer is freed,
+    // submitting any still queued if the ring failed. Interrupted or busy
+    // waits are retried, reaping whatever completed in between.
+    while (inflight)
+    {
+        if (!ring.submit(1U) && errno != EAGAIN && errno != EBUSY)
+        {
+            // The kernel may still write to the buffers, so they cannot be
+            // freed; keep them and report the broken ring
+            int error = errno;
+            ring.close();
+            close(fd);
+            new std::vector<uint8_t>(std::move(storage));
+            throw std::system_error(error, std::generic_category(), "io_uring reads could not be drained");
+        }
+
+        uint64_t tag;
+        int result;
+        while (ring.reap(tag, result))
+        {
+            --inflight;
+        }
+    }
+
+    close(fd);
+    last.method = direct ? "io_uring+direct" : "io_uring";
+    last.bytes = hashed;
+    return true;
+#else
+    (void)path;
+    (void)hash;
+    (void)ok;
+    return false;
+#endif
+}
+
+bool StreamHash::hash_readahead(const char *path, Hash &hash)
+{
+    bool stdin_path = std::strcmp(path, "-") == 0;
+    std::FILE *file = stdin_path ? stdin : std::fopen(path, "rb");
+    if (!file)
+    {
+        return false;
+    }
+
+    // Read straight into the ring buffers, and tell the kernel the access
+    // is sequential so it reads ahead aggressively
+    if (!stdin_path)
+    {
+        std::setvbuf(file, nullptr, _IONBF, 0U);
+#if defined(CRYPTLIB_IO_URING)
+        posix_fadvise(fileno(file), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    }
+
+    std::vector<uint8_t> storage(depth * buffersize + io_alignment);
+    uint8_t *buffers = align_buffer(storage);
+    std::vector<size_t> lengths(depth);
+    std::mutex lock;
+    std::condition_variable changed;
+    size_t filled = 0U;
+    size_t consumed = 0U;
+    bool error = false;
+
+    // The reader fills buffers in order, at most depth ahead of the hash;
+    // an empty buffer marks the end of the file
+    std::thread reader([&]()
+    {
+        for (size_t i = 0U;; ++i)
+        {
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                changed.wait(guard, [&]() { return i - consumed < depth; });
+            }
+
+            uint8_t *buffer = buffers + (i % depth) * buffersize;
+            size_t length = std::fread(buffer, 1U, buffersize, file);
+
+            std::lock_guard<std::mutex> guard(lock);
+            lengths[i % depth] = length;
+            error = length == 0U && std::ferror(file);
+            filled = i + 1U;
+            changed.notify_all();
+            if (length == 0U)
+            {
+                return;
+            }
+        }
+    });
+
+    uint64_t bytes = 0U;
+    for (size_t i = 0U;; ++i)
+    {
+        size_t length;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            changed.wait(guard, [&]() { return filled > i; });
+            length = lengths[i % depth];
+        }
+
+        if (length == 0U)
+        {
+            break;
+        }
+
+        hash.add(buffers + (i % depth) * buffersize, length);
+        bytes += length;
+
+        std::lock_guard<std::mutex> guard(lock);
+        consumed = i + 1U;
+        changed.notify_all();
+    }
+
+    reader.join();
+    if (!stdin_path)
+    {
+        std::fclose(file);
+    }
+
+    last.method = "readahead";
+    last.bytes = bytes;
+    return !error;
+}
+
+bool StreamHash::hash(const char *path, Hash &hash, uint8_t *digest)
+{
+    auto start = std::chrono::steady_clock::now();
+    last.bytes = 0U;
+
+    // Pipes and other non-regular files always take the reader thread
+    bool ok = false;
+    hash.clear();
+    bool handled = method != readahead && std::strcmp(path, "-") != 0 && hash_uring(path, hash, ok);
+    if (!handled && method != io_uring)
+    {
+        hash.clear();
+        ok = hash_readahead(path, hash);
+    }
+
+    last.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (ok)
+    {
+        hash.close(digest);
+    }
+
+    return ok;
+}
+
+const StreamHash::Stats &StreamHash::stats() const
+{
+    return last;
+}
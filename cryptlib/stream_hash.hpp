@@ -0,0 +1,95 @@
+#pragma once
+
+#include "hash.hpp"
+
+/// Asynchronous streaming file hasher.
+/// Keeps several reads in flight while the hash consumes completed buffers
+/// in file order, so the disk and the processor are busy at the same time.
+/// On Linux the reads go through io_uring, with O_DIRECT where the file
+/// system supports it so the file does not churn the page cache. Where
+/// io_uring is unavailable (older kernels, seccomp filters, other systems)
+/// a reader thread fills a ring of buffers with sequential read-ahead.
+class StreamHash
+{
+public:
+    /// Read method.
+    enum Method
+    {
+        automatic,
+        io_uring,
+        readahead
+    };
+
+    /// Statistics of the last file hashed.
+    struct Stats
+    {
+        /// Method used ("io_uring", "io_uring+direct" or "readahead")
+        const char *method;
+
+        /// Bytes hashed
+        uint64_t bytes;
+
+        /// Elapsed time in seconds
+        double seconds;
+
+        /// Get the achieved throughput.
+        /// @return                     Throughput in MB/s
+        double rate() const
+        {
+            return seconds > 0.0 ? static_cast<double>(bytes) / seconds / 1e6 : 0.0;
+        }
+    };
+
+    /// Default number of reads in flight.
+    static const size_t default_depth = 4U;
+
+    /// Default read size.
+    static const size_t default_buffer_size = 1U << 20;
+
+private:
+    /// Number of reads in flight.
+    size_t depth;
+
+    /// Read size, a multiple of 4 KiB.
+    size_t buffersize;
+
+    /// Read method.
+    Method method;
+
+    /// Statistics of the last file hashed.
+    Stats last;
+
+    /// Hash a regular file through io_uring.
+    /// @param path                     File path
+    /// @param hash                     Cleared hash object to feed
+    /// @param ok                       Set to the success of the read
+    /// @return                         False if io_uring is unavailable, leaving the hash untouched
+    bool hash_uring(const char *path, Hash &hash, bool &ok);
+
+    /// Hash a file with a reader thread.
+    /// @param path                     File path ("-" for standard input)
+    /// @param hash                     Cleared hash object to feed
+    /// @return                         True on success
+    bool hash_readahead(const char *path, Hash &hash);
+
+public:
+    /// Constructor.
+    /// @param depth                    Number of reads in flight (0 is taken as 1; 2 or more
+    ///                                 overlaps reading with hashing)
+    /// @param buffer_size              Read size, rounded up to a multiple of 4 KiB
+    /// @param method                   Read method
+    explicit StreamHash(size_t depth = default_depth, size_t buffer_size = default_buffer_size, Method method = automatic);
+
+    /// Hash a single file.
+    /// @param path                     File path ("-" for standard input)
+    /// @param hash                     Hash object to use
+    /// @param digest                   Output buffer of hash.size() bytes
+    /// @return                         True on success
+    /// @throws std::system_error       If io_uring fails with reads in flight and cannot
+    ///                                 wait for them, so their buffers cannot be freed
+    bool hash(const char *path, Hash &hash, uint8_t *digest);
+
+    /// Get the statistics of the last file hashed.
+    /// @return                         Statistics
+    const Stats &stats() const;
+};
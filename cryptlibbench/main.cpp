@@ -0,0 +1,355 @@
+#include "blake3_hash.hpp"
+#include "md5_hash.hpp"
+#include "sha1_hash.hpp"
+#include "sha256_hash.hpp"
+#include "sha512_hash.hpp"
+#include "cpu_features.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#if defined(CRYPTLIB_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(CRYPTLIB_X86)
+#include <x86intrin.h>
+#endif
+
+// Number of heap allocations made by the process
+static std::atomic<uint64_t> allocations(0U);
+
+// Count heap allocations so the benchmarks can report allocations per digest
+void *operator new(size_t size)
+{
+    ++allocations;
+    if (void *ptr = std::malloc(size ? size : 1U))
+    {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+// Read the processor cycle counter
+static uint64_t cycles()
+{
+#if defined(CRYPTLIB_X86)
+    return __rdtsc();
+#else
+    return 0U;
+#endif
+}
+
+/// Benchmark measurement.
+struct Result
+{
+    /// Algorithm name
+    const char *algorithm;
+
+    /// Usage mode name
+    const char *mode;
+
+    /// Message size in bytes
+    size_t size;
+
+    /// Number of digests calculated
+    size_t iterations;
+
+    /// Elapsed time in seconds
+    double seconds;
+
+    /// Elapsed processor cycles (0 if unavailable)
+    uint64_t cycles;
+
+    /// Heap allocations made while measuring
+    uint64_t allocations;
+};
+
+/// Benchmark options.
+struct Options
+{
+    /// Output format ("text", "csv" or "json")
+    const char *format;
+
+    /// Largest message size to measure
+    size_t max_size;
+
+    /// Chunk size for the streaming mode
+    size_t chunk;
+
+    /// Bytes to hash per measurement
+    size_t work;
+};
+
+// Choose the number of digests for a measurement of the given message size
+static size_t iterations(const Options &options, size_t size)
+{
+    size_t count = options.work / (size < 64U ? 64U : size);
+    if (count < 1U)
+    {
+        return 1U;
+    }
+
+    return (count > (1U << 20)) ? (1U << 20) : count;
+}
+
+// Time a digest function over a number of iterations
+template <typename F>
+static Result measure(const char *algorithm, const char *mode, size_t size, size_t count, F digest)
+{
+    // Warm up caches and the backend selection
+    digest();
+
+    uint64_t allocs = allocations;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t ticks = cycles();
+
+    for (size_t i = 0U; i < count; ++i)
+    {
+        digest();
+    }
+
+    ticks = cycles() - ticks;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return Result{ algorithm, mode, size, count, seconds, ticks, allocations - allocs };
+}
+
+// Measure one algorithm across message sizes and usage modes
+template <typename H>
+static void bench(const char *name, const Options &options, const std::vector<uint8_t> &data, std::vector<Result> &results)
+{
+    static const size_t sizes[] =
+    {
+        0U, 1U, 64U, 256U, 1U << 10, 4U << 10, 64U << 10, 1U << 20, 16U << 20, 256U << 20, 1U << 30
+    };
+
+    H hash;
+    typename H::Digest digest;
+
+    for (size_t size : sizes)
+    {
+        if (size > options.max_size)
+        {
+            break;
+        }
+
+        size_t count = iterations(options, size);
+
+        // Hash the whole message with a single add() call
+        results.push_back(measure(name, "oneshot", size, count, [&]()
+        {
+            hash.clear();
+            hash.add(data.data(), size);
+            hash.close(digest);
+        }));
+
+        // Hash the message in chunks, as when reading from a stream
+        results.push_back(measure(name, "stream", size, count, [&]()
+        {
+            hash.clear();
+            for (size_t pos = 0U; pos < size; pos += options.chunk)
+            {
+                hash.add(data.data() + pos, (size - pos < options.chunk) ? size - pos : options.chunk);
+            }
+
+            hash.close(digest);
+        }));
+    }
+
+    // Hash messages with a 4 KiB shared header and a 256 byte body, with
+    // and without restoring a midstate snapshot of the absorbed header
+    if (options.max_size >= 4352U)
+    {
+        size_t count = iterations(options, 4352U);
+        results.push_back(measure(name, "prefix-rehash", 4352U, count, [&]()
+        {
+            hash.clear();
+            hash.add(data.data(), 4096U);
+            hash.add(data.data() + 4096U, 256U);
+            hash.close(digest);
+        }));
+
+        typename H::State state;
+        hash.clear();
+        hash.add(data.data(), 4096U);
+        hash.save(state);
+        results.push_back(measure(name, "prefix-snapshot", 4352U, count, [&]()
+        {
+            hash.restore(state);
+            hash.add(data.data() + 4096U, 256U);
+            hash.close(digest);
+        }));
+    }
+}
+
+// Print the results as aligned text
+static void print_text(const std::vector<Result> &results)
+{
+    for (const Result &result : results)
+    {
+        double bytes = static_cast<double>(result.size) * static_cast<double>(result.iterations);
+        double digests = static_cast<double>(result.iterations);
+
+        std::printf(
+            "%-8s %-16s %10zu bytes  %8.3f cycles/byte  %10.1f cycles/digest  %9.1f MB/s  %5.2f allocs/digest\n",
+            result.algorithm,
+            result.mode,
+            result.size,
+            bytes ? static_cast<double>(result.cycles) / bytes : 0.0,
+            static_cast<double>(result.cycles) / digests,
+            bytes / result.seconds / 1e6,
+            static_cast<double>(result.allocations) / digests);
+    }
+}
+
+// Print the results as CSV with a header row
+static void print_csv(const std::vector<Result> &results)
+{
+    std::printf("algorithm,mode,size,iterations,seconds,cycles,mb_per_s,cycles_per_byte,cycles_per_digest,allocs_per_digest\n");
+    for (const Result &result : results)
+    {
+        double bytes = static_cast<double>(result.size) * static_cast<double>(result.iterations);
+        double digests = static_cast<double>(result.iterations);
+
+        std::printf(
+            "%s,%s,%zu,%zu,%.9f,%llu,%.3f,%.4f,%.1f,%.3f\n",
+            result.algorithm,
+            result.mode,
+            result.size,
+            result.iterations,
+            result.seconds,
+            static_cast<unsigned long long>(result.cycles),
+            bytes / result.seconds / 1e6,
+            bytes ? static_cast<double>(result.cycles) / bytes : 0.0,
+            static_cast<double>(result.cycles) / digests,
+            static_cast<double>(result.allocations) / digests);
+    }
+}
+
+// Print the results as a JSON document
+static void print_json(const std::vector<Result> &results)
+{
+    std::printf(
+        "{\n  \"backend\": { \"sha256\": \"%s\", \"sha512\": \"%s\", \"blake3\": \"%s\" },\n  \"results\": [\n",
+        Sha256Hash::backend(),
+        Sha512Hash::backend(),
+        Blake3Hash::backend());
+    for (size_t i = 0U; i < results.size(); ++i)
+    {
+        const Result &result = results[i];
+        double bytes = static_cast<double>(result.size) * static_cast<double>(result.iterations);
+        double digests = static_cast<double>(result.iterations);
+
+        std::printf(
+            "    { \"algorithm\": \"%s\", \"mode\": \"%s\", \"size\": %zu, \"iterations\": %zu, \"seconds\": %.9f, "
+            "\"cycles\": %llu, \"mb_per_s\": %.3f, \"cycles_per_byte\": %.4f, \"cycles_per_digest\": %.1f, "
+            "\"allocs_per_digest\": %.3f }%s\n",
+            result.algorithm,
+            result.mode,
+            result.size,
+            result.iterations,
+            result.seconds,
+            static_cast<unsigned long long>(result.cycles),
+            bytes / result.seconds / 1e6,
+            bytes ? static_cast<double>(result.cycles) / bytes : 0.0,
+            static_cast<double>(result.cycles) / digests,
+            static_cast<double>(result.allocations) / digests,
+            (i + 1U < results.size()) ? "," : "");
+    }
+
+    std::printf("  ]\n}\n");
+}
+
+// Print the command line usage
+static int usage(const char *program)
+{
+    std::fprintf(
+        stderr,
+        "usage: %s [--format text|csv|json] [--max-size BYTES] [--chunk BYTES] [--work BYTES]\n",
+        program);
+    return 2;
+}
+
+int main(int argc, char *argv[])
+{
+    // Measure sizes up to 1 GiB, hashing at least 64 MiB per measurement
+    Options options = { "text", 1U << 30, 4096U, 64U << 20 };
+    for (int i = 1; i < argc; ++i)
+    {
+        if (i + 1 == argc)
+        {
+            return usage(argv[0]);
+        }
+
+        if (std::strcmp(argv[i], "--format") == 0)
+        {
+            options.format = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--max-size") == 0)
+        {
+            options.max_size = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 0));
+        }
+        else if (std::strcmp(argv[i], "--chunk") == 0)
+        {
+            options.chunk = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 0));
+        }
+        else if (std::strcmp(argv[i], "--work") == 0)
+        {
+            options.work = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 0));
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+
+    if (options.chunk == 0U ||
+        (std::strcmp(options.format, "text") != 0 &&
+         std::strcmp(options.format, "csv") != 0 &&
+         std::strcmp(options.format, "json") != 0))
+    {
+        return usage(argv[0]);
+    }
+
+    // Message data, large enough for the largest size and the prefix workload
+    std::vector<uint8_t> data((options.max_size > 4352U) ? options.max_size : 4352U);
+    for (size_t i = 0U; i < data.size(); ++i)
+    {
+        data[i] = static_cast<uint8_t>(i);
+    }
+
+    std::vector<Result> results;
+    bench<Md5Hash>("md5", options, data, results);
+    bench<Sha1Hash>("sha1", options, data, results);
+    bench<Sha256Hash>("sha256", options, data, results);
+    bench<Sha512Hash>("sha512", options, data, results);
+    bench<Blake3Hash>("blake3", options, data, results);
+
+    if (std::strcmp(options.format, "csv") == 0)
+    {
+        print_csv(results);
+    }
+    else if (std::strcmp(options.format, "json") == 0)
+    {
+        print_json(results);
+    }
+    else
+    {
+        print_text(results);
+    }
+
+    return 0;
+}
@@ -0,0 +1,237 @@
+#include "file_hash.hpp"
+#include "stream_hash.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Print the command line usage
+static int usage(const char *program)
+{
+    std::fprintf(
+        stderr,
+        "usage: %s [-a ALGORITHM] [-j THREADS | -s [-q DEPTH] [-b BYTES]] [FILE]...\n"
+        "       %s [-a ALGORITHM] [-j THREADS | -s [-q DEPTH] [-b BYTES]] -c [MANIFEST]...\n"
+        "Print or check checksums in sha256sum format. With no FILE, or when\n"
+        "FILE is -, read standard input. ALGORITHM is md5, sha1, sha256 (default),\n"
+        "sha384, sha512, sha512-256 or blake3.\n"
+        "With -s, files are hashed one at a time while DEPTH reads of BYTES each\n"
+        "are in flight (io_uring where available), and the throughput of each\n"
+        "file is reported on standard error.\n",
+        program,
+        program);
+    return 2;
+}
+
+// Read the entries of a manifest
+static bool read_manifest(const std::string &path, std::vector<FileHash::Entry> &entries, size_t &malformed)
+{
+    std::ifstream file;
+    std::istream *input = &std::cin;
+    if (path != "-")
+    {
+        file.open(path, std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+
+        input = &file;
+    }
+
+    std::string line;
+    while (std::getline(*input, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+
+        FileHash::Entry entry;
+        if (FileHash::parse(line, entry))
+        {
+            entries.push_back(entry);
+        }
+        else if (!line.empty())
+        {
+            ++malformed;
+        }
+    }
+
+    return true;
+}
+
+// Hash files one at a time through the asynchronous streaming pipeline
+static std::vector<FileHash::Result> stream_files(
+    const char *program,
+    const std::vector<std::string> &paths,
+    FileHash::Algorithm algorithm,
+    StreamHash &stream)
+{
+    std::unique_ptr<Hash> hash = FileHash::create(algorithm);
+    std::vector<uint8_t> digest(hash->size());
+    std::vector<FileHash::Result> results(paths.size());
+    for (size_t i = 0U; i < paths.size(); ++i)
+    {
+        results[i].path = paths[i];
+        if (!stream.hash(paths[i].c_str(), *hash, digest.data()))
+        {
+            continue;
+        }
+
+        results[i].digest = digest;
+        const StreamHash::Stats &stats = stream.stats();
+        std::fprintf(
+            stderr,
+            "%s: %s: %llu bytes in %.3f s, %.1f MB/s (%s)\n",
+            program,
+            paths[i].c_str(),
+            static_cast<unsigned long long>(stats.bytes),
+            stats.seconds,
+            stats.rate(),
+            stats.method);
+    }
+
+    return results;
+}
+
+int main(int argc, char *argv[])
+{
+    FileHash::Algorithm algorithm = FileHash::sha256;
+    unsigned threads = 0U;
+    bool check = false;
+    bool stream = false;
+    size_t depth = StreamHash::default_depth;
+    size_t buffer_size = StreamHash::default_buffer_size;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "-a") == 0 && i + 1 < argc)
+        {
+            if (!FileHash::parse(argv[++i], algorithm))
+            {
+                return usage(argv[0]);
+            }
+        }
+        else if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "-s") == 0)
+        {
+            stream = true;
+        }
+        else if (std::strcmp(argv[i], "-q") == 0 && i + 1 < argc)
+        {
+            depth = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+        {
+            buffer_size = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "-c") == 0)
+        {
+            check = true;
+        }
+        else if (std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "--help") == 0)
+        {
+            return usage(argv[0]);
+        }
+        else
+        {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    if (paths.empty())
+    {
+        paths.push_back("-");
+    }
+
+    StreamHash streamer(depth, buffer_size);
+    if (!check)
+    {
+        // Hash the files and print a manifest
+        int status = 0;
+        std::vector<FileHash::Result> results = stream ?
+            stream_files(argv[0], paths, algorithm, streamer) :
+            FileHash::hash(paths, algorithm, threads);
+        for (const FileHash::Result &result : results)
+        {
+            if (result.digest.empty())
+            {
+                std::fprintf(stderr, "%s: %s: cannot read file\n", argv[0], result.path.c_str());
+                status = 1;
+                continue;
+            }
+
+            std::fputs(FileHash::format(result).c_str(), stdout);
+        }
+
+        return status;
+    }
+
+    // Read the manifests
+    std::vector<FileHash::Entry> entries;
+    size_t malformed = 0U;
+    for (const std::string &path : paths)
+    {
+        if (!read_manifest(path, entries, malformed))
+        {
+            std::fprintf(stderr, "%s: %s: cannot read manifest\n", argv[0], path.c_str());
+            return 1;
+        }
+    }
+
+    // Hash the listed files and compare against the manifest
+    std::vector<std::string> files;
+    for (const FileHash::Entry &entry : entries)
+    {
+        files.push_back(entry.path);
+    }
+
+    size_t failed = 0U;
+    size_t unreadable = 0U;
+    std::vector<FileHash::Result> results = stream ?
+        stream_files(argv[0], files, algorithm, streamer) :
+        FileHash::hash(files, algorithm, threads);
+    for (size_t i = 0U; i < results.size(); ++i)
+    {
+        if (results[i].digest.empty())
+        {
+            std::printf("%s: FAILED open or read\n", entries[i].path.c_str());
+            ++unreadable;
+        }
+        else if (results[i].digest != entries[i].digest)
+        {
+            std::printf("%s: FAILED\n", entries[i].path.c_str());
+            ++failed;
+        }
+        else
+        {
+            std::printf("%s: OK\n", entries[i].path.c_str());
+        }
+    }
+
+    std::fflush(stdout);
+    if (malformed)
+    {
+        std::fprintf(stderr, "%s: WARNING: %zu lines are improperly formatted\n", argv[0], malformed);
+    }
+
+    if (unreadable)
+    {
+        std::fprintf(stderr, "%s: WARNING: %zu listed files could not be read\n", argv[0], unreadable);
+    }
+
+    if (failed)
+    {
+        std::fprintf(stderr, "%s: WARNING: %zu computed checksums did NOT match\n", argv[0], failed);
+    }
+
+    return (failed || unreadable || entries.empty()) ? 1 : 0;
+}
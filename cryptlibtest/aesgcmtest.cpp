@@ -0,0 +1,501 @@
+#include "CppUnitTest.h"
+#include "aes_gcm.hpp"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cryptlibtest
+{
+    // AES-GCM test vector
+    struct GcmVector
+    {
+        std::vector<uint8_t> key;
+        std::vector<uint8_t> iv;
+        std::vector<uint8_t> aad;
+        std::vector<uint8_t> plaintext;
+        std::vector<uint8_t> ciphertext;
+        std::vector<uint8_t> tag;
+    };
+
+    TEST_CLASS(AesGcmTest)
+    {
+    public:
+
+        TEST_METHOD(AesGcmNist)
+        {
+            // GCM specification test cases 1, 2, 4, 5, 6 and 16, covering empty
+            // messages, partial blocks, 64-bit and 480-bit IVs and AES-256
+            const GcmVector vectors[] = {
+                {
+                    {
+                        0x00U, 0x00U, 0x00U, 0x00U,
+                        0x00U, 0x00U, 0x00U, 0x00U,
+                        0x00U, 0x00U, 0x00U, 0x00U,
+                        0x00U, 0x00U, 0x00U, 0x00U
+                    },
+                    {
+                        0x00U, 0x00U, 0x00U, 0x00U,
+                        0x00U, 0x00U, 0x00U, 0x00U,
+                        0x00U, 0x00U, 0x00U, 0x00U
+                    },
+                    {},
+                    {},
+                    {},
+                    {
+                        0x58U, 0xe2U, 0xfcU, 0xceU,
+                        0xfaU, 0x7eU, 0x30U, 0x61U,
+                        0x36U, 0x7fU, 0x1dU, 0x57U,
+                        0xa4U, 0xe7U, 0x45U, 0x5aU
+                    }
+                },
+                {
+                    {
+                        0x00U, 0x00U, 0x00U, 0x00U,
+                        0x00U, 0x00U, 0x00U, 0x00U,
+                        0x00U, 0x00U, 0x00U, 0x00U,
+                        0x00U, 0x00U, 0x00U, 0x00U
+                    },
+                    {
+                        0x00U, 0x00U, 0x00U, 0x00U,
+                        0x00U, 0x00U, 0x00U, 0x00U,
+                        0x00U, 0x00U, 0x00U, 0x00U
+                    },
+                    {},
+                    {
+                        0x00U, 0x00U, 0x00U, 0x00U,
+                        0x00U, 0x00U, 0x00U, 0x00U,
+                        0x00U, 0x00U, 0x00U, 0x00U,
+                        0x00U, 0x00U, 0x00U, 0x00U
+                    },
+                    {
+                        0x03U, 0x88U, 0xdaU, 0xceU,
+                        0x60U, 0xb6U, 0xa3U, 0x92U,
+                        0xf3U, 0x28U, 0xc2U, 0xb9U,
+                        0x71U, 0xb2U, 0xfeU, 0x78U
+                    },
+                    {
+                        0xabU, 0x6eU, 0x47U, 0xd4U,
+                        0x2cU, 0xecU, 0x13U, 0xbdU,
+                        0xf5U, 0x3aU, 0x67U, 0xb2U,
+                        0x12U, 0x57U, 0xbdU, 0xdfU
+                    }
+                },
+                {
+                    {
+                        0xfeU, 0xffU, 0xe9U, 0x92U,
+                        0x86U, 0x65U, 0x73U, 0x1cU,
+                        0x6dU, 0x6aU, 0x8fU, 0x94U,
+                        0x67U, 0x30U, 0x83U, 0x08U
+                    },
+                    {
+                        0xcaU, 0xfeU, 0xbaU, 0xbeU,
+                        0xfaU, 0xceU, 0xdbU, 0xadU,
+                        0xdeU, 0xcaU, 0xf8U, 0x88U
+                    },
+                    {
+                        0xfeU, 0xedU, 0xfaU, 0xceU,
+                        0xdeU, 0xadU, 0xbeU, 0xefU,
+                        0xfeU, 0xedU, 0xfaU, 0xceU,
+                        0xdeU, 0xadU, 0xbeU, 0xefU,
+                        0xabU, 0xadU, 0xdaU, 0xd2U
+                    },
+                    {
+                        0xd9U, 0x31U, 0x32U, 0x25U,
+                        0xf8U, 0x84U, 0x06U, 0xe5U,
+                        0xa5U, 0x59U, 0x09U, 0xc5U,
+                        0xafU, 0xf5U, 0x26U, 0x9aU,
+                        0x86U, 0xa7U, 0xa9U, 0x53U,
+                        0x15U, 0x34U, 0xf7U, 0xdaU,
+                        0x2eU, 0x4cU, 0x30U, 0x3dU,
+                        0x8aU, 0x31U, 0x8aU, 0x72U,
+                        0x1cU, 0x3cU, 0x0cU, 0x95U,
+                        0x95U, 0x68U, 0x09U, 0x53U,
+                        0x2fU, 0xcfU, 0x0eU, 0x24U,
+                        0x49U, 0xa6U, 0xb5U, 0x25U,
+                        0xb1U, 0x6aU, 0xedU, 0xf5U,
+                        0xaaU, 0x0dU, 0xe6U, 0x57U,
+                        0xbaU, 0x63U, 0x7bU, 0x39U
+                    },
+                    {
+                        0x42U, 0x83U, 0x1eU, 0xc2U,
+                        0x21U, 0x77U, 0x74U, 0x24U,
+                        0x4bU, 0x72U, 0x21U, 0xb7U,
+                        0x84U, 0xd0U, 0xd4U, 0x9cU,
+                        0xe3U, 0xaaU, 0x21U, 0x2fU,
+                        0x2cU, 0x02U, 0xa4U, 0xe0U,
+                        0x35U, 0xc1U, 0x7eU, 0x23U,
+                        0x29U, 0xacU, 0xa1U, 0x2eU,
+                        0x21U, 0xd5U, 0x14U, 0xb2U,
+                        0x54U, 0x66U, 0x93U, 0x1cU,
+                        0x7dU, 0x8fU, 0x6aU, 0x5aU,
+                        0xacU, 0x84U, 0xaaU, 0x05U,
+                        0x1bU, 0xa3U, 0x0bU, 0x39U,
+                        0x6aU, 0x0aU, 0xacU, 0x97U,
+                        0x3dU, 0x58U, 0xe0U, 0x91U
+                    },
+                    {
+                        0x5bU, 0xc9U, 0x4fU, 0xbcU,
+                        0x32U, 0x21U, 0xa5U, 0xdbU,
+                        0x94U, 0xfaU, 0xe9U, 0x5aU,
+                        0xe7U, 0x12U, 0x1aU, 0x47U
+                    }
+                },
+                {
+                    {
+                        0xfeU, 0xffU, 0xe9U, 0x92U,
+                        0x86U, 0x65U, 0x73U, 0x1cU,
+                        0x6dU, 0x6aU, 0x8fU, 0x94U,
+                        0x67U, 0x30U, 0x83U, 0x08U
+                    },
+                    {
+                        0xcaU, 0xfeU, 0xbaU, 0xbeU,
+                        0xfaU, 0xceU, 0xdbU, 0xadU
+                    },
+                    {
+                        0xfeU, 0xedU, 0xfaU, 0xceU,
+                        0xdeU, 0xadU, 0xbeU, 0xefU,
+                        0xfeU, 0xedU, 0xfaU, 0xceU,
+                        0xdeU, 0xadU, 0xbeU, 0xefU,
+                        0xabU, 0xadU, 0xdaU, 0xd2U
+                    },
+                    {
+                        0xd9U, 0x31U, 0x32U, 0x25U,
+                        0xf8U, 0x84U, 0x06U, 0xe5U,
+                        0xa5U, 0x59U, 0x09U, 0xc5U,
+                        0xafU, 0xf5U, 0x26U, 0x9aU,
+                        0x86U, 0xa7U, 0xa9U, 0x53U,
+                        0x15U, 0x34U, 0xf7U, 0xdaU,
+                        0x2eU, 0x4cU, 0x30U, 0x3dU,
+                        0x8aU, 0x31U, 0x8aU, 0x72U,
+                        0x1cU, 0x3cU, 0x0cU, 0x95U,
+                        0x95U, 0x68U, 0x09U, 0x53U,
+                        0x2fU, 0xcfU, 0x0eU, 0x24U,
+                        0x49U, 0xa6U, 0xb5U, 0x25U,
+                        0xb1U, 0x6aU, 0xedU, 0xf5U,
+                        0xaaU, 0x0dU, 0xe6U, 0x57U,
+                        0xbaU, 0x63U, 0x7bU, 0x39U
+                    },
+                    {
+                        0x61U, 0x35U, 0x3bU, 0x4cU,
+                        0x28U, 0x06U, 0x93U, 0x4aU,
+                        0x77U, 0x7fU, 0xf5U, 0x1fU,
+                        0xa2U, 0x2aU, 0x47U, 0x55U,
+                        0x69U, 0x9bU, 0x2aU, 0x71U,
+                        0x4fU, 0xcdU, 0xc6U, 0xf8U,
+                        0x37U, 0x66U, 0xe5U, 0xf9U,
+                        0x7bU, 0x6cU, 0x74U, 0x23U,
+                        0x73U, 0x80U, 0x69U, 0x00U,
+                        0xe4U, 0x9fU, 0x24U, 0xb2U,
+                        0x2bU, 0x09U, 0x75U, 0x44U,
+                        0xd4U, 0x89U, 0x6bU, 0x42U,
+                        0x49U, 0x89U, 0xb5U, 0xe1U,
+                        0xebU, 0xacU, 0x0fU, 0x07U,
+                        0xc2U, 0x3fU, 0x45U, 0x98U
+                    },
+                    {
+                        0x36U, 0x12U, 0xd2U, 0xe7U,
+                        0x9eU, 0x3bU, 0x07U, 0x85U,
+                        0x56U, 0x1bU, 0xe1U, 0x4aU,
+                        0xacU, 0xa2U, 0xfcU, 0xcbU
+                    }
+                },
+                {
+                    {
+                        0xfeU, 0xffU, 0xe9U, 0x92U,
+                        0x86U, 0x65U, 0x73U, 0x1cU,
+                        0x6dU, 0x6aU, 0x8fU, 0x94U,
+                        0x67U, 0x30U, 0x83U, 0x08U
+                    },
+                    {
+                        0x93U, 0x13U, 0x22U, 0x5dU,
+                        0xf8U, 0x84U, 0x06U, 0xe5U,
+                        0x55U, 0x90U, 0x9cU, 0x5aU,
+                        0xffU, 0x52U, 0x69U, 0xaaU,
+                        0x6aU, 0x7aU, 0x95U, 0x38U,
+                        0x53U, 0x4fU, 0x7dU, 0xa1U,
+                        0xe4U, 0xc3U, 0x03U, 0xd2U,
+                        0xa3U, 0x18U, 0xa7U, 0x28U,
+                        0xc3U, 0xc0U, 0xc9U, 0x51U,
+                        0x56U, 0x80U, 0x95U, 0x39U,
+                        0xfcU, 0xf0U, 0xe2U, 0x42U,
+                        0x9aU, 0x6bU, 0x52U, 0x54U,
+                        0x16U, 0xaeU, 0xdbU, 0xf5U,
+                        0xa0U, 0xdeU, 0x6aU, 0x57U,
+                        0xa6U, 0x37U, 0xb3U, 0x9bU
+                    },
+                    {
+                        0xfeU, 0xedU, 0xfaU, 0xceU,
+                        0xdeU, 0xadU, 0xbeU, 0xefU,
+                        0xfeU, 0xedU, 0xfaU, 0xceU,
+                        0xdeU, 0xadU, 0xbeU, 0xefU,
+                        0xabU, 0xadU, 0xdaU, 0xd2U
+                    },
+                    {
+                        0xd9U, 0x31U, 0x32U, 0x25U,
+                        0xf8U, 0x84U, 0x06U, 0xe5U,
+                        0xa5U, 0x59U, 0x09U, 0xc5U,
+                        0xafU, 0xf5U, 0x26U, 0x9aU,
+                        0x86U, 0xa7U, 0xa9U, 0x53U,
+                        0x15U, 0x34U, 0xf7U, 0xdaU,
+                        0x2eU, 0x4cU, 0x30U, 0x3dU,
+                        0x8aU, 0x31U, 0x8aU, 0x72U,
+                        0x1cU, 0x3cU, 0x0cU, 0x95U,
+                        0x95U, 0x68U, 0x09U, 0x53U,
+                        0x2fU, 0xcfU, 0x0eU, 0x24U,
+                        0x49U, 0xa6U, 0xb5U, 0x25U,
+                        0xb1U, 0x6aU, 0xedU, 0xf5U,
+                        0xaaU, 0x0dU, 0xe6U, 0x57U,
+                        0xbaU, 0x63U, 0x7bU, 0x39U
+                    },
+                    {
+                        0x8cU, 0xe2U, 0x49U, 0x98U,
+                        0x62U, 0x56U, 0x15U, 0xb6U,
+                        0x03U, 0xa0U, 0x33U, 0xacU,
+                        0xa1U, 0x3fU, 0xb8U, 0x94U,
+                        0xbeU, 0x91U, 0x12U, 0xa5U,
+                        0xc3U, 0xa2U, 0x11U, 0xa8U,
+                        0xbaU, 0x26U, 0x2aU, 0x3cU,
+                        0xcaU, 0x7eU, 0x2cU, 0xa7U,
+                        0x01U, 0xe4U, 0xa9U, 0xa4U,
+                        0xfbU, 0xa4U, 0x3cU, 0x90U,
+                        0xccU, 0xdcU, 0xb2U, 0x81U,
+                        0xd4U, 0x8cU, 0x7cU, 0x6fU,
+                        0xd6U, 0x28U, 0x75U, 0xd2U,
+                        0xacU, 0xa4U, 0x17U, 0x03U,
+                        0x4cU, 0x34U, 0xaeU, 0xe5U
+                    },
+                    {
+                        0x61U, 0x9cU, 0xc5U, 0xaeU,
+                        0xffU, 0xfeU, 0x0bU, 0xfaU,
+                        0x46U, 0x2aU, 0xf4U, 0x3cU,
+                        0x16U, 0x99U, 0xd0U, 0x50U
+                    }
+                },
+                {
+                    {
+                        0xfeU, 0xffU, 0xe9U, 0x92U,
+                        0x86U, 0x65U, 0x73U, 0x1cU,
+                        0x6dU, 0x6aU, 0x8fU, 0x94U,
+                        0x67U, 0x30U, 0x83U, 0x08U,
+                        0xfeU, 0xffU, 0xe9U, 0x92U,
+                        0x86U, 0x65U, 0x73U, 0x1cU,
+                        0x6dU, 0x6aU, 0x8fU, 0x94U,
+                        0x67U, 0x30U, 0x83U, 0x08U
+                    },
+                    {
+                        0xcaU, 0xfeU, 0xbaU, 0xbeU,
+                        0xfaU, 0xceU, 0xdbU, 0xadU,
+                        0xdeU, 0xcaU, 0xf8U, 0x88U
+                    },
+                    {
+                        0xfeU, 0xedU, 0xfaU, 0xceU,
+                        0xdeU, 0xadU, 0xbeU, 0xefU,
+                        0xfeU, 0xedU, 0xfaU, 0xceU,
+                        0xdeU, 0xadU, 0xbeU, 0xefU,
+                        0xabU, 0xadU, 0xdaU, 0xd2U
+                    },
+                    {
+                        0xd9U, 0x31U, 0x32U, 0x25U,
+                        0xf8U, 0x84U, 0x06U, 0xe5U,
+                        0xa5U, 0x59U, 0x09U, 0xc5U,
+                        0xafU, 0xf5U, 0x26U, 0x9aU,
+                        0x86U, 0xa7U, 0xa9U, 0x53U,
+                        0x15U, 0x34U, 0xf7U, 0xdaU,
+                        0x2eU, 0x4cU, 0x30U, 0x3dU,
+                        0x8aU, 0x31U, 0x8aU, 0x72U,
+                        0x1cU, 0x3cU, 0x0cU, 0x95U,
+                        0x95U, 0x68U, 0x09U, 0x53U,
+                        0x2fU, 0xcfU, 0x0eU, 0x24U,
+                        0x49U, 0xa6U, 0xb5U, 0x25U,
+                        0xb1U, 0x6aU, 0xedU, 0xf5U,
+                        0xaaU, 0x0dU, 0xe6U, 0x57U,
+                        0xbaU, 0x63U, 0x7bU, 0x39U
+                    },
+                    {
+                        0x52U, 0x2dU, 0xc1U, 0xf0U,
+                        0x99U, 0x56U, 0x7dU, 0x07U,
+                        0xf4U, 0x7fU, 0x37U, 0xa3U,
+                        0x2aU, 0x84U, 0x42U, 0x7dU,
+                        0x64U, 0x3aU, 0x8cU, 0xdcU,
+                        0xbfU, 0xe5U, 0xc0U, 0xc9U,
+                        0x75U, 0x98U, 0xa2U, 0xbdU,
+                        0x25U, 0x55U, 0xd1U, 0xaaU,
+                        0x8cU, 0xb0U, 0x8eU, 0x48U,
+                        0x59U, 0x0dU, 0xbbU, 0x3dU,
+                        0xa7U, 0xb0U, 0x8bU, 0x10U,
+                        0x56U, 0x82U, 0x88U, 0x38U,
+                        0xc5U, 0xf6U, 0x1eU, 0x63U,
+                        0x93U, 0xbaU, 0x7aU, 0x0aU,
+                        0xbcU, 0xc9U, 0xf6U, 0x62U
+                    },
+                    {
+                        0x76U, 0xfcU, 0x6eU, 0xceU,
+                        0x0fU, 0x4eU, 0x17U, 0x68U,
+                        0xcdU, 0xdfU, 0x88U, 0x53U,
+                        0xbbU, 0x2dU, 0x55U, 0x1bU
+                    }
+                }
+            };
+
+            for (const GcmVector &v : vectors)
+            {
+                AesGcm gcm(v.key.data(), v.key.size());
+                std::vector<uint8_t> output(v.plaintext.size());
+                std::vector<uint8_t> tag(16U);
+                gcm.seal(v.iv.data(), v.iv.size(), v.aad.data(), v.aad.size(), v.plaintext.data(), output.data(), output.size(), tag.data());
+                Assert::IsTrue(output == v.ciphertext);
+                Assert::IsTrue(tag == v.tag);
+
+                Assert::IsTrue(gcm.open(v.iv.data(), v.iv.size(), v.aad.data(), v.aad.size(), v.ciphertext.data(), output.data(), output.size(), v.tag.data()));
+                Assert::IsTrue(output == v.plaintext);
+            }
+        }
+
+        TEST_METHOD(AesGcmStreaming)
+        {
+            // Long messages in uneven pieces must match the one-shot result,
+            // exercising the stitched eight-block path and partial blocks
+            uint8_t key[16];
+            uint8_t iv[12];
+            for (size_t i = 0U; i < sizeof(key); ++i)
+            {
+                key[i] = static_cast<uint8_t>(i * 17U + 3U);
+            }
+
+            for (size_t i = 0U; i < sizeof(iv); ++i)
+            {
+                iv[i] = static_cast<uint8_t>(i * 5U);
+            }
+
+            std::vector<uint8_t> aad(77U);
+            std::vector<uint8_t> data(16U * 41U + 9U);
+            for (size_t i = 0U; i < aad.size(); ++i)
+            {
+                aad[i] = static_cast<uint8_t>(i * 3U);
+            }
+
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 7U + 1U);
+            }
+
+            AesGcm gcm(key, sizeof(key));
+            std::vector<uint8_t> whole(data.size());
+            uint8_t tag[16];
+            gcm.seal(iv, sizeof(iv), aad.data(), aad.size(), data.data(), whole.data(), whole.size(), tag);
+
+            const size_t pieces[] = { 1U, 15U, 3U, 130U, 16U, 200U, 7U };
+            gcm.start(iv, sizeof(iv));
+            gcm.add_aad(aad.data(), 5U);
+            gcm.add_aad(aad.data() + 5U, aad.size() - 5U);
+
+            std::vector<uint8_t> streamed(data.size());
+            size_t offset = 0U;
+            for (size_t i = 0U; offset < data.size(); i = (i + 1U) % 7U)
+            {
+                size_t size = (pieces[i] < data.size() - offset) ? pieces[i] : data.size() - offset;
+                gcm.encrypt(data.data() + offset, streamed.data() + offset, size);
+                offset += size;
+            }
+
+            uint8_t streamed_tag[16];
+            gcm.finish(streamed_tag);
+            Assert::IsTrue(streamed == whole);
+            Assert::IsTrue(std::vector<uint8_t>(tag, tag + 16) == std::vector<uint8_t>(streamed_tag, streamed_tag + 16));
+
+            // Decrypt in place, in two pieces
+            gcm.start(iv, sizeof(iv));
+            gcm.add_aad(aad.data(), aad.size());
+            gcm.decrypt(streamed.data(), streamed.data(), 100U);
+            gcm.decrypt(streamed.data() + 100U, streamed.data() + 100U, streamed.size() - 100U);
+            Assert::IsTrue(gcm.verify(tag));
+            Assert::IsTrue(streamed == data);
+        }
+
+        TEST_METHOD(AesGcmTamper)
+        {
+            uint8_t key[32] = {};
+            uint8_t iv[12] = {};
+            std::vector<uint8_t> data(300U, 0x5aU);
+            std::vector<uint8_t> sealed(data.size());
+            uint8_t tag[16];
+
+            AesGcm gcm(key, sizeof(key));
+            gcm.seal(iv, sizeof(iv), "header", 6U, data.data(), sealed.data(), sealed.size(), tag);
+
+            // A flipped ciphertext bit fails and the output is wiped
+            std::vector<uint8_t> output(data.size(), 0xffU);
+            sealed[123] ^= 0x10U;
+            Assert::IsFalse(gcm.open(iv, sizeof(iv), "header", 6U, sealed.data(), output.data(), output.size(), tag));
+            Assert::IsTrue(output == std::vector<uint8_t>(data.size(), 0U));
+            sealed[123] ^= 0x10U;
+
+            // So do changed AAD and a changed tag
+            Assert::IsFalse(gcm.open(iv, sizeof(iv), "Header", 6U, sealed.data(), output.data(), output.size(), tag));
+            tag[15] ^= 0x01U;
+            Assert::IsFalse(gcm.open(iv, sizeof(iv), "header", 6U, sealed.data(), output.data(), output.size(), tag));
+            tag[15] ^= 0x01U;
+            Assert::IsTrue(gcm.open(iv, sizeof(iv), "header", 6U, sealed.data(), output.data(), output.size(), tag));
+            Assert::IsTrue(output == data);
+
+            // A truncated tag of 12 bytes is accepted, a shorter one is refused
+            gcm.start(iv, sizeof(iv));
+            gcm.add_aad("header", 6U);
+            gcm.decrypt(sealed.data(), output.data(), output.size());
+            Assert::IsTrue(gcm.verify(tag, 12U));
+
+            bool thrown = false;
+            gcm.start(iv, sizeof(iv));
+            try
+            {
+                gcm.verify(tag, 1U);
+            }
+            catch (const std::invalid_argument &)
+            {
+                thrown = true;
+            }
+
+            Assert::IsTrue(thrown);
+
+            // AAD after the text would not match the GCM construction
+            thrown = false;
+            gcm.start(iv, sizeof(iv));
+            gcm.add_aad("ab", 2U);
+            gcm.encrypt(data.data(), output.data(), 20U);
+            try
+            {
+                gcm.add_aad("cd", 2U);
+            }
+            catch (const std::logic_error &)
+            {
+                thrown = true;
+            }
+
+            Assert::IsTrue(thrown);
+
+            // Text past 2^32 - 2 blocks would wrap the counter back to J0; the
+            // size is refused before any data is read
+            if (sizeof(size_t) > 4U)
+            {
+                thrown = false;
+                gcm.start(iv, sizeof(iv));
+                gcm.encrypt(data.data(), output.data(), 32U);
+                try
+                {
+                    gcm.encrypt(nullptr, nullptr, static_cast<size_t>(16ULL * 0xfffffffeULL - 31U));
+                }
+                catch (const std::invalid_argument &)
+                {
+                    thrown = true;
+                }
+
+                Assert::IsTrue(thrown);
+            }
+
+            std::string backend = AesGcm::backend();
+            Assert::IsTrue(backend == "aes-ni+pclmul" || backend == "portable");
+        }
+    };
+}
@@ -0,0 +1,290 @@
+#include "CppUnitTest.h"
+#include "aes.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cryptlibtest
+{
+    TEST_CLASS(AesTest)
+    {
+    public:
+
+        TEST_METHOD(AesFips197)
+        {
+            uint8_t key[32];
+            for (size_t i = 0U; i < sizeof(key); ++i)
+            {
+                key[i] = static_cast<uint8_t>(i);
+            }
+
+            const uint8_t plaintext[16] = {
+                0x00U, 0x11U, 0x22U, 0x33U,
+                0x44U, 0x55U, 0x66U, 0x77U,
+                0x88U, 0x99U, 0xaaU, 0xbbU,
+                0xccU, 0xddU, 0xeeU, 0xffU
+            };
+
+            const uint8_t expected[3][16] = {
+                {
+                    0x69U, 0xc4U, 0xe0U, 0xd8U,
+                    0x6aU, 0x7bU, 0x04U, 0x30U,
+                    0xd8U, 0xcdU, 0xb7U, 0x80U,
+                    0x70U, 0xb4U, 0xc5U, 0x5aU
+                },
+                {
+                    0xddU, 0xa9U, 0x7cU, 0xa4U,
+                    0x86U, 0x4cU, 0xdfU, 0xe0U,
+                    0x6eU, 0xafU, 0x70U, 0xa0U,
+                    0xecU, 0x0dU, 0x71U, 0x91U
+                },
+                {
+                    0x8eU, 0xa2U, 0xb7U, 0xcaU,
+                    0x51U, 0x67U, 0x45U, 0xbfU,
+                    0xeaU, 0xfcU, 0x49U, 0x90U,
+                    0x4bU, 0x49U, 0x60U, 0x89U
+                }
+            };
+
+            for (size_t i = 0U; i < 3U; ++i)
+            {
+                Aes aes(key, 16U + 8U * i);
+                uint8_t block[16];
+                aes.encrypt(plaintext, block, 1U);
+                Assert::IsTrue(std::memcmp(block, expected[i], 16U) == 0);
+                aes.decrypt(block, block, 1U);
+                Assert::IsTrue(std::memcmp(block, plaintext, 16U) == 0);
+            }
+        }
+
+        TEST_METHOD(AesCbc)
+        {
+            // SP 800-38A F.2.1 and F.2.2
+            const uint8_t key[16] = {
+                0x2bU, 0x7eU, 0x15U, 0x16U,
+                0x28U, 0xaeU, 0xd2U, 0xa6U,
+                0xabU, 0xf7U, 0x15U, 0x88U,
+                0x09U, 0xcfU, 0x4fU, 0x3cU
+            };
+
+            const uint8_t plaintext[64] = {
+                0x6bU, 0xc1U, 0xbeU, 0xe2U,
+                0x2eU, 0x40U, 0x9fU, 0x96U,
+                0xe9U, 0x3dU, 0x7eU, 0x11U,
+                0x73U, 0x93U, 0x17U, 0x2aU,
+                0xaeU, 0x2dU, 0x8aU, 0x57U,
+                0x1eU, 0x03U, 0xacU, 0x9cU,
+                0x9eU, 0xb7U, 0x6fU, 0xacU,
+                0x45U, 0xafU, 0x8eU, 0x51U,
+                0x30U, 0xc8U, 0x1cU, 0x46U,
+                0xa3U, 0x5cU, 0xe4U, 0x11U,
+                0xe5U, 0xfbU, 0xc1U, 0x19U,
+                0x1aU, 0x0aU, 0x52U, 0xefU,
+                0xf6U, 0x9fU, 0x24U, 0x45U,
+                0xdfU, 0x4fU, 0x9bU, 0x17U,
+                0xadU, 0x2bU, 0x41U, 0x7bU,
+                0xe6U, 0x6cU, 0x37U, 0x10U
+            };
+
+            const uint8_t expected[64] = {
+                0x76U, 0x49U, 0xabU, 0xacU,
+                0x81U, 0x19U, 0xb2U, 0x46U,
+                0xceU, 0xe9U, 0x8eU, 0x9bU,
+                0x12U, 0xe9U, 0x19U, 0x7dU,
+                0x50U, 0x86U, 0xcbU, 0x9bU,
+                0x50U, 0x72U, 0x19U, 0xeeU,
+                0x95U, 0xdbU, 0x11U, 0x3aU,
+                0x91U, 0x76U, 0x78U, 0xb2U,
+                0x73U, 0xbeU, 0xd6U, 0xb8U,
+                0xe3U, 0xc1U, 0x74U, 0x3bU,
+                0x71U, 0x16U, 0xe6U, 0x9eU,
+                0x22U, 0x22U, 0x95U, 0x16U,
+                0x3fU, 0xf1U, 0xcaU, 0xa1U,
+                0x68U, 0x1fU, 0xacU, 0x09U,
+                0x12U, 0x0eU, 0xcaU, 0x30U,
+                0x75U, 0x86U, 0xe1U, 0xa7U
+            };
+
+            Aes aes(key, sizeof(key));
+            uint8_t iv[16];
+            uint8_t buffer[64];
+
+            // Encrypt in two calls to exercise the IV chaining
+            for (size_t i = 0U; i < 16U; ++i)
+            {
+                iv[i] = static_cast<uint8_t>(i);
+            }
+
+            aes.cbc_encrypt(iv, plaintext, buffer, 1U);
+            aes.cbc_encrypt(iv, plaintext + 16U, buffer + 16U, 3U);
+            Assert::IsTrue(std::memcmp(buffer, expected, sizeof(expected)) == 0);
+
+            // Decrypt in place
+            for (size_t i = 0U; i < 16U; ++i)
+            {
+                iv[i] = static_cast<uint8_t>(i);
+            }
+
+            aes.cbc_decrypt(iv, buffer, buffer, 4U);
+            Assert::IsTrue(std::memcmp(buffer, plaintext, sizeof(plaintext)) == 0);
+            Assert::IsTrue(std::memcmp(iv, expected + 48U, 16U) == 0);
+        }
+
+        TEST_METHOD(AesCtr)
+        {
+            // SP 800-38A F.5.1
+            const uint8_t key[16] = {
+                0x2bU, 0x7eU, 0x15U, 0x16U,
+                0x28U, 0xaeU, 0xd2U, 0xa6U,
+                0xabU, 0xf7U, 0x15U, 0x88U,
+                0x09U, 0xcfU, 0x4fU, 0x3cU
+            };
+
+            const uint8_t plaintext[64] = {
+                0x6bU, 0xc1U, 0xbeU, 0xe2U,
+                0x2eU, 0x40U, 0x9fU, 0x96U,
+                0xe9U, 0x3dU, 0x7eU, 0x11U,
+                0x73U, 0x93U, 0x17U, 0x2aU,
+                0xaeU, 0x2dU, 0x8aU, 0x57U,
+                0x1eU, 0x03U, 0xacU, 0x9cU,
+                0x9eU, 0xb7U, 0x6fU, 0xacU,
+                0x45U, 0xafU, 0x8eU, 0x51U,
+                0x30U, 0xc8U, 0x1cU, 0x46U,
+                0xa3U, 0x5cU, 0xe4U, 0x11U,
+                0xe5U, 0xfbU, 0xc1U, 0x19U,
+                0x1aU, 0x0aU, 0x52U, 0xefU,
+                0xf6U, 0x9fU, 0x24U, 0x45U,
+                0xdfU, 0x4fU, 0x9bU, 0x17U,
+                0xadU, 0x2bU, 0x41U, 0x7bU,
+                0xe6U, 0x6cU, 0x37U, 0x10U
+            };
+
+            const uint8_t expected[64] = {
+                0x87U, 0x4dU, 0x61U, 0x91U,
+                0xb6U, 0x20U, 0xe3U, 0x26U,
+                0x1bU, 0xefU, 0x68U, 0x64U,
+                0x99U, 0x0dU, 0xb6U, 0xceU,
+                0x98U, 0x06U, 0xf6U, 0x6bU,
+                0x79U, 0x70U, 0xfdU, 0xffU,
+                0x86U, 0x17U, 0x18U, 0x7bU,
+                0xb9U, 0xffU, 0xfdU, 0xffU,
+                0x5aU, 0xe4U, 0xdfU, 0x3eU,
+                0xdbU, 0xd5U, 0xd3U, 0x5eU,
+                0x5bU, 0x4fU, 0x09U, 0x02U,
+                0x0dU, 0xb0U, 0x3eU, 0xabU,
+                0x1eU, 0x03U, 0x1dU, 0xdaU,
+                0x2fU, 0xbeU, 0x03U, 0xd1U,
+                0x79U, 0x21U, 0x70U, 0xa0U,
+                0xf3U, 0x00U, 0x9cU, 0xeeU
+            };
+
+            Aes aes(key, sizeof(key));
+            uint8_t counter[16];
+            for (size_t i = 0U; i < 16U; ++i)
+            {
+                counter[i] = static_cast<uint8_t>(0xf0U + i);
+            }
+
+            uint8_t buffer[64];
+            aes.ctr(counter, plaintext, buffer, sizeof(plaintext));
+            Assert::IsTrue(std::memcmp(buffer, expected, sizeof(expected)) == 0);
+            Assert::IsTrue(counter[15] == 0x03U && counter[14] == 0xffU);
+        }
+
+        TEST_METHOD(AesCtrStreaming)
+        {
+            // A long message in one call must match block-by-block calls,
+            // including the carry out of the low 64 counter bits
+            uint8_t key[32];
+            for (size_t i = 0U; i < sizeof(key); ++i)
+            {
+                key[i] = static_cast<uint8_t>(i * 13U + 1U);
+            }
+
+            Aes aes(key, sizeof(key));
+            std::vector<uint8_t> data(16U * 37U + 5U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 7U);
+            }
+
+            uint8_t start[16] = {};
+            std::memset(start + 8U, 0xffU, 8U);
+            start[15] = 0xf0U;
+
+            uint8_t counter[16];
+            std::memcpy(counter, start, sizeof(counter));
+            std::vector<uint8_t> whole(data.size());
+            aes.ctr(counter, data.data(), whole.data(), data.size());
+
+            // The counter advanced by 38 blocks, carrying into byte 7
+            Assert::IsTrue(counter[7] == 0x01U && counter[15] == 0x16U);
+
+            std::memcpy(counter, start, sizeof(counter));
+            std::vector<uint8_t> pieces(data);
+            for (size_t offset = 0U; offset < pieces.size(); offset += 16U)
+            {
+                size_t size = pieces.size() - offset < 16U ? pieces.size() - offset : 16U;
+                aes.ctr(counter, pieces.data() + offset, pieces.data() + offset, size);
+            }
+
+            Assert::IsTrue(pieces == whole);
+
+            // Decryption is the same operation
+            std::memcpy(counter, start, sizeof(counter));
+            aes.ctr(counter, whole.data(), whole.data(), whole.size());
+            Assert::IsTrue(whole == data);
+        }
+
+        TEST_METHOD(AesEcbMultiBlock)
+        {
+            // The pipelined path must agree with single block calls
+            uint8_t key[24];
+            for (size_t i = 0U; i < sizeof(key); ++i)
+            {
+                key[i] = static_cast<uint8_t>(0xa5U ^ i);
+            }
+
+            Aes aes(key, sizeof(key));
+            std::vector<uint8_t> data(16U * 21U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 31U);
+            }
+
+            std::vector<uint8_t> whole(data.size());
+            aes.encrypt(data.data(), whole.data(), 21U);
+            for (size_t i = 0U; i < 21U; ++i)
+            {
+                uint8_t block[16];
+                aes.encrypt(data.data() + 16U * i, block, 1U);
+                Assert::IsTrue(std::memcmp(block, whole.data() + 16U * i, 16U) == 0);
+            }
+
+            aes.decrypt(whole.data(), whole.data(), 21U);
+            Assert::IsTrue(whole == data);
+        }
+
+        TEST_METHOD(AesKeySize)
+        {
+            uint8_t key[20] = {};
+            bool thrown = false;
+            try
+            {
+                Aes aes(key, sizeof(key));
+            }
+            catch (const std::invalid_argument &)
+            {
+                thrown = true;
+            }
+
+            Assert::IsTrue(thrown);
+
+            std::string backend = Aes::backend();
+            Assert::IsTrue(backend == "aes-ni" || backend == "bitsliced");
+        }
+    };
+}
@@ -0,0 +1,196 @@
+#include "CppUnitTest.h"
+#include "blake3_hash.hpp"
+#include <algorithm>
+#include <cstring>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cryptlibtest
+{
+    TEST_CLASS(Blake3Test)
+    {
+    public:
+
+        // Input used by the BLAKE3 test vectors: bytes counting modulo 251
+        static std::vector<uint8_t> input(size_t size)
+        {
+            std::vector<uint8_t> data(size);
+            for (size_t i = 0U; i < size; ++i)
+            {
+                data[i] = static_cast<uint8_t>(i % 251U);
+            }
+
+            return data;
+        }
+
+        TEST_METHOD(Blake3TestEmpty)
+        {
+            Blake3Hash hash;
+            auto digest = hash.close();
+
+            const std::vector<uint8_t> expected = {
+                0xafU, 0x13U, 0x49U, 0xb9U,
+                0xf5U, 0xf9U, 0xa1U, 0xa6U,
+                0xa0U, 0x40U, 0x4dU, 0xeaU,
+                0x36U, 0xdcU, 0xc9U, 0x49U,
+                0x9bU, 0xcbU, 0x25U, 0xc9U,
+                0xadU, 0xc1U, 0x12U, 0xb7U,
+                0xccU, 0x9aU, 0x93U, 0xcaU,
+                0xe4U, 0x1fU, 0x32U, 0x62U
+            };
+
+            Assert::IsTrue(expected == digest);
+        }
+
+        TEST_METHOD(Blake3TwoChunks)
+        {
+            auto data = input(1025U);
+            Blake3Hash hash;
+            hash.add(data.data(), data.size());
+            auto digest = hash.close();
+
+            const std::vector<uint8_t> expected = {
+                0xd0U, 0x02U, 0x78U, 0xaeU,
+                0x47U, 0xebU, 0x27U, 0xb3U,
+                0x4fU, 0xaeU, 0xcfU, 0x67U,
+                0xb4U, 0xfeU, 0x26U, 0x3fU,
+                0x82U, 0xd5U, 0x41U, 0x29U,
+                0x16U, 0xc1U, 0xffU, 0xd9U,
+                0x7cU, 0x8cU, 0xb7U, 0xfbU,
+                0x81U, 0x4bU, 0x84U, 0x44U
+            };
+
+            Assert::IsTrue(expected == digest);
+        }
+
+        TEST_METHOD(Blake3Tree)
+        {
+            // 100 chunks fill every lane width and leave a ragged tree
+            auto data = input(102400U);
+            Blake3Hash hash;
+            hash.add(data.data(), data.size());
+            auto digest = hash.close();
+
+            const std::vector<uint8_t> expected = {
+                0xbcU, 0x3eU, 0x3dU, 0x41U,
+                0xa1U, 0x14U, 0x6bU, 0x06U,
+                0x9aU, 0xbfU, 0xfaU, 0xd3U,
+                0xc0U, 0xd4U, 0x48U, 0x60U,
+                0xcfU, 0x66U, 0x43U, 0x90U,
+                0xafU, 0xceU, 0x4dU, 0x96U,
+                0x61U, 0xf7U, 0x90U, 0x2eU,
+                0x79U, 0x43U, 0xe0U, 0x85U
+            };
+
+            Assert::IsTrue(expected == digest);
+        }
+
+        TEST_METHOD(Blake3Xof)
+        {
+            auto data = input(1023U);
+            Blake3Hash hash;
+            hash.add(data.data(), data.size());
+            std::vector<uint8_t> output(80U);
+            hash.close(output.data(), output.size());
+
+            const std::vector<uint8_t> expected = {
+                0x10U, 0x10U, 0x89U, 0x70U,
+                0xeeU, 0xdaU, 0x3eU, 0xb9U,
+                0x32U, 0xbaU, 0xacU, 0x14U,
+                0x28U, 0xc7U, 0xa2U, 0x16U,
+                0x3bU, 0x0eU, 0x92U, 0x4cU,
+                0x9aU, 0x9eU, 0x25U, 0xb3U,
+                0x5bU, 0xbaU, 0x72U, 0xb2U,
+                0x8fU, 0x70U, 0xbdU, 0x11U,
+                0xa1U, 0x82U, 0xd2U, 0x7aU,
+                0x59U, 0x1bU, 0x05U, 0x59U,
+                0x2bU, 0x15U, 0x60U, 0x75U,
+                0x00U, 0xe1U, 0xe8U, 0xddU,
+                0x56U, 0xbcU, 0x6cU, 0x7fU,
+                0xc0U, 0x63U, 0x71U, 0x5bU,
+                0x7aU, 0x1dU, 0x73U, 0x7dU,
+                0xf5U, 0xbaU, 0xd3U, 0x33U,
+                0x9cU, 0x56U, 0x77U, 0x89U,
+                0x57U, 0xd8U, 0x70U, 0xebU,
+                0x97U, 0x17U, 0xb5U, 0x7eU,
+                0xa3U, 0xd9U, 0xfbU, 0x68U
+            };
+
+            Assert::IsTrue(expected == output);
+
+            // The digest is a prefix of the output, and the output can be
+            // read from any offset
+            Assert::IsTrue(std::equal(output.begin(), output.begin() + 32, hash.close().begin()));
+            std::vector<uint8_t> tail(21U);
+            hash.close(tail.data(), tail.size(), 59U);
+            Assert::IsTrue(std::equal(tail.begin(), tail.end(), output.begin() + 59));
+        }
+
+        TEST_METHOD(Blake3Chunked)
+        {
+            auto data = input(40000U);
+
+            // Add in pieces that straddle block, chunk and subtree boundaries
+            static const size_t chunks[] = { 1U, 63U, 1024U, 4096U, 1000U, 9000U };
+            for (size_t size = 0U; size <= data.size(); size += 2500U)
+            {
+                Blake3Hash hash;
+                for (size_t pos = 0U, i = 0U; pos < size; ++i)
+                {
+                    size_t part = std::min(chunks[i % 6U], size - pos);
+                    hash.add(data.data() + pos, part);
+                    pos += part;
+                }
+
+                Blake3Hash whole;
+                whole.add(data.data(), size);
+                Assert::IsTrue(whole.close() == hash.close());
+            }
+        }
+
+        TEST_METHOD(Blake3Threads)
+        {
+            auto data = input((3U << 20) + 17U);
+
+            Blake3Hash serial;
+            serial.add(data.data(), data.size());
+
+            Blake3Hash parallel(4U);
+            parallel.add(data.data(), data.size());
+            Assert::IsTrue(serial.close() == parallel.close());
+        }
+
+        TEST_METHOD(Blake3Backend)
+        {
+            const char *backend = Blake3Hash::backend();
+
+            Assert::IsTrue(
+                std::strcmp(backend, "avx512") == 0 ||
+                std::strcmp(backend, "avx2") == 0 ||
+                std::strcmp(backend, "sse4.1") == 0 ||
+                std::strcmp(backend, "portable") == 0);
+        }
+
+        TEST_METHOD(Blake3Snapshot)
+        {
+            auto data = input(10000U);
+
+            // Absorb a prefix that ends mid-chunk and fork from its midstate
+            Blake3Hash hash;
+            hash.add(data.data(), 1500U);
+            Blake3Hash::State state;
+            hash.save(state);
+
+            for (size_t size = 1500U; size <= data.size(); size += 2000U)
+            {
+                hash.restore(state);
+                hash.add(data.data() + 1500U, size - 1500U);
+                auto forked = hash.close();
+
+                Blake3Hash full;
+                full.add(data.data(), size);
+                Assert::IsTrue(full.close() == forked);
+            }
+        }
+    };
+}
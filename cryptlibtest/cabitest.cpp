@@ -0,0 +1,108 @@
+#include "CppUnitTest.h"
+#include "md5.h"
+#include "sha1.h"
+#include "sha256.h"
+#include <cstring>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cryptlibtest
+{
+    TEST_CLASS(CAbiTest)
+    {
+    public:
+
+        TEST_METHOD(CAbiContextLayout)
+        {
+            Assert::AreEqual(sizeof(MD5Context), MD5ContextSize());
+            Assert::AreEqual(alignof(MD5Context), MD5ContextAlign());
+            Assert::AreEqual(sizeof(SHA1Context), SHA1ContextSize());
+            Assert::AreEqual(alignof(SHA1Context), SHA1ContextAlign());
+            Assert::AreEqual(sizeof(SHA256Context), SHA256ContextSize());
+            Assert::AreEqual(alignof(SHA256Context), SHA256ContextAlign());
+        }
+
+        TEST_METHOD(CAbiMd5Streaming)
+        {
+            // Add in pieces through a stack context
+            MD5Context context;
+            MD5Init(&context);
+            MD5Add(&context, "The quick brown fox ", 20U);
+            MD5Add(&context, "jumps over the lazy dog", 23U);
+            uint8_t digest[MD5_DIGEST_SIZE];
+            MD5Close(&context, digest);
+
+            const uint8_t expected[MD5_DIGEST_SIZE] = {
+                0x9eU, 0x10U, 0x7dU, 0x9dU,
+                0x37U, 0x2bU, 0xb6U, 0x82U,
+                0x6bU, 0xd8U, 0x1dU, 0x35U,
+                0x42U, 0xa4U, 0x19U, 0xd6U
+            };
+
+            Assert::IsTrue(std::memcmp(digest, expected, sizeof(expected)) == 0);
+
+            // The context is reusable after another init
+            MD5Init(&context);
+            MD5Add(&context, "The quick brown fox jumps over the lazy dog", 43U);
+            MD5Close(&context, digest);
+            Assert::IsTrue(std::memcmp(digest, expected, sizeof(expected)) == 0);
+        }
+
+        TEST_METHOD(CAbiSha1OneShot)
+        {
+            uint8_t digest[SHA1_DIGEST_SIZE];
+            SHA1Hash("The quick brown fox jumps over the lazy dog", 43U, digest);
+
+            const uint8_t expected[SHA1_DIGEST_SIZE] = {
+                0x2fU, 0xd4U, 0xe1U, 0xc6U,
+                0x7aU, 0x2dU, 0x28U, 0xfcU,
+                0xedU, 0x84U, 0x9eU, 0xe1U,
+                0xbbU, 0x76U, 0xe7U, 0x39U,
+                0x1bU, 0x93U, 0xebU, 0x12U
+            };
+
+            Assert::IsTrue(std::memcmp(digest, expected, sizeof(expected)) == 0);
+        }
+
+        TEST_METHOD(CAbiBatch)
+        {
+            std::vector<uint8_t> data(1000U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 7U + 3U);
+            }
+
+            std::vector<HashData> messages;
+            for (size_t i = 0U; i < 19U; ++i)
+            {
+                messages.push_back({ data.data() + i, (i * 151U) % 900U });
+            }
+
+            // Each batch must match one-shot calls
+            std::vector<uint8_t> digests(messages.size() * SHA256_DIGEST_SIZE);
+            uint8_t digest[SHA256_DIGEST_SIZE];
+
+            MD5HashBatch(messages.data(), messages.size(), digests.data());
+            for (size_t i = 0U; i < messages.size(); ++i)
+            {
+                MD5Hash(messages[i].data, messages[i].size, digest);
+                Assert::IsTrue(std::memcmp(digest, digests.data() + i * MD5_DIGEST_SIZE, MD5_DIGEST_SIZE) == 0);
+            }
+
+            SHA1HashBatch(messages.data(), messages.size(), digests.data());
+            for (size_t i = 0U; i < messages.size(); ++i)
+            {
+                SHA1Hash(messages[i].data, messages[i].size, digest);
+                Assert::IsTrue(std::memcmp(digest, digests.data() + i * SHA1_DIGEST_SIZE, SHA1_DIGEST_SIZE) == 0);
+            }
+
+            SHA256HashBatch(messages.data(), messages.size(), digests.data());
+            for (size_t i = 0U; i < messages.size(); ++i)
+            {
+                SHA256Hash(messages[i].data, messages[i].size, digest);
+                Assert::IsTrue(std::memcmp(digest, digests.data() + i * SHA256_DIGEST_SIZE, SHA256_DIGEST_SIZE) == 0);
+            }
+        }
+    };
+}
@@ -0,0 +1,211 @@
+#include "CppUnitTest.h"
+#include "chacha20_poly1305.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cryptlibtest
+{
+    TEST_CLASS(ChaCha20Poly1305Test)
+    {
+    public:
+
+        TEST_METHOD(ChaCha20Poly1305Rfc)
+        {
+            // RFC 8439 section 2.8.2
+            uint8_t key[32];
+            for (size_t i = 0U; i < sizeof(key); ++i)
+            {
+                key[i] = static_cast<uint8_t>(0x80U + i);
+            }
+
+            const uint8_t nonce[12] =
+            {
+                0x07U, 0x00U, 0x00U, 0x00U,
+                0x40U, 0x41U, 0x42U, 0x43U,
+                0x44U, 0x45U, 0x46U, 0x47U
+            };
+
+            const uint8_t aad[12] =
+            {
+                0x50U, 0x51U, 0x52U, 0x53U,
+                0xc0U, 0xc1U, 0xc2U, 0xc3U,
+                0xc4U, 0xc5U, 0xc6U, 0xc7U
+            };
+
+            const char *text = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, sunscreen would be it.";
+            const std::vector<uint8_t> expected =
+            {
+                0xd3U, 0x1aU, 0x8dU, 0x34U,
+                0x64U, 0x8eU, 0x60U, 0xdbU,
+                0x7bU, 0x86U, 0xafU, 0xbcU,
+                0x53U, 0xefU, 0x7eU, 0xc2U,
+                0xa4U, 0xadU, 0xedU, 0x51U,
+                0x29U, 0x6eU, 0x08U, 0xfeU,
+                0xa9U, 0xe2U, 0xb5U, 0xa7U,
+                0x36U, 0xeeU, 0x62U, 0xd6U,
+                0x3dU, 0xbeU, 0xa4U, 0x5eU,
+                0x8cU, 0xa9U, 0x67U, 0x12U,
+                0x82U, 0xfaU, 0xfbU, 0x69U,
+                0xdaU, 0x92U, 0x72U, 0x8bU,
+                0x1aU, 0x71U, 0xdeU, 0x0aU,
+                0x9eU, 0x06U, 0x0bU, 0x29U,
+                0x05U, 0xd6U, 0xa5U, 0xb6U,
+                0x7eU, 0xcdU, 0x3bU, 0x36U,
+                0x92U, 0xddU, 0xbdU, 0x7fU,
+                0x2dU, 0x77U, 0x8bU, 0x8cU,
+                0x98U, 0x03U, 0xaeU, 0xe3U,
+                0x28U, 0x09U, 0x1bU, 0x58U,
+                0xfaU, 0xb3U, 0x24U, 0xe4U,
+                0xfaU, 0xd6U, 0x75U, 0x94U,
+                0x55U, 0x85U, 0x80U, 0x8bU,
+                0x48U, 0x31U, 0xd7U, 0xbcU,
+                0x3fU, 0xf4U, 0xdeU, 0xf0U,
+                0x8eU, 0x4bU, 0x7aU, 0x9dU,
+                0xe5U, 0x76U, 0xd2U, 0x65U,
+                0x86U, 0xceU, 0xc6U, 0x4bU,
+                0x61U, 0x16U
+            };
+
+            const std::vector<uint8_t> expected_tag =
+            {
+                0x1aU, 0xe1U, 0x0bU, 0x59U,
+                0x4fU, 0x09U, 0xe2U, 0x6aU,
+                0x7eU, 0x90U, 0x2eU, 0xcbU,
+                0xd0U, 0x60U, 0x06U, 0x91U
+            };
+
+            ChaCha20Poly1305 aead(key, sizeof(key));
+            std::vector<uint8_t> output(std::strlen(text));
+            std::vector<uint8_t> tag(16U);
+            aead.seal(nonce, sizeof(nonce), aad, sizeof(aad), reinterpret_cast<const uint8_t*>(text), output.data(), output.size(), tag.data());
+            Assert::IsTrue(output == expected);
+            Assert::IsTrue(tag == expected_tag);
+
+            Assert::IsTrue(aead.open(nonce, sizeof(nonce), aad, sizeof(aad), expected.data(), output.data(), output.size(), tag.data()));
+            Assert::IsTrue(std::string(output.begin(), output.end()) == text);
+        }
+
+        TEST_METHOD(ChaCha20Poly1305Streaming)
+        {
+            // Long messages in uneven pieces must match the one-shot result,
+            // exercising the SIMD keystream and MAC paths and partial blocks
+            uint8_t key[32];
+            uint8_t nonce[12];
+            for (size_t i = 0U; i < sizeof(key); ++i)
+            {
+                key[i] = static_cast<uint8_t>(i * 17U + 3U);
+            }
+
+            for (size_t i = 0U; i < sizeof(nonce); ++i)
+            {
+                nonce[i] = static_cast<uint8_t>(i * 5U);
+            }
+
+            std::vector<uint8_t> aad(77U);
+            std::vector<uint8_t> data(64U * 16U * 10U + 64U * 5U + 9U);
+            for (size_t i = 0U; i < aad.size(); ++i)
+            {
+                aad[i] = static_cast<uint8_t>(i * 3U);
+            }
+
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 7U + 1U);
+            }
+
+            ChaCha20Poly1305 aead(key, sizeof(key));
+            std::vector<uint8_t> whole(data.size());
+            uint8_t tag[16];
+            aead.seal(nonce, sizeof(nonce), aad.data(), aad.size(), data.data(), whole.data(), whole.size(), tag);
+
+            const size_t pieces[] = { 1U, 63U, 3U, 1300U, 64U, 200U, 7U };
+            aead.start(nonce, sizeof(nonce));
+            aead.add_aad(aad.data(), 5U);
+            aead.add_aad(aad.data() + 5U, aad.size() - 5U);
+
+            std::vector<uint8_t> streamed(data.size());
+            size_t offset = 0U;
+            for (size_t i = 0U; offset < data.size(); i = (i + 1U) % 7U)
+            {
+                size_t size = (pieces[i] < data.size() - offset) ? pieces[i] : data.size() - offset;
+                aead.encrypt(data.data() + offset, streamed.data() + offset, size);
+                offset += size;
+            }
+
+            uint8_t streamed_tag[16];
+            aead.finish(streamed_tag);
+            Assert::IsTrue(streamed == whole);
+            Assert::IsTrue(std::vector<uint8_t>(tag, tag + 16) == std::vector<uint8_t>(streamed_tag, streamed_tag + 16));
+
+            // Decrypt in place, in two pieces
+            aead.start(nonce, sizeof(nonce));
+            aead.add_aad(aad.data(), aad.size());
+            aead.decrypt(streamed.data(), streamed.data(), 100U);
+            aead.decrypt(streamed.data() + 100U, streamed.data() + 100U, streamed.size() - 100U);
+            Assert::IsTrue(aead.verify(tag));
+            Assert::IsTrue(streamed == data);
+        }
+
+        TEST_METHOD(ChaCha20Poly1305Tamper)
+        {
+            uint8_t key[32] = {};
+            uint8_t nonce[12] = {};
+            std::vector<uint8_t> data(300U, 0x5aU);
+            std::vector<uint8_t> sealed(data.size());
+            uint8_t tag[16];
+
+            ChaCha20Poly1305 aead(key, sizeof(key));
+            aead.seal(nonce, sizeof(nonce), "header", 6U, data.data(), sealed.data(), sealed.size(), tag);
+
+            // A flipped ciphertext bit fails and the output is wiped
+            std::vector<uint8_t> output(data.size(), 0xffU);
+            sealed[123] ^= 0x10U;
+            Assert::IsFalse(aead.open(nonce, sizeof(nonce), "header", 6U, sealed.data(), output.data(), output.size(), tag));
+            Assert::IsTrue(output == std::vector<uint8_t>(data.size(), 0U));
+            sealed[123] ^= 0x10U;
+
+            // So do changed AAD and a changed tag
+            Assert::IsFalse(aead.open(nonce, sizeof(nonce), "Header", 6U, sealed.data(), output.data(), output.size(), tag));
+            tag[15] ^= 0x01U;
+            Assert::IsFalse(aead.open(nonce, sizeof(nonce), "header", 6U, sealed.data(), output.data(), output.size(), tag));
+            tag[15] ^= 0x01U;
+            Assert::IsTrue(aead.open(nonce, sizeof(nonce), "header", 6U, sealed.data(), output.data(), output.size(), tag));
+            Assert::IsTrue(output == data);
+
+            // Only 96-bit nonces are supported
+            bool thrown = false;
+            try
+            {
+                aead.start(nonce, 8U);
+            }
+            catch (const std::invalid_argument &)
+            {
+                thrown = true;
+            }
+
+            Assert::IsTrue(thrown);
+
+            // AAD after the text would not match the RFC 8439 construction
+            thrown = false;
+            aead.start(nonce, sizeof(nonce));
+            aead.encrypt(data.data(), sealed.data(), 10U);
+            try
+            {
+                aead.add_aad("header", 6U);
+            }
+            catch (const std::logic_error &)
+            {
+                thrown = true;
+            }
+
+            Assert::IsTrue(thrown);
+
+            std::string backend = ChaCha20Poly1305::backend();
+            Assert::IsTrue(backend.find('+') != std::string::npos);
+        }
+    };
+}
@@ -0,0 +1,169 @@
+#include "CppUnitTest.h"
+#include "chacha20.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cryptlibtest
+{
+    TEST_CLASS(ChaCha20Test)
+    {
+    public:
+
+        TEST_METHOD(ChaCha20Rfc)
+        {
+            // RFC 8439 section 2.4.2
+            uint8_t key[32];
+            for (size_t i = 0U; i < sizeof(key); ++i)
+            {
+                key[i] = static_cast<uint8_t>(i);
+            }
+
+            const uint8_t nonce[12] =
+            {
+                0x00U, 0x00U, 0x00U, 0x00U,
+                0x00U, 0x00U, 0x00U, 0x4aU,
+                0x00U, 0x00U, 0x00U, 0x00U
+            };
+
+            const char *text = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, sunscreen would be it.";
+            const std::vector<uint8_t> expected =
+            {
+                0x6eU, 0x2eU, 0x35U, 0x9aU,
+                0x25U, 0x68U, 0xf9U, 0x80U,
+                0x41U, 0xbaU, 0x07U, 0x28U,
+                0xddU, 0x0dU, 0x69U, 0x81U,
+                0xe9U, 0x7eU, 0x7aU, 0xecU,
+                0x1dU, 0x43U, 0x60U, 0xc2U,
+                0x0aU, 0x27U, 0xafU, 0xccU,
+                0xfdU, 0x9fU, 0xaeU, 0x0bU,
+                0xf9U, 0x1bU, 0x65U, 0xc5U,
+                0x52U, 0x47U, 0x33U, 0xabU,
+                0x8fU, 0x59U, 0x3dU, 0xabU,
+                0xcdU, 0x62U, 0xb3U, 0x57U,
+                0x16U, 0x39U, 0xd6U, 0x24U,
+                0xe6U, 0x51U, 0x52U, 0xabU,
+                0x8fU, 0x53U, 0x0cU, 0x35U,
+                0x9fU, 0x08U, 0x61U, 0xd8U,
+                0x07U, 0xcaU, 0x0dU, 0xbfU,
+                0x50U, 0x0dU, 0x6aU, 0x61U,
+                0x56U, 0xa3U, 0x8eU, 0x08U,
+                0x8aU, 0x22U, 0xb6U, 0x5eU,
+                0x52U, 0xbcU, 0x51U, 0x4dU,
+                0x16U, 0xccU, 0xf8U, 0x06U,
+                0x81U, 0x8cU, 0xe9U, 0x1aU,
+                0xb7U, 0x79U, 0x37U, 0x36U,
+                0x5aU, 0xf9U, 0x0bU, 0xbfU,
+                0x74U, 0xa3U, 0x5bU, 0xe6U,
+                0xb4U, 0x0bU, 0x8eU, 0xedU,
+                0xf2U, 0x78U, 0x5eU, 0x42U,
+                0x87U, 0x4dU
+            };
+
+            ChaCha20 cipher(key, sizeof(key));
+            std::vector<uint8_t> output(std::strlen(text));
+            uint32_t counter = 1U;
+            cipher.crypt(nonce, counter, reinterpret_cast<const uint8_t*>(text), output.data(), output.size());
+            Assert::IsTrue(output == expected);
+            Assert::IsTrue(counter == 3U);
+
+            // Decrypt in place
+            counter = 1U;
+            cipher.crypt(nonce, counter, output.data(), output.data(), output.size());
+            Assert::IsTrue(std::string(output.begin(), output.end()) == text);
+        }
+
+        TEST_METHOD(ChaCha20Lanes)
+        {
+            uint8_t key[32];
+            uint8_t nonce[12];
+            for (size_t i = 0U; i < sizeof(key); ++i)
+            {
+                key[i] = static_cast<uint8_t>(i * 13U + 5U);
+            }
+
+            for (size_t i = 0U; i < sizeof(nonce); ++i)
+            {
+                nonce[i] = static_cast<uint8_t>(i * 7U);
+            }
+
+            std::vector<uint8_t> data(64U * 16U * 3U + 64U * 11U + 37U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 3U + 1U);
+            }
+
+            // Every length through the SIMD groups and their tails must match
+            // the keystream generated one block at a time, up to the last
+            // counter value
+            const uint32_t first = static_cast<uint32_t>(0U - (data.size() + 63U) / 64U);
+            ChaCha20 cipher(key, sizeof(key));
+            std::vector<uint8_t> expected(data.size());
+            uint32_t counter = first;
+            for (size_t offset = 0U; offset < data.size(); offset += 64U)
+            {
+                size_t size = (data.size() - offset < 64U) ? data.size() - offset : 64U;
+                cipher.crypt(nonce, counter, data.data() + offset, expected.data() + offset, size);
+            }
+
+            for (size_t size = 0U; size <= data.size(); size += (size < 1100U) ? 1U : 61U)
+            {
+                std::vector<uint8_t> output(size);
+                counter = first;
+                cipher.crypt(nonce, counter, data.data(), output.data(), size);
+                Assert::IsTrue(std::memcmp(output.data(), expected.data(), size) == 0);
+                Assert::IsTrue(counter == static_cast<uint32_t>(first + (size + 63U) / 64U));
+            }
+
+            std::string backend = ChaCha20::backend();
+            Assert::IsTrue(backend == "avx512" || backend == "avx2" || backend == "ssse3" || backend == "portable");
+            Assert::IsTrue(ChaCha20::lanes() >= 1U && ChaCha20::lanes() <= 16U);
+        }
+
+        TEST_METHOD(ChaCha20CounterWrap)
+        {
+            uint8_t key[32] = {};
+            uint8_t nonce[12] = {};
+            uint8_t data[128] = {};
+            ChaCha20 cipher(key, sizeof(key));
+
+            // The last block may be used, but not the keystream after it
+            uint32_t counter = 0xffffffffU;
+            cipher.crypt(nonce, counter, data, data, 64U);
+            Assert::IsTrue(counter == 0U);
+
+            bool thrown = false;
+            counter = 0xffffffffU;
+            try
+            {
+                cipher.crypt(nonce, counter, data, data, 65U);
+            }
+            catch (const std::invalid_argument &)
+            {
+                thrown = true;
+            }
+
+            Assert::IsTrue(thrown);
+            Assert::IsTrue(counter == 0xffffffffU);
+        }
+
+        TEST_METHOD(ChaCha20InvalidKey)
+        {
+            uint8_t key[32] = {};
+            bool thrown = false;
+            try
+            {
+                ChaCha20 cipher(key, 16U);
+            }
+            catch (const std::invalid_argument &)
+            {
+                thrown = true;
+            }
+
+            Assert::IsTrue(thrown);
+        }
+    };
+}
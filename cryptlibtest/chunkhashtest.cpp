@@ -0,0 +1,151 @@
+#include "CppUnitTest.h"
+#include "chunk_hash.hpp"
+#include "sha256_hash.hpp"
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <stdexcept>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cryptlibtest
+{
+    TEST_CLASS(ChunkHashTest)
+    {
+    private:
+        // Fill a buffer with pseudorandom bytes
+        static std::vector<uint8_t> random_data(size_t size, uint64_t seed)
+        {
+            std::vector<uint8_t> data(size);
+            for (size_t i = 0U; i < size; ++i)
+            {
+                seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+                data[i] = static_cast<uint8_t>(seed >> 56);
+            }
+
+            return data;
+        }
+
+        // Chunk a buffer, adding it in pieces of the given size
+        static std::vector<ChunkHash::Chunk> chunk(const std::vector<uint8_t> &data, size_t piece, bool threaded)
+        {
+            ChunkHash chunker(2048U, 8192U, 65536U, threaded);
+            std::vector<ChunkHash::Chunk> chunks;
+            for (size_t pos = 0U; pos < data.size(); pos += piece)
+            {
+                chunker.add(data.data() + pos, std::min(piece, data.size() - pos));
+                chunker.take(chunks);
+            }
+
+            chunker.close();
+            chunker.take(chunks);
+            return chunks;
+        }
+
+    public:
+
+        TEST_METHOD(ChunkHashBoundaries)
+        {
+            auto data = random_data(1U << 20, 1U);
+            auto chunks = chunk(data, data.size(), false);
+
+            // Chunks tile the stream, within the size limits, with the
+            // digests of their contents
+            uint64_t offset = 0U;
+            for (size_t i = 0U; i < chunks.size(); ++i)
+            {
+                Assert::IsTrue(chunks[i].offset == offset);
+                Assert::IsTrue(chunks[i].size <= 65536U);
+                Assert::IsTrue(chunks[i].size >= 2048U || i + 1U == chunks.size());
+
+                uint8_t expected[32];
+                Sha256Hash::hash(data.data() + offset, chunks[i].size, expected);
+                Assert::IsTrue(std::memcmp(expected, chunks[i].digest.data(), 32U) == 0);
+                offset += chunks[i].size;
+            }
+
+            Assert::IsTrue(offset == data.size());
+            Assert::IsTrue(chunks.size() > 64U && chunks.size() < 256U);
+        }
+
+        TEST_METHOD(ChunkHashPieces)
+        {
+            auto data = random_data(300000U, 2U);
+            auto expected = chunk(data, data.size(), false);
+
+            // Boundaries and digests do not depend on how the stream is split
+            // or on which thread hashes it
+            for (size_t piece : { 1U, 63U, 4096U, 65537U })
+            {
+                for (bool threaded : { false, true })
+                {
+                    auto chunks = chunk(data, piece, threaded);
+                    Assert::IsTrue(chunks.size() == expected.size());
+                    for (size_t i = 0U; i < chunks.size(); ++i)
+                    {
+                        Assert::IsTrue(chunks[i].offset == expected[i].offset);
+                        Assert::IsTrue(chunks[i].size == expected[i].size);
+                        Assert::IsTrue(chunks[i].digest == expected[i].digest);
+                    }
+                }
+            }
+        }
+
+        TEST_METHOD(ChunkHashInsertion)
+        {
+            auto data = random_data(1U << 20, 3U);
+            auto before = chunk(data, data.size(), false);
+
+            // Inserting bytes near the start only changes the chunks around it
+            data.insert(data.begin() + 5000, 100U, 0x5AU);
+            auto after = chunk(data, data.size(), false);
+
+            std::set<std::vector<uint8_t>> digests;
+            for (const auto &c : before)
+            {
+                digests.insert(std::vector<uint8_t>(c.digest.begin(), c.digest.end()));
+            }
+
+            size_t shared = 0U;
+            for (const auto &c : after)
+            {
+                shared += digests.count(std::vector<uint8_t>(c.digest.begin(), c.digest.end()));
+            }
+
+            Assert::IsTrue(shared + 3U >= before.size());
+        }
+
+        TEST_METHOD(ChunkHashEmpty)
+        {
+            ChunkHash chunker;
+            std::vector<ChunkHash::Chunk> chunks;
+            chunker.add(nullptr, 0U);
+            chunker.close();
+            Assert::IsTrue(chunker.take(chunks) == 0U);
+
+            // A short stream is one chunk, and close() starts a new stream
+            chunker.add("abc", 3U);
+            chunker.close();
+            chunker.add("abc", 3U);
+            chunker.close();
+            Assert::IsTrue(chunker.take(chunks) == 2U);
+            Assert::IsTrue(chunks[1].offset == 0U && chunks[1].size == 3U);
+            Assert::IsTrue(chunks[1].digest == sha256("abc"));
+        }
+
+        TEST_METHOD(ChunkHashInvalidSizes)
+        {
+            bool thrown = false;
+            try
+            {
+                ChunkHash chunker(8192U, 4096U, 65536U);
+            }
+            catch (const std::invalid_argument &)
+            {
+                thrown = true;
+            }
+
+            Assert::IsTrue(thrown);
+        }
+    };
+}
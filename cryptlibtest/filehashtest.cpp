@@ -0,0 +1,76 @@
+#include "CppUnitTest.h"
+#include "file_hash.hpp"
+#include "sha256_hash.hpp"
+#include <cstdio>
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cryptlibtest
+{
+    TEST_CLASS(FileHashTest)
+    {
+    public:
+
+        TEST_METHOD(FileHashMatchesSha256)
+        {
+            // Write files of assorted sizes, including an empty one
+            std::vector<std::string> paths;
+            std::vector<std::vector<uint8_t>> contents;
+            for (size_t i = 0U; i < 6U; ++i)
+            {
+                std::vector<uint8_t> data(i * i * 3001U);
+                for (size_t j = 0U; j < data.size(); ++j)
+                {
+                    data[j] = static_cast<uint8_t>(j * 7U + i);
+                }
+
+                std::string path = "filehashtest" + std::to_string(i) + ".bin";
+                std::FILE *file = std::fopen(path.c_str(), "wb");
+                Assert::IsTrue(file != nullptr);
+                std::fwrite(data.data(), 1U, data.size(), file);
+                std::fclose(file);
+
+                paths.push_back(path);
+                contents.push_back(data);
+            }
+
+            paths.push_back("filehashtest-missing.bin");
+            auto results = FileHash::hash(paths, FileHash::sha256, 3U);
+
+            for (size_t i = 0U; i < contents.size(); ++i)
+            {
+                Sha256Hash hash;
+                hash.add(contents[i].data(), contents[i].size());
+                Assert::IsTrue(results[i].path == paths[i]);
+                Assert::IsTrue(results[i].digest == hash.close());
+                std::remove(paths[i].c_str());
+            }
+
+            Assert::IsTrue(results.back().digest.empty());
+        }
+
+        TEST_METHOD(FileHashManifest)
+        {
+            FileHash::Result result = { "dir/file name.txt", { 0xe3U, 0xb0U, 0xc4U, 0x42U } };
+            Assert::IsTrue(FileHash::format(result) == "e3b0c442  dir/file name.txt\n");
+
+            // Round trip a path that needs escaping
+            result.path = "a\\b\nc";
+            std::string line = FileHash::format(result);
+            Assert::IsTrue(line == "\\e3b0c442  a\\\\b\\nc\n");
+
+            FileHash::Entry entry;
+            Assert::IsTrue(FileHash::parse(line.substr(0U, line.size() - 1U), entry));
+            Assert::IsTrue(entry.path == result.path);
+            Assert::IsTrue(entry.digest == result.digest);
+
+            // Binary mode marker and malformed lines
+            Assert::IsTrue(FileHash::parse("E3B0C442 *file", entry));
+            Assert::IsTrue(entry.path == "file");
+            Assert::IsFalse(FileHash::parse("e3b0c44  file", entry));
+            Assert::IsFalse(FileHash::parse("xyz0  file", entry));
+            Assert::IsFalse(FileHash::parse("", entry));
+        }
+    };
+}
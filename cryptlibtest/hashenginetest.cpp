@@ -0,0 +1,81 @@
+#include "CppUnitTest.h"
+#include "md5_engine.hpp"
+#include "sha1_engine.hpp"
+#include "sha256_engine.hpp"
+#include "sha256_hash.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cryptlibtest
+{
+    // Digests calculated at compile time
+    static constexpr Md5Engine::Digest md5_fox = md5("The quick brown fox jumps over the lazy dog");
+    static constexpr Sha1Engine::Digest sha1_fox = sha1("The quick brown fox jumps over the lazy dog");
+    static constexpr Sha256Engine::Digest sha256_long = sha256("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopqabcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq");
+
+    static_assert(md5_fox == Md5Engine::Digest{ {
+            0x9eU, 0x10U, 0x7dU, 0x9dU,
+            0x37U, 0x2bU, 0xb6U, 0x82U,
+            0x6bU, 0xd8U, 0x1dU, 0x35U,
+            0x42U, 0xa4U, 0x19U, 0xd6U
+        } }, "constexpr MD5");
+
+    static_assert(sha1_fox == Sha1Engine::Digest{ {
+            0x2fU, 0xd4U, 0xe1U, 0xc6U,
+            0x7aU, 0x2dU, 0x28U, 0xfcU,
+            0xedU, 0x84U, 0x9eU, 0xe1U,
+            0xbbU, 0x76U, 0xe7U, 0x39U,
+            0x1bU, 0x93U, 0xebU, 0x12U
+        } }, "constexpr SHA1");
+
+    static_assert(sha256_long == Sha256Engine::Digest{ {
+            0x59U, 0xf1U, 0x09U, 0xd9U,
+            0x53U, 0x3bU, 0x2bU, 0x70U,
+            0xe7U, 0xc3U, 0xb8U, 0x14U,
+            0xa2U, 0xbdU, 0x21U, 0x8fU,
+            0x78U, 0xeaU, 0x5dU, 0x37U,
+            0x14U, 0x45U, 0x5bU, 0xc6U,
+            0x79U, 0x87U, 0xcfU, 0x0dU,
+            0x66U, 0x43U, 0x99U, 0xcfU
+        } }, "constexpr SHA256");
+
+    TEST_CLASS(HashEngineTest)
+    {
+    public:
+
+        TEST_METHOD(HashEngineMatchesConstexpr)
+        {
+            const char *fox = "The quick brown fox jumps over the lazy dog";
+
+            Md5Engine md5engine;
+            md5engine.add(fox, 43U);
+            Assert::IsTrue(md5_fox == md5engine.close());
+
+            Sha1Engine sha1engine;
+            sha1engine.add(fox, 43U);
+            Assert::IsTrue(sha1_fox == sha1engine.close());
+        }
+
+        TEST_METHOD(HashEngineSha256Backends)
+        {
+            std::vector<uint8_t> data(1000U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 7U + 3U);
+            }
+
+            // The portable and dispatched engines must agree with the Hash adapter
+            Sha256Engine fast;
+            Sha256ConstEngine portable;
+            Sha256Hash hash;
+            fast.add(data.data(), data.size());
+            portable.add(data.data(), data.size());
+            hash.add(data.data(), data.size());
+
+            Sha256Hash::Digest expected;
+            hash.close(expected);
+            Assert::IsTrue(expected == fast.close());
+            Assert::IsTrue(expected == portable.close());
+        }
+    };
+}
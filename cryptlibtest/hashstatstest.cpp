@@ -0,0 +1,99 @@
+#include "CppUnitTest.h"
+#include "hash_stats.hpp"
+#include "md5_hash.hpp"
+#include "sha256_hash.hpp"
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cryptlibtest
+{
+    TEST_CLASS(HashStatsTest)
+    {
+        // Get the change in a counter between two snapshots
+        static uint64_t delta(const HashStats::Snapshot &before, const HashStats::Snapshot &after, HashStats::Algorithm algorithm, HashStats::Counter counter)
+        {
+            return after.get(algorithm, counter) - before.get(algorithm, counter);
+        }
+
+    public:
+
+        TEST_METHOD(HashStatsCounts)
+        {
+            std::vector<uint8_t> data(200U, 0x5AU);
+
+            HashStats::Snapshot before;
+            HashStats::snapshot(before);
+
+            // 10 bytes buffered; 100 complete the block and buffer 46; 90
+            // complete another, process one in place and buffer 8
+            Sha256Hash hash;
+            hash.add(data.data(), 10U);
+            hash.add(data.data(), 100U);
+            hash.add(data.data(), 90U);
+            hash.close();
+
+            HashStats::Snapshot after;
+            HashStats::snapshot(after);
+
+            // Without CRYPTLIB_STATS nothing is counted
+            uint64_t on = HashStats::enabled() ? 1U : 0U;
+            Assert::IsTrue(delta(before, after, HashStats::sha256, HashStats::bytes) == 200U * on);
+            Assert::IsTrue(delta(before, after, HashStats::sha256, HashStats::blocks) == 4U * on);
+            Assert::IsTrue(delta(before, after, HashStats::sha256, HashStats::calls) == 4U * on);
+            Assert::IsTrue(delta(before, after, HashStats::sha256, HashStats::copies) == 5U * on);
+            Assert::IsTrue(delta(before, after, HashStats::sha256, HashStats::finals) == 1U * on);
+            Assert::IsTrue(delta(before, after, HashStats::md5, HashStats::bytes) == 0U);
+            Assert::IsTrue(after.backends[HashStats::sha256] == Sha256Hash::backend());
+        }
+
+        TEST_METHOD(HashStatsExitedThread)
+        {
+            std::vector<uint8_t> data(1000U, 0xA5U);
+
+            HashStats::Snapshot before;
+            HashStats::snapshot(before);
+
+            // The counts of a thread survive its exit
+            std::thread worker([&data]()
+            {
+                uint8_t digest[16];
+                Md5Hash::hash(data.data(), data.size(), digest);
+            });
+            worker.join();
+
+            HashStats::Snapshot after;
+            HashStats::snapshot(after);
+
+            uint64_t on = HashStats::enabled() ? 1U : 0U;
+            Assert::IsTrue(delta(before, after, HashStats::md5, HashStats::bytes) == 1000U * on);
+            Assert::IsTrue(delta(before, after, HashStats::md5, HashStats::blocks) == 16U * on);
+            Assert::IsTrue(delta(before, after, HashStats::md5, HashStats::finals) == 1U * on);
+        }
+
+        TEST_METHOD(HashStatsSampling)
+        {
+            std::vector<uint8_t> data(4096U, 0x3CU);
+
+            HashStats::Snapshot before;
+            HashStats::snapshot(before);
+
+            // Time every call
+            HashStats::set_sample_interval(1U);
+            for (size_t i = 0U; i < 8U; ++i)
+            {
+                uint8_t digest[32];
+                Sha256Hash::hash(data.data(), data.size(), digest);
+            }
+            HashStats::set_sample_interval(0U);
+
+            HashStats::Snapshot after;
+            HashStats::snapshot(after);
+
+            uint64_t calls = delta(before, after, HashStats::sha256, HashStats::calls);
+            Assert::IsTrue(delta(before, after, HashStats::sha256, HashStats::samples) == calls);
+            Assert::IsTrue(calls == (HashStats::enabled() ? 16U : 0U));
+            Assert::IsTrue((delta(before, after, HashStats::sha256, HashStats::ticks) > 0U) == HashStats::enabled());
+        }
+    };
+}
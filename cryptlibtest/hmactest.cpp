@@ -0,0 +1,252 @@
+#include "CppUnitTest.h"
+#include "hmac.hpp"
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cryptlibtest
+{
+    // HMAC test vector
+    struct HmacVector
+    {
+        std::string key;
+        std::string data;
+        std::vector<uint8_t> mac;
+    };
+
+    TEST_CLASS(HmacTest)
+    {
+    public:
+
+        TEST_METHOD(HmacSha1Rfc2202)
+        {
+            // RFC 2202 test cases 1-7 (case 5 untruncated)
+            const HmacVector vectors[] = {
+                {
+                    std::string(20U, '\x0b'),
+                    std::string("Hi There"),
+                    {
+                        0xb6U, 0x17U, 0x31U, 0x86U,
+                        0x55U, 0x05U, 0x72U, 0x64U,
+                        0xe2U, 0x8bU, 0xc0U, 0xb6U,
+                        0xfbU, 0x37U, 0x8cU, 0x8eU,
+                        0xf1U, 0x46U, 0xbeU, 0x00U
+                    }
+                },
+                {
+                    std::string("Jefe"),
+                    std::string("what do ya want for nothing?"),
+                    {
+                        0xefU, 0xfcU, 0xdfU, 0x6aU,
+                        0xe5U, 0xebU, 0x2fU, 0xa2U,
+                        0xd2U, 0x74U, 0x16U, 0xd5U,
+                        0xf1U, 0x84U, 0xdfU, 0x9cU,
+                        0x25U, 0x9aU, 0x7cU, 0x79U
+                    }
+                },
+                {
+                    std::string(20U, '\xaa'),
+                    std::string(50U, '\xdd'),
+                    {
+                        0x12U, 0x5dU, 0x73U, 0x42U,
+                        0xb9U, 0xacU, 0x11U, 0xcdU,
+                        0x91U, 0xa3U, 0x9aU, 0xf4U,
+                        0x8aU, 0xa1U, 0x7bU, 0x4fU,
+                        0x63U, 0xf1U, 0x75U, 0xd3U
+                    }
+                },
+                {
+                    std::string("\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f\x10\x11\x12\x13\x14\x15\x16\x17\x18\x19", 25U),
+                    std::string(50U, '\xcd'),
+                    {
+                        0x4cU, 0x90U, 0x07U, 0xf4U,
+                        0x02U, 0x62U, 0x50U, 0xc6U,
+                        0xbcU, 0x84U, 0x14U, 0xf9U,
+                        0xbfU, 0x50U, 0xc8U, 0x6cU,
+                        0x2dU, 0x72U, 0x35U, 0xdaU
+                    }
+                },
+                {
+                    std::string(20U, '\x0c'),
+                    std::string("Test With Truncation"),
+                    {
+                        0x4cU, 0x1aU, 0x03U, 0x42U,
+                        0x4bU, 0x55U, 0xe0U, 0x7fU,
+                        0xe7U, 0xf2U, 0x7bU, 0xe1U,
+                        0xd5U, 0x8bU, 0xb9U, 0x32U,
+                        0x4aU, 0x9aU, 0x5aU, 0x04U
+                    }
+                },
+                {
+                    std::string(80U, '\xaa'),
+                    std::string("Test Using Larger Than Block-Size Key - Hash Key First"),
+                    {
+                        0xaaU, 0x4aU, 0xe5U, 0xe1U,
+                        0x52U, 0x72U, 0xd0U, 0x0eU,
+                        0x95U, 0x70U, 0x56U, 0x37U,
+                        0xceU, 0x8aU, 0x3bU, 0x55U,
+                        0xedU, 0x40U, 0x21U, 0x12U
+                    }
+                },
+                {
+                    std::string(80U, '\xaa'),
+                    std::string("Test Using Larger Than Block-Size Key and Larger Than One Block-Size Data"),
+                    {
+                        0xe8U, 0xe9U, 0x9dU, 0x0fU,
+                        0x45U, 0x23U, 0x7dU, 0x78U,
+                        0x6dU, 0x6bU, 0xbaU, 0xa7U,
+                        0x96U, 0x5cU, 0x78U, 0x08U,
+                        0xbbU, 0xffU, 0x1aU, 0x91U
+                    }
+                }
+            };
+
+            for (const auto &vector : vectors)
+            {
+                HmacSha1 hmac(vector.key.data(), vector.key.size());
+                hmac.add(vector.data.data(), vector.data.size());
+                Assert::IsTrue(vector.mac == hmac.close());
+            }
+        }
+
+        TEST_METHOD(HmacSha256Rfc4231)
+        {
+            // RFC 4231 test cases 1-7 (case 5 untruncated)
+            const HmacVector vectors[] = {
+                {
+                    std::string(20U, '\x0b'),
+                    std::string("Hi There"),
+                    {
+                        0xb0U, 0x34U, 0x4cU, 0x61U,
+                        0xd8U, 0xdbU, 0x38U, 0x53U,
+                        0x5cU, 0xa8U, 0xafU, 0xceU,
+                        0xafU, 0x0bU, 0xf1U, 0x2bU,
+                        0x88U, 0x1dU, 0xc2U, 0x00U,
+                        0xc9U, 0x83U, 0x3dU, 0xa7U,
+                        0x26U, 0xe9U, 0x37U, 0x6cU,
+                        0x2eU, 0x32U, 0xcfU, 0xf7U
+                    }
+                },
+                {
+                    std::string("Jefe"),
+                    std::string("what do ya want for nothing?"),
+                    {
+                        0x5bU, 0xdcU, 0xc1U, 0x46U,
+                        0xbfU, 0x60U, 0x75U, 0x4eU,
+                        0x6aU, 0x04U, 0x24U, 0x26U,
+                        0x08U, 0x95U, 0x75U, 0xc7U,
+                        0x5aU, 0x00U, 0x3fU, 0x08U,
+                        0x9dU, 0x27U, 0x39U, 0x83U,
+                        0x9dU, 0xecU, 0x58U, 0xb9U,
+                        0x64U, 0xecU, 0x38U, 0x43U
+                    }
+                },
+                {
+                    std::string(20U, '\xaa'),
+                    std::string(50U, '\xdd'),
+                    {
+                        0x77U, 0x3eU, 0xa9U, 0x1eU,
+                        0x36U, 0x80U, 0x0eU, 0x46U,
+                        0x85U, 0x4dU, 0xb8U, 0xebU,
+                        0xd0U, 0x91U, 0x81U, 0xa7U,
+                        0x29U, 0x59U, 0x09U, 0x8bU,
+                        0x3eU, 0xf8U, 0xc1U, 0x22U,
+                        0xd9U, 0x63U, 0x55U, 0x14U,
+                        0xceU, 0xd5U, 0x65U, 0xfeU
+                    }
+                },
+                {
+                    std::string("\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f\x10\x11\x12\x13\x14\x15\x16\x17\x18\x19", 25U),
+                    std::string(50U, '\xcd'),
+                    {
+                        0x82U, 0x55U, 0x8aU, 0x38U,
+                        0x9aU, 0x44U, 0x3cU, 0x0eU,
+                        0xa4U, 0xccU, 0x81U, 0x98U,
+                        0x99U, 0xf2U, 0x08U, 0x3aU,
+                        0x85U, 0xf0U, 0xfaU, 0xa3U,
+                        0xe5U, 0x78U, 0xf8U, 0x07U,
+                        0x7aU, 0x2eU, 0x3fU, 0xf4U,
+                        0x67U, 0x29U, 0x66U, 0x5bU
+                    }
+                },
+                {
+                    std::string(20U, '\x0c'),
+                    std::string("Test With Truncation"),
+                    {
+                        0xa3U, 0xb6U, 0x16U, 0x74U,
+                        0x73U, 0x10U, 0x0eU, 0xe0U,
+                        0x6eU, 0x0cU, 0x79U, 0x6cU,
+                        0x29U, 0x55U, 0x55U, 0x2bU,
+                        0xfaU, 0x6fU, 0x7cU, 0x0aU,
+                        0x6aU, 0x8aU, 0xefU, 0x8bU,
+                        0x93U, 0xf8U, 0x60U, 0xaaU,
+                        0xb0U, 0xcdU, 0x20U, 0xc5U
+                    }
+                },
+                {
+                    std::string(131U, '\xaa'),
+                    std::string("Test Using Larger Than Block-Size Key - Hash Key First"),
+                    {
+                        0x60U, 0xe4U, 0x31U, 0x59U,
+                        0x1eU, 0xe0U, 0xb6U, 0x7fU,
+                        0x0dU, 0x8aU, 0x26U, 0xaaU,
+                        0xcbU, 0xf5U, 0xb7U, 0x7fU,
+                        0x8eU, 0x0bU, 0xc6U, 0x21U,
+                        0x37U, 0x28U, 0xc5U, 0x14U,
+                        0x05U, 0x46U, 0x04U, 0x0fU,
+                        0x0eU, 0xe3U, 0x7fU, 0x54U
+                    }
+                },
+                {
+                    std::string(131U, '\xaa'),
+                    std::string("This is a test using a larger than block-size key and a larger than block-size data. The key needs to be hashed before being used by the HMAC algorithm."),
+                    {
+                        0x9bU, 0x09U, 0xffU, 0xa7U,
+                        0x1bU, 0x94U, 0x2fU, 0xcbU,
+                        0x27U, 0x63U, 0x5fU, 0xbcU,
+                        0xd5U, 0xb0U, 0xe9U, 0x44U,
+                        0xbfU, 0xdcU, 0x63U, 0x64U,
+                        0x4fU, 0x07U, 0x13U, 0x93U,
+                        0x8aU, 0x7fU, 0x51U, 0x53U,
+                        0x5cU, 0x3aU, 0x35U, 0xe2U
+                    }
+                }
+            };
+
+            for (const auto &vector : vectors)
+            {
+                HmacSha256 hmac(vector.key.data(), vector.key.size());
+                hmac.add(vector.data.data(), vector.data.size());
+                Assert::IsTrue(vector.mac == hmac.close());
+            }
+        }
+
+        TEST_METHOD(HmacSha256Batch)
+        {
+            std::vector<uint8_t> data(1000U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 7U + 3U);
+            }
+
+            std::vector<HashData> messages;
+            for (size_t i = 0U; i < 20U; ++i)
+            {
+                messages.push_back({ data.data() + i, i * 47U });
+            }
+
+            // Batch MACs must match MACs calculated one message at a time
+            HmacSha256 hmac("key", 3U);
+            std::vector<uint8_t> macs(messages.size() * 32U);
+            hmac.mac(messages.data(), messages.size(), macs.data());
+
+            for (size_t i = 0U; i < messages.size(); ++i)
+            {
+                hmac.clear();
+                hmac.add(messages[i].data, messages[i].size);
+                Assert::IsTrue(hmac.close() == std::vector<uint8_t>(macs.begin() + i * 32U, macs.begin() + i * 32U + 32U));
+            }
+        }
+    };
+}
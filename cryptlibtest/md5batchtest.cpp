@@ -0,0 +1,68 @@
+#include "CppUnitTest.h"
+#include "md5_batch.hpp"
+#include "md5_hash.hpp"
+#include <algorithm>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cryptlibtest
+{
+    TEST_CLASS(Md5BatchTest)
+    {
+    public:
+
+        TEST_METHOD(Md5BatchFox)
+        {
+            const HashData messages[] = {
+                { "", 0U },
+                { "The quick brown fox jumps over the lazy dog", 43U },
+            };
+
+            uint8_t digests[32];
+            Md5Batch::hash(messages, 2U, digests);
+
+            const std::vector<uint8_t> expected = {
+                0xd4U, 0x1dU, 0x8cU, 0xd9U,
+                0x8fU, 0x00U, 0xb2U, 0x04U,
+                0xe9U, 0x80U, 0x09U, 0x98U,
+                0xecU, 0xf8U, 0x42U, 0x7eU,
+                0x9eU, 0x10U, 0x7dU, 0x9dU,
+                0x37U, 0x2bU, 0xb6U, 0x82U,
+                0x6bU, 0xd8U, 0x1dU, 0x35U,
+                0x42U, 0xa4U, 0x19U, 0xd6U
+            };
+
+            Assert::IsTrue(expected == std::vector<uint8_t>(digests, digests + 32));
+        }
+
+        TEST_METHOD(Md5BatchMixedLengths)
+        {
+            // Build messages of assorted lengths covering every tail case
+            std::vector<uint8_t> data(2100U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 7U + 3U);
+            }
+
+            std::vector<HashData> messages;
+            for (size_t i = 0U; i < 53U; ++i)
+            {
+                size_t size = (i * 397U) % 2100U;
+                messages.push_back({ data.data() + (i % 13U), size - std::min(size, i % 13U) });
+            }
+
+            std::vector<uint8_t> digests(messages.size() * 16U);
+            Md5Batch::hash(messages.data(), messages.size(), digests.data());
+
+            // Compare against separate single-stream runs
+            for (size_t i = 0U; i < messages.size(); ++i)
+            {
+                Md5Hash hash;
+                hash.add(messages[i].data, messages[i].size);
+                auto expected = hash.close();
+
+                Assert::IsTrue(expected == std::vector<uint8_t>(digests.begin() + i * 16U, digests.begin() + i * 16U + 16U));
+            }
+        }
+    };
+}
@@ -1,5 +1,6 @@
 #include "CppUnitTest.h"
 #include "md5_hash.hpp"
+#include <algorithm>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -39,5 +40,148 @@ namespace cryptlibtest
 
             Assert::IsTrue(expected == digest);
         }
+
+        TEST_METHOD(Md5FoxDigest)
+        {
+            Md5Hash hash;
+            hash.add("The quick brown fox jumps over the lazy dog", 43U);
+            Md5Hash::Digest digest;
+            hash.close(digest);
+
+            const Md5Hash::Digest expected = { {
+                0x9eU, 0x10U, 0x7dU, 0x9dU,
+                0x37U, 0x2bU, 0xb6U, 0x82U,
+                0x6bU, 0xd8U, 0x1dU, 0x35U,
+                0x42U, 0xa4U, 0x19U, 0xd6U
+            } };
+
+            Assert::AreEqual(static_cast<size_t>(16U), hash.size());
+            Assert::IsTrue(expected == digest);
+        }
+
+        TEST_METHOD(Md5MillionA)
+        {
+            std::vector<uint8_t> data(1000U, 'a');
+
+            Md5Hash hash;
+            for (size_t i = 0U; i < 1000U; ++i)
+            {
+                hash.add(data.data(), data.size());
+            }
+            auto digest = hash.close();
+
+            const std::vector<uint8_t> expected = {
+                0x77U, 0x07U, 0xd6U, 0xaeU,
+                0x4eU, 0x02U, 0x7cU, 0x70U,
+                0xeeU, 0xa2U, 0xa9U, 0x35U,
+                0xc2U, 0x29U, 0x6fU, 0x21U
+            };
+
+            Assert::IsTrue(expected == digest);
+        }
+
+        TEST_METHOD(Md5Chunked)
+        {
+            std::vector<uint8_t> data(1000U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 7U + 3U);
+            }
+
+            // Add in chunks that straddle block boundaries
+            static const size_t chunks[] = { 1U, 63U, 64U, 65U, 200U, 7U };
+            Md5Hash hash;
+            for (size_t pos = 0U, i = 0U; pos < data.size(); ++i)
+            {
+                size_t size = std::min(chunks[i % 6U], data.size() - pos);
+                hash.add(data.data() + pos, size);
+                pos += size;
+            }
+            auto digest = hash.close();
+
+            const std::vector<uint8_t> expected = {
+                0x10U, 0x04U, 0x6fU, 0x07U,
+                0x7fU, 0x20U, 0x82U, 0xacU,
+                0x19U, 0x67U, 0x6bU, 0x80U,
+                0x79U, 0xf1U, 0xcbU, 0x1aU
+            };
+
+            Assert::IsTrue(expected == digest);
+        }
+
+        TEST_METHOD(Md5Snapshot)
+        {
+            std::vector<uint8_t> data(1000U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 7U + 3U);
+            }
+
+            // Absorb a prefix that ends mid-block and fork from its midstate
+            Md5Hash hash;
+            hash.add(data.data(), 100U);
+            Md5Hash::State state;
+            hash.save(state);
+
+            for (size_t size = 100U; size <= data.size(); size += 300U)
+            {
+                hash.restore(state);
+                hash.add(data.data() + 100U, size - 100U);
+                auto forked = hash.close();
+
+                Md5Hash full;
+                full.add(data.data(), size);
+                Assert::IsTrue(full.close() == forked);
+            }
+        }
+
+        TEST_METHOD(Md5Segments)
+        {
+            std::vector<uint8_t> data(1000U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 7U + 3U);
+            }
+
+            // Fragments that are empty, tiny, block-sized and straddling
+            static const size_t sizes[] = { 0U, 1U, 13U, 64U, 200U, 7U, 130U, 0U, 65U };
+            std::vector<HashData> segments;
+            for (size_t pos = 0U, i = 0U; pos < data.size(); ++i)
+            {
+                size_t size = std::min(sizes[i % 9U], data.size() - pos);
+                segments.push_back(HashData{ data.data() + pos, size });
+                pos += size;
+            }
+
+            Md5Hash full;
+            full.add(data.data(), data.size());
+            auto expected = full.close();
+
+            Md5Hash hash;
+            Hash &base = hash;
+            base.add(segments.data(), segments.size());
+            Assert::IsTrue(expected == hash.close());
+        }
+
+        TEST_METHOD(Md5OneShot)
+        {
+            std::vector<uint8_t> data(300U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 11U + 5U);
+            }
+
+            // Every size through the one-block, two-block and long paths
+            for (size_t size = 0U; size <= data.size(); ++size)
+            {
+                Md5Hash full;
+                full.add(data.data(), size);
+                auto expected = full.close();
+
+                std::vector<uint8_t> actual(16U);
+                Md5Hash::hash(data.data(), size, actual.data());
+                Assert::IsTrue(expected == actual);
+            }
+        }
 	};
 }
\ No newline at end of file
@@ -0,0 +1,251 @@
+#include "CppUnitTest.h"
+#include "pbkdf2_sha256.hpp"
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cryptlibtest
+{
+    // PBKDF2 test vector
+    struct Pbkdf2Vector
+    {
+        std::string password;
+        std::string salt;
+        uint32_t iterations;
+        std::vector<uint8_t> key;
+    };
+
+    TEST_CLASS(Pbkdf2Test)
+    {
+    public:
+
+        TEST_METHOD(Pbkdf2Sha1Rfc6070)
+        {
+            // RFC 6070 test cases 1-3, 5 and 6 (case 4 runs 16777216 iterations)
+            const Pbkdf2Vector vectors[] = {
+                {
+                    std::string("password"),
+                    std::string("salt"),
+                    1U,
+                    {
+                        0x0cU, 0x60U, 0xc8U, 0x0fU,
+                        0x96U, 0x1fU, 0x0eU, 0x71U,
+                        0xf3U, 0xa9U, 0xb5U, 0x24U,
+                        0xafU, 0x60U, 0x12U, 0x06U,
+                        0x2fU, 0xe0U, 0x37U, 0xa6U
+                    }
+                },
+                {
+                    std::string("password"),
+                    std::string("salt"),
+                    2U,
+                    {
+                        0xeaU, 0x6cU, 0x01U, 0x4dU,
+                        0xc7U, 0x2dU, 0x6fU, 0x8cU,
+                        0xcdU, 0x1eU, 0xd9U, 0x2aU,
+                        0xceU, 0x1dU, 0x41U, 0xf0U,
+                        0xd8U, 0xdeU, 0x89U, 0x57U
+                    }
+                },
+                {
+                    std::string("password"),
+                    std::string("salt"),
+                    4096U,
+                    {
+                        0x4bU, 0x00U, 0x79U, 0x01U,
+                        0xb7U, 0x65U, 0x48U, 0x9aU,
+                        0xbeU, 0xadU, 0x49U, 0xd9U,
+                        0x26U, 0xf7U, 0x21U, 0xd0U,
+                        0x65U, 0xa4U, 0x29U, 0xc1U
+                    }
+                },
+                {
+                    std::string("passwordPASSWORDpassword"),
+                    std::string("saltSALTsaltSALTsaltSALTsaltSALTsalt"),
+                    4096U,
+                    {
+                        0x3dU, 0x2eU, 0xecU, 0x4fU,
+                        0xe4U, 0x1cU, 0x84U, 0x9bU,
+                        0x80U, 0xc8U, 0xd8U, 0x36U,
+                        0x62U, 0xc0U, 0xe4U, 0x4aU,
+                        0x8bU, 0x29U, 0x1aU, 0x96U,
+                        0x4cU, 0xf2U, 0xf0U, 0x70U,
+                        0x38U
+                    }
+                },
+                {
+                    std::string("pass\0word", 9U),
+                    std::string("sa\0lt", 5U),
+                    4096U,
+                    {
+                        0x56U, 0xfaU, 0x6aU, 0xa7U,
+                        0x55U, 0x48U, 0x09U, 0x9dU,
+                        0xccU, 0x37U, 0xd7U, 0xf0U,
+                        0x34U, 0x25U, 0xe0U, 0xc3U
+                    }
+                }
+            };
+
+            for (const auto &vector : vectors)
+            {
+                std::vector<uint8_t> key(vector.key.size());
+                Pbkdf2Sha1::derive(vector.password.data(), vector.password.size(), vector.salt.data(), vector.salt.size(), vector.iterations, key.data(), key.size());
+                Assert::IsTrue(vector.key == key);
+            }
+        }
+
+        TEST_METHOD(Pbkdf2Sha256Rfc7914)
+        {
+            // RFC 7914 section 11 test vectors
+            const Pbkdf2Vector vectors[] = {
+                {
+                    std::string("passwd"),
+                    std::string("salt"),
+                    1U,
+                    {
+                        0x55U, 0xacU, 0x04U, 0x6eU,
+                        0x56U, 0xe3U, 0x08U, 0x9fU,
+                        0xecU, 0x16U, 0x91U, 0xc2U,
+                        0x25U, 0x44U, 0xb6U, 0x05U,
+                        0xf9U, 0x41U, 0x85U, 0x21U,
+                        0x6dU, 0xdeU, 0x04U, 0x65U,
+                        0xe6U, 0x8bU, 0x9dU, 0x57U,
+                        0xc2U, 0x0dU, 0xacU, 0xbcU,
+                        0x49U, 0xcaU, 0x9cU, 0xccU,
+                        0xf1U, 0x79U, 0xb6U, 0x45U,
+                        0x99U, 0x16U, 0x64U, 0xb3U,
+                        0x9dU, 0x77U, 0xefU, 0x31U,
+                        0x7cU, 0x71U, 0xb8U, 0x45U,
+                        0xb1U, 0xe3U, 0x0bU, 0xd5U,
+                        0x09U, 0x11U, 0x20U, 0x41U,
+                        0xd3U, 0xa1U, 0x97U, 0x83U
+                    }
+                },
+                {
+                    std::string("Password"),
+                    std::string("NaCl"),
+                    80000U,
+                    {
+                        0x4dU, 0xdcU, 0xd8U, 0xf6U,
+                        0x0bU, 0x98U, 0xbeU, 0x21U,
+                        0x83U, 0x0cU, 0xeeU, 0x5eU,
+                        0xf2U, 0x27U, 0x01U, 0xf9U,
+                        0x64U, 0x1aU, 0x44U, 0x18U,
+                        0xd0U, 0x4cU, 0x04U, 0x14U,
+                        0xaeU, 0xffU, 0x08U, 0x87U,
+                        0x6bU, 0x34U, 0xabU, 0x56U,
+                        0xa1U, 0xd4U, 0x25U, 0xa1U,
+                        0x22U, 0x58U, 0x33U, 0x54U,
+                        0x9aU, 0xdbU, 0x84U, 0x1bU,
+                        0x51U, 0xc9U, 0xb3U, 0x17U,
+                        0x6aU, 0x27U, 0x2bU, 0xdeU,
+                        0xbbU, 0xa1U, 0xd0U, 0x78U,
+                        0x47U, 0x8fU, 0x62U, 0xb3U,
+                        0x97U, 0xf3U, 0x3cU, 0x8dU
+                    }
+                }
+            };
+
+            // The two output blocks run in SIMD lanes, or serially without them
+            for (const auto &vector : vectors)
+            {
+                std::vector<uint8_t> key(vector.key.size());
+                Pbkdf2Sha256::derive(vector.password.data(), vector.password.size(), vector.salt.data(), vector.salt.size(), vector.iterations, key.data(), key.size());
+                Assert::IsTrue(vector.key == key);
+
+                std::vector<uint8_t> serial(vector.key.size());
+                Pbkdf2<Sha256Engine>::derive(vector.password.data(), vector.password.size(), vector.salt.data(), vector.salt.size(), vector.iterations, serial.data(), serial.size());
+                Assert::IsTrue(vector.key == serial);
+            }
+        }
+
+        TEST_METHOD(Pbkdf2Sha512)
+        {
+            const Pbkdf2Vector vectors[] = {
+                {
+                    std::string("password"),
+                    std::string("salt"),
+                    1U,
+                    {
+                        0x86U, 0x7fU, 0x70U, 0xcfU,
+                        0x1aU, 0xdeU, 0x02U, 0xcfU,
+                        0xf3U, 0x75U, 0x25U, 0x99U,
+                        0xa3U, 0xa5U, 0x3dU, 0xc4U,
+                        0xafU, 0x34U, 0xc7U, 0xa6U,
+                        0x69U, 0x81U, 0x5aU, 0xe5U,
+                        0xd5U, 0x13U, 0x55U, 0x4eU,
+                        0x1cU, 0x8cU, 0xf2U, 0x52U,
+                        0xc0U, 0x2dU, 0x47U, 0x0aU,
+                        0x28U, 0x5aU, 0x05U, 0x01U,
+                        0xbaU, 0xd9U, 0x99U, 0xbfU,
+                        0xe9U, 0x43U, 0xc0U, 0x8fU,
+                        0x05U, 0x02U, 0x35U, 0xd7U,
+                        0xd6U, 0x8bU, 0x1dU, 0xa5U,
+                        0x5eU, 0x63U, 0xf7U, 0x3bU,
+                        0x60U, 0xa5U, 0x7fU, 0xceU
+                    }
+                },
+                {
+                    std::string("password"),
+                    std::string("salt"),
+                    2U,
+                    {
+                        0xe1U, 0xd9U, 0xc1U, 0x6aU,
+                        0xa6U, 0x81U, 0x70U, 0x8aU,
+                        0x45U, 0xf5U, 0xc7U, 0xc4U,
+                        0xe2U, 0x15U, 0xceU, 0xb6U,
+                        0x6eU, 0x01U, 0x1aU, 0x2eU,
+                        0x9fU, 0x00U, 0x40U, 0x71U,
+                        0x3fU, 0x18U, 0xaeU, 0xfdU,
+                        0xb8U, 0x66U, 0xd5U, 0x3cU,
+                        0xf7U, 0x6cU, 0xabU, 0x28U,
+                        0x68U, 0xa3U, 0x9bU, 0x9fU,
+                        0x78U, 0x40U, 0xedU, 0xceU,
+                        0x4fU, 0xefU, 0x5aU, 0x82U,
+                        0xbeU, 0x67U, 0x33U, 0x5cU,
+                        0x77U, 0xa6U, 0x06U, 0x8eU,
+                        0x04U, 0x11U, 0x27U, 0x54U,
+                        0xf2U, 0x7cU, 0xcfU, 0x4eU
+                    }
+                }
+            };
+
+            for (const auto &vector : vectors)
+            {
+                std::vector<uint8_t> key(vector.key.size());
+                Pbkdf2Sha512::derive(vector.password.data(), vector.password.size(), vector.salt.data(), vector.salt.size(), vector.iterations, key.data(), key.size());
+                Assert::IsTrue(vector.key == key);
+            }
+        }
+
+        TEST_METHOD(Pbkdf2Sha256Batch)
+        {
+            // More output blocks than lanes, with uneven iteration counts
+            // and key sizes, including empty and partial final blocks
+            const size_t count = 24U;
+            std::vector<std::string> passwords(count);
+            std::vector<std::string> salts(count);
+            std::vector<std::vector<uint8_t>> keys(count);
+            std::vector<Pbkdf2Params> params(count);
+            for (size_t i = 0U; i < count; ++i)
+            {
+                passwords[i] = std::string(i * 7U % 90U, static_cast<char>('a' + i));
+                salts[i] = std::string(i * 5U % 70U, static_cast<char>('A' + i));
+                keys[i].resize((i * 13U) % 100U);
+                params[i] = Pbkdf2Params{ passwords[i].data(), passwords[i].size(), salts[i].data(), salts[i].size(),
+                    static_cast<uint32_t>(1U + i * 37U % 200U), keys[i].data(), keys[i].size() };
+            }
+
+            Pbkdf2Sha256::derive(params.data(), params.size());
+
+            for (size_t i = 0U; i < count; ++i)
+            {
+                std::vector<uint8_t> expected(keys[i].size());
+                Pbkdf2<Sha256Engine>::derive(passwords[i].data(), passwords[i].size(), salts[i].data(), salts[i].size(),
+                    params[i].iterations, expected.data(), expected.size());
+                Assert::IsTrue(expected == keys[i]);
+            }
+        }
+    };
+}
@@ -0,0 +1,121 @@
+#include "CppUnitTest.h"
+#include "poly1305.hpp"
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cryptlibtest
+{
+    TEST_CLASS(Poly1305Test)
+    {
+    private:
+        // Compute the tag of a message in one call
+        static std::vector<uint8_t> tag_of(const uint8_t *key, const void *data, size_t size)
+        {
+            Poly1305 mac(key);
+            std::vector<uint8_t> tag(16U);
+            mac.add(data, size);
+            mac.close(tag.data());
+            return tag;
+        }
+
+    public:
+
+        TEST_METHOD(Poly1305Rfc)
+        {
+            // RFC 8439 section 2.5.2
+            const uint8_t key[32] =
+            {
+                0x85U, 0xd6U, 0xbeU, 0x78U,
+                0x57U, 0x55U, 0x6dU, 0x33U,
+                0x7fU, 0x44U, 0x52U, 0xfeU,
+                0x42U, 0xd5U, 0x06U, 0xa8U,
+                0x01U, 0x03U, 0x80U, 0x8aU,
+                0xfbU, 0x0dU, 0xb2U, 0xfdU,
+                0x4aU, 0xbfU, 0xf6U, 0xafU,
+                0x41U, 0x49U, 0xf5U, 0x1bU
+            };
+
+            const std::vector<uint8_t> expected =
+            {
+                0xa8U, 0x06U, 0x1dU, 0xc1U,
+                0x30U, 0x51U, 0x36U, 0xc6U,
+                0xc2U, 0x2bU, 0x8bU, 0xafU,
+                0x0cU, 0x01U, 0x27U, 0xa9U
+            };
+
+            const char *text = "Cryptographic Forum Research Group";
+            Assert::IsTrue(tag_of(key, text, std::strlen(text)) == expected);
+        }
+
+        TEST_METHOD(Poly1305Reduction)
+        {
+            // RFC 8439 appendix A.3 vectors 5 and 6: the accumulator and the
+            // tag wrap around 2^130 - 5 and 2^128
+            uint8_t key[32] = { 0x02U };
+            uint8_t data[16];
+            std::memset(data, 0xff, sizeof(data));
+
+            const std::vector<uint8_t> expected =
+            {
+                0x03U, 0x00U, 0x00U, 0x00U,
+                0x00U, 0x00U, 0x00U, 0x00U,
+                0x00U, 0x00U, 0x00U, 0x00U,
+                0x00U, 0x00U, 0x00U, 0x00U
+            };
+
+            Assert::IsTrue(tag_of(key, data, sizeof(data)) == expected);
+
+            std::memset(key + 16, 0xff, 16U);
+            std::memset(data, 0, sizeof(data));
+            data[0] = 0x02U;
+            Assert::IsTrue(tag_of(key, data, sizeof(data)) == expected);
+        }
+
+        TEST_METHOD(Poly1305Lanes)
+        {
+            uint8_t key[32];
+            for (size_t i = 0U; i < sizeof(key); ++i)
+            {
+                key[i] = static_cast<uint8_t>(i * 29U + 7U);
+            }
+
+            std::vector<uint8_t> data(1000U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 11U + (i >> 7));
+            }
+
+            const std::vector<uint8_t> expected =
+            {
+                0x1fU, 0xa6U, 0xfeU, 0xceU,
+                0x99U, 0x62U, 0xbeU, 0xe4U,
+                0xd5U, 0x28U, 0x6bU, 0xf3U,
+                0xf1U, 0xd0U, 0xebU, 0xfdU
+            };
+
+            Assert::IsTrue(tag_of(key, data.data(), data.size()) == expected);
+
+            // Uneven pieces split the message between the SIMD groups and
+            // the partial block differently, but not the tag
+            const size_t pieces[] = { 1U, 15U, 3U, 130U, 16U, 200U, 7U };
+            Poly1305 mac(key);
+            size_t offset = 0U;
+            for (size_t i = 0U; offset < data.size(); i = (i + 1U) % 7U)
+            {
+                size_t size = (pieces[i] < data.size() - offset) ? pieces[i] : data.size() - offset;
+                mac.add(data.data() + offset, size);
+                offset += size;
+            }
+
+            std::vector<uint8_t> tag(16U);
+            mac.close(tag.data());
+            Assert::IsTrue(tag == expected);
+
+            std::string backend = Poly1305::backend();
+            Assert::IsTrue(backend == "avx512" || backend == "avx2" || backend == "portable");
+        }
+    };
+}
@@ -1,5 +1,7 @@
 #include "CppUnitTest.h"
 #include "sha1_hash.hpp"
+#include <algorithm>
+#include <cstring>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -41,5 +43,184 @@ namespace cryptlibtest
 
             Assert::IsTrue(expected == digest);
         }
+
+        TEST_METHOD(Sha1FoxDigest)
+        {
+            Sha1Hash hash;
+            hash.add("The quick brown fox jumps over the lazy dog", 43U);
+            Sha1Hash::Digest digest;
+            hash.close(digest);
+
+            const Sha1Hash::Digest expected = { {
+                0x2fU, 0xd4U, 0xe1U, 0xc6U,
+                0x7aU, 0x2dU, 0x28U, 0xfcU,
+                0xedU, 0x84U, 0x9eU, 0xe1U,
+                0xbbU, 0x76U, 0xe7U, 0x39U,
+                0x1bU, 0x93U, 0xebU, 0x12U
+            } };
+
+            Assert::AreEqual(static_cast<size_t>(20U), hash.size());
+            Assert::IsTrue(expected == digest);
+        }
+
+        TEST_METHOD(Sha1MillionA)
+        {
+            std::vector<uint8_t> data(1000U, 'a');
+
+            Sha1Hash hash;
+            for (size_t i = 0U; i < 1000U; ++i)
+            {
+                hash.add(data.data(), data.size());
+            }
+            auto digest = hash.close();
+
+            const std::vector<uint8_t> expected = {
+                0x34U, 0xaaU, 0x97U, 0x3cU,
+                0xd4U, 0xc4U, 0xdaU, 0xa4U,
+                0xf6U, 0x1eU, 0xebU, 0x2bU,
+                0xdbU, 0xadU, 0x27U, 0x31U,
+                0x65U, 0x34U, 0x01U, 0x6fU
+            };
+
+            Assert::IsTrue(expected == digest);
+        }
+
+        TEST_METHOD(Sha1Chunked)
+        {
+            std::vector<uint8_t> data(1000U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 7U + 3U);
+            }
+
+            // Add in chunks that straddle block boundaries
+            static const size_t chunks[] = { 1U, 63U, 64U, 65U, 200U, 7U };
+            Sha1Hash hash;
+            for (size_t pos = 0U, i = 0U; pos < data.size(); ++i)
+            {
+                size_t size = std::min(chunks[i % 6U], data.size() - pos);
+                hash.add(data.data() + pos, size);
+                pos += size;
+            }
+            auto digest = hash.close();
+
+            const std::vector<uint8_t> expected = {
+                0x42U, 0x31U, 0xa8U, 0xa5U,
+                0x0aU, 0x10U, 0xfaU, 0x97U,
+                0x58U, 0xdbU, 0x8eU, 0xc7U,
+                0x1fU, 0xdeU, 0xf8U, 0x55U,
+                0xb7U, 0x51U, 0x04U, 0x8aU
+            };
+
+            Assert::IsTrue(expected == digest);
+        }
+
+        TEST_METHOD(Sha1Backend)
+        {
+            const char *backend = Sha1Hash::backend();
+
+            Assert::IsTrue(
+                std::strcmp(backend, "sha-ni") == 0 ||
+                std::strcmp(backend, "avx2") == 0 ||
+                std::strcmp(backend, "ssse3") == 0 ||
+                std::strcmp(backend, "scalar") == 0);
+        }
+
+        TEST_METHOD(Sha1Portable)
+        {
+            std::vector<uint8_t> data(1000U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 13U + 5U);
+            }
+
+            // An odd number of blocks in one call covers the paired and single block paths
+            for (size_t size = 0U; size <= data.size(); size += 125U)
+            {
+                Sha1Hash hash;
+                hash.add(data.data(), size);
+                Sha1Hash::Digest digest;
+                hash.close(digest);
+
+                Sha1ConstEngine engine;
+                engine.add(data.data(), size);
+                Assert::IsTrue(engine.close() == digest);
+            }
+        }
+
+        TEST_METHOD(Sha1Snapshot)
+        {
+            std::vector<uint8_t> data(1000U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 7U + 3U);
+            }
+
+            // Absorb a prefix that ends mid-block and fork from its midstate
+            Sha1Hash hash;
+            hash.add(data.data(), 100U);
+            Sha1Hash::State state;
+            hash.save(state);
+
+            for (size_t size = 100U; size <= data.size(); size += 300U)
+            {
+                hash.restore(state);
+                hash.add(data.data() + 100U, size - 100U);
+                auto forked = hash.close();
+
+                Sha1Hash full;
+                full.add(data.data(), size);
+                Assert::IsTrue(full.close() == forked);
+            }
+        }
+
+        TEST_METHOD(Sha1Segments)
+        {
+            std::vector<uint8_t> data(1000U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 7U + 3U);
+            }
+
+            // Fragments that are empty, tiny, block-sized and straddling
+            static const size_t sizes[] = { 0U, 1U, 13U, 64U, 200U, 7U, 130U, 0U, 65U };
+            std::vector<HashData> segments;
+            for (size_t pos = 0U, i = 0U; pos < data.size(); ++i)
+            {
+                size_t size = std::min(sizes[i % 9U], data.size() - pos);
+                segments.push_back(HashData{ data.data() + pos, size });
+                pos += size;
+            }
+
+            Sha1Hash full;
+            full.add(data.data(), data.size());
+            auto expected = full.close();
+
+            Sha1Hash hash;
+            Hash &base = hash;
+            base.add(segments.data(), segments.size());
+            Assert::IsTrue(expected == hash.close());
+        }
+
+        TEST_METHOD(Sha1OneShot)
+        {
+            std::vector<uint8_t> data(300U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 11U + 5U);
+            }
+
+            // Every size through the one-block, two-block and long paths
+            for (size_t size = 0U; size <= data.size(); ++size)
+            {
+                Sha1Hash full;
+                full.add(data.data(), size);
+                auto expected = full.close();
+
+                std::vector<uint8_t> actual(20U);
+                Sha1Hash::hash(data.data(), size, actual.data());
+                Assert::IsTrue(expected == actual);
+            }
+        }
     };
 }
\ No newline at end of file
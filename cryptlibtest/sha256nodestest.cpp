@@ -0,0 +1,131 @@
+#include "CppUnitTest.h"
+#include "sha256_nodes.hpp"
+#include "sha256_hash.hpp"
+#include <cstring>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cryptlibtest
+{
+    TEST_CLASS(Sha256NodesTest)
+    {
+    public:
+
+        TEST_METHOD(Sha256NodesZero)
+        {
+            uint8_t inputs[64] = {};
+            uint8_t digests[64];
+            Sha256Nodes::hash64(inputs, 1U, digests);
+            Sha256Nodes::hash32(inputs, 1U, digests + 32);
+
+            const std::vector<uint8_t> expected = {
+                0xf5U, 0xa5U, 0xfdU, 0x42U,
+                0xd1U, 0x6aU, 0x20U, 0x30U,
+                0x27U, 0x98U, 0xefU, 0x6eU,
+                0xd3U, 0x09U, 0x97U, 0x9bU,
+                0x43U, 0x00U, 0x3dU, 0x23U,
+                0x20U, 0xd9U, 0xf0U, 0xe8U,
+                0xeaU, 0x98U, 0x31U, 0xa9U,
+                0x27U, 0x59U, 0xfbU, 0x4bU,
+                0x66U, 0x68U, 0x7aU, 0xadU,
+                0xf8U, 0x62U, 0xbdU, 0x77U,
+                0x6cU, 0x8fU, 0xc1U, 0x8bU,
+                0x8eU, 0x9fU, 0x8eU, 0x20U,
+                0x08U, 0x97U, 0x14U, 0x85U,
+                0x6eU, 0xe2U, 0x33U, 0xb3U,
+                0x90U, 0x2aU, 0x59U, 0x1dU,
+                0x0dU, 0x5fU, 0x29U, 0x25U
+            };
+
+            Assert::IsTrue(expected == std::vector<uint8_t>(digests, digests + 64));
+        }
+
+        TEST_METHOD(Sha256NodesCounts)
+        {
+            std::vector<uint8_t> inputs(40U * 64U);
+            for (size_t i = 0U; i < inputs.size(); ++i)
+            {
+                inputs[i] = static_cast<uint8_t>(i * 13U + 5U);
+            }
+
+            // Cover full lane groups and every partial tail
+            for (size_t count = 0U; count <= 40U; ++count)
+            {
+                std::vector<uint8_t> digests64(count * 32U);
+                std::vector<uint8_t> digests32(count * 32U);
+                Sha256Nodes::hash64(inputs.data(), count, digests64.data());
+                Sha256Nodes::hash32(inputs.data(), count, digests32.data());
+
+                for (size_t i = 0U; i < count; ++i)
+                {
+                    uint8_t expected[32];
+                    Sha256Hash::hash(inputs.data() + i * 64U, 64U, expected);
+                    Assert::IsTrue(std::memcmp(expected, digests64.data() + i * 32U, 32U) == 0);
+
+                    Sha256Hash::hash(inputs.data() + i * 32U, 32U, expected);
+                    Assert::IsTrue(std::memcmp(expected, digests32.data() + i * 32U, 32U) == 0);
+                }
+            }
+        }
+
+        TEST_METHOD(Sha256NodesInPlace)
+        {
+            std::vector<uint8_t> nodes(37U * 64U);
+            for (size_t i = 0U; i < nodes.size(); ++i)
+            {
+                nodes[i] = static_cast<uint8_t>(i * 29U + 1U);
+            }
+
+            std::vector<uint8_t> expected(37U * 32U);
+            for (size_t i = 0U; i < 37U; ++i)
+            {
+                Sha256Hash::hash(nodes.data() + i * 64U, 64U, expected.data() + i * 32U);
+            }
+
+            Sha256Nodes::hash64(nodes.data(), 37U, nodes.data());
+            Assert::IsTrue(expected == std::vector<uint8_t>(nodes.begin(), nodes.begin() + 37U * 32U));
+        }
+
+        TEST_METHOD(Sha256NodesReduce)
+        {
+            for (size_t count = 1U; count <= 70U; ++count)
+            {
+                std::vector<uint8_t> nodes(count * 32U);
+                for (size_t i = 0U; i < nodes.size(); ++i)
+                {
+                    nodes[i] = static_cast<uint8_t>(i * 7U + count);
+                }
+
+                // Pair the nodes level by level with single-stream hashes
+                std::vector<std::vector<uint8_t>> level;
+                for (size_t i = 0U; i < count; ++i)
+                {
+                    level.emplace_back(nodes.begin() + i * 32U, nodes.begin() + i * 32U + 32U);
+                }
+
+                while (level.size() > 1U)
+                {
+                    std::vector<std::vector<uint8_t>> next;
+                    for (size_t i = 0U; i + 1U < level.size(); i += 2U)
+                    {
+                        Sha256Hash hash;
+                        hash.add(level[i].data(), 32U);
+                        hash.add(level[i + 1U].data(), 32U);
+                        auto digest = hash.close();
+                        next.emplace_back(digest.begin(), digest.end());
+                    }
+
+                    if (level.size() % 2U)
+                    {
+                        next.push_back(level.back());
+                    }
+
+                    level.swap(next);
+                }
+
+                Sha256Nodes::reduce(nodes.data(), count);
+                Assert::IsTrue(level[0] == std::vector<uint8_t>(nodes.begin(), nodes.begin() + 32U));
+            }
+        }
+    };
+}
@@ -1,5 +1,7 @@
 #include "CppUnitTest.h"
 #include "sha256_hash.hpp"
+#include <algorithm>
+#include <cstring>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -47,5 +49,189 @@ namespace cryptlibtest
 
             Assert::IsTrue(expected == digest);
         }
+
+        TEST_METHOD(Sha256TwoBlocks)
+        {
+            Sha256Hash hash;
+            hash.add("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 56U);
+            auto digest = hash.close();
+
+            const std::vector<uint8_t> expected = {
+                0x24U, 0x8dU, 0x6aU, 0x61U,
+                0xd2U, 0x06U, 0x38U, 0xb8U,
+                0xe5U, 0xc0U, 0x26U, 0x93U,
+                0x0cU, 0x3eU, 0x60U, 0x39U,
+                0xa3U, 0x3cU, 0xe4U, 0x59U,
+                0x64U, 0xffU, 0x21U, 0x67U,
+                0xf6U, 0xecU, 0xedU, 0xd4U,
+                0x19U, 0xdbU, 0x06U, 0xc1U
+            };
+
+            Assert::IsTrue(expected == digest);
+        }
+
+        TEST_METHOD(Sha256FoxDigest)
+        {
+            Sha256Hash hash;
+            hash.add("The quick brown fox jumps over the lazy dog", 43U);
+            Sha256Hash::Digest digest;
+            hash.close(digest);
+
+            const Sha256Hash::Digest expected = { {
+                0xd7U, 0xa8U, 0xfbU, 0xb3U,
+                0x07U, 0xd7U, 0x80U, 0x94U,
+                0x69U, 0xcaU, 0x9aU, 0xbcU,
+                0xb0U, 0x08U, 0x2eU, 0x4fU,
+                0x8dU, 0x56U, 0x51U, 0xe4U,
+                0x6dU, 0x3cU, 0xdbU, 0x76U,
+                0x2dU, 0x02U, 0xd0U, 0xbfU,
+                0x37U, 0xc9U, 0xe5U, 0x92U
+            } };
+
+            Assert::AreEqual(static_cast<size_t>(32U), hash.size());
+            Assert::IsTrue(expected == digest);
+        }
+
+        TEST_METHOD(Sha256MillionA)
+        {
+            std::vector<uint8_t> data(1000U, 'a');
+
+            Sha256Hash hash;
+            for (size_t i = 0U; i < 1000U; ++i)
+            {
+                hash.add(data.data(), data.size());
+            }
+            auto digest = hash.close();
+
+            const std::vector<uint8_t> expected = {
+                0xcdU, 0xc7U, 0x6eU, 0x5cU,
+                0x99U, 0x14U, 0xfbU, 0x92U,
+                0x81U, 0xa1U, 0xc7U, 0xe2U,
+                0x84U, 0xd7U, 0x3eU, 0x67U,
+                0xf1U, 0x80U, 0x9aU, 0x48U,
+                0xa4U, 0x97U, 0x20U, 0x0eU,
+                0x04U, 0x6dU, 0x39U, 0xccU,
+                0xc7U, 0x11U, 0x2cU, 0xd0U
+            };
+
+            Assert::IsTrue(expected == digest);
+        }
+
+        TEST_METHOD(Sha256Chunked)
+        {
+            std::vector<uint8_t> data(1000U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 7U + 3U);
+            }
+
+            // Add in chunks that straddle block boundaries
+            static const size_t chunks[] = { 1U, 63U, 64U, 65U, 200U, 7U };
+            Sha256Hash hash;
+            for (size_t pos = 0U, i = 0U; pos < data.size(); ++i)
+            {
+                size_t size = std::min(chunks[i % 6U], data.size() - pos);
+                hash.add(data.data() + pos, size);
+                pos += size;
+            }
+            auto digest = hash.close();
+
+            const std::vector<uint8_t> expected = {
+                0x1eU, 0x9bU, 0xc3U, 0x8cU,
+                0xbfU, 0x86U, 0x0bU, 0x9eU,
+                0xc3U, 0x19U, 0x18U, 0xb0U,
+                0x65U, 0xf9U, 0xb5U, 0x24U,
+                0x76U, 0xc5U, 0x49U, 0xa7U,
+                0x82U, 0xe0U, 0xe7U, 0x99U,
+                0x0bU, 0xedU, 0x8cU, 0xe3U,
+                0x86U, 0x8dU, 0x23U, 0x71U
+            };
+
+            Assert::IsTrue(expected == digest);
+        }
+
+        TEST_METHOD(Sha256Backend)
+        {
+            const char *backend = Sha256Hash::backend();
+
+            Assert::IsTrue(
+                std::strcmp(backend, "sha-ni") == 0 ||
+                std::strcmp(backend, "scalar") == 0);
+        }
+
+        TEST_METHOD(Sha256Snapshot)
+        {
+            std::vector<uint8_t> data(1000U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 7U + 3U);
+            }
+
+            // Absorb a prefix that ends mid-block and fork from its midstate
+            Sha256Hash hash;
+            hash.add(data.data(), 100U);
+            Sha256Hash::State state;
+            hash.save(state);
+
+            for (size_t size = 100U; size <= data.size(); size += 300U)
+            {
+                hash.restore(state);
+                hash.add(data.data() + 100U, size - 100U);
+                auto forked = hash.close();
+
+                Sha256Hash full;
+                full.add(data.data(), size);
+                Assert::IsTrue(full.close() == forked);
+            }
+        }
+
+        TEST_METHOD(Sha256Segments)
+        {
+            std::vector<uint8_t> data(1000U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 7U + 3U);
+            }
+
+            // Fragments that are empty, tiny, block-sized and straddling
+            static const size_t sizes[] = { 0U, 1U, 13U, 64U, 200U, 7U, 130U, 0U, 65U };
+            std::vector<HashData> segments;
+            for (size_t pos = 0U, i = 0U; pos < data.size(); ++i)
+            {
+                size_t size = std::min(sizes[i % 9U], data.size() - pos);
+                segments.push_back(HashData{ data.data() + pos, size });
+                pos += size;
+            }
+
+            Sha256Hash full;
+            full.add(data.data(), data.size());
+            auto expected = full.close();
+
+            Sha256Hash hash;
+            Hash &base = hash;
+            base.add(segments.data(), segments.size());
+            Assert::IsTrue(expected == hash.close());
+        }
+
+        TEST_METHOD(Sha256OneShot)
+        {
+            std::vector<uint8_t> data(300U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 11U + 5U);
+            }
+
+            // Every size through the one-block, two-block and long paths
+            for (size_t size = 0U; size <= data.size(); ++size)
+            {
+                Sha256Hash full;
+                full.add(data.data(), size);
+                auto expected = full.close();
+
+                std::vector<uint8_t> actual(32U);
+                Sha256Hash::hash(data.data(), size, actual.data());
+                Assert::IsTrue(expected == actual);
+            }
+        }
     };
 }
\ No newline at end of file
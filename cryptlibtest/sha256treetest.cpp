@@ -0,0 +1,132 @@
+#include "CppUnitTest.h"
+#include "sha256_tree.hpp"
+#include <cstdio>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cryptlibtest
+{
+    // Build test data
+    static std::vector<uint8_t> tree_data(size_t size)
+    {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0U; i < data.size(); ++i)
+        {
+            data[i] = static_cast<uint8_t>(i * 7U + 3U);
+        }
+
+        return data;
+    }
+
+    // Hash a prefix byte followed by data
+    static Sha256Tree::Digest tree_hash(uint8_t prefix, const void *data, size_t size, const void *more = nullptr, size_t more_size = 0U)
+    {
+        Sha256Engine engine;
+        engine.add(&prefix, 1U);
+        engine.add(data, size);
+        engine.add(more, more_size);
+        return engine.close();
+    }
+
+    TEST_CLASS(Sha256TreeTest)
+    {
+    public:
+
+        TEST_METHOD(Sha256TreeStructure)
+        {
+            // Three leaves: root = node(node(leaf0, leaf1), leaf2)
+            auto data = tree_data(250U);
+            Sha256Tree tree(100U);
+            tree.build(data.data(), data.size(), 1U);
+
+            auto leaf0 = tree_hash(0x00U, data.data(), 100U);
+            auto leaf1 = tree_hash(0x00U, data.data() + 100U, 100U);
+            auto leaf2 = tree_hash(0x00U, data.data() + 200U, 50U);
+            auto node = tree_hash(0x01U, leaf0.data(), 32U, leaf1.data(), 32U);
+            auto root = tree_hash(0x01U, node.data(), 32U, leaf2.data(), 32U);
+
+            Assert::IsTrue(tree.leaves() == 3U);
+            Assert::IsTrue(tree.leaf(2U) == leaf2);
+            Assert::IsTrue(tree.root() == root);
+
+            // Empty data has a single empty leaf
+            tree.build(nullptr, 0U, 1U);
+            Assert::IsTrue(tree.leaves() == 1U);
+            Assert::IsTrue(tree.root() == tree_hash(0x00U, nullptr, 0U));
+        }
+
+        TEST_METHOD(Sha256TreeUpdate)
+        {
+            auto data = tree_data(10000U);
+            Sha256Tree tree(64U);
+            tree.build(data.data(), data.size(), 1U);
+
+            // Modify bytes straddling a leaf boundary
+            data[1000U] ^= 0xFFU;
+            data[1030U] ^= 0xFFU;
+            tree.update(data.data(), data.size(), 1000U, 31U, 1U);
+
+            Sha256Tree full(64U);
+            full.build(data.data(), data.size(), 1U);
+            Assert::IsTrue(full.root() == tree.root());
+
+            // Grow and shrink the data
+            static const size_t sizes[] = { 10050U, 20000U, 5000U, 64U, 1U, 0U, 777U };
+            for (size_t size : sizes)
+            {
+                data.resize(size, 0xABU);
+                tree.update(data.data(), data.size(), 0U, 0U, 1U);
+                full.build(data.data(), data.size(), 1U);
+                Assert::IsTrue(full.root() == tree.root());
+                Assert::IsTrue(full.leaves() == tree.leaves());
+            }
+        }
+
+        TEST_METHOD(Sha256TreeThreads)
+        {
+            auto data = tree_data(100000U);
+            Sha256Tree serial(1000U);
+            Sha256Tree parallel(1000U);
+            serial.build(data.data(), data.size(), 1U);
+            parallel.build(data.data(), data.size(), 4U);
+            Assert::IsTrue(serial.root() == parallel.root());
+        }
+
+        TEST_METHOD(Sha256TreeIndex)
+        {
+            const char *path = "sha256treetest.idx";
+            auto data = tree_data(5000U);
+            Sha256Tree tree(256U);
+            tree.build(data.data(), data.size());
+            Assert::IsTrue(tree.save(path));
+
+            // Reload the index and update only the modified leaf
+            data[4321U] ^= 0x55U;
+            Sha256Tree loaded;
+            Assert::IsTrue(loaded.load(path));
+            Assert::IsTrue(loaded.leaf_size() == 256U);
+            loaded.update(data.data(), data.size(), 4321U, 1U);
+            std::remove(path);
+
+            tree.build(data.data(), data.size());
+            Assert::IsTrue(tree.root() == loaded.root());
+            Assert::IsFalse(loaded.load(path));
+
+            // A header claiming more leaves than the file holds is rejected
+            const uint8_t corrupt[24] =
+            {
+                'S', '2', '5', '6', 'T', 'R', 'E', 'E',
+                0x01U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U,
+                0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x40U
+            };
+
+            std::FILE *file = std::fopen(path, "wb");
+            Assert::IsTrue(file != nullptr);
+            std::fwrite(corrupt, 1U, sizeof(corrupt), file);
+            std::fclose(file);
+            Assert::IsFalse(loaded.load(path));
+            Assert::IsTrue(tree.root() == loaded.root());
+            std::remove(path);
+        }
+    };
+}
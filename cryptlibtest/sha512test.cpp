@@ -0,0 +1,272 @@
+#include "CppUnitTest.h"
+#include "sha512_hash.hpp"
+#include <algorithm>
+#include <cstring>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cryptlibtest
+{
+    TEST_CLASS(Sha512Test)
+    {
+    public:
+
+        TEST_METHOD(Sha512TestEmpty)
+        {
+            Sha512Hash hash;
+            auto digest = hash.close();
+
+            const std::vector<uint8_t> expected = {
+                0xcfU, 0x83U, 0xe1U, 0x35U,
+                0x7eU, 0xefU, 0xb8U, 0xbdU,
+                0xf1U, 0x54U, 0x28U, 0x50U,
+                0xd6U, 0x6dU, 0x80U, 0x07U,
+                0xd6U, 0x20U, 0xe4U, 0x05U,
+                0x0bU, 0x57U, 0x15U, 0xdcU,
+                0x83U, 0xf4U, 0xa9U, 0x21U,
+                0xd3U, 0x6cU, 0xe9U, 0xceU,
+                0x47U, 0xd0U, 0xd1U, 0x3cU,
+                0x5dU, 0x85U, 0xf2U, 0xb0U,
+                0xffU, 0x83U, 0x18U, 0xd2U,
+                0x87U, 0x7eU, 0xecU, 0x2fU,
+                0x63U, 0xb9U, 0x31U, 0xbdU,
+                0x47U, 0x41U, 0x7aU, 0x81U,
+                0xa5U, 0x38U, 0x32U, 0x7aU,
+                0xf9U, 0x27U, 0xdaU, 0x3eU
+            };
+
+            Assert::IsTrue(expected == digest);
+        }
+
+        TEST_METHOD(Sha512Fox)
+        {
+            Sha512Hash hash;
+            hash.add("The quick brown fox jumps over the lazy dog", 43U);
+            auto digest = hash.close();
+
+            const std::vector<uint8_t> expected = {
+                0x07U, 0xe5U, 0x47U, 0xd9U,
+                0x58U, 0x6fU, 0x6aU, 0x73U,
+                0xf7U, 0x3fU, 0xbaU, 0xc0U,
+                0x43U, 0x5eU, 0xd7U, 0x69U,
+                0x51U, 0x21U, 0x8fU, 0xb7U,
+                0xd0U, 0xc8U, 0xd7U, 0x88U,
+                0xa3U, 0x09U, 0xd7U, 0x85U,
+                0x43U, 0x6bU, 0xbbU, 0x64U,
+                0x2eU, 0x93U, 0xa2U, 0x52U,
+                0xa9U, 0x54U, 0xf2U, 0x39U,
+                0x12U, 0x54U, 0x7dU, 0x1eU,
+                0x8aU, 0x3bU, 0x5eU, 0xd6U,
+                0xe1U, 0xbfU, 0xd7U, 0x09U,
+                0x78U, 0x21U, 0x23U, 0x3fU,
+                0xa0U, 0x53U, 0x8fU, 0x3dU,
+                0xb8U, 0x54U, 0xfeU, 0xe6U
+            };
+
+            Assert::IsTrue(expected == digest);
+        }
+
+        TEST_METHOD(Sha512TwoBlocks)
+        {
+            Sha512Hash hash;
+            hash.add("abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu", 112U);
+            auto digest = hash.close();
+
+            const std::vector<uint8_t> expected = {
+                0x8eU, 0x95U, 0x9bU, 0x75U,
+                0xdaU, 0xe3U, 0x13U, 0xdaU,
+                0x8cU, 0xf4U, 0xf7U, 0x28U,
+                0x14U, 0xfcU, 0x14U, 0x3fU,
+                0x8fU, 0x77U, 0x79U, 0xc6U,
+                0xebU, 0x9fU, 0x7fU, 0xa1U,
+                0x72U, 0x99U, 0xaeU, 0xadU,
+                0xb6U, 0x88U, 0x90U, 0x18U,
+                0x50U, 0x1dU, 0x28U, 0x9eU,
+                0x49U, 0x00U, 0xf7U, 0xe4U,
+                0x33U, 0x1bU, 0x99U, 0xdeU,
+                0xc4U, 0xb5U, 0x43U, 0x3aU,
+                0xc7U, 0xd3U, 0x29U, 0xeeU,
+                0xb6U, 0xddU, 0x26U, 0x54U,
+                0x5eU, 0x96U, 0xe5U, 0x5bU,
+                0x87U, 0x4bU, 0xe9U, 0x09U
+            };
+
+            Assert::IsTrue(expected == digest);
+        }
+
+        TEST_METHOD(Sha384Fox)
+        {
+            Sha384Hash hash;
+            hash.add("The quick brown fox jumps over the lazy dog", 43U);
+            auto digest = hash.close();
+
+            const std::vector<uint8_t> expected = {
+                0xcaU, 0x73U, 0x7fU, 0x10U,
+                0x14U, 0xa4U, 0x8fU, 0x4cU,
+                0x0bU, 0x6dU, 0xd4U, 0x3cU,
+                0xb1U, 0x77U, 0xb0U, 0xafU,
+                0xd9U, 0xe5U, 0x16U, 0x93U,
+                0x67U, 0x54U, 0x4cU, 0x49U,
+                0x40U, 0x11U, 0xe3U, 0x31U,
+                0x7dU, 0xbfU, 0x9aU, 0x50U,
+                0x9cU, 0xb1U, 0xe5U, 0xdcU,
+                0x1eU, 0x85U, 0xa9U, 0x41U,
+                0xbbU, 0xeeU, 0x3dU, 0x7fU,
+                0x2aU, 0xfbU, 0xc9U, 0xb1U
+            };
+
+            Assert::IsTrue(expected == digest);
+        }
+
+        TEST_METHOD(Sha512_256Fox)
+        {
+            Sha512_256Hash hash;
+            hash.add("The quick brown fox jumps over the lazy dog", 43U);
+            auto digest = hash.close();
+
+            const std::vector<uint8_t> expected = {
+                0xddU, 0x9dU, 0x67U, 0xb3U,
+                0x71U, 0x51U, 0x9cU, 0x33U,
+                0x9eU, 0xd8U, 0xdbU, 0xd2U,
+                0x5aU, 0xf9U, 0x0eU, 0x97U,
+                0x6aU, 0x1eU, 0xeeU, 0xfdU,
+                0x4aU, 0xd3U, 0xd8U, 0x89U,
+                0x00U, 0x5eU, 0x53U, 0x2fU,
+                0xc5U, 0xbeU, 0xf0U, 0x4dU
+            };
+
+            Assert::IsTrue(expected == digest);
+        }
+
+        TEST_METHOD(Sha512MillionA)
+        {
+            std::vector<uint8_t> data(1000U, 'a');
+
+            Sha512Hash hash;
+            for (size_t i = 0U; i < 1000U; ++i)
+            {
+                hash.add(data.data(), data.size());
+            }
+            auto digest = hash.close();
+
+            const std::vector<uint8_t> expected = {
+                0xe7U, 0x18U, 0x48U, 0x3dU,
+                0x0cU, 0xe7U, 0x69U, 0x64U,
+                0x4eU, 0x2eU, 0x42U, 0xc7U,
+                0xbcU, 0x15U, 0xb4U, 0x63U,
+                0x8eU, 0x1fU, 0x98U, 0xb1U,
+                0x3bU, 0x20U, 0x44U, 0x28U,
+                0x56U, 0x32U, 0xa8U, 0x03U,
+                0xafU, 0xa9U, 0x73U, 0xebU,
+                0xdeU, 0x0fU, 0xf2U, 0x44U,
+                0x87U, 0x7eU, 0xa6U, 0x0aU,
+                0x4cU, 0xb0U, 0x43U, 0x2cU,
+                0xe5U, 0x77U, 0xc3U, 0x1bU,
+                0xebU, 0x00U, 0x9cU, 0x5cU,
+                0x2cU, 0x49U, 0xaaU, 0x2eU,
+                0x4eU, 0xadU, 0xb2U, 0x17U,
+                0xadU, 0x8cU, 0xc0U, 0x9bU
+            };
+
+            Assert::IsTrue(expected == digest);
+        }
+
+        TEST_METHOD(Sha512Chunked)
+        {
+            std::vector<uint8_t> data(1000U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 7U + 3U);
+            }
+
+            // Add in chunks that straddle block boundaries
+            static const size_t chunks[] = { 1U, 127U, 128U, 129U, 300U, 7U };
+            Sha512Hash hash;
+            for (size_t pos = 0U, i = 0U; pos < data.size(); ++i)
+            {
+                size_t size = std::min(chunks[i % 6U], data.size() - pos);
+                hash.add(data.data() + pos, size);
+                pos += size;
+            }
+            auto digest = hash.close();
+
+            const std::vector<uint8_t> expected = {
+                0x00U, 0xe3U, 0x6fU, 0xccU,
+                0xf1U, 0x93U, 0xe5U, 0x96U,
+                0x97U, 0xa9U, 0x2bU, 0x5aU,
+                0xb2U, 0x46U, 0x66U, 0xceU,
+                0x63U, 0x26U, 0xd7U, 0xfaU,
+                0x16U, 0xbfU, 0x10U, 0x83U,
+                0x2dU, 0x09U, 0x91U, 0xddU,
+                0xc5U, 0x91U, 0x11U, 0x2eU,
+                0x9dU, 0xfaU, 0x6aU, 0x63U,
+                0x69U, 0x50U, 0xedU, 0x9cU,
+                0x4dU, 0x67U, 0x34U, 0x4aU,
+                0x76U, 0x06U, 0x54U, 0xc2U,
+                0xffU, 0x77U, 0x85U, 0xe1U,
+                0xd6U, 0x00U, 0x94U, 0xd6U,
+                0x51U, 0x03U, 0x87U, 0x35U,
+                0xb5U, 0xdcU, 0xcaU, 0xbdU
+            };
+
+            Assert::IsTrue(expected == digest);
+        }
+
+        TEST_METHOD(Sha512Backend)
+        {
+            const char *backend = Sha512Hash::backend();
+
+            Assert::IsTrue(
+                std::strcmp(backend, "avx2") == 0 ||
+                std::strcmp(backend, "scalar") == 0);
+        }
+
+        TEST_METHOD(Sha512Portable)
+        {
+            std::vector<uint8_t> data(2000U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 13U + 5U);
+            }
+
+            // Odd and even block counts cover the paired and single block schedules
+            for (size_t size = 0U; size <= data.size(); size += 250U)
+            {
+                Sha512Hash hash;
+                hash.add(data.data(), size);
+                Sha512Hash::Digest digest;
+                hash.close(digest);
+
+                Sha512ConstEngine engine;
+                engine.add(data.data(), size);
+                Assert::IsTrue(engine.close() == digest);
+            }
+        }
+
+        TEST_METHOD(Sha512Snapshot)
+        {
+            std::vector<uint8_t> data(1000U);
+            for (size_t i = 0U; i < data.size(); ++i)
+            {
+                data[i] = static_cast<uint8_t>(i * 7U + 3U);
+            }
+
+            // Absorb a prefix that ends mid-block and fork from its midstate
+            Sha384Hash hash;
+            hash.add(data.data(), 200U);
+            Sha384Hash::State state;
+            hash.save(state);
+
+            for (size_t size = 200U; size <= data.size(); size += 300U)
+            {
+                hash.restore(state);
+                hash.add(data.data() + 200U, size - 200U);
+                auto forked = hash.close();
+
+                Sha384Hash full;
+                full.add(data.data(), size);
+                Assert::IsTrue(full.close() == forked);
+            }
+        }
+    };
+}
@@ -0,0 +1,62 @@
+#include "CppUnitTest.h"
+#include "stream_hash.hpp"
+#include "sha256_hash.hpp"
+#include <cstdio>
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace cryptlibtest
+{
+    TEST_CLASS(StreamHashTest)
+    {
+    public:
+
+        TEST_METHOD(StreamHashMatchesSha256)
+        {
+            // Sizes around the 4 KiB alignment and the buffer size
+            static const size_t sizes[] = { 0U, 1U, 4095U, 4096U, 65537U, 300000U };
+            static const StreamHash::Method methods[] = { StreamHash::automatic, StreamHash::readahead };
+
+            for (size_t size : sizes)
+            {
+                std::vector<uint8_t> data(size);
+                for (size_t j = 0U; j < data.size(); ++j)
+                {
+                    data[j] = static_cast<uint8_t>(j * 13U + 1U);
+                }
+
+                std::string path = "streamhashtest.bin";
+                std::FILE *file = std::fopen(path.c_str(), "wb");
+                Assert::IsTrue(file != nullptr);
+                std::fwrite(data.data(), 1U, data.size(), file);
+                std::fclose(file);
+
+                Sha256Hash expected;
+                expected.add(data.data(), data.size());
+                auto digest = expected.close();
+
+                // A small buffer keeps several reads in flight at once
+                for (StreamHash::Method method : methods)
+                {
+                    StreamHash stream(3U, 8192U, method);
+                    Sha256Hash hash;
+                    std::vector<uint8_t> actual(hash.size());
+                    Assert::IsTrue(stream.hash(path.c_str(), hash, actual.data()));
+                    Assert::IsTrue(digest == actual);
+                    Assert::IsTrue(stream.stats().bytes == size);
+                }
+
+                std::remove(path.c_str());
+            }
+        }
+
+        TEST_METHOD(StreamHashMissing)
+        {
+            StreamHash stream;
+            Sha256Hash hash;
+            std::vector<uint8_t> digest(hash.size());
+            Assert::IsFalse(stream.hash("streamhashtest-missing.bin", hash, digest.data()));
+        }
+    };
+}